@@ -0,0 +1,111 @@
+//
+// Word being typed, one keystroke at a time.
+//
+
+#include <cstring>
+#include "ComposingSession.h"
+
+ComposingSession::ComposingSession(SuggestionProvider *suggestionProvider, int numSuggestions,
+                                   SuggestOptions *suggestOptions)
+        : suggestionProvider(suggestionProvider), numSuggestions(numSuggestions),
+          defaultSuggestOptions(nullptr, 0),
+          suggestOptions(suggestOptions ? suggestOptions : &defaultSuggestOptions),
+          traverseSession(nullptr), prevWordsInfo(new PrevWordsInfo()), inputSize(0) {}
+
+ComposingSession::~ComposingSession() {
+    hibernate();
+}
+
+void ComposingSession::reset() {
+    prevWordsInfo.reset(new PrevWordsInfo());
+    inputSize = 0;
+    discardSearch();
+}
+
+void ComposingSession::reset(const int *prevWordCodePoints, int prevWordCodePointCount,
+                             bool isBeginningOfSentence) {
+    prevWordsInfo.reset(new PrevWordsInfo(prevWordCodePoints, prevWordCodePointCount,
+                                          isBeginningOfSentence));
+    inputSize = 0;
+    discardSearch();
+}
+
+bool ComposingSession::appendCodePoint(int codePoint) {
+    return insertCodePoint(inputSize, codePoint);
+}
+
+bool ComposingSession::deleteLast() {
+    return deleteCodePoint(inputSize - 1);
+}
+
+bool ComposingSession::insertCodePoint(int index, int codePoint) {
+    if (index < 0 || index > inputSize || inputSize >= MAX_WORD_LENGTH) {
+        return false;
+    }
+    // Only the new code point is looked up; the touch points before it stay exactly as they
+    // were, which is what lets the engine continue from its checkpoints before the edit.
+    const int movedCount = inputSize - index;
+    memmove(&inputCodePoints[index + 1], &inputCodePoints[index], movedCount * sizeof(int));
+    memmove(&xCoords[index + 1], &xCoords[index], movedCount * sizeof(int));
+    memmove(&yCoords[index + 1], &yCoords[index], movedCount * sizeof(int));
+    inputCodePoints[index] = codePoint;
+    suggestionProvider->getKeyCoordinates(&inputCodePoints[index], 1, &xCoords[index],
+                                          &yCoords[index]);
+    inputSize++;
+    return true;
+}
+
+bool ComposingSession::deleteCodePoint(int index) {
+    if (index < 0 || index >= inputSize) {
+        return false;
+    }
+    const int movedCount = inputSize - index - 1;
+    memmove(&inputCodePoints[index], &inputCodePoints[index + 1], movedCount * sizeof(int));
+    memmove(&xCoords[index], &xCoords[index + 1], movedCount * sizeof(int));
+    memmove(&yCoords[index], &yCoords[index + 1], movedCount * sizeof(int));
+    inputSize--;
+    return true;
+}
+
+int ComposingSession::getSuggestions(SuggestionProvider::SuggestionBuffer *outSuggestions,
+                                     QueryStats *outStats) {
+    if (inputSize == 0) {
+        if (outStats) {
+            outStats->reset();
+        }
+        return suggestionProvider->getEmptySuggestions(numSuggestions, prevWordsInfo.get(),
+                                                       outSuggestions);
+    }
+    if (!traverseSession) {
+        traverseSession = static_cast<DicTraverseSession *>(
+                DicTraverseSession::getSessionInstance(suggestionProvider->dictSize));
+    }
+    traverseSession->getQueryStats()->reset();
+    traverseSession->setExpansionThreadCount(suggestionProvider->expansionThreadCount);
+    traverseSession->setMaxCheckpointCount(suggestionProvider->maxCheckpointCount);
+    int count = suggestionProvider->getSuggestions(traverseSession,
+                                                   &suggestionProvider->dictionaryGroup,
+                                                   numSuggestions, inputCodePoints, xCoords,
+                                                   yCoords, inputSize, prevWordsInfo.get(),
+                                                   suggestOptions, outSuggestions);
+    if (outStats) {
+        *outStats = *traverseSession->getQueryStats();
+    }
+    return count;
+}
+
+void ComposingSession::hibernate() {
+    DicTraverseSession::releaseSessionInstance(traverseSession);
+    traverseSession = nullptr;
+}
+
+size_t ComposingSession::getMemorySize() const {
+    return sizeof(ComposingSession) + sizeof(PrevWordsInfo)
+           + (traverseSession ? traverseSession->getMemorySize() : 0);
+}
+
+void ComposingSession::discardSearch() {
+    if (traverseSession) {
+        traverseSession->discardCheckpoints();
+    }
+}
@@ -0,0 +1,77 @@
+//
+// Word being typed, one keystroke at a time.
+//
+
+#ifndef BOBBLE_INDIC2_COMPOSINGSESSION_H
+#define BOBBLE_INDIC2_COMPOSINGSESSION_H
+
+#include <memory>
+#include "libDict/suggest/core/session/prev_words_info.h"
+#include "libDict/suggest/core/suggest_options.h"
+#include "SuggestionProvider.h"
+
+// Keeps the state of one word being composed: its code points, their touch points and a traverse
+// session of its own. Since no other query ever runs on that session, the search steps the engine
+// checkpoints during a query are still there for the next one, and a keystroke that appends,
+// deletes or changes a code point continues from the last step before the edit instead of
+// starting over at the root; see SuggestionProvider::setMaxCheckpointCount.
+//
+// Starting a new word restarts the search. The traverse session, which
+// holds nearly all of the memory, is allocated on the first query and freed by hibernate(); the
+// next query then allocates a new one and restarts the search. A session is meant for one thread
+// at a time; any number of sessions can be used concurrently on one provider, which must outlive
+// them.
+class ComposingSession {
+public:
+    // suggestOptions, when not null, must outlive the session.
+    explicit ComposingSession(SuggestionProvider *suggestionProvider, int numSuggestions = 3,
+                              SuggestOptions *suggestOptions = nullptr);
+    ~ComposingSession();
+
+    // Starts a new word, with no previous word or after the given one.
+    void reset();
+    void reset(const int *prevWordCodePoints, int prevWordCodePointCount, bool isBeginningOfSentence);
+
+    // Return false, leaving the word unchanged, when it is full or empty respectively.
+    bool appendCodePoint(int codePoint);
+    bool deleteLast();
+    // Edits at a code point index of the word, such as after the cursor moved into it. Return
+    // false, leaving the word unchanged, when the index is out of range or the word is full.
+    bool insertCodePoint(int index, int codePoint);
+    bool deleteCodePoint(int index);
+
+    // Suggestions for the word typed so far, or predictions when it is empty. outStats, if not
+    // null, receives the stats of the search; they are all zero for predictions.
+    int getSuggestions(SuggestionProvider::SuggestionBuffer *outSuggestions,
+                       QueryStats *outStats = nullptr);
+
+    // Frees the traverse session, keeping the word and the previous word.
+    void hibernate();
+    bool isHibernating() const { return traverseSession == nullptr; }
+    // Approximate number of bytes held, including the traverse session if there is one.
+    size_t getMemorySize() const;
+
+    int getInputSize() const { return inputSize; }
+    const int *getInputCodePoints() const { return inputCodePoints; }
+
+private:
+    SuggestionProvider *const suggestionProvider;
+    const int numSuggestions;
+    SuggestOptions defaultSuggestOptions;
+    SuggestOptions *const suggestOptions;
+    DicTraverseSession *traverseSession;
+    std::unique_ptr<PrevWordsInfo> prevWordsInfo;
+
+    int inputCodePoints[MAX_WORD_LENGTH];
+    int xCoords[MAX_WORD_LENGTH];
+    int yCoords[MAX_WORD_LENGTH];
+    int inputSize;
+
+    void discardSearch();
+
+    ComposingSession(const ComposingSession &) = delete;
+    ComposingSession &operator=(const ComposingSession &) = delete;
+};
+
+
+#endif //BOBBLE_INDIC2_COMPOSINGSESSION_H
@@ -2,188 +2,316 @@
 // Created by kunaldawn on 25/1/17.
 //
 
+#include <algorithm>
 #include <iostream>
+#include <set>
 #include "ProximityProvider.h"
 #include "FileUtils.h"
+#include "libDict/suggest/policyimpl/dictionary/utils/mmapped_buffer.h"
 
-ProximityProvider::ProximityProvider(const std::vector<std::string> filePathsList) {
-    
-    for (int index = 0; index < filePathsList.size(); index++) {
-        std::string filePath = filePathsList[index];
-        ProximityInfo *proximity = createNewProximityInstance(filePath);
-        mProviderInstances.push_back(proximity);
-    }
-}
+using latinime::MmappedBuffer;
 
-ProximityProvider::ProximityProvider(const std::string &providerPath) {
-    std::vector<std::string> proximityFiles = FileUtils::getFiles(providerPath, true, ".json");
+const std::string ProximityProvider::COMPILED_LAYOUT_EXTENSION = ".kbl";
 
-    // TODO : DEBUG
-    std::cout << "num proximity files : " << proximityFiles.size() << std::endl;
+namespace {
 
-    for (int index = 0; index < proximityFiles.size(); index++) {
-        std::string fileName = proximityFiles[index];
-        ProximityInfo *proximity = createNewProximityInstance(providerPath + "/" + fileName);
-        mProviderInstances.push_back(proximity);
-    }
+bool hasSuffix(const std::string &value, const std::string &suffix) {
+    return value.size() >= suffix.size()
+           && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
 }
 
-ProximityProvider::~ProximityProvider() {
-    mCodeToProximityMap.clear();
-    for (int index = 0; index < mProviderInstances.size(); index++) {
-        ProximityInfo *instance = mProviderInstances[index];
-        delete instance;
+template<typename T>
+std::vector<T> readArray(const Json::Value &root, const char *name, Json::ValueType type) {
+    Json::Value arrayContainer = root.get(name, Json::arrayValue);
+    std::vector<T> values(arrayContainer.size());
+    for (Json::ArrayIndex index = 0; index < arrayContainer.size(); index++) {
+        const Json::Value value = arrayContainer.get(index, type);
+        values[index] = type == Json::realValue ? value.asFloat() : value.asInt();
     }
-    mProviderInstances.clear();
+    return values;
 }
 
-ProximityInfo *ProximityProvider::createNewProximityInstance(const std::string &path) {
+// Owns the arrays of a layout parsed from JSON.
+class JsonLayout {
+public:
+    explicit JsonLayout(const std::string &path) {
+        Json::Value root = FileUtils::loadJson(path);
+
+        locale = root.get("locale", Json::stringValue).asString();
+        layout.keyboardWidth = root.get("keyboardMinWidth", Json::intValue).asInt();
+        layout.keyboardHeight = root.get("keyboardHeight", Json::intValue).asInt();
+        layout.gridWidth = root.get("gridWidth", Json::intValue).asInt();
+        layout.gridHeight = root.get("gridHeight", Json::intValue).asInt();
+        layout.mostCommonKeyWidth = root.get("mostCommonKeyWidth", Json::intValue).asInt();
+        layout.mostCommonKeyHeight = root.get("mostCommonKeyHeight", Json::intValue).asInt();
+
+        proximityChars = readArray<int>(root, "proximityCharsArray", Json::intValue);
+        keyXCoordinates = readArray<int>(root, "keyXCoordinates", Json::intValue);
+        keyYCoordinates = readArray<int>(root, "keyYCoordinates", Json::intValue);
+        keyWidths = readArray<int>(root, "keyWidths", Json::intValue);
+        keyHeights = readArray<int>(root, "keyHeights", Json::intValue);
+        keyCharCodes = readArray<int>(root, "keyCharCodes", Json::intValue);
+        sweetSpotCenterXs = readArray<float>(root, "sweetSpotCenterXs", Json::realValue);
+        sweetSpotCenterYs = readArray<float>(root, "sweetSpotCenterYs", Json::realValue);
+        sweetSpotRadii = readArray<float>(root, "sweetSpotRadii", Json::realValue);
+
+        // Every key array gets keyCount entries. Some layouts ship without sweet spots; those
+        // have no touch position correction data and do not map their key codes.
+        const int keyCount = std::max(0, root.get("keyCount", Json::intValue).asInt());
+        const bool hasSweetSpots = (int) sweetSpotCenterXs.size() >= keyCount
+                                   && (int) sweetSpotCenterYs.size() >= keyCount
+                                   && (int) sweetSpotRadii.size() >= keyCount;
+        keyXCoordinates.resize(keyCount);
+        keyYCoordinates.resize(keyCount);
+        keyWidths.resize(keyCount);
+        keyHeights.resize(keyCount);
+        keyCharCodes.resize(keyCount);
+
+        layout.locale = locale.c_str();
+        layout.keyCount = keyCount;
+        layout.proximityCharsLength = proximityChars.size();
+        layout.proximityChars = proximityChars.data();
+        layout.keyXCoordinates = keyXCoordinates.data();
+        layout.keyYCoordinates = keyYCoordinates.data();
+        layout.keyWidths = keyWidths.data();
+        layout.keyHeights = keyHeights.data();
+        layout.keyCharCodes = keyCharCodes.data();
+        if (hasSweetSpots) {
+            layout.sweetSpotCenterXs = sweetSpotCenterXs.data();
+            layout.sweetSpotCenterYs = sweetSpotCenterYs.data();
+            layout.sweetSpotRadii = sweetSpotRadii.data();
+        }
+    }
 
-    Json::Value root = FileUtils::loadJson(path);
+    KeyboardLayoutFile::Layout layout;
 
+private:
     std::string locale;
-    int keyboardMinWidth;
-    int keyboardHeight;
-    int gridWidth;
-    int gridHeight;
-    int mostCommonKeyWidth;
-    int mostCommonKeyHeight;
-    int keyCount;
-    int proximityCharsArrayLen;
-    int charCodesLen;
-    int charXCoordLen;
-    int charYCoordLen;
-
-    char *c_locale;
+    std::vector<int> proximityChars;
+    std::vector<int> keyXCoordinates;
+    std::vector<int> keyYCoordinates;
+    std::vector<int> keyWidths;
+    std::vector<int> keyHeights;
+    std::vector<int> keyCharCodes;
+    std::vector<float> sweetSpotCenterXs;
+    std::vector<float> sweetSpotCenterYs;
+    std::vector<float> sweetSpotRadii;
+};
+
+// Reads a compiled or JSON layout and keeps the memory the layout view points into.
+class LayoutFileReader {
+public:
+    // Returns false if the compiled layout is missing or invalid.
+    bool readCompiledLayout(const std::string &path) {
+        mBuffer = MmappedBuffer::openBuffer(path.c_str(), false /* isUpdatable */);
+        if (!mBuffer) {
+            return false;
+        }
+        return KeyboardLayoutFile::readLayout(mBuffer->getReadOnlyByteArrayView().data(),
+                                              mBuffer->getReadOnlyByteArrayView().size(),
+                                              &layout);
+    }
 
-    int *proximityCharsArray;
-    int *keyXCoordinates;
-    int *keyYCoordinates;
-    int *keyWidths;
-    int *keyHeights;
-    int *keyCharCodes;
+    // Throws if a JSON layout cannot be parsed.
+    bool readLayout(const std::string &path) {
+        if (hasSuffix(path, ProximityProvider::COMPILED_LAYOUT_EXTENSION)) {
+            return readCompiledLayout(path);
+        }
+        mJsonLayout.reset(new JsonLayout(path));
+        layout = mJsonLayout->layout;
+        return true;
+    }
 
-    float *sweetSpotCenterXs;
-    float *sweetSpotCenterYs;
-    float *sweetSpotRadii;
+    KeyboardLayoutFile::Layout layout;
 
-    locale = root.get("locale", Json::stringValue).asString();
-    keyboardMinWidth = root.get("keyboardMinWidth", Json::intValue).asInt();
-    keyboardHeight = root.get("keyboardHeight", Json::intValue).asInt();
-    gridWidth = root.get("gridWidth", Json::intValue).asInt();
-    gridHeight = root.get("gridHeight", Json::intValue).asInt();
-    mostCommonKeyWidth = root.get("mostCommonKeyWidth", Json::intValue).asInt();
-    mostCommonKeyHeight = root.get("mostCommonKeyHeight", Json::intValue).asInt();
-    keyCount = root.get("keyCount", Json::intValue).asInt();
+private:
+    MmappedBuffer::MmappedBufferPtr mBuffer;
+    std::unique_ptr<JsonLayout> mJsonLayout;
+};
 
-    Json::Value arrayContainer;
+}
 
-    arrayContainer = root.get("proximityCharsArray", Json::arrayValue);
-    proximityCharsArray = new int[arrayContainer.size()];
-    proximityCharsArrayLen = arrayContainer.size();
-    for (int index = 0; index < arrayContainer.size(); index++) {
-        proximityCharsArray[index] = arrayContainer.get(index, Json::intValue).asInt();
+ProximityProvider::ProximityProvider(const std::vector<std::string> filePathsList, bool isLazy)
+        : mIsLazy(isLazy), mCodeToLayoutMap(-1), mCodeToCoordinateMap(nullptr),
+          mUnknownKeyCoordinate(0, 0) {
+    
+    for (size_t index = 0; index < filePathsList.size(); index++) {
+        addLayout(filePathsList[index]);
     }
+}
 
-    arrayContainer = root.get("keyXCoordinates", Json::arrayValue);
-    keyXCoordinates = new int[arrayContainer.size()];
-    for (int index = 0; index < arrayContainer.size(); index++) {
-        keyXCoordinates[index] = arrayContainer.get(index, Json::intValue).asInt();
-    }
+ProximityProvider::ProximityProvider(const std::string &providerPath, bool isLazy)
+        : mIsLazy(isLazy), mCodeToLayoutMap(-1), mCodeToCoordinateMap(nullptr),
+          mUnknownKeyCoordinate(0, 0) {
+    std::vector<std::string> proximityFiles = FileUtils::getFiles(providerPath, true, ".json");
+    std::vector<std::string> compiledFiles =
+            FileUtils::getFiles(providerPath, true, COMPILED_LAYOUT_EXTENSION);
 
-    arrayContainer = root.get("keyYCoordinates", Json::arrayValue);
-    keyYCoordinates = new int[arrayContainer.size()];
-    for (int index = 0; index < arrayContainer.size(); index++) {
-        keyYCoordinates[index] = arrayContainer.get(index, Json::intValue).asInt();
-    }
+    // TODO : DEBUG
+    std::cout << "num proximity files : " << proximityFiles.size() << std::endl;
 
-    arrayContainer = root.get("keyWidths", Json::arrayValue);
-    keyWidths = new int[arrayContainer.size()];
-    for (int index = 0; index < arrayContainer.size(); index++) {
-        keyWidths[index] = arrayContainer.get(index, Json::intValue).asInt();
+    std::set<std::string> loadedFiles;
+    for (size_t index = 0; index < proximityFiles.size(); index++) {
+        std::string fileName = proximityFiles[index];
+        if (!hasSuffix(fileName, ".json")) {
+            continue;
+        }
+        addLayout(providerPath + "/" + fileName);
+        loadedFiles.insert(getCompiledLayoutPath(fileName));
     }
-
-    arrayContainer = root.get("keyHeights", Json::arrayValue);
-    keyHeights = new int[arrayContainer.size()];
-    for (int index = 0; index < arrayContainer.size(); index++) {
-        keyHeights[index] = arrayContainer.get(index, Json::intValue).asInt();
+    for (size_t index = 0; index < compiledFiles.size(); index++) {
+        std::string fileName = compiledFiles[index];
+        if (!hasSuffix(fileName, COMPILED_LAYOUT_EXTENSION) || loadedFiles.count(fileName) > 0) {
+            continue;
+        }
+        addLayout(providerPath + "/" + fileName);
     }
+}
 
-    arrayContainer = root.get("keyCharCodes", Json::arrayValue);
-    keyCharCodes = new int[arrayContainer.size()];
-    charCodesLen = arrayContainer.size();
-    for (int index = 0; index < arrayContainer.size(); index++) {
-        keyCharCodes[index] = arrayContainer.get(index, Json::intValue).asInt();
+ProximityProvider::~ProximityProvider() {
+    for (size_t index = 0; index < mLayouts.size(); index++) {
+        delete mLayouts[index];
     }
+    mLayouts.clear();
 
-    arrayContainer = root.get("sweetSpotCenterXs", Json::arrayValue);
-    sweetSpotCenterXs = new float[arrayContainer.size()];
-    charXCoordLen = arrayContainer.size();
-    for (int index = 0; index < arrayContainer.size(); index++) {
-        sweetSpotCenterXs[index] = arrayContainer.get(index, Json::realValue).asFloat();
+    for (size_t index = 0; index < mCoordinateInstances.size(); index++) {
+        delete mCoordinateInstances[index];
     }
+    mCoordinateInstances.clear();
+}
 
-    arrayContainer = root.get("sweetSpotCenterYs", Json::arrayValue);
-    sweetSpotCenterYs = new float[arrayContainer.size()];
-    charYCoordLen = arrayContainer.size();
-    for (int index = 0; index < arrayContainer.size(); index++) {
-        sweetSpotCenterYs[index] = arrayContainer.get(index, Json::realValue).asFloat();
-    }
+bool ProximityProvider::compileLayout(const std::string &jsonPath,
+                                      const std::string &compiledPath) {
+    JsonLayout jsonLayout(jsonPath);
+    return KeyboardLayoutFile::writeLayoutFile(compiledPath.c_str(), jsonLayout.layout);
+}
 
-    arrayContainer = root.get("sweetSpotRadii", Json::arrayValue);
-    sweetSpotRadii = new float[arrayContainer.size()];
-    for (int index = 0; index < arrayContainer.size(); index++) {
-        sweetSpotRadii[index] = arrayContainer.get(index, Json::realValue).asFloat();
-    }
+std::string ProximityProvider::getCompiledLayoutPath(const std::string &jsonPath) {
+    const std::string basePath = hasSuffix(jsonPath, ".json")
+                                 ? jsonPath.substr(0, jsonPath.size() - 5) : jsonPath;
+    return basePath + COMPILED_LAYOUT_EXTENSION;
+}
 
-    c_locale = new char[locale.length() + 1];
-    strcpy(c_locale, locale.c_str());
+void ProximityProvider::addLayout(const std::string &path) {
+    LayoutFileReader reader;
+    std::string layoutPath = path;
+    // A missing or stale-format compiled layout just falls back to parsing the JSON.
+    if (!hasSuffix(path, COMPILED_LAYOUT_EXTENSION)
+        && reader.readCompiledLayout(getCompiledLayoutPath(path))) {
+        layoutPath = getCompiledLayoutPath(path);
+    } else if (!reader.readLayout(path)) {
+        throw std::runtime_error("reading file : " + path + " has failed!");
+    }
 
-    // Create proximity instance
-    ProximityInfo *proximityInfo = new ProximityInfo(c_locale,
-                                      keyboardMinWidth, keyboardHeight,
-                                      gridWidth, gridHeight,
-                                      mostCommonKeyWidth, mostCommonKeyHeight,
-                                      proximityCharsArray, proximityCharsArrayLen, keyCount,
-                                      keyXCoordinates, keyYCoordinates,
-                                      keyWidths, keyHeights, keyCharCodes,
-                                      sweetSpotCenterXs, sweetSpotCenterYs, sweetSpotRadii);
+    LayoutSlot *slot = new LayoutSlot(layoutPath);
+    mLayouts.push_back(slot);
+    indexLayout(reader.layout, (int) mLayouts.size() - 1);
+    if (!mIsLazy) {
+        slot->proximityInfo = std::make_shared<ProximityInfo>(reader.layout);
+    }
+}
 
+void ProximityProvider::indexLayout(const KeyboardLayoutFile::Layout &layout, int layoutIndex) {
     // Update character mapping
-    int limit = std::min(charCodesLen, std::min(charXCoordLen, charYCoordLen));
-    for (int index = 0; index < limit; index++) {
-        int code = keyCharCodes[index];
-        float x = sweetSpotCenterXs[index];
-        float y = sweetSpotCenterYs[index];
-        KeyCoordinate *coordinate = new KeyCoordinate(x, y);
-        mCoordinateInstances.push_back(coordinate);
-
-        mCodeToProximityMap[code] = proximityInfo;
-        mCodeToCoordinateMap[code] = coordinate;
+    if (layout.hasSweetSpots()) {
+        for (int index = 0; index < layout.keyCount; index++) {
+            int code = layout.keyCharCodes[index];
+            float x = layout.sweetSpotCenterXs[index];
+            float y = layout.sweetSpotCenterYs[index];
+            KeyCoordinate *coordinate = new KeyCoordinate(x, y);
+            mCoordinateInstances.push_back(coordinate);
+
+            mCodeToLayoutMap.put(code, layoutIndex);
+            mCodeToCoordinateMap.put(code, coordinate);
+        }
     }
+}
 
+std::shared_ptr<ProximityInfo> ProximityProvider::getLoadedProximity(int layoutIndex) {
+    LayoutSlot *slot = mLayouts[layoutIndex];
+    if (!mIsLazy) {
+        return slot->proximityInfo;
+    }
+    // Stamped before the load, so that an eviction running meanwhile sees the layout as used.
+    slot->lastUsedTicks.store(std::chrono::steady_clock::now().time_since_epoch().count(),
+                              std::memory_order_relaxed);
+    std::shared_ptr<ProximityInfo> proximityInfo = std::atomic_load(&slot->proximityInfo);
+    if (proximityInfo) {
+        return proximityInfo;
+    }
+    std::lock_guard<std::mutex> lock(mLoadMutex);
+    proximityInfo = std::atomic_load(&slot->proximityInfo);
+    if (!proximityInfo) {
+        LayoutFileReader reader;
+        if (!reader.readLayout(slot->path)) {
+            return nullptr;
+        }
+        proximityInfo = std::make_shared<ProximityInfo>(reader.layout);
+        std::atomic_store(&slot->proximityInfo, proximityInfo);
+    }
     return proximityInfo;
 }
 
-ProximityProvider::KeyCoordinate * ProximityProvider::getKeyCoordinate(int keyCode) {
-    if (mCodeToCoordinateMap.find(keyCode) != mCodeToCoordinateMap.end()) {
-        return mCodeToCoordinateMap[keyCode];
+int ProximityProvider::evictIdleLayouts(std::chrono::milliseconds maxIdleTime) {
+    if (!mIsLazy) {
+        return 0;
     }
+    const std::chrono::steady_clock::rep now =
+            std::chrono::steady_clock::now().time_since_epoch().count();
+    const std::chrono::steady_clock::rep maxIdleTicks =
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(maxIdleTime).count();
+    int evictedCount = 0;
+    std::lock_guard<std::mutex> lock(mLoadMutex);
+    for (size_t index = 0; index < mLayouts.size(); index++) {
+        LayoutSlot *slot = mLayouts[index];
+        if (std::atomic_load(&slot->proximityInfo)
+            && now - slot->lastUsedTicks.load(std::memory_order_relaxed) >= maxIdleTicks) {
+            // Queries holding the layout keep it alive until they are done.
+            std::atomic_store(&slot->proximityInfo, std::shared_ptr<ProximityInfo>());
+            evictedCount++;
+        }
+    }
+    return evictedCount;
+}
 
-    KeyCoordinate *newInstance = new KeyCoordinate(0, 0);
-    mCoordinateInstances.push_back(newInstance);
-
-    return newInstance;
+int ProximityProvider::getLayoutCount() const {
+    return (int) mLayouts.size();
 }
 
-ProximityInfo *ProximityProvider::getProximity(int keyCode) {
-    if (mCodeToProximityMap.find(keyCode) != mCodeToProximityMap.end()) {
-        return mCodeToProximityMap[keyCode];
+int ProximityProvider::getLoadedLayoutCount() {
+    int loadedCount = 0;
+    for (size_t index = 0; index < mLayouts.size(); index++) {
+        if (std::atomic_load(&mLayouts[index]->proximityInfo)) {
+            loadedCount++;
+        }
     }
+    return loadedCount;
+}
 
-    if (mProviderInstances.size() > 0) {
-        return mProviderInstances[0];
+ProximityProvider::KeyCoordinate * ProximityProvider::getKeyCoordinate(int keyCode) {
+    KeyCoordinate *coordinate = mCodeToCoordinateMap.get(keyCode);
+    return coordinate ? coordinate : &mUnknownKeyCoordinate;
+}
+
+int ProximityProvider::getLayoutIndex(int keyCode) {
+    int layoutIndex = mCodeToLayoutMap.get(keyCode);
+    if (layoutIndex >= 0) {
+        return layoutIndex;
     }
+    return mLayouts.empty() ? -1 : 0;
+}
+
+std::shared_ptr<ProximityInfo> ProximityProvider::acquireProximity(int keyCode) {
+    const int layoutIndex = getLayoutIndex(keyCode);
+    return layoutIndex >= 0 ? getLoadedProximity(layoutIndex) : nullptr;
+}
 
-    return nullptr;
+ProximityInfo *ProximityProvider::getProximity(int keyCode) {
+    const int layoutIndex = getLayoutIndex(keyCode);
+    if (layoutIndex < 0) {
+        return nullptr;
+    }
+    // Eager layouts live as long as the provider: skip the reference count of a shared_ptr copy.
+    return mIsLazy ? getLoadedProximity(layoutIndex).get()
+                   : mLayouts[layoutIndex]->proximityInfo.get();
 }
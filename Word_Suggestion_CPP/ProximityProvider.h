@@ -5,12 +5,20 @@
 #ifndef BOBBLE_INDIC2_PROXIMITYPROVIDER_H
 #define BOBBLE_INDIC2_PROXIMITYPROVIDER_H
 
+#include "libDict/suggest/core/layout/keyboard_layout_file.h"
 #include "libDict/suggest/core/layout/proximity_info.h"
+#include "libDict/utils/code_point_map.h"
 
+using latinime::CodePointMap;
+using latinime::KeyboardLayoutFile;
 using latinime::ProximityInfo;
 
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
-#include <map>
 
 class ProximityProvider {
 public:
@@ -23,20 +31,75 @@ public:
     };
 
 private:
-    std::vector<ProximityInfo *> mProviderInstances;
+    // One layout file. Its key codes and coordinates are indexed up front; the ProximityInfo
+    // itself is built on first use in lazy mode and may be evicted again when idle.
+    class LayoutSlot {
+    public:
+        explicit LayoutSlot(const std::string &path) : path(path), lastUsedTicks(0) {}
+
+        // The file actually read: the compiled sibling of a JSON layout when there is one.
+        std::string path;
+        // Set once while constructing in eager mode. In lazy mode it is only read and written
+        // with std::atomic_load and std::atomic_store, so that queries never lock to read it.
+        std::shared_ptr<ProximityInfo> proximityInfo;
+        // steady_clock ticks of the last query on the layout, lazy mode only.
+        std::atomic<std::chrono::steady_clock::rep> lastUsedTicks;
+    };
+
+    const bool mIsLazy;
+    std::vector<LayoutSlot *> mLayouts;
     std::vector<KeyCoordinate *> mCoordinateInstances;
-    std::map<int, ProximityInfo *> mCodeToProximityMap;
-    std::map<int, KeyCoordinate *> mCodeToCoordinateMap;
+    // Key code to index in mLayouts, -1 for codes on none of the layouts.
+    CodePointMap<int> mCodeToLayoutMap;
+    CodePointMap<KeyCoordinate *> mCodeToCoordinateMap;
+    // Returned for key codes that are on none of the layouts. Shared so that lookups never
+    // mutate the provider and can run concurrently.
+    KeyCoordinate mUnknownKeyCoordinate;
+    // Serializes building and evicting the ProximityInfo of lazy layouts, so that a layout is
+    // built once. Queries on a loaded layout, and all queries in eager mode, take no lock. The
+    // key code maps are only written while constructing and need no locking either.
+    std::mutex mLoadMutex;
 
-    ProximityInfo *createNewProximityInstance(const std::string &path);
+    void addLayout(const std::string &path);
+    void indexLayout(const KeyboardLayoutFile::Layout &layout, int layoutIndex);
+    // Index of the layout of the key code, the first layout for unknown codes, -1 if none.
+    int getLayoutIndex(int keyCode);
+    std::shared_ptr<ProximityInfo> getLoadedProximity(int layoutIndex);
 
 public:
-    ProximityProvider(std::vector<std::string> fileList);
-    ProximityProvider(const std::string &providerPath);
+    // Extension of compiled layout files, see KeyboardLayoutFile. A compiled layout next to a
+    // JSON layout with the same base name is loaded instead of the JSON file.
+    static const std::string COMPILED_LAYOUT_EXTENSION;
+
+    // Layout files may be JSON or compiled layouts. When isLazy is set, only the key codes and
+    // coordinates of each layout are read up front and its ProximityInfo is built the first time
+    // getProximity needs it. Indexing a JSON layout still parses it, so lazy mode saves startup
+    // time mostly for compiled layouts. Lazy mode costs each query a clock read and a few atomic
+    // operations; eager mode reads the layouts as plain immutable data.
+    ProximityProvider(std::vector<std::string> fileList, bool isLazy = false);
+    // Loads every JSON layout in the directory (or its compiled sibling), then every compiled
+    // layout that has no JSON counterpart.
+    ProximityProvider(const std::string &providerPath, bool isLazy = false);
     ~ProximityProvider();
+
+    // Converts a JSON layout into a compiled layout file. The compiled file has to be
+    // regenerated whenever the JSON layout changes.
+    static bool compileLayout(const std::string &jsonPath, const std::string &compiledPath);
+    static std::string getCompiledLayoutPath(const std::string &jsonPath);
+
+    // Keeps the layout alive while the caller uses it, even if it is evicted meanwhile.
+    std::shared_ptr<ProximityInfo> acquireProximity(int keyCode);
+    // The returned pointer is only valid until the layout is evicted; use acquireProximity when
+    // evictIdleLayouts may run concurrently.
     ProximityInfo *getProximity(int keyCode);
     KeyCoordinate *getKeyCoordinate(int keyCode);
-};
 
+    // Releases the ProximityInfo of layouts not used for at least maxIdleTime. They are rebuilt
+    // transparently on their next use. Returns the number of layouts released, always 0 for an
+    // eager provider, whose layouts stay loaded.
+    int evictIdleLayouts(std::chrono::milliseconds maxIdleTime);
+    int getLayoutCount() const;
+    int getLoadedLayoutCount();
+};
 
 #endif //BOBBLE_INDIC2_PROXIMITYPROVIDER_H
@@ -0,0 +1,138 @@
+//
+// Composing sessions of many users under one memory budget.
+//
+
+#include "SessionManager.h"
+
+SessionManager::ScopedSession::ScopedSession(SessionManager *sessionManager, const std::string &key)
+        : sessionManager(sessionManager), entry(sessionManager->acquireEntry(key)) {
+    entry->sessionMutex.lock();
+}
+
+SessionManager::ScopedSession::~ScopedSession() {
+    entry->sessionMutex.unlock();
+    sessionManager->releaseEntry(entry);
+}
+
+SessionManager::SessionManager(SuggestionProvider *suggestionProvider, size_t byteBudget,
+                               int numSuggestions, SuggestOptions *suggestOptions)
+        : suggestionProvider(suggestionProvider), byteBudget(byteBudget),
+          numSuggestions(numSuggestions), suggestOptions(suggestOptions), bytesHeld(0),
+          liveSessionCount(0) {}
+
+SessionManager::~SessionManager() {
+    for (auto &keyAndEntry : entries) {
+        delete keyAndEntry.second;
+    }
+}
+
+SessionManager::Entry *SessionManager::acquireEntry(const std::string &key) {
+    std::lock_guard<std::mutex> lock(entriesMutex);
+    Entry *entry;
+    auto found = entries.find(key);
+    if (found != entries.end()) {
+        entry = found->second;
+        (entry->isHibernated() ? hibernatedEntries : recentlyUsedEntries)
+                .erase(entry->leastRecentlyUsed);
+    } else {
+        entry = new Entry(key, suggestionProvider, numSuggestions, suggestOptions);
+        entries[key] = entry;
+        bytesHeld += entry->memorySize;
+    }
+    recentlyUsedEntries.push_front(entry);
+    entry->leastRecentlyUsed = recentlyUsedEntries.begin();
+    entry->useCount++;
+    return entry;
+}
+
+void SessionManager::releaseEntry(Entry *entry) {
+    std::vector<Entry *> removedEntries;
+    {
+        std::lock_guard<std::mutex> lock(entriesMutex);
+        entry->useCount--;
+        // Nobody else touches the session while it is in use, and the last user has just
+        // unlocked it, so it can be read here.
+        if (entry->useCount == 0) {
+            updateEntry(entry);
+        }
+        enforceBudget(&removedEntries);
+    }
+    for (Entry *removedEntry : removedEntries) {
+        delete removedEntry;
+    }
+}
+
+void SessionManager::updateEntry(Entry *entry) {
+    const bool isLive = !entry->session.isHibernating();
+    const size_t memorySize = entry->session.getMemorySize();
+    liveSessionCount += (isLive ? 1 : 0) - (entry->isLive ? 1 : 0);
+    bytesHeld = bytesHeld - entry->memorySize + memorySize;
+    entry->isLive = isLive;
+    entry->memorySize = memorySize;
+    if (entry->isHibernated()) {
+        // The budget hibernates the least recently used entries first, and all the entries
+        // hibernated before were used even less recently, so the newest goes first.
+        recentlyUsedEntries.erase(entry->leastRecentlyUsed);
+        hibernatedEntries.push_front(entry);
+        entry->leastRecentlyUsed = hibernatedEntries.begin();
+    }
+}
+
+void SessionManager::enforceBudget(std::vector<Entry *> *outRemovedEntries) {
+    // Once all idle entries are hibernated, only the entries in use are left to scan here, at
+    // most one per thread.
+    for (auto it = recentlyUsedEntries.end();
+         bytesHeld > byteBudget && it != recentlyUsedEntries.begin();) {
+        Entry *entry = *--it;
+        if (entry->useCount > 0) {
+            continue;
+        }
+        entry->session.hibernate();
+        // Step past the entry, which updateEntry moves to hibernatedEntries.
+        ++it;
+        updateEntry(entry);
+    }
+    while (bytesHeld > byteBudget && !hibernatedEntries.empty()) {
+        Entry *entry = hibernatedEntries.back();
+        hibernatedEntries.pop_back();
+        entries.erase(entry->key);
+        bytesHeld -= entry->memorySize;
+        outRemovedEntries->push_back(entry);
+    }
+}
+
+bool SessionManager::removeSession(const std::string &key) {
+    Entry *entry;
+    {
+        std::lock_guard<std::mutex> lock(entriesMutex);
+        auto found = entries.find(key);
+        if (found == entries.end() || found->second->useCount > 0) {
+            return false;
+        }
+        entry = found->second;
+        entries.erase(found);
+        (entry->isHibernated() ? hibernatedEntries : recentlyUsedEntries)
+                .erase(entry->leastRecentlyUsed);
+        bytesHeld -= entry->memorySize;
+        if (entry->isLive) {
+            liveSessionCount--;
+        }
+    }
+    delete entry;
+    return true;
+}
+
+int SessionManager::getSessionCount() const {
+    std::lock_guard<std::mutex> lock(entriesMutex);
+    return (int)entries.size();
+}
+
+int SessionManager::getLiveSessionCount() const {
+    std::lock_guard<std::mutex> lock(entriesMutex);
+    return liveSessionCount;
+}
+
+size_t SessionManager::getBytesHeld() const {
+    std::lock_guard<std::mutex> lock(entriesMutex);
+    return bytesHeld;
+}
@@ -0,0 +1,121 @@
+//
+// Composing sessions of many users under one memory budget.
+//
+
+#ifndef BOBBLE_INDIC2_SESSIONMANAGER_H
+#define BOBBLE_INDIC2_SESSIONMANAGER_H
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ComposingSession.h"
+
+// Keeps one ComposingSession per key (a user, or a text field of a user). The traverse sessions
+// behind them hold nearly all of the memory, so whenever the bytes held exceed the budget, the
+// least recently used sessions that are not in use are hibernated: their traverse session is
+// freed while the word typed so far is kept. Such a session gets a new traverse session on its
+// next query, which restarts the search but returns the same suggestions.
+//
+// Hibernated sessions still hold a small amount of memory. When hibernating every idle session
+// is not enough, the least recently used hibernated sessions are removed, and their keys start
+// over from an empty word on their next use.
+//
+// The budget is enforced when a session is released, so sessions in use may push the total
+// over the budget for as long as they are held.
+class SessionManager {
+private:
+    class Entry {
+    public:
+        Entry(const std::string &key, SuggestionProvider *suggestionProvider, int numSuggestions,
+              SuggestOptions *suggestOptions)
+                : key(key), session(suggestionProvider, numSuggestions, suggestOptions),
+                  useCount(0), isLive(false), memorySize(session.getMemorySize()),
+                  leastRecentlyUsed() {}
+
+        const std::string key;
+        ComposingSession session;
+        // Serializes the users of one key.
+        std::mutex sessionMutex;
+        // Number of ScopedSessions holding or waiting for the session; such entries are
+        // neither hibernated nor removed.
+        int useCount;
+        // Whether the session held a traverse session, and its getMemorySize(), as of the last
+        // release.
+        bool isLive;
+        size_t memorySize;
+        // Position in recentlyUsedEntries, or in hibernatedEntries when isHibernated().
+        std::list<Entry *>::iterator leastRecentlyUsed;
+
+        // Whether the entry is in hibernatedEntries.
+        bool isHibernated() const { return useCount == 0 && !isLive; }
+    };
+
+    SuggestionProvider *const suggestionProvider;
+    const size_t byteBudget;
+    const int numSuggestions;
+    SuggestOptions *const suggestOptions;
+
+    mutable std::mutex entriesMutex;
+    std::unordered_map<std::string, Entry *> entries;
+    // Entries in use or with a live session, most recently used first.
+    std::list<Entry *> recentlyUsedEntries;
+    // The other entries, whose session is hibernated, most recently used first. Kept apart so
+    // that enforcing the budget visits neither them while hibernating nor the live entries
+    // while removing.
+    std::list<Entry *> hibernatedEntries;
+    size_t bytesHeld;
+    int liveSessionCount;
+
+    Entry *acquireEntry(const std::string &key);
+    void releaseEntry(Entry *entry);
+    // Brings the totals and lists up to date with the current state of an entry's session.
+    void updateEntry(Entry *entry);
+    // Hibernates, then removes, least recently used entries while over budget. The removed
+    // entries are added to outRemovedEntries, to be deleted once entriesMutex is released.
+    void enforceBudget(std::vector<Entry *> *outRemovedEntries);
+
+public:
+    // Exclusive use of the session of a key for the lifetime of the object. The session is
+    // created, or woken from hibernation, as needed.
+    class ScopedSession {
+    public:
+        ScopedSession(SessionManager *sessionManager, const std::string &key);
+        ~ScopedSession();
+
+        ComposingSession *get() const { return &entry->session; }
+        ComposingSession *operator->() const { return &entry->session; }
+
+    private:
+        SessionManager *const sessionManager;
+        Entry *const entry;
+
+        ScopedSession(const ScopedSession &) = delete;
+        ScopedSession &operator=(const ScopedSession &) = delete;
+    };
+
+    // suggestOptions, when not null, must outlive the manager, and so must suggestionProvider.
+    SessionManager(SuggestionProvider *suggestionProvider, size_t byteBudget,
+                   int numSuggestions = 3, SuggestOptions *suggestOptions = nullptr);
+    ~SessionManager();
+
+    // Drops the session of a key, for example when its user leaves. Returns false if there is
+    // no such session or it is in use.
+    bool removeSession(const std::string &key);
+
+    // Number of keys with a session, hibernated or not.
+    int getSessionCount() const;
+    // Number of sessions holding a traverse session.
+    int getLiveSessionCount() const;
+    // Approximate bytes held by all sessions, as of their last release.
+    size_t getBytesHeld() const;
+    size_t getByteBudget() const { return byteBudget; }
+
+    SessionManager(const SessionManager &) = delete;
+    SessionManager &operator=(const SessionManager &) = delete;
+};
+
+
+#endif //BOBBLE_INDIC2_SESSIONMANAGER_H
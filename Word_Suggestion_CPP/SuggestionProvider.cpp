@@ -2,80 +2,315 @@
 // Created by bobble on 20/1/17.
 //
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
 #include <iostream>
+#include <mutex>
+#include <thread>
 #include "jsoncpp/json.h"
+#include "libDict/suggest/core/dictionary/property/unigram_property.h"
+#include "libDict/suggest/core/session/prev_words_info.h"
+#include "libDict/suggest/core/suggest_options.h"
+#include "libDict/suggest/policyimpl/dictionary/structure/word_list/word_list_policy.h"
+#include "libDict/utils/work_stealing_pool.h"
 #include "SuggestionProvider.h"
 
-std::vector<std::string> SuggestionProvider::getSuggestions(int numSuggestions, int *inputCodePoints, int inputSize,
-                                                        PrevWordsInfo *prevWordsInfo, SuggestOptions *suggestOptions) {
-    SuggestionResults *outSuggestionResults = new SuggestionResults(numSuggestions);
+namespace {
 
-    int currentCode = inputCodePoints[inputSize - 1];
-    ProximityProvider::KeyCoordinate *coordinate = proximityProvider->getKeyCoordinate(currentCode);
-    mXCoords[inputSize - 1] = (int)coordinate->x;
-    mYCoords[inputSize - 1] = (int)coordinate->y;
+// Orders the previous words by content, so that queries with the same previous words, which
+// may be passed as distinct PrevWordsInfo instances, come together.
+int comparePrevWords(const PrevWordsInfo *left, const PrevWordsInfo *right) {
+    for (int n = 1; n <= MAX_PREV_WORD_COUNT_FOR_N_GRAM; n++) {
+        const int leftCount = left->getNthPrevWordCodePointCount(n);
+        const int rightCount = right->getNthPrevWordCodePointCount(n);
+        if (leftCount != rightCount) {
+            return leftCount < rightCount ? -1 : 1;
+        }
+        const int comparison = memcmp(left->getNthPrevWordCodePoints(n),
+                                      right->getNthPrevWordCodePoints(n), leftCount * sizeof(int));
+        if (comparison != 0) {
+            return comparison;
+        }
+        const bool isLeftBeginningOfSentence = left->isNthPrevWordBeginningOfSentence(n);
+        if (isLeftBeginningOfSentence != right->isNthPrevWordBeginningOfSentence(n)) {
+            return isLeftBeginningOfSentence ? 1 : -1;
+        }
+    }
+    return 0;
+}
+
+}
+
+SuggestionProvider::WordList::WordList(float languageWeight) : languageWeight(languageWeight) {
+    const std::vector<int> locale;
+    const latinime::DictionaryHeaderStructurePolicy::AttributeMap attributeMap;
+    DictionaryStructureWithBufferPolicy::StructurePolicyPtr dictionaryStructureWithBufferPolicy(
+            new latinime::WordListPolicy(locale, &attributeMap));
+    dictionary.reset(new Dictionary(std::move(dictionaryStructureWithBufferPolicy)));
+}
+
+SuggestionProvider::WordList::~WordList() {}
+
+bool SuggestionProvider::WordList::addWord(const int *codePoints, int codePointCount,
+                                           int probability) {
+    if (codePointCount <= 0 || codePointCount > MAX_WORD_LENGTH || probability < 0
+        || probability > MAX_PROBABILITY) {
+        return false;
+    }
+    const std::vector<latinime::UnigramProperty::ShortcutProperty> shortcuts;
+    const latinime::UnigramProperty unigramProperty(false /* representsBeginningOfSentence */,
+                                                    false /* isNotAWord */,
+                                                    false /* isBlacklisted */, probability,
+                                                    NOT_A_TIMESTAMP, 0 /* level */, 0 /* count */,
+                                                    &shortcuts);
+    return dictionary->addUnigramEntry(codePoints, codePointCount, &unigramProperty);
+}
+
+int SuggestionProvider::getSuggestions(int numSuggestions, int *inputCodePoints, int inputSize,
+                                       PrevWordsInfo *prevWordsInfo, SuggestOptions *suggestOptions,
+                                       SuggestionBuffer *outSuggestions, QueryStats *outStats) {
+    return getSuggestions(numSuggestions, inputCodePoints, inputSize, prevWordsInfo,
+                          suggestOptions, nullptr /* wordLists */, 0 /* wordListCount */,
+                          outSuggestions, outStats);
+}
+
+int SuggestionProvider::getSuggestions(int numSuggestions, int *inputCodePoints, int inputSize,
+                                       PrevWordsInfo *prevWordsInfo, SuggestOptions *suggestOptions,
+                                       const WordList *const *wordLists, int wordListCount,
+                                       SuggestionBuffer *outSuggestions, QueryStats *outStats) {
+    DictionaryGroup dictionaries = dictionaryGroup;
+    for (int index = 0; index < wordListCount; index++) {
+        dictionaries.addDictionary(wordLists[index]->dictionary.get(),
+                                   wordLists[index]->languageWeight);
+    }
+    DicTraverseSessionPool::ScopedSession traverseSession(traverseSessionPool);
+    // A query that ends before the search would otherwise leave the stats of the previous one.
+    traverseSession.get()->getQueryStats()->reset();
+    traverseSession.get()->setExpansionThreadCount(expansionThreadCount);
+    traverseSession.get()->setMaxCheckpointCount(maxCheckpointCount);
+    int count = getSuggestions(traverseSession.get(), &dictionaries, numSuggestions,
+                               inputCodePoints, inputSize, prevWordsInfo, suggestOptions,
+                               outSuggestions);
+    if (outStats) {
+        *outStats = *traverseSession.get()->getQueryStats();
+    }
+    return count;
+}
+
+int SuggestionProvider::getSuggestions(DicTraverseSession *traverseSession,
+                                       const DictionaryGroup *dictionaries, int numSuggestions,
+                                       int *inputCodePoints, int inputSize,
+                                       PrevWordsInfo *prevWordsInfo, SuggestOptions *suggestOptions,
+                                       SuggestionBuffer *outSuggestions) {
+    outSuggestions->count = 0;
+    outSuggestions->truncated = false;
+    if (inputSize <= 0 || inputSize > MAX_WORD_LENGTH) {
+        return 0;
+    }
+
+    // Touch points are derived from the input on every call so that no per-call state is kept
+    // in the provider.
+    int xCoords[MAX_WORD_LENGTH];
+    int yCoords[MAX_WORD_LENGTH];
+    getKeyCoordinates(inputCodePoints, inputSize, xCoords, yCoords);
+
+    return getSuggestions(traverseSession, dictionaries, numSuggestions, inputCodePoints, xCoords,
+                          yCoords, inputSize, prevWordsInfo, suggestOptions, outSuggestions);
+}
+
+int SuggestionProvider::getSuggestions(DicTraverseSession *traverseSession,
+                                       const DictionaryGroup *dictionaries, int numSuggestions,
+                                       int *inputCodePoints, int *xCoords, int *yCoords,
+                                       int inputSize, PrevWordsInfo *prevWordsInfo,
+                                       SuggestOptions *suggestOptions,
+                                       SuggestionBuffer *outSuggestions) {
+    SuggestionResults suggestionResults(numSuggestions);
+    int times[MAX_WORD_LENGTH] = {};
+    int pointerIds[MAX_WORD_LENGTH] = {};
 
-    dictionary->getSuggestions(proximityProvider->getProximity(currentCode), traverseSession,
-                               mXCoords, mYCoords, mTimes, mPointerIds,
+    int currentCode = inputCodePoints[inputSize - 1];
+    // Held for the whole query so that the layout cannot be evicted under the search.
+    std::shared_ptr<ProximityInfo> proximityInfo = proximityProvider->acquireProximity(currentCode);
+    if (!proximityInfo) {
+        return 0;
+    }
+    dictionary->getSuggestions(dictionaries, proximityInfo.get(), traverseSession,
+                               xCoords, yCoords, times, pointerIds,
                                inputCodePoints, inputSize, prevWordsInfo, suggestOptions,
-                               LANGUAGE_WEIGHT, outSuggestionResults);
+                               LANGUAGE_WEIGHT, &suggestionResults);
+
+    return outputSuggestions(&suggestionResults, outSuggestions);
+}
+
+void SuggestionProvider::getKeyCoordinates(const int *codePoints, int count, int *outXCoords,
+                                           int *outYCoords) {
+    for (int index = 0; index < count; index++) {
+        ProximityProvider::KeyCoordinate *coordinate =
+                proximityProvider->getKeyCoordinate(codePoints[index]);
+        outXCoords[index] = (int)coordinate->x;
+        outYCoords[index] = (int)coordinate->y;
+    }
+}
+
+int SuggestionProvider::getEmptySuggestions(int numSuggestions, PrevWordsInfo *prevWordsInfo,
+                                            SuggestionBuffer *outSuggestions) {
+    SuggestionResults suggestionResults(numSuggestions);
+
+    dictionary->getPredictions(prevWordsInfo, &suggestionResults);
+
+    return outputSuggestions(&suggestionResults, outSuggestions);
+}
+
+int SuggestionProvider::outputSuggestions(SuggestionResults *suggestionResults,
+                                          SuggestionBuffer *outSuggestions) {
+    const int count = suggestionResults->getSuggestionCount();
+    const SuggestedWord *words = suggestionResults->sortAndGetSuggestedWords();
+
+    for (int index = 0; index < count; index++) {
+        Suggestion &suggestion = outSuggestions->suggestions[index];
+        suggestion.codePointCount = words[index].getCodePointCount();
+        memmove(suggestion.codePoints, words[index].getCodePoint(),
+                sizeof(suggestion.codePoints[0]) * suggestion.codePointCount);
+        suggestion.utf8Length = intArrayToCharArray(suggestion.codePoints, suggestion.codePointCount,
+                                                    suggestion.utf8, NELEMS(suggestion.utf8));
+        suggestion.score = words[index].getScore();
+        suggestion.kind = words[index].getType() & Dictionary::KIND_MASK_KIND;
+        suggestion.flags = words[index].getType() & Dictionary::KIND_MASK_FLAGS;
+    }
+    outSuggestions->count = count;
+    outSuggestions->truncated = suggestionResults->isTruncated();
+
+    return count;
+}
+
+std::vector<std::string> SuggestionProvider::getSuggestions(int numSuggestions, int *inputCodePoints, int inputSize,
+                                                        PrevWordsInfo *prevWordsInfo, SuggestOptions *suggestOptions) {
+    if (inputSize <= 0 || inputSize > MAX_WORD_LENGTH) {
+        return std::vector<std::string>();
+    }
 
-    std::priority_queue<
-            SuggestedWord,
-            std::vector<SuggestedWord>,
-            SuggestedWord::Comparator> words = outSuggestionResults->getSuggestedWords();
+    SuggestionBuffer buffer;
+    getSuggestions(numSuggestions, inputCodePoints, inputSize, prevWordsInfo, suggestOptions, &buffer);
 
     std::vector<std::string> suggestions;
-    std::map<int, std::vector<std::string>, std::greater<int>> sortedMap;
 
-    char inputWordBuf[50];
+    char inputWordBuf[Suggestion::MAX_UTF8_LENGTH];
     intArrayToCharArray(inputCodePoints, inputSize, inputWordBuf, NELEMS(inputWordBuf));
     suggestions.push_back(std::string(inputWordBuf));
 
-    while(!words.empty()) {
-        char buf[50];
-        intArrayToCharArray(words.top().getCodePoint(), words.top().getCodePointCount(), buf, NELEMS(buf));
-        sortedMap[words.top().getScore()].push_back(std::string(buf));
-        words.pop();
-    }
-
-    for (auto iterator = sortedMap.begin(); iterator != sortedMap.end(); iterator++) {
-        for (auto item : iterator->second) {
-            if (item != std::string(inputWordBuf))
-                suggestions.push_back(item);
-        }
+    for (int index = 0; index < buffer.count; index++) {
+        if (strcmp(buffer.suggestions[index].utf8, inputWordBuf) != 0)
+            suggestions.push_back(std::string(buffer.suggestions[index].utf8));
     }
 
     return suggestions;
 }
 
 std::vector<std::string> SuggestionProvider::getEmptySuggestions(int numSuggestions, PrevWordsInfo *prevWordsInfo) {
-    SuggestionResults *outSuggestionResults = new SuggestionResults(numSuggestions);
-
-    dictionary->getPredictions(prevWordsInfo, outSuggestionResults);
-
-    std::priority_queue<
-            SuggestedWord,
-            std::vector<SuggestedWord>,
-            SuggestedWord::Comparator> words = outSuggestionResults->getSuggestedWords();
+    SuggestionBuffer buffer;
+    getEmptySuggestions(numSuggestions, prevWordsInfo, &buffer);
 
     std::vector<std::string> suggestions;
-    std::map<int, std::vector<std::string>, std::greater<int>> sortedMap;
+    for (int index = 0; index < buffer.count; index++) {
+        suggestions.push_back(std::string(buffer.suggestions[index].utf8));
+    }
 
-    while(!words.empty()) {
-        char buf[50];
-        intArrayToCharArray(words.top().getCodePoint(), words.top().getCodePointCount(), buf, NELEMS(buf));
-        sortedMap[words.top().getScore()].push_back(std::string(buf));
-        words.pop();
+    return suggestions;
+}
+
+void SuggestionProvider::getSuggestionsBatch(const BatchInput *inputs, PrevWordsInfo *const *prevWordsInfos,
+                                             int batchSize, const BatchOptions &options,
+                                             SuggestionBuffer *outSuggestions) {
+    if (batchSize <= 0) {
+        return;
     }
+    SuggestOptions defaultSuggestOptions(nullptr, 0);
+    SuggestOptions *suggestOptions = options.suggestOptions ? options.suggestOptions
+                                                            : &defaultSuggestOptions;
+    int workerCount = options.workerCount > 0 ? options.workerCount
+                                              : (int) std::thread::hardware_concurrency();
+    workerCount = std::max(1, workerCount);
+    PrevWordsInfo emptyPrevWordsInfo;
+    auto getPrevWordsInfo = [&](int index) {
+        return prevWordsInfos && prevWordsInfos[index] ? prevWordsInfos[index]
+                                                       : &emptyPrevWordsInfo;
+    };
 
-    for (auto iterator = sortedMap.begin(); iterator != sortedMap.end(); iterator++) {
-        for (auto item : iterator->second) {
-            suggestions.push_back(item);
+    // Sharing prefixes runs the queries in sorted order. Each pool thread starts on a contiguous
+    // share of that order and steals single queries once done, so a query mostly resumes from
+    // the one sorted before it on the same session while the threads still finish together.
+    std::vector<int> order;
+    if (options.sharesPrefixes) {
+        order.resize(batchSize);
+        for (int index = 0; index < batchSize; index++) {
+            order[index] = index;
         }
+        std::sort(order.begin(), order.end(), [&](int left, int right) {
+            const int prevWordsComparison = comparePrevWords(getPrevWordsInfo(left),
+                                                             getPrevWordsInfo(right));
+            if (prevWordsComparison != 0) {
+                return prevWordsComparison < 0;
+            }
+            if (inputs[left].inputSize != inputs[right].inputSize) {
+                return inputs[left].inputSize < inputs[right].inputSize;
+            }
+            const int comparison = inputs[left].inputSize == 0 ? 0
+                    : memcmp(inputs[left].inputCodePoints, inputs[right].inputCodePoints,
+                             inputs[left].inputSize * sizeof(int));
+            return comparison != 0 ? comparison < 0 : left < right;
+        });
     }
 
-    return suggestions;
+    // The pool threads outlive the batch; only one batch runs on them at a time.
+    std::lock_guard<std::mutex> batchLock(batchMutex);
+    if (!batchThreadPool || batchThreadPool->getThreadCount() != workerCount) {
+        delete batchThreadPool;
+        batchThreadPool = new latinime::WorkStealingPool(workerCount);
+    }
+    std::vector<DicTraverseSession *> traverseSessions;
+    for (int index = 0; index < workerCount; index++) {
+        traverseSessions.push_back(batchSessionPool->acquireSession());
+        traverseSessions.back()->setMaxCheckpointCount(maxCheckpointCount);
+        // A query that resumes the one before it gives the suggestions it would give alone,
+        // whichever thread ran it after which query.
+        traverseSessions.back()->setResumesExactlyOnly(true);
+    }
+    std::atomic<bool> hasFailed(false);
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    batchThreadPool->run(batchSize, [&](int position, int threadIndex) {
+        if (hasFailed) {
+            return;
+        }
+        try {
+            const int index = order.empty() ? position : order[position];
+            PrevWordsInfo *prevWordsInfo = getPrevWordsInfo(index);
+            if (inputs[index].inputSize == 0) {
+                getEmptySuggestions(options.numSuggestions, prevWordsInfo,
+                                    &outSuggestions[index]);
+            } else {
+                getSuggestions(traverseSessions[threadIndex], &dictionaryGroup,
+                               options.numSuggestions, inputs[index].inputCodePoints,
+                               inputs[index].inputSize, prevWordsInfo, suggestOptions,
+                               &outSuggestions[index]);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            // Make the other threads skip the queries left.
+            hasFailed = true;
+        }
+    });
+    for (DicTraverseSession *traverseSession : traverseSessions) {
+        batchSessionPool->releaseSession(traverseSession);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
 }
 
 int SuggestionProvider::get_file_size(std::string &path) {
@@ -83,14 +318,15 @@ int SuggestionProvider::get_file_size(std::string &path) {
     return static_cast<int>(in.tellg());
 }
 
-SuggestionProvider::SuggestionProvider(const std::string &dictPath, const std::vector<std::string> &proximityPathVec) {
+SuggestionProvider::SuggestionProvider(const std::string &dictPath, const std::vector<std::string> &proximityPathVec,
+                                       int maxSessionCount, bool lazyLayouts) {
     
     // Create a new proximity provider
-    proximityProvider = new ProximityProvider(proximityPathVec);
+    proximityProvider = new ProximityProvider(proximityPathVec, lazyLayouts);
     
     // Get dict size
     std::string localDictPath = dictPath;
-    int dictSize = get_file_size(localDictPath);
+    dictSize = get_file_size(localDictPath);
     
     // Create dict policy implementation
     DictionaryStructureWithBufferPolicy::StructurePolicyPtr dictionaryStructureWithBufferPolicy(
@@ -99,18 +335,21 @@ SuggestionProvider::SuggestionProvider(const std::string &dictPath, const std::v
     
     // Create dict instance
     dictionary = new Dictionary(std::move(dictionaryStructureWithBufferPolicy));
+    dictionaryGroup = DictionaryGroup(dictionary);
     
     
-    traverseSession = (DicTraverseSession *) DicTraverseSession::getSessionInstance(dictSize);
+    traverseSessionPool = new DicTraverseSessionPool(dictSize, maxSessionCount);
+    batchSessionPool = new DicTraverseSessionPool(dictSize, 0 /* maxSessionCount */);
 }
 
-SuggestionProvider::SuggestionProvider(const std::string &dictPath, const std::string &proximityPath) {
+SuggestionProvider::SuggestionProvider(const std::string &dictPath, const std::string &proximityPath,
+                                       int maxSessionCount, bool lazyLayouts) {
     // Create a new proximity provider
-    proximityProvider = new ProximityProvider(proximityPath);
+    proximityProvider = new ProximityProvider(proximityPath, lazyLayouts);
 
     // Get dict size
     std::string localDictPath = dictPath;
-    int dictSize = get_file_size(localDictPath);
+    dictSize = get_file_size(localDictPath);
 
     // Create dict policy implementation
     DictionaryStructureWithBufferPolicy::StructurePolicyPtr dictionaryStructureWithBufferPolicy(
@@ -119,13 +358,48 @@ SuggestionProvider::SuggestionProvider(const std::string &dictPath, const std::s
 
     // Create dict instance
     dictionary = new Dictionary(std::move(dictionaryStructureWithBufferPolicy));
+    dictionaryGroup = DictionaryGroup(dictionary);
+
+
+    traverseSessionPool = new DicTraverseSessionPool(dictSize, maxSessionCount);
+    batchSessionPool = new DicTraverseSessionPool(dictSize, 0 /* maxSessionCount */);
+}
+
+void SuggestionProvider::setExpansionThreadCount(int threadCount) {
+    expansionThreadCount = std::max(1, threadCount);
+}
+
+void SuggestionProvider::setMaxCheckpointCount(int checkpointCount) {
+    maxCheckpointCount = std::max(0, checkpointCount);
+}
 
+bool SuggestionProvider::addDictionary(const std::string &dictPath, float languageWeight) {
+    if (dictionaryGroup.getDictionaryCount() >= DictionaryGroup::MAX_DICTIONARY_COUNT) {
+        return false;
+    }
+    std::string localDictPath = dictPath;
+    DictionaryStructureWithBufferPolicy::StructurePolicyPtr dictionaryStructureWithBufferPolicy(
+            DictionaryStructureWithBufferPolicyFactory::newPolicyForExistingDictFile(
+                    localDictPath.c_str(), 0, get_file_size(localDictPath), false));
+    if (!dictionaryStructureWithBufferPolicy) {
+        return false;
+    }
+    additionalDictionaries.push_back(new Dictionary(std::move(dictionaryStructureWithBufferPolicy)));
+    dictionaryGroup.addDictionary(additionalDictionaries.back(), languageWeight);
+    return true;
+}
 
-    traverseSession = (DicTraverseSession *) DicTraverseSession::getSessionInstance(dictSize);
+int SuggestionProvider::evictIdleLayouts(std::chrono::milliseconds maxIdleTime) {
+    return proximityProvider->evictIdleLayouts(maxIdleTime);
 }
 
 SuggestionProvider::~SuggestionProvider() {
+    for (Dictionary *additionalDictionary : additionalDictionaries) {
+        delete additionalDictionary;
+    }
     delete dictionary;
-    delete traverseSession;
+    delete traverseSessionPool;
+    delete batchThreadPool;
+    delete batchSessionPool;
     delete proximityProvider;
 }
@@ -5,46 +5,220 @@
 #ifndef BOBBLE_INDIC2_INDICSUGGESTOR_H
 #define BOBBLE_INDIC2_INDICSUGGESTOR_H
 
+#include <chrono>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <fstream>
+#include "libDict/suggest/core/dictionary/dictionary.h"
+#include "libDict/suggest/core/dictionary/dictionary_group.h"
 #include "libDict/suggest/core/layout/proximity_info.h"
 #include "libDict/suggest/core/session/dic_traverse_session.h"
+#include "libDict/suggest/core/session/dic_traverse_session_pool.h"
 #include "libDict/suggest/core/result/suggestion_results.h"
 #include "libDict/suggest/policyimpl/dictionary/structure/dictionary_structure_with_buffer_policy_factory.h"
 #include "ProximityProvider.h"
 
 using latinime::Dictionary;
+using latinime::DictionaryGroup;
 using latinime::SuggestedWord;
 using latinime::ProximityInfo;
 using latinime::PrevWordsInfo;
+using latinime::QueryStats;
 using latinime::SuggestOptions;
 using latinime::SuggestionResults;
 using latinime::DicTraverseSession;
+using latinime::DicTraverseSessionPool;
 using latinime::DictionaryStructureWithBufferPolicy;
 using latinime::DictionaryStructureWithBufferPolicyFactory;
 
+namespace latinime {
+class WorkStealingPool;
+}
+
 class SuggestionProvider {
+    friend class ComposingSession;
+
+public:
+    // One suggestion, both as code points and as null-terminated UTF-8.
+    class Suggestion {
+    public:
+        static const int MAX_UTF8_LENGTH = MAX_WORD_LENGTH * 4 + 1;
+
+        int codePoints[MAX_WORD_LENGTH];
+        int codePointCount;
+        char utf8[MAX_UTF8_LENGTH];
+        int utf8Length;
+        int score;
+        // Dictionary::KIND_* value and Dictionary::KIND_FLAG_* bits of the suggestion.
+        int kind;
+        int flags;
+    };
+
+    // Caller-owned, fixed-capacity output of a query. Suggestions are ordered from the best to
+    // the worst. Reusing one buffer across calls keeps the query path free of heap allocation.
+    class SuggestionBuffer {
+    public:
+        static const int CAPACITY = SuggestionResults::MAX_SUGGESTION_COUNT;
+
+        Suggestion suggestions[CAPACITY];
+        int count = 0;
+        // Whether the search stopped at the deadline or dicNode limit of the suggest options;
+        // the suggestions are then the best found until then.
+        bool truncated = false;
+    };
+
+    // One query of a batch. An input without code points asks for predictions, as
+    // getEmptySuggestions does.
+    class BatchInput {
+    public:
+        int *inputCodePoints;
+        int inputSize;
+    };
+
+    // An in-memory list of words, such as the contacts of the user or the vocabulary of an app,
+    // that a query searches along with the dictionaries; see getSuggestions. A list only
+    // allocates as words are added, about 30 bytes per code point not shared with an earlier
+    // word, so it can be built for the request it applies to. Words must not be added while a
+    // query searches the list.
+    class WordList {
+    public:
+        // languageWeight multiplies the language cost of the words of the list; see
+        // addDictionary.
+        explicit WordList(float languageWeight = 1.0f);
+        ~WordList();
+
+        // Adds a word of 1 to MAX_WORD_LENGTH code points with a probability from 0 to
+        // MAX_PROBABILITY (255). Adding a word again updates its probability.
+        bool addWord(const int *codePoints, int codePointCount, int probability);
+
+    private:
+        friend class SuggestionProvider;
+
+        std::unique_ptr<Dictionary> dictionary;
+        float languageWeight;
+    };
+
+    class BatchOptions {
+    public:
+        int numSuggestions = 3;
+        // nullptr uses default options.
+        SuggestOptions *suggestOptions = nullptr;
+        // Number of worker threads, each with a traverse session of its own. 0 uses one worker
+        // per hardware thread. The threads are kept for the next batch and only started anew
+        // when the count changes.
+        int workerCount = 0;
+        // Runs the queries ordered by previous words, input size and code points, so that a
+        // query resumes the search of the one before it from the last step their shared prefix
+        // decides instead of searching from the root. Worth it for batches with many inputs of
+        // the same size and prefix, such as repeated or misspelled words; the suggestions are
+        // the same either way.
+        bool sharesPrefixes = false;
+    };
+
 private:
     float LANGUAGE_WEIGHT = -1.0f;
 
     int get_file_size(std::string &path);
 
-    int mXCoords[48] = {};
-    int mYCoords[48] = {};
-    int mTimes[48] = {};
-    int mPointerIds[48] = {};
-
     ProximityProvider *proximityProvider;
     Dictionary *dictionary;
-    DicTraverseSession *traverseSession;
+    // Dictionaries added with addDictionary, searched with the main one by every query.
+    std::vector<Dictionary *> additionalDictionaries;
+    // The main dictionary followed by the additional ones.
+    DictionaryGroup dictionaryGroup;
+    DicTraverseSessionPool *traverseSessionPool;
+    // Sessions of batch workers. Kept apart from traverseSessionPool so that a batch neither
+    // waits for nor starves interactive calls; they stay allocated for the next batch.
+    DicTraverseSessionPool *batchSessionPool;
+    // Threads running the batches, made by the first batch. Guarded by batchMutex, which lets
+    // a single batch run at a time.
+    latinime::WorkStealingPool *batchThreadPool = nullptr;
+    std::mutex batchMutex;
+    // Size of the dictionary file, which decides the cache size of new traverse sessions.
+    int dictSize;
+    // Threads expanding each search step of a single query; see setExpansionThreadCount.
+    int expansionThreadCount = 1;
+    // Search steps kept by each traverse session; see setMaxCheckpointCount.
+    int maxCheckpointCount = latinime::DicNodeCheckpoints::DEFAULT_MAX_COUNT;
+
+    int getSuggestions(DicTraverseSession *traverseSession, const DictionaryGroup *dictionaries,
+                       int numSuggestions, int *inputCodePoints, int inputSize,
+                       PrevWordsInfo *prevWordsInfo, SuggestOptions *suggestOptions,
+                       SuggestionBuffer *outSuggestions);
+    // As above, with the touch points of the input already looked up.
+    int getSuggestions(DicTraverseSession *traverseSession, const DictionaryGroup *dictionaries,
+                       int numSuggestions, int *inputCodePoints, int *xCoords, int *yCoords,
+                       int inputSize, PrevWordsInfo *prevWordsInfo, SuggestOptions *suggestOptions,
+                       SuggestionBuffer *outSuggestions);
+    void getKeyCoordinates(const int *codePoints, int count, int *outXCoords, int *outYCoords);
+    int outputSuggestions(SuggestionResults *suggestionResults, SuggestionBuffer *outSuggestions);
 public:
-    SuggestionProvider(const std::string &dictPath, const std::vector<std::string> &proximityPathVec);
-    SuggestionProvider(const std::string &dictPath, const std::string &proximityPath);
+    // The dictionary and layouts are shared read-only by all calls; each call checks a traverse
+    // session out of a pool. maxSessionCount bounds the number of queries running at once
+    // (0 means unbounded). With the default of 1 concurrent calls are serialized.
+    // lazyLayouts builds each layout on first use, see ProximityProvider.
+    SuggestionProvider(const std::string &dictPath, const std::vector<std::string> &proximityPathVec,
+                       int maxSessionCount = 1, bool lazyLayouts = false);
+    SuggestionProvider(const std::string &dictPath, const std::string &proximityPath,
+                       int maxSessionCount = 1, bool lazyLayouts = false);
     ~SuggestionProvider();
+
+    // Splits each search step of getSuggestions and composing session queries across
+    // threadCount threads, giving the same suggestions as a single thread. Batches keep one
+    // thread per query, as they already run queries in parallel. Must not be called while
+    // queries are running.
+    void setExpansionThreadCount(int threadCount);
+
+    // Number of search steps each traverse session keeps, so that a later query on the session
+    // whose input starts like the previous one resumes from a step instead of from the root:
+    // after a code point is appended, deleted or changed. Each step kept costs up to about 50KB
+    // per session. 1 only resumes after an appended code point, 0 never resumes. Must not be
+    // called while queries are running.
+    void setMaxCheckpointCount(int checkpointCount);
+
+    // Adds a dictionary, such as a user dictionary, that every query searches along with the main
+    // one, in the same traversal: the input is matched once and the dictionaries share the search
+    // beam, so a query over several dictionaries costs far less than a query per dictionary.
+    // languageWeight multiplies the language cost of the words of the dictionary: 1 scores them
+    // as those of the main dictionary, less favours them and more demotes them. Up to
+    // DictionaryGroup::MAX_DICTIONARY_COUNT dictionaries and word lists, the main one included,
+    // are searched at once. Returns false when the dictionary cannot be loaded or no more fit.
+    // Must not be called while queries are running.
+    bool addDictionary(const std::string &dictPath, float languageWeight = 1.0f);
+
+    // Releases layouts not used for at least maxIdleTime; see ProximityProvider.
+    int evictIdleLayouts(std::chrono::milliseconds maxIdleTime);
+
+    // Writes at most numSuggestions (capped to SuggestionBuffer::CAPACITY) suggestions into
+    // outSuggestions and returns how many were written. outStats, if not null, receives the
+    // stage timings and search counters of the query.
+    int getSuggestions(int numSuggestions, int *inputCodePoints, int inputSize,
+                       PrevWordsInfo *prevWordsInfo, SuggestOptions *suggestOptions,
+                       SuggestionBuffer *outSuggestions, QueryStats *outStats = nullptr);
+    // As above, also searching wordListCount word lists in the same traversal as the
+    // dictionaries. Lists past the room left by the dictionaries are not searched.
+    int getSuggestions(int numSuggestions, int *inputCodePoints, int inputSize,
+                       PrevWordsInfo *prevWordsInfo, SuggestOptions *suggestOptions,
+                       const WordList *const *wordLists, int wordListCount,
+                       SuggestionBuffer *outSuggestions, QueryStats *outStats = nullptr);
+    // Predictions only come from the main dictionary.
+    int getEmptySuggestions(int numSuggestions, PrevWordsInfo *prevWordsInfo, SuggestionBuffer *outSuggestions);
+
+    // Convenience wrappers returning UTF-8 strings. getSuggestions puts the typed word first.
     std::vector<std::string> getSuggestions(int numSuggestions, int *inputCodePoints, int inputSize,
                                             PrevWordsInfo *prevWordsInfo, SuggestOptions *suggestOptions);
     std::vector<std::string> getEmptySuggestions(int numSuggestions, PrevWordsInfo *prevWordsInfo);
+
+    // Runs batchSize queries on a pool of worker threads sharing the dictionary and layouts.
+    // outSuggestions[i] receives the result of inputs[i] with prevWordsInfos[i] (prevWordsInfos,
+    // or any of its entries, may be null for no previous word). Returns once all are done. The
+    // suggestions do not depend on the worker count or on how the queries are ordered. Batches
+    // called from several threads at once run one after the other.
+    void getSuggestionsBatch(const BatchInput *inputs, PrevWordsInfo *const *prevWordsInfos,
+                             int batchSize, const BatchOptions &options,
+                             SuggestionBuffer *outSuggestions);
 };
 
 
@@ -0,0 +1,244 @@
+//
+// Throughput of SuggestionProvider::getSuggestionsBatch for a growing number of workers.
+//
+// Usage: batchBenchmark <dictionary> <layout directory> [query count] [max workers]
+//
+// Queries are every keystroke prefix of a fixed list of (previous word, typed word) pairs plus
+// one prediction per pair, repeated up to the query count. Each worker count runs the same batch;
+// results are checked against the single worker run.
+//
+// Then, with the most workers, the batch runs as consecutive small batches of 1, 8 and 64
+// queries, one call each. Last, the batch and one of misspellings (each typed word with its
+// last letter replaced by every letter) run with BatchOptions::sharesPrefixes, checked against
+// the same batch run without it.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SuggestionProvider.h"
+#include "libDict/suggest/core/session/prev_words_info.h"
+
+namespace {
+
+const char *const WORD_PAIRS[][2] = {
+        {"", "the"}, {"i", "think"}, {"think", "thst"}, {"going", "to"}, {"to", "the"},
+        {"the", "wrold"}, {"what", "are"}, {"are", "yuo"}, {"you", "doing"}, {"i", "dont"},
+        {"dont", "know"}, {"know", "waht"}, {"how", "abuot"}, {"about", "tomorow"},
+        {"see", "you"}, {"thank", "you"}, {"you", "very"}, {"very", "mcuh"}, {"good", "morning"},
+        {"morning", "evryone"}, {"i", "love"}, {"love", "this"}, {"this", "song"},
+        {"the", "best"}, {"best", "thing"}, {"can", "you"}, {"you", "plese"}, {"please", "help"},
+        {"help", "me"}, {"let", "me"}, {"me", "knwo"}, {"happy", "birthday"}, {"i", "cant"},
+        {"cant", "wait"}, {"wait", "for"}, {"for", "teh"}, {"the", "weekend"}, {"see", "ya"},
+        {"on", "my"}, {"my", "way"}, {"way", "hoem"}, {"what", "time"}, {"time", "is"},
+        {"is", "it"}, {"it", "beautifull"}, {"have", "a"}, {"a", "great"}, {"great", "day"},
+        {"sounds", "good"}, {"good", "idea"}, {"i", "agree"}, {"agree", "with"},
+        {"with", "yuo"}, {"where", "are"}, {"are", "we"}, {"we", "meeting"}, {"at", "the"},
+        {"the", "restaurant"}, {"really", "intresting"}, {"interesting", "article"},
+};
+
+class Query {
+public:
+    std::vector<int> prevWord;
+    std::vector<int> input;
+};
+
+std::vector<int> toCodePoints(const char *word) {
+    return std::vector<int>(word, word + strlen(word));
+}
+
+std::vector<Query> buildQueries(int queryCount) {
+    std::vector<Query> queries;
+    while (queries.size() < (size_t) queryCount) {
+        for (const auto &pair : WORD_PAIRS) {
+            const std::vector<int> prevWord = toCodePoints(pair[0]);
+            const std::vector<int> word = toCodePoints(pair[1]);
+            queries.push_back(Query{prevWord, std::vector<int>()});
+            for (size_t length = 1; length <= word.size(); length++) {
+                queries.push_back(Query{prevWord, std::vector<int>(word.begin(),
+                                                                   word.begin() + length)});
+            }
+        }
+    }
+    queries.resize(queryCount);
+    return queries;
+}
+
+std::vector<Query> buildMisspellingQueries(int queryCount) {
+    std::vector<Query> queries;
+    while (queries.size() < (size_t) queryCount) {
+        for (const auto &pair : WORD_PAIRS) {
+            std::vector<int> word = toCodePoints(pair[1]);
+            for (int letter = 'a'; letter <= 'z'; letter++) {
+                word.back() = letter;
+                queries.push_back(Query{toCodePoints(pair[0]), word});
+            }
+        }
+    }
+    queries.resize(queryCount);
+    return queries;
+}
+
+class Batch {
+public:
+    explicit Batch(const std::vector<Query> &batchQueries) : queries(batchQueries) {
+        prevWordsInfos.reserve(queries.size());
+        for (Query &query : queries) {
+            prevWordsInfos.emplace_back(query.prevWord.data(), (int) query.prevWord.size(),
+                                        false /* isBeginningOfSentence */);
+            prevWordsInfoPointers.push_back(&prevWordsInfos.back());
+            inputs.push_back(SuggestionProvider::BatchInput{query.input.data(),
+                                                            (int) query.input.size()});
+        }
+    }
+
+    int size() const {
+        return (int) queries.size();
+    }
+
+    std::vector<Query> queries;
+    std::vector<PrevWordsInfo> prevWordsInfos;
+    std::vector<PrevWordsInfo *> prevWordsInfoPointers;
+    std::vector<SuggestionProvider::BatchInput> inputs;
+};
+
+// Returns the queries per second of running the batch into output.
+double runBatch(SuggestionProvider &provider, Batch &batch,
+                const SuggestionProvider::BatchOptions &options,
+                std::vector<SuggestionProvider::SuggestionBuffer> &output) {
+    const auto start = std::chrono::steady_clock::now();
+    provider.getSuggestionsBatch(batch.inputs.data(), batch.prevWordsInfoPointers.data(),
+                                 batch.size(), options, output.data());
+    const double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+    return batch.size() / seconds;
+}
+
+// Returns the queries per second of running the batch into output as consecutive batches of
+// sliceSize queries, one call each; shows what a call costs besides its queries.
+double runSlices(SuggestionProvider &provider, Batch &batch, int sliceSize,
+                 const SuggestionProvider::BatchOptions &options,
+                 std::vector<SuggestionProvider::SuggestionBuffer> &output) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int first = 0; first < batch.size(); first += sliceSize) {
+        provider.getSuggestionsBatch(batch.inputs.data() + first,
+                                     batch.prevWordsInfoPointers.data() + first,
+                                     std::min(sliceSize, batch.size() - first), options,
+                                     output.data() + first);
+    }
+    const double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+    return batch.size() / seconds;
+}
+
+bool isSameResult(const SuggestionProvider::SuggestionBuffer &left,
+                  const SuggestionProvider::SuggestionBuffer &right) {
+    if (left.count != right.count) {
+        return false;
+    }
+    for (int index = 0; index < left.count; index++) {
+        if (strcmp(left.suggestions[index].utf8, right.suggestions[index].utf8) != 0
+            || left.suggestions[index].score != right.suggestions[index].score) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <dictionary> <layout directory> [query count] [max workers]\n",
+                argv[0]);
+        return 1;
+    }
+    const int queryCount = argc > 3 ? atoi(argv[3]) : 20000;
+    const int hardwareThreads = std::max(1, (int) std::thread::hardware_concurrency());
+    const int maxWorkers = argc > 4 ? atoi(argv[4]) : hardwareThreads;
+
+    SuggestionProvider provider(argv[1], std::string(argv[2]));
+
+    Batch batch(buildQueries(queryCount));
+    std::vector<SuggestionProvider::SuggestionBuffer> reference(queryCount);
+    std::vector<SuggestionProvider::SuggestionBuffer> results(queryCount);
+    SuggestionProvider::BatchOptions options;
+    options.numSuggestions = 3;
+
+    printf("%d queries, %d hardware threads\n", queryCount, hardwareThreads);
+    printf("%8s %12s %9s %11s %11s\n", "workers", "queries/s", "speedup", "efficiency",
+           "mismatches");
+    std::vector<int> workerCounts;
+    for (int workerCount = 1; workerCount < maxWorkers; workerCount *= 2) {
+        workerCounts.push_back(workerCount);
+    }
+    workerCounts.push_back(maxWorkers);
+
+    double singleWorkerRate = 0.0;
+    for (int workerCount : workerCounts) {
+        options.workerCount = workerCount;
+        std::vector<SuggestionProvider::SuggestionBuffer> &output =
+                workerCount == 1 ? reference : results;
+        // Warm up the worker sessions, then measure.
+        provider.getSuggestionsBatch(batch.inputs.data(), batch.prevWordsInfoPointers.data(),
+                                     std::min(queryCount, workerCount * 64), options,
+                                     output.data());
+        const double rate = runBatch(provider, batch, options, output);
+
+        int mismatches = 0;
+        for (int index = 0; index < queryCount; index++) {
+            if (!isSameResult(output[index], reference[index])) {
+                mismatches++;
+            }
+        }
+        if (workerCount == 1) {
+            singleWorkerRate = rate;
+        }
+        const double speedup = rate / singleWorkerRate;
+        printf("%8d %12.0f %8.2fx %10.0f%% %11d\n", workerCount, rate, speedup,
+               100.0 * speedup / workerCount, mismatches);
+    }
+
+    printf("\nsmall batches, %d workers\n", maxWorkers);
+    printf("%8s %12s %11s\n", "queries", "queries/s", "mismatches");
+    options.workerCount = maxWorkers;
+    for (int sliceSize : {1, 8, 64}) {
+        const double rate = runSlices(provider, batch, sliceSize, options, results);
+        int mismatches = 0;
+        for (int index = 0; index < queryCount; index++) {
+            if (!isSameResult(results[index], reference[index])) {
+                mismatches++;
+            }
+        }
+        printf("%8d %12.0f %11d\n", sliceSize, rate, mismatches);
+    }
+
+    printf("\nprefix sharing, %d workers\n", maxWorkers);
+    printf("%12s %14s %12s %9s %11s\n", "batch", "independent/s", "shared/s", "speedup",
+           "mismatches");
+    Batch misspellingBatch(buildMisspellingQueries(queryCount));
+    const std::pair<const char *, Batch *> batches[] = {
+            {"keystrokes", &batch}, {"misspellings", &misspellingBatch}};
+    options.workerCount = maxWorkers;
+    for (const auto &namedBatch : batches) {
+        options.sharesPrefixes = false;
+        const double independentRate = runBatch(provider, *namedBatch.second, options, reference);
+        options.sharesPrefixes = true;
+        const double sharedRate = runBatch(provider, *namedBatch.second, options, results);
+        int mismatches = 0;
+        for (int index = 0; index < queryCount; index++) {
+            if (!isSameResult(results[index], reference[index])) {
+                mismatches++;
+            }
+        }
+        printf("%12s %14.0f %12.0f %8.2fx %11d\n", namedBatch.first, independentRate,
+               sharedRate, sharedRate / independentRate, mismatches);
+    }
+    return 0;
+}
@@ -0,0 +1,197 @@
+//
+// Per-keystroke latency of ComposingSession against restarting the search on every keystroke.
+//
+// Usage: composingBenchmark <dictionary> <layout directory> [rounds] [checkpoints]
+//
+// Every word of a fixed list is typed one code point at a time. The incremental run appends each
+// code point to one session and asks for suggestions; the restart run resets the session and
+// types the whole prefix again before asking, so every query starts at the root. Latencies are
+// reported per prefix length, together with the number of prefixes whose suggestions differ.
+//
+// Edits are then measured the same way on the whole typed word: backspacing it down to one code
+// point, one query per deleted code point, and changing each of its code points in turn, one
+// query per change, the incremental session resuming from its checkpoints before the edit.
+// checkpoints sets SuggestionProvider::setMaxCheckpointCount(); the memory the incremental
+// session ends up holding is reported last.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ComposingSession.h"
+
+namespace {
+
+const int MAX_LENGTH = 20;
+
+// Typed words, with typos, of 1 to 20 characters.
+const char *const WORDS[] = {
+        "a", "i", "to", "in", "the", "teh", "what", "thsi", "about", "hwere", "people",
+        "tonigth", "because", "beautful", "something", "togehter", "important", "experiance",
+        "everything", "definitely", "understanding", "relationship", "conversations",
+        "responsibility", "congratulations", "recommendations", "misunderstanding",
+        "responsibilities", "internationally", "disproportionately", "characteristically",
+        "internationalization", "incomprehensibility", "counterrevolutionary",
+};
+
+bool isSameResult(const SuggestionProvider::SuggestionBuffer &left,
+                  const SuggestionProvider::SuggestionBuffer &right) {
+    if (left.count != right.count) {
+        return false;
+    }
+    for (int index = 0; index < left.count; index++) {
+        if (strcmp(left.suggestions[index].utf8, right.suggestions[index].utf8) != 0
+            || left.suggestions[index].score != right.suggestions[index].score) {
+            return false;
+        }
+    }
+    return true;
+}
+
+double elapsedMicros(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+            .count();
+}
+
+// Latencies of one kind of keystroke, summed over the measured rounds.
+class Scenario {
+public:
+    explicit Scenario(const char *name) : name(name) {}
+
+    const char *name;
+    double incrementalMicros = 0.0;
+    double restartMicros = 0.0;
+    int queryCount = 0;
+    int mismatches = 0;
+    // Search steps the incremental session did, against the ones of restarts.
+    long incrementalSteps = 0;
+    long restartSteps = 0;
+};
+
+// Asks incremental for suggestions on its word as it is, and restart for the same word typed
+// again from scratch, counting both in scenario unless the round is a warm-up.
+void measure(ComposingSession *incremental, ComposingSession *restart, bool isWarmUp,
+             Scenario *scenario) {
+    SuggestionProvider::SuggestionBuffer incrementalResult;
+    SuggestionProvider::SuggestionBuffer restartResult;
+    QueryStats incrementalStats;
+    QueryStats restartStats;
+
+    auto start = std::chrono::steady_clock::now();
+    incremental->getSuggestions(&incrementalResult, &incrementalStats);
+    const double incrementalTime = elapsedMicros(start);
+
+    start = std::chrono::steady_clock::now();
+    restart->reset();
+    for (int index = 0; index < incremental->getInputSize(); index++) {
+        restart->appendCodePoint(incremental->getInputCodePoints()[index]);
+    }
+    restart->getSuggestions(&restartResult, &restartStats);
+    const double restartTime = elapsedMicros(start);
+
+    if (isWarmUp) {
+        return;
+    }
+    scenario->incrementalMicros += incrementalTime;
+    scenario->restartMicros += restartTime;
+    scenario->queryCount++;
+    scenario->incrementalSteps += incrementalStats.expansionStepCount;
+    scenario->restartSteps += restartStats.expansionStepCount;
+    if (!isSameResult(incrementalResult, restartResult)) {
+        scenario->mismatches++;
+    }
+}
+
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <dictionary> <layout directory> [rounds] [checkpoints]\n",
+                argv[0]);
+        return 1;
+    }
+    const int rounds = argc > 3 ? atoi(argv[3]) : 5;
+
+    SuggestionProvider provider(argv[1], std::string(argv[2]));
+    if (argc > 4) {
+        provider.setMaxCheckpointCount(atoi(argv[4]));
+    }
+    ComposingSession incremental(&provider);
+    ComposingSession restart(&provider);
+
+    std::vector<Scenario> appends;
+    for (int length = 0; length <= MAX_LENGTH; length++) {
+        appends.emplace_back("append");
+    }
+    Scenario backspace("backspace");
+    Scenario edit("edit");
+    SuggestionProvider::SuggestionBuffer wordResult;
+
+    for (int round = 0; round < rounds; round++) {
+        // The first round warms up caches and is not counted.
+        const bool isWarmUp = round == 0;
+        for (const char *word : WORDS) {
+            const int length = std::min((int) strlen(word), MAX_LENGTH);
+            incremental.reset();
+            for (int prefixLength = 1; prefixLength <= length; prefixLength++) {
+                incremental.appendCodePoint(word[prefixLength - 1]);
+                measure(&incremental, &restart, isWarmUp, &appends[prefixLength]);
+            }
+            for (int prefixLength = length - 1; prefixLength >= 1; prefixLength--) {
+                incremental.deleteLast();
+                measure(&incremental, &restart, isWarmUp, &backspace);
+            }
+            // Retypes the word, then changes each code point to the next letter and back.
+            incremental.reset();
+            for (int index = 0; index < length; index++) {
+                incremental.appendCodePoint(word[index]);
+            }
+            incremental.getSuggestions(&wordResult);
+            for (int index = 0; index < length; index++) {
+                const int codePoint = word[index] == 'z' ? 'a' : word[index] + 1;
+                incremental.deleteCodePoint(index);
+                incremental.insertCodePoint(index, codePoint);
+                measure(&incremental, &restart, isWarmUp, &edit);
+                incremental.deleteCodePoint(index);
+                incremental.insertCodePoint(index, word[index]);
+            }
+        }
+    }
+
+    printf("%9s %8s %15s %12s %9s %11s %7s\n", "length", "queries", "incremental us",
+           "restart us", "speedup", "mismatches", "steps");
+    Scenario appendTotal("append");
+    for (int length = 1; length <= MAX_LENGTH; length++) {
+        const Scenario &scenario = appends[length];
+        if (scenario.queryCount == 0) {
+            continue;
+        }
+        appendTotal.incrementalMicros += scenario.incrementalMicros;
+        appendTotal.restartMicros += scenario.restartMicros;
+        appendTotal.queryCount += scenario.queryCount;
+        appendTotal.mismatches += scenario.mismatches;
+        appendTotal.incrementalSteps += scenario.incrementalSteps;
+        appendTotal.restartSteps += scenario.restartSteps;
+        printf("%9d %8d %15.1f %12.1f %8.2fx %11d %6.0f%%\n", length, scenario.queryCount,
+               scenario.incrementalMicros / scenario.queryCount,
+               scenario.restartMicros / scenario.queryCount,
+               scenario.restartMicros / scenario.incrementalMicros, scenario.mismatches,
+               100.0 * scenario.incrementalSteps / scenario.restartSteps);
+    }
+    printf("\n%9s %8s %15s %12s %9s %11s %7s\n", "keystroke", "queries", "incremental us",
+           "restart us", "speedup", "mismatches", "steps");
+    for (const Scenario *scenario : {&appendTotal, &backspace, &edit}) {
+        printf("%9s %8d %15.1f %12.1f %8.2fx %11d %6.0f%%\n", scenario->name,
+               scenario->queryCount, scenario->incrementalMicros / scenario->queryCount,
+               scenario->restartMicros / scenario->queryCount,
+               scenario->restartMicros / scenario->incrementalMicros, scenario->mismatches,
+               100.0 * scenario->incrementalSteps / scenario->restartSteps);
+    }
+    printf("\nincremental session memory: %zu KB\n", incremental.getMemorySize() / 1024);
+    return 0;
+}
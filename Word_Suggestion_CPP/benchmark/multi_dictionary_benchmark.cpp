@@ -0,0 +1,188 @@
+//
+// Cost of searching several dictionaries in one traversal, see SuggestionProvider::addDictionary
+// and SuggestionProvider::WordList.
+//
+// Usage: multiDictionaryBenchmark <dictionary> <pairs file> <layout directory> [rounds]
+//
+// The typed words of the pairs file (see replayBenchmark) are replayed keystroke by keystroke,
+// as replayBenchmark does, on providers searching the main dictionary alone, with a word list of
+// LIST_WORD_COUNT made-up words, and with one to three more copies of the main dictionary, the
+// worst case of a dictionary as large as the main one. The rounds alternate between the providers
+// so that they see the same machine load. Each line gives the mean latency of a query and its
+// ratio to the main dictionary alone, which separate searches of every dictionary would at least
+// multiply by the dictionary count.
+//
+// The made-up words are then typed with two letters swapped, with and without the list: found
+// counts the words among the suggestions. The cost of building the list, which a caller may pay
+// on every request, is measured apart.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "SuggestionProvider.h"
+#include "libDict/suggest/core/session/prev_words_info.h"
+#include "libDict/suggest/core/suggest_options.h"
+
+namespace {
+
+const int LIST_WORD_COUNT = 300;
+const int SUGGESTION_COUNT = 5;
+const int LIST_BUILD_COUNT = 1000;
+
+// Typed words of the pairs file, ASCII only.
+std::vector<std::vector<int>> readTypedWords(const char *path) {
+    std::vector<std::vector<int>> words;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        const std::string word = line.substr(line.find('\t') + 1);
+        if (word.empty() || word.size() > MAX_WORD_LENGTH) {
+            continue;
+        }
+        words.push_back(std::vector<int>(word.begin(), word.end()));
+    }
+    return words;
+}
+
+// Pronounceable words that are not in an English dictionary, such as names.
+std::vector<std::vector<int>> getListWords() {
+    const char *const syllables[] = {"ka", "zo", "mi", "re", "tu", "va", "shi", "lon", "dra",
+                                     "ne", "qui", "bex", "ya", "fo", "rin", "gu"};
+    const int syllableCount = sizeof(syllables) / sizeof(syllables[0]);
+    std::vector<std::vector<int>> words;
+    unsigned int seed = 12345;
+    while ((int) words.size() < LIST_WORD_COUNT) {
+        std::string word;
+        const int length = 2 + (int) ((seed >> 16) % 3);
+        for (int i = 0; i < length; i++) {
+            seed = seed * 1103515245u + 12345u;
+            word += syllables[(seed >> 16) % syllableCount];
+        }
+        words.push_back(std::vector<int>(word.begin(), word.end()));
+    }
+    return words;
+}
+
+class Configuration {
+public:
+    const char *name;
+    std::unique_ptr<SuggestionProvider> provider;
+    const SuggestionProvider::WordList *wordList = nullptr;
+    double nanos = 0;
+    long queries = 0;
+};
+
+int getSuggestions(Configuration *configuration, std::vector<int> &word, int inputSize,
+                   SuggestionProvider::SuggestionBuffer *buffer) {
+    PrevWordsInfo prevWordsInfo;
+    int optionFlags[SuggestOptions::OPTION_COUNT] = {};
+    SuggestOptions suggestOptions(optionFlags, NELEMS(optionFlags));
+    return configuration->provider->getSuggestions(SUGGESTION_COUNT, word.data(), inputSize,
+                                                   &prevWordsInfo, &suggestOptions,
+                                                   &configuration->wordList,
+                                                   configuration->wordList ? 1 : 0, buffer);
+}
+
+int countFound(Configuration *configuration, const std::vector<std::vector<int>> &words) {
+    int found = 0;
+    SuggestionProvider::SuggestionBuffer buffer;
+    for (const std::vector<int> &word : words) {
+        std::vector<int> typo = word;
+        std::swap(typo[1], typo[2]);
+        getSuggestions(configuration, typo, (int) typo.size(), &buffer);
+        for (int i = 0; i < buffer.count; i++) {
+            if (buffer.suggestions[i].codePointCount == (int) word.size()
+                && std::equal(word.begin(), word.end(), buffer.suggestions[i].codePoints)) {
+                found++;
+                break;
+            }
+        }
+    }
+    return found;
+}
+
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        fprintf(stderr, "usage: %s <dictionary> <pairs file> <layout directory> [rounds]\n",
+                argv[0]);
+        return 1;
+    }
+    const std::string dictPath = argv[1];
+    const std::string layoutPath = argv[3];
+    const int rounds = argc > 4 ? atoi(argv[4]) : 3;
+    std::vector<std::vector<int>> typedWords = readTypedWords(argv[2]);
+    const std::vector<std::vector<int>> listWords = getListWords();
+
+    const auto buildStart = std::chrono::steady_clock::now();
+    for (int build = 0; build < LIST_BUILD_COUNT; build++) {
+        SuggestionProvider::WordList wordList;
+        for (const std::vector<int> &word : listWords) {
+            wordList.addWord(word.data(), (int) word.size(), 150 /* probability */);
+        }
+    }
+    const double buildMicros = std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - buildStart).count() / LIST_BUILD_COUNT;
+
+    SuggestionProvider::WordList wordList;
+    for (const std::vector<int> &word : listWords) {
+        wordList.addWord(word.data(), (int) word.size(), 150 /* probability */);
+    }
+
+    const char *const names[] = {"main", "main + list", "2 dictionaries", "3 dictionaries",
+                                 "4 dictionaries"};
+    std::vector<Configuration> configurations(5);
+    for (int index = 0; index < (int) configurations.size(); index++) {
+        Configuration &configuration = configurations[index];
+        configuration.name = names[index];
+        configuration.provider.reset(new SuggestionProvider(dictPath, layoutPath));
+        for (int copy = 1; copy < index; copy++) {
+            configuration.provider->addDictionary(dictPath);
+        }
+        if (index == 1) {
+            configuration.wordList = &wordList;
+        }
+    }
+
+    SuggestionProvider::SuggestionBuffer buffer;
+    for (int round = 0; round <= rounds; round++) {
+        for (Configuration &configuration : configurations) {
+            const auto start = std::chrono::steady_clock::now();
+            long queries = 0;
+            for (std::vector<int> &word : typedWords) {
+                for (int inputSize = 1; inputSize <= (int) word.size(); inputSize++) {
+                    getSuggestions(&configuration, word, inputSize, &buffer);
+                    queries++;
+                }
+            }
+            // The first round warms up.
+            if (round > 0) {
+                configuration.nanos += std::chrono::duration<double, std::nano>(
+                        std::chrono::steady_clock::now() - start).count();
+                configuration.queries += queries;
+            }
+        }
+    }
+
+    printf("%zu typed words, %d rounds, %d words in the list\n", typedWords.size(), rounds,
+           LIST_WORD_COUNT);
+    printf("%-16s %10s %8s\n", "dictionaries", "us/query", "ratio");
+    const double mainMicros = configurations[0].nanos / configurations[0].queries / 1000;
+    for (const Configuration &configuration : configurations) {
+        const double micros = configuration.nanos / configuration.queries / 1000;
+        printf("%-16s %10.1f %7.2fx\n", configuration.name, micros, micros / mainMicros);
+    }
+    printf("list built in %.1f us\n", buildMicros);
+    printf("list words found: %d/%d with the list, %d without\n",
+           countFound(&configurations[1], listWords), LIST_WORD_COUNT,
+           countFound(&configurations[0], listWords));
+    return 0;
+}
@@ -0,0 +1,223 @@
+//
+// Cost of classifying dictionary code points against the proximity code points of a typed input,
+// as ProximityInfoState::getProximityType does for every child dicNode.
+//
+// Usage: proximityBenchmark <layout directory> [rounds]
+//
+// Every word of a fixed list is set up as a typed input. At each of its input points, the code
+// points a child dicNode may carry are classified three ways: by the scan getProximityType did
+// before it compared all the proximity code points at once, by getProximityType and by the batch
+// getProximityTypes. Times are per classification; mismatches count the classifications or
+// proximity indices that differ from the scan.
+//
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ProximityProvider.h"
+#include "libDict/suggest/core/layout/proximity_info.h"
+#include "libDict/suggest/core/layout/proximity_info_state.h"
+#include "libDict/suggest/policyimpl/typing/scoring_params.h"
+#include "libDict/utils/char_utils.h"
+
+using namespace latinime;
+
+namespace {
+
+// Typed words, with typos.
+const char *const WORDS[] = {
+        "a", "i", "to", "in", "the", "teh", "what", "thsi", "about", "hwere", "people",
+        "tonigth", "because", "beautful", "something", "togehter", "important", "experiance",
+        "everything", "definitely", "understanding", "relationship", "conversations",
+};
+
+// Code points of the children of a dicNode: letters, intentional omissions and accented letters.
+std::vector<int> getChildCodePoints() {
+    std::vector<int> codePoints;
+    for (int codePoint = 'a'; codePoint <= 'z'; codePoint++) {
+        codePoints.push_back(codePoint);
+    }
+    const int others[] = {'\'', '-', 0xE0, 0xE7, 0xE8, 0xE9, 0xF1, 0xF6, 0xFC};
+    codePoints.insert(codePoints.end(), others, others + sizeof(others) / sizeof(others[0]));
+    return codePoints;
+}
+
+// The scan of getProximityType before the proximity code points were compared at once. Not
+// inlined, as getProximityType is not.
+__attribute__((noinline)) ProximityType scanProximityType(const int *const currentCodePoints,
+                                                          const int codePoint,
+                                                          int *proximityIndex) {
+    const int firstCodePoint = currentCodePoints[0];
+    const int baseLowerC = CharUtils::toBaseLowerCase(codePoint);
+    if (firstCodePoint == baseLowerC || firstCodePoint == codePoint) {
+        return MATCH_CHAR;
+    }
+    if (CharUtils::toBaseLowerCase(firstCodePoint) == baseLowerC) {
+        return PROXIMITY_CHAR;
+    }
+    int j = 1;
+    while (j < MAX_PROXIMITY_CHARS_SIZE
+           && currentCodePoints[j] > ADDITIONAL_PROXIMITY_CHAR_DELIMITER_CODE) {
+        if (currentCodePoints[j] == baseLowerC || currentCodePoints[j] == codePoint) {
+            *proximityIndex = j;
+            return PROXIMITY_CHAR;
+        }
+        ++j;
+    }
+    if (j < MAX_PROXIMITY_CHARS_SIZE
+        && currentCodePoints[j] == ADDITIONAL_PROXIMITY_CHAR_DELIMITER_CODE) {
+        ++j;
+        while (j < MAX_PROXIMITY_CHARS_SIZE
+               && currentCodePoints[j] > ADDITIONAL_PROXIMITY_CHAR_DELIMITER_CODE) {
+            if (currentCodePoints[j] == baseLowerC || currentCodePoints[j] == codePoint) {
+                *proximityIndex = j;
+                return ADDITIONAL_PROXIMITY_CHAR;
+            }
+            ++j;
+        }
+    }
+    return SUBSTITUTION_CHAR;
+}
+
+class TypedInput {
+public:
+    std::shared_ptr<ProximityInfo> proximityInfo;
+    std::unique_ptr<ProximityInfoState> state;
+    std::vector<int> proximities;
+    int inputSize;
+};
+
+double getNanosPer(std::chrono::steady_clock::time_point start, long count) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+                   .count() / count;
+}
+
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <layout directory> [rounds]\n", argv[0]);
+        return 1;
+    }
+    const int rounds = argc > 2 ? atoi(argv[2]) : 2000;
+    ProximityProvider provider((std::string(argv[1])));
+    const std::vector<int> childCodePoints = getChildCodePoints();
+    const int childCount = (int) childCodePoints.size();
+
+    std::vector<TypedInput> inputs;
+    for (const char *word : WORDS) {
+        TypedInput input;
+        input.inputSize = (int) strlen(word);
+        std::vector<int> codePoints(word, word + input.inputSize);
+        std::vector<int> xs(input.inputSize), ys(input.inputSize);
+        for (int index = 0; index < input.inputSize; index++) {
+            ProximityProvider::KeyCoordinate *coordinate =
+                    provider.getKeyCoordinate(codePoints[index]);
+            xs[index] = (int) coordinate->x;
+            ys[index] = (int) coordinate->y;
+        }
+        input.proximityInfo = provider.acquireProximity(codePoints.back());
+        if (!input.proximityInfo) {
+            fprintf(stderr, "no layout for %s\n", word);
+            return 1;
+        }
+        input.state.reset(new ProximityInfoState());
+        input.state->initInputParams(0 /* pointerId */, ScoringParams::MAX_SPATIAL_DISTANCE,
+                                     input.proximityInfo.get(), codePoints.data(),
+                                     input.inputSize, xs.data(), ys.data(), nullptr, nullptr,
+                                     false /* isGeometric */);
+        input.proximities.resize(MAX_PROXIMITY_CHARS_SIZE * input.inputSize);
+        input.proximityInfo->initializeProximities(codePoints.data(), xs.data(), ys.data(),
+                                                   input.inputSize, input.proximities.data());
+        inputs.push_back(std::move(input));
+    }
+
+    long classifications = 0;
+    int mismatches = 0;
+    for (const TypedInput &input : inputs) {
+        for (int index = 0; index < input.inputSize; index++) {
+            const int *const proximityCodePoints =
+                    &input.proximities[index * MAX_PROXIMITY_CHARS_SIZE];
+            std::vector<ProximityType> batch(childCount);
+            input.state->getProximityTypes(index, childCodePoints.data(), childCount,
+                                           batch.data());
+            for (int child = 0; child < childCount; child++) {
+                int scanIndex = NOT_AN_INDEX;
+                int proximityIndex = NOT_AN_INDEX;
+                const ProximityType type = scanProximityType(proximityCodePoints,
+                                                             childCodePoints[child], &scanIndex);
+                if (type != input.state->getProximityType(index, childCodePoints[child],
+                                                          true, &proximityIndex)
+                    || scanIndex != proximityIndex || type != batch[child]) {
+                    mismatches++;
+                }
+                classifications++;
+            }
+        }
+    }
+
+    // Sums the types so that the compiler keeps the classifications.
+    long checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (const TypedInput &input : inputs) {
+            for (int index = 0; index < input.inputSize; index++) {
+                const int *const proximityCodePoints =
+                        &input.proximities[index * MAX_PROXIMITY_CHARS_SIZE];
+                for (int child = 0; child < childCount; child++) {
+                    int proximityIndex = NOT_AN_INDEX;
+                    checksum += scanProximityType(proximityCodePoints, childCodePoints[child],
+                                                  &proximityIndex);
+                }
+            }
+        }
+    }
+    const double scanNanos = getNanosPer(start, classifications * rounds);
+
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (const TypedInput &input : inputs) {
+            for (int index = 0; index < input.inputSize; index++) {
+                for (int child = 0; child < childCount; child++) {
+                    checksum += input.state->getProximityType(index, childCodePoints[child],
+                                                              true /* checkProximityChars */);
+                }
+            }
+        }
+    }
+    const double singleNanos = getNanosPer(start, classifications * rounds);
+
+    std::vector<ProximityType> types(childCount);
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (const TypedInput &input : inputs) {
+            for (int index = 0; index < input.inputSize; index++) {
+                input.state->getProximityTypes(index, childCodePoints.data(), childCount,
+                                               types.data());
+                checksum += types[index % childCount];
+            }
+        }
+    }
+    const double batchNanos = getNanosPer(start, classifications * rounds);
+
+#if defined(__AVX2__)
+    const char *const instructions = "AVX2";
+#elif defined(__SSE2__)
+    const char *const instructions = "SSE2";
+#else
+    const char *const instructions = "scalar";
+#endif
+    printf("%ld classifications x %d rounds, %s (checksum %ld)\n", classifications, rounds,
+           instructions, checksum);
+    printf("%10s %12s %9s\n", "method", "ns/child", "speedup");
+    printf("%10s %12.2f %8.2fx\n", "scan", scanNanos, 1.0);
+    printf("%10s %12.2f %8.2fx\n", "single", singleNanos, scanNanos / singleNanos);
+    printf("%10s %12.2f %8.2fx\n", "batch", batchNanos, scanNanos / batchNanos);
+    printf("mismatches: %d\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,572 @@
+//
+// End-to-end replay of typing through SuggestionProvider.
+//
+// Usage: replayBenchmark <dictionary> <pairs file> <layout directory | layout files...>
+//                        [--output <json file>] [--suggestions <count>] [--repeat <count>]
+//                        [--warmup <count>] [--label <text>] [--expansion-threads <count>]
+//                        [--adaptive-beam] [--deadlines-us <list>] [--node-budgets <list>]
+//
+// The pairs file has one "previous word<TAB>typed word" pair per line, UTF-8, with an empty
+// previous word for the start of a text. Every pair is replayed keystroke by keystroke: one
+// getSuggestions call per prefix of the typed word, then one getEmptySuggestions call for the
+// prediction after the previous word. The warm-up passes are not measured; the measured passes
+// are repeated --repeat times. --expansion-threads splits the search steps of each query across
+// threads, see SuggestionProvider::setExpansionThreadCount. --adaptive-beam turns on
+// SuggestOptions::useAdaptiveBeam() for all the passes.
+//
+// A summary is printed and the full results are written as JSON (replay_benchmark.json by
+// default): throughput, and count, mean, p50, p90, p99 and max latency in microseconds for all
+// queries, for typing, for typing by input length and for predictions. resultDigest is a hash
+// of all suggestions returned, so two builds can also be checked for giving the same output.
+// typing.typedWordHitRate is the share of typing queries whose suggestions include the whole
+// typed word, a measure of the completion accuracy. typing.allocationsPerQuery is the mean
+// number of heap allocations a typing query makes, counted by the operator new of this program.
+// typing.stages breaks the mean typing query down into the stages and counters of QueryStats,
+// once over all typing queries and once over the slowest 1% of them.
+//
+// --deadlines-us and --node-budgets take comma-separated search budgets (see
+// SuggestOptions::getSearchDeadlineMicros() and getMaxExpandedDicNodeCount()). After the
+// measured passes, one more pass is replayed with each budget, and its typing latency, the share
+// of truncated queries and how well its suggestions agree with those of the unbounded search are
+// reported under "budgets": top1Agreement is the share of queries with the same first
+// suggestion, recall the share of the unbounded suggestions that are also returned. The first
+// entry is a pass without a budget, replayed the same way, to compare the latencies with.
+// continuedSearchRatio and meanExpandedDicNodes show how much a truncated query costs the next
+// one, which cannot resume from the steps it did not finish.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <new>
+#include <string>
+#include <sys/stat.h>
+#include <utility>
+#include <vector>
+
+#include "jsoncpp/json.h"
+#include "SuggestionProvider.h"
+#include "libDict/suggest/core/session/prev_words_info.h"
+#include "libDict/suggest/core/suggest_options.h"
+
+namespace {
+
+// Calls to operator new so far, on any thread.
+std::atomic<uint64_t> allocationCount(0);
+
+class Pair {
+public:
+    std::vector<int> prevWord;
+    std::vector<int> typedWord;
+};
+
+class LatencyRecorder {
+public:
+    void add(double micros) {
+        latencies.push_back(micros);
+    }
+
+    Json::Value toJson() {
+        Json::Value result;
+        result["count"] = (Json::UInt64) latencies.size();
+        if (latencies.empty()) {
+            return result;
+        }
+        std::sort(latencies.begin(), latencies.end());
+        double total = 0.0;
+        for (double latency : latencies) {
+            total += latency;
+        }
+        result["meanUs"] = total / latencies.size();
+        result["p50Us"] = getPercentile(50);
+        result["p90Us"] = getPercentile(90);
+        result["p99Us"] = getPercentile(99);
+        result["maxUs"] = latencies.back();
+        return result;
+    }
+
+private:
+    std::vector<double> latencies;
+
+    // Nearest rank on the sorted latencies.
+    double getPercentile(int percentile) const {
+        size_t rank = (latencies.size() * percentile + 99) / 100;
+        return latencies[std::max<size_t>(rank, 1) - 1];
+    }
+};
+
+// Mean stage timings and counters of a set of queries.
+Json::Value getMeanStats(const std::vector<std::pair<double, QueryStats>> &queries, size_t begin,
+                         size_t end) {
+    Json::Value result;
+    const double count = (double) (end - begin);
+    result["count"] = (Json::UInt64) (end - begin);
+    if (count == 0) {
+        return result;
+    }
+    double latency = 0, sessionInit = 0, proximitySetup = 0, initializeSearch = 0, expansion = 0;
+    double outputSuggestions = 0, expansionSteps = 0, expanded = 0, pushed = 0, evicted = 0;
+    double terminals = 0, continued = 0, beamSizeSum = 0, trimmed = 0;
+    for (size_t index = begin; index < end; index++) {
+        const QueryStats &stats = queries[index].second;
+        latency += queries[index].first;
+        sessionInit += stats.sessionInitNanos;
+        proximitySetup += stats.proximitySetupNanos;
+        initializeSearch += stats.initializeSearchNanos;
+        expansion += stats.expansionNanos;
+        outputSuggestions += stats.outputSuggestionsNanos;
+        expansionSteps += stats.expansionStepCount;
+        expanded += stats.expandedDicNodeCount;
+        pushed += stats.pushedDicNodeCount;
+        evicted += stats.evictedDicNodeCount;
+        terminals += stats.terminalDicNodeCount;
+        continued += stats.isContinuedSearch ? 1 : 0;
+        beamSizeSum += stats.beamSizeSum;
+        trimmed += stats.trimmedDicNodeCount;
+    }
+    result["latencyUs"] = latency / count;
+    result["sessionInitUs"] = sessionInit / count / 1000.0;
+    result["proximitySetupUs"] = proximitySetup / count / 1000.0;
+    result["initializeSearchUs"] = initializeSearch / count / 1000.0;
+    result["expansionUs"] = expansion / count / 1000.0;
+    result["outputSuggestionsUs"] = outputSuggestions / count / 1000.0;
+    result["expansionSteps"] = expansionSteps / count;
+    result["expandedDicNodes"] = expanded / count;
+    result["pushedDicNodes"] = pushed / count;
+    result["evictedDicNodes"] = evicted / count;
+    result["terminalDicNodes"] = terminals / count;
+    result["continuedSearchRatio"] = continued / count;
+    result["meanBeamSize"] = expansionSteps == 0 ? 0.0 : beamSizeSum / expansionSteps;
+    result["trimmedDicNodes"] = trimmed / count;
+    return result;
+}
+
+// Decodes UTF-8, skipping malformed bytes.
+std::vector<int> decodeUtf8(const std::string &text) {
+    std::vector<int> codePoints;
+    for (size_t index = 0; index < text.size();) {
+        const unsigned char lead = (unsigned char) text[index];
+        int length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3
+                : (lead >> 3) == 0x1E ? 4 : 0;
+        if (length == 0 || index + length > text.size()) {
+            index++;
+            continue;
+        }
+        int codePoint = length == 1 ? lead : lead & (0x7F >> length);
+        for (int offset = 1; offset < length; offset++) {
+            codePoint = (codePoint << 6) | (text[index + offset] & 0x3F);
+        }
+        codePoints.push_back(codePoint);
+        index += length;
+    }
+    return codePoints;
+}
+
+bool readPairs(const char *path, std::vector<Pair> *outPairs) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        const size_t tab = line.find('\t');
+        Pair pair;
+        pair.prevWord = decodeUtf8(tab == std::string::npos ? "" : line.substr(0, tab));
+        pair.typedWord = decodeUtf8(tab == std::string::npos ? line : line.substr(tab + 1));
+        if (pair.typedWord.empty() || pair.typedWord.size() > MAX_WORD_LENGTH
+            || pair.prevWord.size() > MAX_WORD_LENGTH) {
+            continue;
+        }
+        outPairs->push_back(pair);
+    }
+    return true;
+}
+
+bool isDirectory(const char *path) {
+    struct stat status;
+    return stat(path, &status) == 0 && S_ISDIR(status.st_mode);
+}
+
+std::vector<int> parseList(const char *text) {
+    std::vector<int> values;
+    for (const char *cursor = text; *cursor;) {
+        char *end = nullptr;
+        const long value = strtol(cursor, &end, 10);
+        if (end == cursor) {
+            break;
+        }
+        values.push_back((int) value);
+        cursor = *end == ',' ? end + 1 : end;
+    }
+    return values;
+}
+
+bool hasWord(const SuggestionProvider::SuggestionBuffer &buffer, const std::vector<int> &word) {
+    for (int index = 0; index < buffer.count; index++) {
+        const SuggestionProvider::Suggestion &suggestion = buffer.suggestions[index];
+        if (suggestion.codePointCount == (int) word.size()
+            && std::equal(word.begin(), word.end(), suggestion.codePoints)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<std::string> getWords(const SuggestionProvider::SuggestionBuffer &buffer) {
+    std::vector<std::string> words;
+    for (int index = 0; index < buffer.count; index++) {
+        words.push_back(buffer.suggestions[index].utf8);
+    }
+    return words;
+}
+
+// Replays the typing queries of all pairs once with the options of the measured passes plus a
+// search budget, and compares the suggestions with fullWords, those of the unbounded search in
+// the same order.
+Json::Value replayWithBudget(SuggestionProvider *provider, std::vector<Pair> &pairs,
+                             int numSuggestions, const int *baseOptionFlags, int optionIndex,
+                             int budget, const std::vector<std::vector<std::string>> &fullWords) {
+    int optionFlags[SuggestOptions::OPTION_COUNT];
+    std::copy(baseOptionFlags, baseOptionFlags + SuggestOptions::OPTION_COUNT, optionFlags);
+    optionFlags[optionIndex] = budget;
+    SuggestOptions suggestOptions(optionFlags, NELEMS(optionFlags));
+    SuggestionProvider::SuggestionBuffer buffer;
+    QueryStats queryStats;
+    LatencyRecorder queries;
+    size_t queryIndex = 0, truncatedCount = 0, top1Count = 0, foundCount = 0, fullCount = 0;
+    size_t continuedCount = 0, expandedCount = 0;
+    for (Pair &pair : pairs) {
+        PrevWordsInfo prevWordsInfo(pair.prevWord.data(), (int) pair.prevWord.size(),
+                                    false /* isBeginningOfSentence */);
+        for (int length = 1; length <= (int) pair.typedWord.size(); length++) {
+            const auto start = std::chrono::steady_clock::now();
+            provider->getSuggestions(numSuggestions, pair.typedWord.data(), length,
+                                     &prevWordsInfo, &suggestOptions, &buffer, &queryStats);
+            queries.add(std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - start).count());
+            const std::vector<std::string> words = getWords(buffer);
+            const std::vector<std::string> &full = fullWords[queryIndex++];
+            truncatedCount += buffer.truncated ? 1 : 0;
+            continuedCount += queryStats.isContinuedSearch ? 1 : 0;
+            expandedCount += queryStats.expandedDicNodeCount;
+            top1Count += words.empty() == full.empty()
+                         && (full.empty() || words[0] == full[0]) ? 1 : 0;
+            for (const std::string &word : full) {
+                foundCount += std::find(words.begin(), words.end(), word) != words.end() ? 1 : 0;
+            }
+            fullCount += full.size();
+        }
+    }
+    Json::Value result = queries.toJson();
+    result[optionIndex == SuggestOptions::SEARCH_DEADLINE_MICROS ? "deadlineUs" : "nodeBudget"] =
+            budget;
+    result["truncatedRatio"] = (double) truncatedCount / queryIndex;
+    result["top1Agreement"] = (double) top1Count / queryIndex;
+    result["recall"] = fullCount == 0 ? 1.0 : (double) foundCount / fullCount;
+    result["continuedSearchRatio"] = (double) continuedCount / queryIndex;
+    result["meanExpandedDicNodes"] = (double) expandedCount / queryIndex;
+    return result;
+}
+
+// FNV-1a over the suggestions and their scores.
+void addToDigest(const SuggestionProvider::SuggestionBuffer &buffer, uint64_t *digest) {
+    for (int index = 0; index < buffer.count; index++) {
+        const SuggestionProvider::Suggestion &suggestion = buffer.suggestions[index];
+        for (int byte = 0; byte < suggestion.utf8Length; byte++) {
+            *digest = (*digest ^ (unsigned char) suggestion.utf8[byte]) * 1099511628211ULL;
+        }
+        *digest = (*digest ^ (uint32_t) suggestion.score) * 1099511628211ULL;
+    }
+    *digest = (*digest ^ 0xFF) * 1099511628211ULL;
+}
+
+void printSummary(const char *name, const Json::Value &stats) {
+    if (stats["count"].asUInt64() == 0) {
+        return;
+    }
+    printf("%-12s %8llu %9.1f %9.1f %9.1f %9.1f %10.1f\n", name,
+           (unsigned long long) stats["count"].asUInt64(), stats["meanUs"].asDouble(),
+           stats["p50Us"].asDouble(), stats["p90Us"].asDouble(), stats["p99Us"].asDouble(),
+           stats["maxUs"].asDouble());
+}
+
+}
+
+// The replacements of the global allocation functions count the allocations. All the forms are
+// replaced so that every delete frees what the matching new allocated, and the deletes are kept
+// out of line: inlined at a new expression, they would show free() on a pointer the compiler
+// knows comes from operator new.
+void *operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *pointer = malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+__attribute__((noinline)) void operator delete(void *pointer) noexcept {
+    free(pointer);
+}
+
+__attribute__((noinline)) void operator delete[](void *pointer) noexcept {
+    free(pointer);
+}
+
+__attribute__((noinline)) void operator delete(void *pointer, size_t) noexcept {
+    free(pointer);
+}
+
+__attribute__((noinline)) void operator delete[](void *pointer, size_t) noexcept {
+    free(pointer);
+}
+
+int main(int argc, char **argv) {
+    std::vector<std::string> positional;
+    std::string outputPath = "replay_benchmark.json";
+    std::string label;
+    int numSuggestions = 3;
+    int repeatCount = 1;
+    int warmupCount = 1;
+    int expansionThreadCount = 1;
+    bool usesAdaptiveBeam = false;
+    std::vector<int> deadlines;
+    std::vector<int> nodeBudgets;
+    for (int index = 1; index < argc; index++) {
+        const std::string argument = argv[index];
+        const bool hasValue = index + 1 < argc;
+        if (argument == "--output" && hasValue) {
+            outputPath = argv[++index];
+        } else if (argument == "--suggestions" && hasValue) {
+            numSuggestions = atoi(argv[++index]);
+        } else if (argument == "--repeat" && hasValue) {
+            repeatCount = std::max(1, atoi(argv[++index]));
+        } else if (argument == "--warmup" && hasValue) {
+            warmupCount = std::max(0, atoi(argv[++index]));
+        } else if (argument == "--label" && hasValue) {
+            label = argv[++index];
+        } else if (argument == "--expansion-threads" && hasValue) {
+            expansionThreadCount = std::max(1, atoi(argv[++index]));
+        } else if (argument == "--adaptive-beam") {
+            usesAdaptiveBeam = true;
+        } else if (argument == "--deadlines-us" && hasValue) {
+            deadlines = parseList(argv[++index]);
+        } else if (argument == "--node-budgets" && hasValue) {
+            nodeBudgets = parseList(argv[++index]);
+        } else {
+            positional.push_back(argument);
+        }
+    }
+    if (positional.size() < 3) {
+        fprintf(stderr, "usage: %s <dictionary> <pairs file> <layout directory | layout files...>\n"
+                        "       [--output <json file>] [--suggestions <count>] [--repeat <count>]\n"
+                        "       [--warmup <count>] [--label <text>] [--expansion-threads <count>]\n"
+                        "       [--adaptive-beam] [--deadlines-us <list>] [--node-budgets <list>]\n",
+                argv[0]);
+        return 1;
+    }
+
+    std::vector<Pair> pairs;
+    if (!readPairs(positional[1].c_str(), &pairs) || pairs.empty()) {
+        fprintf(stderr, "no pairs read from %s\n", positional[1].c_str());
+        return 1;
+    }
+
+    const auto loadStart = std::chrono::steady_clock::now();
+    std::vector<std::string> layoutFiles(positional.begin() + 2, positional.end());
+    SuggestionProvider *provider = layoutFiles.size() == 1 && isDirectory(layoutFiles[0].c_str())
+            ? new SuggestionProvider(positional[0], layoutFiles[0])
+            : new SuggestionProvider(positional[0], layoutFiles);
+    const double loadSeconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - loadStart).count();
+    provider->setExpansionThreadCount(expansionThreadCount);
+
+    int optionFlags[SuggestOptions::OPTION_COUNT] = {};
+    optionFlags[SuggestOptions::USE_ADAPTIVE_BEAM] = usesAdaptiveBeam ? 1 : 0;
+    SuggestOptions suggestOptions(optionFlags, NELEMS(optionFlags));
+    SuggestionProvider::SuggestionBuffer buffer;
+
+    LatencyRecorder allQueries;
+    LatencyRecorder typingQueries;
+    LatencyRecorder predictionQueries;
+    std::map<int, LatencyRecorder> typingQueriesByLength;
+    std::vector<std::pair<double, QueryStats>> typingQueryStats;
+    // Typing suggestions of the first measured pass, which budgeted passes are compared with.
+    std::vector<std::vector<std::string>> fullWords;
+    // Typing queries of that pass whose suggestions include the whole typed word.
+    size_t typedWordHitCount = 0;
+    uint64_t typingAllocationCount = 0;
+    QueryStats queryStats;
+    uint64_t digest = 14695981039346656037ULL;
+    double replaySeconds = 0.0;
+
+    for (int pass = 0; pass < warmupCount + repeatCount; pass++) {
+        const bool isMeasured = pass >= warmupCount;
+        const auto passStart = std::chrono::steady_clock::now();
+        for (Pair &pair : pairs) {
+            PrevWordsInfo prevWordsInfo(pair.prevWord.data(), (int) pair.prevWord.size(),
+                                        false /* isBeginningOfSentence */);
+            for (int length = 1; length <= (int) pair.typedWord.size(); length++) {
+                const uint64_t allocationCountBefore = allocationCount.load();
+                const auto start = std::chrono::steady_clock::now();
+                provider->getSuggestions(numSuggestions, pair.typedWord.data(), length,
+                                         &prevWordsInfo, &suggestOptions, &buffer, &queryStats);
+                const double micros = std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - start).count();
+                if (isMeasured) {
+                    typingAllocationCount += allocationCount.load() - allocationCountBefore;
+                    allQueries.add(micros);
+                    typingQueries.add(micros);
+                    typingQueriesByLength[length].add(micros);
+                    typingQueryStats.push_back(std::make_pair(micros, queryStats));
+                    if (pass == warmupCount) {
+                        addToDigest(buffer, &digest);
+                        fullWords.push_back(getWords(buffer));
+                        typedWordHitCount += hasWord(buffer, pair.typedWord) ? 1 : 0;
+                    }
+                }
+            }
+            const auto start = std::chrono::steady_clock::now();
+            provider->getEmptySuggestions(numSuggestions, &prevWordsInfo, &buffer);
+            const double micros = std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - start).count();
+            if (isMeasured) {
+                allQueries.add(micros);
+                predictionQueries.add(micros);
+                if (pass == warmupCount) {
+                    addToDigest(buffer, &digest);
+                }
+            }
+        }
+        if (isMeasured) {
+            replaySeconds += std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - passStart).count();
+        }
+    }
+
+    Json::Value results;
+    results["label"] = label;
+    results["dictionary"] = positional[0];
+    results["pairsFile"] = positional[1];
+    results["pairCount"] = (Json::UInt64) pairs.size();
+    results["numSuggestions"] = numSuggestions;
+    results["warmupPasses"] = warmupCount;
+    results["measuredPasses"] = repeatCount;
+    results["expansionThreads"] = expansionThreadCount;
+    results["adaptiveBeam"] = usesAdaptiveBeam;
+    results["loadSeconds"] = loadSeconds;
+    results["replaySeconds"] = replaySeconds;
+    results["all"] = allQueries.toJson();
+    results["queriesPerSecond"] = results["all"]["count"].asUInt64() / replaySeconds;
+    results["typing"] = typingQueries.toJson();
+    results["typing"]["typedWordHitRate"] = fullWords.empty()
+            ? 0.0 : (double) typedWordHitCount / fullWords.size();
+    results["typing"]["allocationsPerQuery"] = typingQueryStats.empty()
+            ? 0.0 : (double) typingAllocationCount / typingQueryStats.size();
+    Json::Value &byLength = results["typing"]["byInputLength"];
+    for (auto &lengthAndQueries : typingQueriesByLength) {
+        byLength[std::to_string(lengthAndQueries.first)] = lengthAndQueries.second.toJson();
+    }
+    std::sort(typingQueryStats.begin(), typingQueryStats.end(),
+              [](const std::pair<double, QueryStats> &left,
+                 const std::pair<double, QueryStats> &right) {
+                  return left.first < right.first;
+              });
+    const size_t slowestBegin = typingQueryStats.size() - (typingQueryStats.size() + 99) / 100;
+    results["typing"]["stages"]["all"] = getMeanStats(typingQueryStats, 0, typingQueryStats.size());
+    results["typing"]["stages"]["slowestPercent"] =
+            getMeanStats(typingQueryStats, slowestBegin, typingQueryStats.size());
+    results["prediction"] = predictionQueries.toJson();
+    char digestText[17];
+    snprintf(digestText, sizeof(digestText), "%016llx", (unsigned long long) digest);
+    results["resultDigest"] = digestText;
+    Json::Value &budgets = results["budgets"];
+    budgets = Json::Value(Json::arrayValue);
+    if (!deadlines.empty() || !nodeBudgets.empty()) {
+        // An unbounded pass replayed the same way, to compare the budgets with.
+        budgets.append(replayWithBudget(provider, pairs, numSuggestions, optionFlags,
+                                        SuggestOptions::SEARCH_DEADLINE_MICROS, 0, fullWords));
+    }
+    for (const int deadline : deadlines) {
+        budgets.append(replayWithBudget(provider, pairs, numSuggestions, optionFlags,
+                                        SuggestOptions::SEARCH_DEADLINE_MICROS, deadline,
+                                        fullWords));
+    }
+    for (const int nodeBudget : nodeBudgets) {
+        budgets.append(replayWithBudget(provider, pairs, numSuggestions, optionFlags,
+                                        SuggestOptions::MAX_EXPANDED_DIC_NODE_COUNT, nodeBudget,
+                                        fullWords));
+    }
+
+    std::ofstream out(outputPath);
+    out << Json::StyledWriter().write(results);
+    if (!out) {
+        fprintf(stderr, "could not write %s\n", outputPath.c_str());
+        delete provider;
+        return 1;
+    }
+
+    printf("%zu pairs, %d measured passes, %.0f queries/s, load %.1f ms, digest %s\n", pairs.size(),
+           repeatCount, results["queriesPerSecond"].asDouble(), loadSeconds * 1000.0, digestText);
+    printf("%-12s %8s %9s %9s %9s %9s %10s\n", "queries", "count", "mean us", "p50 us", "p90 us",
+           "p99 us", "max us");
+    printSummary("all", results["all"]);
+    printSummary("typing", results["typing"]);
+    for (auto &lengthAndQueries : typingQueriesByLength) {
+        const std::string length = std::to_string(lengthAndQueries.first);
+        printSummary(("  length " + length).c_str(), byLength[length]);
+    }
+    printSummary("prediction", results["prediction"]);
+    printf("typed word among the typing suggestions: %.2f%%\n",
+           100.0 * results["typing"]["typedWordHitRate"].asDouble());
+    printf("heap allocations per typing query: %.1f\n",
+           results["typing"]["allocationsPerQuery"].asDouble());
+    printf("\n%-16s %9s %9s %9s %9s %9s %9s %9s %9s %9s\n", "typing stages", "init us",
+           "setup us", "search us", "expand us", "output us", "expanded", "evicted", "continued",
+           "beam");
+    for (const char *name : {"all", "slowestPercent"}) {
+        const Json::Value &stages = results["typing"]["stages"][name];
+        if (stages["count"].asUInt64() == 0) {
+            continue;
+        }
+        printf("%-16s %9.1f %9.1f %9.1f %9.1f %9.1f %9.0f %9.0f %8.0f%% %9.1f\n", name,
+               stages["sessionInitUs"].asDouble(), stages["proximitySetupUs"].asDouble(),
+               stages["initializeSearchUs"].asDouble(), stages["expansionUs"].asDouble(),
+               stages["outputSuggestionsUs"].asDouble(), stages["expandedDicNodes"].asDouble(),
+               stages["evictedDicNodes"].asDouble(),
+               100.0 * stages["continuedSearchRatio"].asDouble(),
+               stages["meanBeamSize"].asDouble());
+    }
+    if (budgets.size() > 0) {
+        printf("\n%-16s %9s %9s %9s %10s %9s %9s %10s %9s\n", "typing budget", "mean us",
+               "p50 us", "p99 us", "truncated", "top1", "recall", "continued", "expanded");
+    }
+    for (const Json::Value &budget : budgets) {
+        const std::string name = !budget.isMember("deadlineUs")
+                ? std::to_string(budget["nodeBudget"].asInt()) + " nodes"
+                : budget["deadlineUs"].asInt() == 0 ? "none"
+                : std::to_string(budget["deadlineUs"].asInt()) + " us";
+        printf("%-16s %9.1f %9.1f %9.1f %9.1f%% %8.1f%% %8.1f%% %9.1f%% %9.1f\n", name.c_str(),
+               budget["meanUs"].asDouble(), budget["p50Us"].asDouble(),
+               budget["p99Us"].asDouble(), 100.0 * budget["truncatedRatio"].asDouble(),
+               100.0 * budget["top1Agreement"].asDouble(), 100.0 * budget["recall"].asDouble(),
+               100.0 * budget["continuedSearchRatio"].asDouble(),
+               budget["meanExpandedDicNodes"].asDouble());
+    }
+    printf("results written to %s\n", outputPath.c_str());
+
+    delete provider;
+    return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Per-lookup cost of CodePointMap against the std::map and std::unordered_map it replaces for
+// key code routing. Usage: codePointMapBenchmark [lookup count]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "../utils/code_point_map.h"
+
+using namespace latinime;
+
+namespace {
+
+// Key codes of a typical set of layouts: qwerty, Devanagari, Bengali and an emoji page.
+std::vector<int> getKeyCodes() {
+    std::vector<int> codes;
+    for (int c = 'a'; c <= 'z'; ++c) codes.push_back(c);
+    codes.push_back('\'');
+    codes.push_back('-');
+    codes.push_back(' ');
+    for (int c = 0x0905; c < 0x0905 + 34; ++c) codes.push_back(c);
+    for (int c = 0x0985; c < 0x0985 + 35; ++c) codes.push_back(c);
+    for (int c = 0x1F600; c < 0x1F600 + 160; ++c) codes.push_back(c);
+    return codes;
+}
+
+// Mostly hits in the typed scripts, with some upper case letters, digits and emoji mixed in.
+std::vector<int> getQueries(const std::vector<int> &keyCodes, const int count) {
+    std::vector<int> queries(count);
+    unsigned int seed = 12345;
+    for (int i = 0; i < count; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        const unsigned int r = seed >> 8;
+        switch (r % 10) {
+            case 0: queries[i] = 'A' + static_cast<int>(r % 26); break;
+            case 1: queries[i] = '0' + static_cast<int>(r % 10); break;
+            case 2: queries[i] = 0x1F600 + static_cast<int>(r % 200); break;
+            default: queries[i] = keyCodes[r % (keyCodes.size() - 160)]; break;
+        }
+    }
+    return queries;
+}
+
+template<typename Lookup>
+void run(const char *const name, const std::vector<int> &queries, const Lookup &lookup) {
+    long long checksum = 0;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < queries.size(); ++i) {
+        checksum += lookup(queries[i]);
+    }
+    const double elapsedNs = std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start).count();
+    printf("%-20s %8.2f ns/lookup  (checksum %lld)\n", name, elapsedNs / queries.size(),
+            checksum);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const int lookupCount = argc > 1 ? atoi(argv[1]) : 20000000;
+    const std::vector<int> keyCodes = getKeyCodes();
+    const std::vector<int> queries = getQueries(keyCodes, lookupCount);
+
+    std::map<int, int> orderedMap;
+    std::unordered_map<int, int> hashMap;
+    CodePointMap<int> codePointMap(NOT_AN_INDEX);
+    for (size_t i = 0; i < keyCodes.size(); ++i) {
+        orderedMap[keyCodes[i]] = static_cast<int>(i);
+        hashMap[keyCodes[i]] = static_cast<int>(i);
+        codePointMap.put(keyCodes[i], static_cast<int>(i));
+    }
+    printf("%zu keys, %d dense blocks, %d lookups\n", keyCodes.size(),
+            codePointMap.getBlockCount(), lookupCount);
+
+    std::vector<int> bmpQueries;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        if (queries[i] < 0x10000) bmpQueries.push_back(queries[i]);
+    }
+    const std::vector<int> *const querySets[] = { &queries, &bmpQueries };
+    const char *const querySetNames[] = { "all queries", "BMP queries only" };
+    for (int i = 0; i < 2; ++i) {
+        printf("%s:\n", querySetNames[i]);
+        run("std::map", *querySets[i], [&orderedMap](const int c) {
+            const std::map<int, int>::const_iterator it = orderedMap.find(c);
+            return it != orderedMap.end() ? it->second : NOT_AN_INDEX;
+        });
+        run("std::unordered_map", *querySets[i], [&hashMap](const int c) {
+            const std::unordered_map<int, int>::const_iterator it = hashMap.find(c);
+            return it != hashMap.end() ? it->second : NOT_AN_INDEX;
+        });
+        run("CodePointMap", *querySets[i], [&codePointMap](const int c) {
+            return codePointMap.get(c);
+        });
+    }
+    return 0;
+}
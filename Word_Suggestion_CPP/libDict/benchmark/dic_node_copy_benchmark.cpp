@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Size of DicNode and cost of the node copies of a search, with the output kept in a shared
+// DicNodeOutputArena against the MAX_WORD_LENGTH array each node carried before. Every step,
+// each node of a beam is expanded into a few children, which are copied into the next beam;
+// searches go twelve letters deep. Both layouts must end with the same words.
+// Usage: dicNodeCopyBenchmark [search count]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "../suggest/core/dicnode/dic_node.h"
+#include "../suggest/core/dicnode/internal/dic_node_output_arena.h"
+
+using namespace latinime;
+
+namespace {
+
+// DicNodeStateOutput as it was before the output arena.
+class LegacyDicNodeStateOutput {
+ public:
+    void init() {
+        mOutputtedCodePointCount = 0;
+        mCurrentWordStart = 0;
+        mOutputCodePoints[0] = 0;
+        mPrevWordCount = 0;
+        mPrevWordsLength = 0;
+        mPrevWordStart = 0;
+        mSecondWordFirstInputIndex = NOT_AN_INDEX;
+    }
+
+    void initByCopy(const LegacyDicNodeStateOutput *const stateOutput) {
+        memmove(mOutputCodePoints, stateOutput->mOutputCodePoints,
+                stateOutput->mOutputtedCodePointCount * sizeof(mOutputCodePoints[0]));
+        mOutputtedCodePointCount = stateOutput->mOutputtedCodePointCount;
+        if (mOutputtedCodePointCount < MAX_WORD_LENGTH) {
+            mOutputCodePoints[mOutputtedCodePointCount] = 0;
+        }
+        mCurrentWordStart = stateOutput->mCurrentWordStart;
+        mPrevWordCount = stateOutput->mPrevWordCount;
+        mPrevWordsLength = stateOutput->mPrevWordsLength;
+        mPrevWordStart = stateOutput->mPrevWordStart;
+        mSecondWordFirstInputIndex = stateOutput->mSecondWordFirstInputIndex;
+    }
+
+    void addMergedNodeCodePoints(const uint16_t mergedNodeCodePointCount,
+            const int *const mergedNodeCodePoints) {
+        const int additionalCodePointCount = std::min(static_cast<int>(mergedNodeCodePointCount),
+                MAX_WORD_LENGTH - mOutputtedCodePointCount);
+        memmove(&mOutputCodePoints[mOutputtedCodePointCount], mergedNodeCodePoints,
+                additionalCodePointCount * sizeof(mOutputCodePoints[0]));
+        mOutputtedCodePointCount = static_cast<uint16_t>(
+                mOutputtedCodePointCount + additionalCodePointCount);
+        if (mOutputtedCodePointCount < MAX_WORD_LENGTH) {
+            mOutputCodePoints[mOutputtedCodePointCount] = 0;
+        }
+    }
+
+    const int *getCodePointBuf() const { return mOutputCodePoints; }
+
+ private:
+    uint16_t mOutputtedCodePointCount;
+    int mOutputCodePoints[MAX_WORD_LENGTH];
+    int16_t mCurrentWordStart;
+    int16_t mPrevWordCount;
+    int16_t mPrevWordsLength;
+    int16_t mPrevWordStart;
+    int mSecondWordFirstInputIndex;
+};
+
+// DicNode with the legacy output: the same members, copied the same way.
+class LegacyDicNode {
+ public:
+    void initAsRoot(const int *const prevWordsPtNodePos) {
+        mDicNodeProperties.init(0 /* rootPtNodeArrayPos */, 0 /* dictionaryIndex */,
+                prevWordsPtNodePos);
+        mDicNodeStateInput.init();
+        mDicNodeStateOutput.init();
+        mDicNodeStateScoring.init();
+        mIsCachedForNextSuggestion = false;
+    }
+
+    void initByCopy(const LegacyDicNode *const dicNode) {
+        mIsCachedForNextSuggestion = dicNode->mIsCachedForNextSuggestion;
+        mDicNodeProperties.initByCopy(&dicNode->mDicNodeProperties);
+        mDicNodeStateInput.initByCopy(&dicNode->mDicNodeStateInput);
+        mDicNodeStateOutput.initByCopy(&dicNode->mDicNodeStateOutput);
+        mDicNodeStateScoring.initByCopy(&dicNode->mDicNodeStateScoring);
+    }
+
+    void initAsChild(const LegacyDicNode *const dicNode, const int ptNodePos,
+            const int codePoint) {
+        mIsCachedForNextSuggestion = dicNode->mIsCachedForNextSuggestion;
+        const uint16_t depth = static_cast<uint16_t>(dicNode->mDicNodeProperties.getDepth() + 1);
+        mDicNodeProperties.init(ptNodePos, NOT_A_DICT_POS, codePoint, 100 /* probability */,
+                false /* isTerminal */, true /* hasChildren */, false /* isBlacklisted */, depth,
+                depth, dicNode->mDicNodeProperties.getDictionaryIndex(),
+                dicNode->mDicNodeProperties.getPrevWordsTerminalPtNodePos());
+        mDicNodeStateInput.initByCopy(&dicNode->mDicNodeStateInput);
+        mDicNodeStateOutput.initByCopy(&dicNode->mDicNodeStateOutput);
+        mDicNodeStateScoring.initByCopy(&dicNode->mDicNodeStateScoring);
+        mDicNodeStateOutput.addMergedNodeCodePoints(1, &codePoint);
+    }
+
+    void getOutputCodePoints(const int count, int *const dest) const {
+        memmove(dest, mDicNodeStateOutput.getCodePointBuf(), count * sizeof(dest[0]));
+    }
+
+ private:
+    DicNodeProperties mDicNodeProperties;
+    DicNodeStateInput mDicNodeStateInput;
+    LegacyDicNodeStateOutput mDicNodeStateOutput;
+    DicNodeStateScoring mDicNodeStateScoring;
+    bool mIsCachedForNextSuggestion;
+};
+
+const int BEAM_SIZE = 170;
+const int CHILD_COUNT = 4;
+const int SEARCH_DEPTH = 12;
+const int ROUND_COUNT = 5;
+
+AK_FORCE_INLINE int getChildCodePoint(const int step, const int parentIndex,
+        const int childIndex) {
+    return 'a' + (step * 7 + parentIndex * 13 + childIndex * 5) % 26;
+}
+
+void initAsRoot(const int *const prevWordsPtNodePos, DicNodeOutputArena *const outputArena,
+        DicNode *const root) {
+    outputArena->clear();
+    root->initAsRoot(0 /* rootPtNodeArrayPos */, 0 /* dictionaryIndex */, prevWordsPtNodePos,
+            outputArena);
+}
+
+void initAsRoot(const int *const prevWordsPtNodePos, DicNodeOutputArena *const,
+        LegacyDicNode *const root) {
+    root->initAsRoot(prevWordsPtNodePos);
+}
+
+AK_FORCE_INLINE void prepareForExpansion(DicNode *const dicNode) {
+    dicNode->commitOutputCodePoints();
+}
+
+AK_FORCE_INLINE void prepareForExpansion(LegacyDicNode *const) {}
+
+AK_FORCE_INLINE void initAsChild(const DicNode *const parent, const int ptNodePos,
+        const int codePoint, DicNode *const child) {
+    child->initAsChild(parent, ptNodePos, NOT_A_DICT_POS, 100 /* probability */,
+            false /* isTerminal */, true /* hasChildren */, false /* isBlacklisted */,
+            1 /* mergedNodeCodePointCount */, &codePoint);
+}
+
+AK_FORCE_INLINE void initAsChild(const LegacyDicNode *const parent, const int ptNodePos,
+        const int codePoint, LegacyDicNode *const child) {
+    child->initAsChild(parent, ptNodePos, codePoint);
+}
+
+void getOutputCodePoints(const DicNode *const dicNode, int *const dest) {
+    dicNode->getOutputCodePoints(0 /* start */, SEARCH_DEPTH, dest);
+}
+
+void getOutputCodePoints(const LegacyDicNode *const dicNode, int *const dest) {
+    dicNode->getOutputCodePoints(SEARCH_DEPTH, dest);
+}
+
+// Runs searchCount searches; returns ns per expanded node and sets outWords to the words of
+// the last beam.
+template<typename Node>
+double run(const int searchCount, std::vector<int> *const outWords) {
+    int prevWordsPtNodePos[MAX_PREV_WORD_COUNT_FOR_N_GRAM];
+    for (size_t i = 0; i < NELEMS(prevWordsPtNodePos); ++i) {
+        prevWordsPtNodePos[i] = NOT_A_DICT_POS;
+    }
+    DicNodeOutputArena outputArena;
+    std::vector<Node> beam(BEAM_SIZE);
+    std::vector<Node> nextBeam(BEAM_SIZE);
+    std::vector<Node> children(CHILD_COUNT);
+    Node expanded;
+    long long expandedCount = 0;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int search = 0; search < searchCount; ++search) {
+        initAsRoot(prevWordsPtNodePos, &outputArena, &beam[0]);
+        int beamSize = 1;
+        for (int step = 0; step < SEARCH_DEPTH; ++step) {
+            int nextBeamSize = 0;
+            for (int i = 0; i < beamSize; ++i) {
+                // Popped out of the queue, then expanded.
+                expanded.initByCopy(&beam[i]);
+                prepareForExpansion(&expanded);
+                for (int j = 0; j < CHILD_COUNT; ++j) {
+                    initAsChild(&expanded, i * CHILD_COUNT + j, getChildCodePoint(step, i, j),
+                            &children[j]);
+                }
+                for (int j = 0; j < CHILD_COUNT; ++j) {
+                    // Pushed to the next queue, the oldest node giving way once it is full.
+                    nextBeam[(i * CHILD_COUNT + j) % BEAM_SIZE].initByCopy(&children[j]);
+                }
+                nextBeamSize = std::min(nextBeamSize + CHILD_COUNT, BEAM_SIZE);
+            }
+            expandedCount += beamSize;
+            beam.swap(nextBeam);
+            beamSize = nextBeamSize;
+        }
+    }
+    const double elapsedNs = std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start).count();
+    outWords->assign(BEAM_SIZE * SEARCH_DEPTH, 0);
+    for (int i = 0; i < BEAM_SIZE; ++i) {
+        getOutputCodePoints(&beam[i], &(*outWords)[i * SEARCH_DEPTH]);
+    }
+    return elapsedNs / static_cast<double>(expandedCount);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const int searchCount = argc > 1 ? atoi(argv[1]) : 300;
+    printf("%-20s %8s %8s\n", "sizeof", "legacy", "arena");
+    printf("%-20s %8zu %8zu\n", "DicNodeStateOutput", sizeof(LegacyDicNodeStateOutput),
+            sizeof(DicNodeStateOutput));
+    printf("%-20s %8zu %8zu\n", "DicNode", sizeof(LegacyDicNode), sizeof(DicNode));
+    printf("  of which properties %zu, input %zu, scoring %zu\n", sizeof(DicNodeProperties),
+            sizeof(DicNodeStateInput), sizeof(DicNodeStateScoring));
+    std::vector<int> legacyWords;
+    std::vector<int> words;
+    // Best of a few alternating rounds, to keep other load out of the comparison.
+    double legacyNs = 0.0;
+    double ns = 0.0;
+    for (int round = 0; round < ROUND_COUNT; ++round) {
+        const double legacyRoundNs = run<LegacyDicNode>(searchCount, &legacyWords);
+        const double roundNs = run<DicNode>(searchCount, &words);
+        legacyNs = round == 0 ? legacyRoundNs : std::min(legacyNs, legacyRoundNs);
+        ns = round == 0 ? roundNs : std::min(ns, roundNs);
+    }
+    printf("best of %d rounds of %d searches, beam %d, %d children per node, depth %d\n",
+            ROUND_COUNT, searchCount, BEAM_SIZE, CHILD_COUNT, SEARCH_DEPTH);
+    printf("%-20s %8.1f %8.1f %7.2fx\n", "ns per expansion", legacyNs, ns, legacyNs / ns);
+    if (words != legacyWords) {
+        printf("output words differ\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Cost of one expansion step of DicNodePriorityQueue against the std::priority_queue of pooled
+// node pointers it replaces: a beam of candidates four times its size is offered, then every
+// survivor is taken out worst first. Both queues must hand out the same nodes in the same order,
+// up to the order of nodes that compare() cannot tell apart.
+// Usage: dicNodeQueueBenchmark [step count per beam size]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <queue>
+#include <vector>
+
+#include "../suggest/core/dicnode/dic_node.h"
+#include "../suggest/core/dicnode/dic_node_priority_queue.h"
+#include "../suggest/core/dicnode/dic_node_utils.h"
+#include "../suggest/core/policy/weighting.h"
+#include "../suggest/core/session/dic_traverse_session.h"
+
+using namespace latinime;
+
+namespace {
+
+// The queue as it was before the min-max heap: candidates are copied into the pool before
+// they are compared, compared through pointers, and copied out again when popped.
+class LegacyDicNodePriorityQueue {
+ public:
+    explicit LegacyDicNodePriorityQueue(const int capacity)
+            : mMaxSize(capacity), mDicNodes(capacity + 1), mPooledDicNodes(), mDicNodesQueue() {
+        for (DicNode &dicNode : mDicNodes) {
+            mPooledDicNodes.push_back(&dicNode);
+        }
+    }
+
+    bool copyPush(const DicNode *const dicNode) {
+        if (mPooledDicNodes.empty()) {
+            return false;
+        }
+        DicNode *const pooledDicNode = mPooledDicNodes.back();
+        mPooledDicNodes.pop_back();
+        DicNodeUtils::initByCopy(dicNode, pooledDicNode);
+        if (static_cast<int>(mDicNodesQueue.size()) < mMaxSize) {
+            mDicNodesQueue.push(pooledDicNode);
+            return true;
+        }
+        if (pooledDicNode->compare(mDicNodesQueue.top())) {
+            mPooledDicNodes.push_back(mDicNodesQueue.top());
+            mDicNodesQueue.pop();
+            mDicNodesQueue.push(pooledDicNode);
+            return false;
+        }
+        mPooledDicNodes.push_back(pooledDicNode);
+        return false;
+    }
+
+    void copyPop(DicNode *const dest) {
+        DicNode *const node = mDicNodesQueue.top();
+        DicNodeUtils::initByCopy(node, dest);
+        mPooledDicNodes.push_back(node);
+        mDicNodesQueue.pop();
+    }
+
+    int getSize() const { return static_cast<int>(mDicNodesQueue.size()); }
+
+ private:
+    struct DicNodeComparator {
+        bool operator()(const DicNode *left, const DicNode *right) const {
+            return left->compare(right);
+        }
+    };
+
+    const int mMaxSize;
+    std::vector<DicNode> mDicNodes;
+    std::deque<DicNode *> mPooledDicNodes;
+    std::priority_queue<DicNode *, std::vector<DicNode *>, DicNodeComparator> mDicNodesQueue;
+};
+
+// Gives each node the cost and error type set up before the call, so that candidates get the
+// distances a search would give them without a dictionary or a layout.
+class FixedCostWeighting : public Weighting {
+ public:
+    FixedCostWeighting() : mCost(0.0f), mErrorType(ErrorTypeUtils::NOT_AN_ERROR) {}
+
+    void addCost(const DicTraverseSession *const traverseSession, const DicNode *const parent,
+            DicNode *const dicNode, const float cost, const ErrorTypeUtils::ErrorType errorType) {
+        mCost = cost;
+        mErrorType = errorType;
+        addCostAndForwardInputIndex(static_cast<const Weighting *>(this), CT_SUBSTITUTION,
+                traverseSession, parent, dicNode, nullptr /* multiBigramMap */);
+    }
+
+ protected:
+    float getTerminalSpatialCost(const DicTraverseSession *const,
+            const DicNode *const) const { return 0.0f; }
+    float getOmissionCost(const DicNode *const, const DicNode *const) const { return 0.0f; }
+    float getMatchedCost(const DicTraverseSession *const, const DicNode *const,
+            DicNode_InputStateG *) const { return 0.0f; }
+    bool isProximityDicNode(const DicTraverseSession *const, const DicNode *const) const {
+        return false;
+    }
+    float getTranspositionCost(const DicTraverseSession *const, const DicNode *const,
+            const DicNode *const) const { return 0.0f; }
+    float getInsertionCost(const DicTraverseSession *const, const DicNode *const,
+            const DicNode *const) const { return 0.0f; }
+    float getNewWordSpatialCost(const DicTraverseSession *const, const DicNode *const,
+            DicNode_InputStateG *const) const { return 0.0f; }
+    float getNewWordBigramLanguageCost(const DicTraverseSession *const, const DicNode *const,
+            MultiBigramMap *const) const { return 0.0f; }
+    float getCompletionCost(const DicTraverseSession *const, const DicNode *const) const {
+        return 0.0f;
+    }
+    float getTerminalInsertionCost(const DicTraverseSession *const, const DicNode *const) const {
+        return 0.0f;
+    }
+    float getTerminalLanguageCost(const DicTraverseSession *const, const DicNode *const,
+            float) const { return 0.0f; }
+    bool needsToNormalizeCompoundDistance() const { return false; }
+    float getAdditionalProximityCost() const { return 0.0f; }
+    float getSubstitutionCost() const { return mCost; }
+    float getSpaceSubstitutionCost(const DicTraverseSession *const,
+            const DicNode *const) const { return 0.0f; }
+    ErrorTypeUtils::ErrorType getErrorType(const CorrectionType, const DicTraverseSession *const,
+            const DicNode *const, const DicNode *const) const { return mErrorType; }
+
+ private:
+    float mCost;
+    ErrorTypeUtils::ErrorType mErrorType;
+};
+
+// Candidates of one to eight letters. Distances are quantized so that some of them tie and
+// have to be told apart by the letters, and about one in sixteen is an exact match.
+std::vector<DicNode> getCandidates(const int count, DicNodeOutputArena *const outputArena) {
+    DicTraverseSession traverseSession(false /* usesLargeCache */);
+    FixedCostWeighting weighting;
+    int prevWordsPtNodePos[MAX_PREV_WORD_COUNT_FOR_N_GRAM];
+    for (size_t i = 0; i < NELEMS(prevWordsPtNodePos); ++i) {
+        prevWordsPtNodePos[i] = NOT_A_DICT_POS;
+    }
+    DicNode root;
+    root.initAsRoot(0 /* rootPtNodeArrayPos */, 0 /* dictionaryIndex */, prevWordsPtNodePos,
+            outputArena);
+    std::vector<DicNode> candidates(count);
+    unsigned int seed = 12345;
+    for (int i = 0; i < count; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        const unsigned int r = seed >> 8;
+        int codePoints[8];
+        const uint16_t codePointCount = static_cast<uint16_t>(1 + r % 8);
+        for (int j = 0; j < codePointCount; ++j) {
+            codePoints[j] = 'a' + static_cast<int>((r >> (j + 3)) % 26);
+        }
+        DicNode *const candidate = &candidates[i];
+        candidate->initAsChild(&root, i /* ptNodePos */, NOT_A_DICT_POS, 100 /* probability */,
+                false /* isTerminal */, true /* hasChildren */, false /* isBlacklisted */,
+                codePointCount, codePoints);
+        const bool isExactMatch = (r >> 12) % 16 == 0;
+        weighting.addCost(&traverseSession, &root, candidate,
+                static_cast<float>((r >> 4) % 4000) / 1000.0f,
+                isExactMatch ? ErrorTypeUtils::NOT_AN_ERROR : ErrorTypeUtils::EDIT_CORRECTION);
+    }
+    return candidates;
+}
+
+// What compare() looks at: nodes with the same key are interchangeable.
+unsigned long long getOrderKey(const DicNode *const dicNode) {
+    int codePoints[MAX_WORD_LENGTH];
+    const int codePointCount = dicNode->getTotalNodeCodePointCount();
+    dicNode->getOutputCodePoints(0 /* start */, codePointCount, codePoints);
+    unsigned long long key = static_cast<unsigned long long>(
+            dicNode->getNormalizedCompoundDistance() * 1000000.0f);
+    for (int i = 0; i < codePointCount; ++i) {
+        key = key * 131 + static_cast<unsigned long long>(codePoints[i]);
+    }
+    return key;
+}
+
+// Offers beamSize * 4 candidates per step and pops every survivor; returns ns per step and
+// sets outChecksum from what was popped.
+template<typename Queue, typename Pop>
+double run(Queue *const queue, const std::vector<DicNode> &candidates, const int beamSize,
+        const int stepCount, const Pop &pop, unsigned long long *const outChecksum) {
+    const int offerCount = beamSize * 4;
+    const int candidateCount = static_cast<int>(candidates.size());
+    unsigned long long checksum = 0;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int step = 0; step < stepCount; ++step) {
+        const int offset = (step * 7919) % candidateCount;
+        for (int i = 0; i < offerCount; ++i) {
+            queue->copyPush(&candidates[(offset + i) % candidateCount]);
+        }
+        while (queue->getSize() > 0) {
+            const DicNode *const dicNode = pop(queue);
+            checksum = checksum * 31 + getOrderKey(dicNode);
+        }
+    }
+    const double elapsedNs = std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start).count();
+    *outChecksum = checksum;
+    return elapsedNs / stepCount;
+}
+
+const int ROUND_COUNT = 5;
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const int stepCount = argc > 1 ? atoi(argv[1]) : 4000;
+    DicNodeOutputArena outputArena;
+    const std::vector<DicNode> candidates = getCandidates(5000, &outputArena);
+    // SMALL and LARGE_PRIORITY_QUEUE_CAPACITY, and one in between.
+    const int beamSizes[] = { 100, 170, 310 };
+    printf("sizeof(DicNode) %zu, best of %d rounds of %d steps, 4x beam size offered per step\n",
+            sizeof(DicNode), ROUND_COUNT, stepCount);
+    printf("%6s %16s %16s %8s\n", "beam", "legacy us/step", "heap us/step", "speedup");
+    int mismatchCount = 0;
+    for (const int beamSize : beamSizes) {
+        DicNode scratch;
+        LegacyDicNodePriorityQueue legacyQueue(beamSize);
+        DicNodePool dicNodePool(beamSize + 2);
+        DicNodePriorityQueue queue(beamSize, &dicNodePool);
+        unsigned long long legacyChecksum = 0;
+        unsigned long long checksum = 0;
+        // Best of a few alternating rounds, to keep other load out of the comparison.
+        double legacyNs = 0.0;
+        double ns = 0.0;
+        for (int round = 0; round < ROUND_COUNT; ++round) {
+            const double legacyRoundNs = run(&legacyQueue, candidates, beamSize, stepCount,
+                    [&scratch](LegacyDicNodePriorityQueue *const queue) {
+                        queue->copyPop(&scratch);
+                        return &scratch;
+                    }, &legacyChecksum);
+            const double roundNs = run(&queue, candidates, beamSize, stepCount,
+                    [](DicNodePriorityQueue *const queue) { return queue->pop(); }, &checksum);
+            legacyNs = round == 0 ? legacyRoundNs : std::min(legacyNs, legacyRoundNs);
+            ns = round == 0 ? roundNs : std::min(ns, roundNs);
+        }
+        if (checksum != legacyChecksum) {
+            mismatchCount++;
+        }
+        printf("%6d %16.2f %16.2f %7.2fx%s\n", beamSize, legacyNs / 1000.0, ns / 1000.0,
+                legacyNs / ns, checksum == legacyChecksum ? "" : "  (pop order differs)");
+    }
+    return mismatchCount == 0 ? 0 : 1;
+}
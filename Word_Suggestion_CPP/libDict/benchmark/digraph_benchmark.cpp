@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Per-child cost of the digraph check of the expansion loop: DigraphUtils::hasDigraphForCodePoint()
+// on the dictionary header against the table of DigraphCodePoints, for a dictionary without
+// digraphs and one with German umlaut processing, on the code points of German words. Exits with 1
+// if the two disagree on any code point.
+// Usage: digraphBenchmark [check count]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "../suggest/core/dictionary/digraph_code_points.h"
+#include "../suggest/core/dictionary/digraph_utils.h"
+#include "../suggest/policyimpl/dictionary/header/header_policy.h"
+#include "../suggest/policyimpl/dictionary/header/header_read_write_utils.h"
+
+using namespace latinime;
+
+namespace {
+
+// Compares the table with DigraphUtils on every code point and a few invalid ones.
+int countMismatches(const HeaderPolicy *const headerPolicy) {
+    const DigraphCodePoints digraphCodePoints(headerPolicy);
+    int mismatches = 0;
+    bool hasDigraphs = false;
+    for (int codePoint = -2; codePoint <= 0x10FFFF + 1; ++codePoint) {
+        const bool hasDigraph = DigraphUtils::hasDigraphForCodePoint(headerPolicy, codePoint);
+        hasDigraphs |= hasDigraph;
+        if (digraphCodePoints.hasDigraphForCodePoint(codePoint) != hasDigraph) {
+            ++mismatches;
+        }
+    }
+    if (digraphCodePoints.hasDigraphs() != hasDigraphs) {
+        ++mismatches;
+    }
+    return mismatches;
+}
+
+// The letters of dictionary nodes in German words, umlauts and sharp s included.
+std::vector<int> getCodePoints(const int count) {
+    static const int LETTERS[] = { 'e', 'n', 'i', 's', 'r', 'a', 't', 'd', 'h', 'u', 'l', 'c',
+            'g', 'm', 'o', 'b', 'w', 'f', 'k', 'z', 'p', 'v', 0xFC, 0xE4, 0xF6, 0xDF, 'E', 'S',
+            'D', 'A', 0xDC };
+    std::vector<int> codePoints;
+    unsigned int seed = 12345;
+    for (int i = 0; i < count; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        codePoints.push_back(LETTERS[(seed >> 8) % NELEMS(LETTERS)]);
+    }
+    return codePoints;
+}
+
+template<typename HasDigraph>
+double run(const std::vector<int> &codePoints, const HasDigraph &hasDigraph, int *checksum) {
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (const int codePoint : codePoints) {
+        *checksum += hasDigraph(codePoint) ? 1 : 0;
+    }
+    return std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start).count() / codePoints.size();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const int checkCount = argc > 1 ? atoi(argv[1]) : 10000000;
+    const std::vector<int> locale;
+    DictionaryHeaderStructurePolicy::AttributeMap attributeMap;
+    const HeaderPolicy plainHeaderPolicy(FormatUtils::VERSION_4, locale, &attributeMap);
+    HeaderReadWriteUtils::setBoolAttribute(&attributeMap, "REQUIRES_GERMAN_UMLAUT_PROCESSING",
+            true);
+    const HeaderPolicy germanHeaderPolicy(FormatUtils::VERSION_4, locale, &attributeMap);
+
+    const HeaderPolicy *const headerPolicies[] = { &plainHeaderPolicy, &germanHeaderPolicy };
+    const char *const names[] = { "none", "german" };
+    const std::vector<int> codePoints = getCodePoints(checkCount);
+    printf("%d checks\n", checkCount);
+    printf("%-8s %13s %9s %8s\n", "digraphs", "DigraphUtils", "table", "ratio");
+    int checksum = 0;
+    int mismatches = 0;
+    for (int i = 0; i < 2; ++i) {
+        const HeaderPolicy *const headerPolicy = headerPolicies[i];
+        mismatches += countMismatches(headerPolicy);
+        const DigraphCodePoints digraphCodePoints(headerPolicy);
+        const double utilsNs = run(codePoints, [headerPolicy](const int codePoint) {
+            return DigraphUtils::hasDigraphForCodePoint(headerPolicy, codePoint);
+        }, &checksum);
+        const double tableNs = run(codePoints, [&digraphCodePoints](const int codePoint) {
+            return digraphCodePoints.hasDigraphForCodePoint(codePoint);
+        }, &checksum);
+        printf("%-8s %10.2f ns %6.2f ns %7.1fx\n", names[i], utilsNs, tableNs,
+                utilsNs / tableNs);
+    }
+    printf("checksum %d, mismatches %d\n", checksum, mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Per-pair cost of the unit-cost Damerau-Levenshtein distance: the table of
+// EditDistance::getEditDistance() on DamerauLevenshteinEditDistancePolicy against the bit-parallel
+// getDamerauLevenshteinDistance() and getDamerauLevenshteinDistanceWithin(), for typed words and
+// the dictionary words they are compared to. Exits with 1 if any of them disagree.
+// Usage: editDistanceBenchmark [pair count]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "../suggest/policyimpl/utils/damerau_levenshtein_edit_distance_policy.h"
+#include "../suggest/policyimpl/utils/edit_distance.h"
+
+using namespace latinime;
+
+namespace {
+
+struct WordPair {
+    std::vector<int> word0;
+    std::vector<int> word1;
+};
+
+unsigned int nextRandom(unsigned int *const seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    return *seed >> 8;
+}
+
+// Letters of a small alphabet, with upper case and accented forms, so that words share letters
+// and repeat them as real words do.
+int getLetter(const unsigned int r) {
+    static const int LETTERS[] = { 'a', 'e', 'i', 'n', 'o', 'r', 's', 't', 'h', 'l', 'c', 'd' };
+    const int letter = LETTERS[r % NELEMS(LETTERS)];
+    switch ((r >> 8) % 32) {
+        case 0: return letter - 'a' + 'A';
+        case 1: return letter == 'e' ? 0xE9 : letter;
+        default: return letter;
+    }
+}
+
+// A word of length letters and a copy with up to maxEditCount typos: substitutions, omissions,
+// insertions and transpositions.
+WordPair getWordPair(const int length, const int maxEditCount, unsigned int *const seed) {
+    WordPair pair;
+    for (int i = 0; i < length; ++i) {
+        pair.word0.push_back(getLetter(nextRandom(seed)));
+    }
+    pair.word1 = pair.word0;
+    const int editCount = static_cast<int>(nextRandom(seed) % (maxEditCount + 1));
+    for (int e = 0; e < editCount && !pair.word1.empty(); ++e) {
+        const unsigned int r = nextRandom(seed);
+        const int at = static_cast<int>((r >> 4) % pair.word1.size());
+        switch (r % 4) {
+            case 0: pair.word1[at] = getLetter(r >> 12); break;
+            case 1: pair.word1.erase(pair.word1.begin() + at); break;
+            case 2: pair.word1.insert(pair.word1.begin() + at, getLetter(r >> 12)); break;
+            default:
+                if (at + 1 < static_cast<int>(pair.word1.size())) {
+                    std::swap(pair.word1[at], pair.word1[at + 1]);
+                }
+                break;
+        }
+    }
+    return pair;
+}
+
+int getTableDistance(const WordPair &pair) {
+    const DamerauLevenshteinEditDistancePolicy policy(pair.word0.data(),
+            static_cast<int>(pair.word0.size()), pair.word1.data(),
+            static_cast<int>(pair.word1.size()));
+    return static_cast<int>(EditDistance::getEditDistance(&policy));
+}
+
+int getBitParallelDistance(const WordPair &pair) {
+    return EditDistance::getDamerauLevenshteinDistance(pair.word0.data(),
+            static_cast<int>(pair.word0.size()), pair.word1.data(),
+            static_cast<int>(pair.word1.size()));
+}
+
+int getDistanceWithin(const WordPair &pair, const int maxDistance) {
+    return EditDistance::getDamerauLevenshteinDistanceWithin(pair.word0.data(),
+            static_cast<int>(pair.word0.size()), pair.word1.data(),
+            static_cast<int>(pair.word1.size()), maxDistance);
+}
+
+// Compares the kernels on words of every length up to MAX_WORD_LENGTH and copies of them with
+// typos, many on the short words, where the corner cases are.
+int countMismatches() {
+    unsigned int seed = 4321;
+    int mismatches = 0;
+    for (int length = 0; length <= MAX_WORD_LENGTH; ++length) {
+        for (int i = 0; i < 2000; ++i) {
+            const WordPair pair = getWordPair(length, length < 12 ? 6 : 3, &seed);
+            const int distance = getTableDistance(pair);
+            if (getBitParallelDistance(pair) != distance) {
+                ++mismatches;
+            }
+            for (int maxDistance = 0; maxDistance <= 4; ++maxDistance) {
+                if (getDistanceWithin(pair, maxDistance) != std::min(distance, maxDistance + 1)) {
+                    ++mismatches;
+                }
+            }
+        }
+    }
+    return mismatches;
+}
+
+template<typename Distance>
+double run(const std::vector<WordPair> &pairs, const Distance &distance, long long *checksum) {
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        *checksum += distance(pairs[i]);
+    }
+    return std::chrono::duration<double, std::nano>(
+            std::chrono::steady_clock::now() - start).count() / pairs.size();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const int pairCount = argc > 1 ? atoi(argv[1]) : 200000;
+    const int mismatches = countMismatches();
+
+    // Typed word lengths, up to MAX_WORD_LENGTH. The words are compared with copies with up to
+    // two typos, and with other words, which the threshold of 2 rejects early.
+    const int lengths[] = { 3, 5, 8, 12, 16, MAX_WORD_LENGTH };
+    const char *const pairKinds[] = { "typos", "unrelated" };
+    printf("%d pairs per length\n", pairCount);
+    printf("%-10s %6s %10s %10s %11s %7s %8s\n", "pairs", "length", "table ns", "bits ns",
+            "within2 ns", "bits", "within2");
+    long long checksum = 0;
+    for (int kind = 0; kind < 2; ++kind) {
+        for (const int length : lengths) {
+            unsigned int seed = 12345u + length;
+            std::vector<WordPair> pairs;
+            for (int i = 0; i < pairCount; ++i) {
+                pairs.push_back(getWordPair(length, 2, &seed));
+                if (kind == 1) {
+                    pairs.back().word1 = getWordPair(length, 2, &seed).word1;
+                }
+            }
+            const double tableNs = run(pairs, getTableDistance, &checksum);
+            const double bitsNs = run(pairs, getBitParallelDistance, &checksum);
+            const double withinNs = run(pairs, [](const WordPair &pair) {
+                return getDistanceWithin(pair, 2);
+            }, &checksum);
+            printf("%-10s %6d %10.1f %10.1f %11.1f %6.1fx %7.1fx\n", pairKinds[kind], length,
+                    tableNs, bitsNs, withinNs, tableNs / bitsNs, tableNs / withinNs);
+        }
+    }
+    printf("checksum %lld, mismatches %d\n", checksum, mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
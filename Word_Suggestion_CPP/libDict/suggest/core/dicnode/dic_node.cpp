@@ -18,13 +18,17 @@
 
 namespace latinime {
 
+// Definition of a constant initialized in its class, which std::min takes by reference.
+const int DicNodeStateOutput::CURRENT_WORD_HEAD_LENGTH;
+
 DicNode::DicNode(const DicNode &dicNode)
         :
 #if DEBUG_DICT
           mProfiler(dicNode.mProfiler),
 #endif
           mDicNodeProperties(dicNode.mDicNodeProperties), mDicNodeState(dicNode.mDicNodeState),
-          mIsCachedForNextSuggestion(dicNode.mIsCachedForNextSuggestion) {
+          mIsCachedForNextSuggestion(dicNode.mIsCachedForNextSuggestion),
+          mPushOrder(dicNode.mPushOrder) {
     /* empty */
 }
 
@@ -35,6 +39,7 @@ DicNode &DicNode::operator=(const DicNode &dicNode) {
     mDicNodeProperties = dicNode.mDicNodeProperties;
     mDicNodeState = dicNode.mDicNodeState;
     mIsCachedForNextSuggestion = dicNode.mIsCachedForNextSuggestion;
+    mPushOrder = dicNode.mPushOrder;
     return *this;
 }
 
@@ -17,6 +17,9 @@
 #ifndef LATINIME_DIC_NODE_H
 #define LATINIME_DIC_NODE_H
 
+#include <cmath>
+#include <cstdint>
+
 //#include "defines.h"
 #include "dic_node_profiler.h"
 #include "dic_node_utils.h"
@@ -32,7 +35,9 @@
 #define LOGI_SHOW_ADD_COST_PROP \
         do { \
             char charBuf[50]; \
-            INTS_TO_CHARS(getOutputWordBuf(), getNodeCodePointCount(), charBuf, NELEMS(charBuf)); \
+            int codePointBuf[MAX_WORD_LENGTH]; \
+            getOutputCodePoints(0 /* start */, getNodeCodePointCount(), codePointBuf); \
+            INTS_TO_CHARS(codePointBuf, getNodeCodePointCount(), charBuf, NELEMS(charBuf)); \
             AKLOGI("%20s, \"%c\", size = %03d, total = %03d, index(0) = %02d, dist = %.4f, %s,,", \
                     __FUNCTION__, getNodeCodePoint(), inputSize, getTotalInputIndex(), \
                     getInputIndex(0), getNormalizedCompoundDistance(), charBuf); \
@@ -40,10 +45,10 @@
 #define DUMP_WORD_AND_SCORE(header) \
         do { \
             char charBuf[50]; \
-            INTS_TO_CHARS(getOutputWordBuf(), \
-                    getNodeCodePointCount() \
-                            + mDicNodeState.mDicNodeStateOutput.getPrevWordsLength(), \
-                    charBuf, NELEMS(charBuf)); \
+            int codePointBuf[MAX_WORD_LENGTH]; \
+            getOutputCodePoints(0 /* start */, getTotalNodeCodePointCount(), codePointBuf); \
+            INTS_TO_CHARS(codePointBuf, getTotalNodeCodePointCount(), charBuf, \
+                    NELEMS(charBuf)); \
             AKLOGI("#%8s, %5f, %5f, %5f, %5f, %s, %d, %5f,", header, \
                     getSpatialDistanceForScoring(), \
                     mDicNodeState.mDicNodeStateScoring.getLanguageDistance(), \
@@ -90,7 +95,8 @@ class DicNode {
 #if DEBUG_DICT
               mProfiler(),
 #endif
-              mDicNodeProperties(), mDicNodeState(), mIsCachedForNextSuggestion(false) {}
+              mDicNodeProperties(), mDicNodeState(), mIsCachedForNextSuggestion(false),
+              mPushOrder(0) {}
 
     DicNode(const DicNode &dicNode);
     DicNode &operator=(const DicNode &dicNode);
@@ -99,28 +105,35 @@ class DicNode {
     // Init for copy
     void initByCopy(const DicNode *const dicNode) {
         mIsCachedForNextSuggestion = dicNode->mIsCachedForNextSuggestion;
+        mPushOrder = dicNode->mPushOrder;
         mDicNodeProperties.initByCopy(&dicNode->mDicNodeProperties);
         mDicNodeState.initByCopy(&dicNode->mDicNodeState);
         PROF_NODE_COPY(&dicNode->mProfiler, mProfiler);
     }
 
-    // Init for root with prevWordsPtNodePos which is used for n-gram
-    void initAsRoot(const int rootPtNodeArrayPos, const int *const prevWordsPtNodePos) {
+    // Init for root with prevWordsPtNodePos which is used for n-gram. The output of this node and
+    // of every node derived from it is kept in outputArena. dictionaryIndex is the index of the
+    // dictionary of the root in the DictionaryGroup of the search.
+    void initAsRoot(const int rootPtNodeArrayPos, const uint8_t dictionaryIndex,
+            const int *const prevWordsPtNodePos, DicNodeOutputArena *const outputArena) {
         mIsCachedForNextSuggestion = false;
-        mDicNodeProperties.init(rootPtNodeArrayPos, prevWordsPtNodePos);
-        mDicNodeState.init();
+        mPushOrder = 0;
+        mDicNodeProperties.init(rootPtNodeArrayPos, dictionaryIndex, prevWordsPtNodePos);
+        mDicNodeState.init(outputArena);
         PROF_NODE_RESET(mProfiler);
     }
 
     // Init for root with previous word
     void initAsRootWithPreviousWord(const DicNode *const dicNode, const int rootPtNodeArrayPos) {
         mIsCachedForNextSuggestion = dicNode->mIsCachedForNextSuggestion;
+        mPushOrder = 0;
         int newPrevWordsPtNodePos[MAX_PREV_WORD_COUNT_FOR_N_GRAM];
         newPrevWordsPtNodePos[0] = dicNode->mDicNodeProperties.getPtNodePos();
         for (size_t i = 1; i < NELEMS(newPrevWordsPtNodePos); ++i) {
             newPrevWordsPtNodePos[i] = dicNode->getPrevWordsTerminalPtNodePos()[i - 1];
         }
-        mDicNodeProperties.init(rootPtNodeArrayPos, newPrevWordsPtNodePos);
+        mDicNodeProperties.init(rootPtNodeArrayPos,
+                dicNode->mDicNodeProperties.getDictionaryIndex(), newPrevWordsPtNodePos);
         mDicNodeState.initAsRootWithPreviousWord(&dicNode->mDicNodeState,
                 dicNode->mDicNodeProperties.getDepth());
         PROF_NODE_COPY(&dicNode->mProfiler, mProfiler);
@@ -128,6 +141,7 @@ class DicNode {
 
     void initAsPassingChild(const DicNode *parentDicNode) {
         mIsCachedForNextSuggestion = parentDicNode->mIsCachedForNextSuggestion;
+        mPushOrder = 0;
         const int codePoint =
                 parentDicNode->mDicNodeState.mDicNodeStateOutput.getCurrentWordCodePointAt(
                             parentDicNode->getNodeCodePointCount());
@@ -142,11 +156,13 @@ class DicNode {
             const uint16_t mergedNodeCodePointCount, const int *const mergedNodeCodePoints) {
         uint16_t newDepth = static_cast<uint16_t>(dicNode->getNodeCodePointCount() + 1);
         mIsCachedForNextSuggestion = dicNode->mIsCachedForNextSuggestion;
+        mPushOrder = 0;
         const uint16_t newLeavingDepth = static_cast<uint16_t>(
                 dicNode->mDicNodeProperties.getLeavingDepth() + mergedNodeCodePointCount);
         mDicNodeProperties.init(ptNodePos, childrenPtNodeArrayPos, mergedNodeCodePoints[0],
                 probability, isTerminal, hasChildren, isBlacklistedOrNotAWord, newDepth,
-                newLeavingDepth, dicNode->mDicNodeProperties.getPrevWordsTerminalPtNodePos());
+                newLeavingDepth, dicNode->mDicNodeProperties.getDictionaryIndex(),
+                dicNode->mDicNodeProperties.getPrevWordsTerminalPtNodePos());
         mDicNodeState.init(&dicNode->mDicNodeState, mergedNodeCodePointCount,
                 mergedNodeCodePoints);
         PROF_NODE_COPY(&dicNode->mProfiler, mProfiler);
@@ -177,6 +193,15 @@ class DicNode {
         mIsCachedForNextSuggestion = true;
     }
 
+    // Order of the push that put this node in a queue, set by DicNodesCache; see compare().
+    uint64_t getPushOrder() const {
+        return mPushOrder;
+    }
+
+    void setPushOrder(const uint64_t pushOrder) {
+        mPushOrder = pushOrder;
+    }
+
     // Check if the current word and the previous word can be considered as a valid multiple word
     // suggestion.
     bool isValidMultipleWordSuggestion() const {
@@ -214,6 +239,12 @@ class DicNode {
         return mDicNodeProperties.getPrevWordsTerminalPtNodePos();
     }
 
+    // Index of the dictionary this node walks in the DictionaryGroup of the search. The
+    // positions of the node are positions in that dictionary.
+    int getDictionaryIndex() const {
+        return mDicNodeProperties.getDictionaryIndex();
+    }
+
     // Used in DicNodeUtils
     int getChildrenPtNodeArrayPos() const {
         return mDicNodeProperties.getChildrenPtNodeArrayPos();
@@ -253,10 +284,33 @@ class DicNode {
     }
 
     void outputResult(int *dest) const {
-        memmove(dest, getOutputWordBuf(), getTotalNodeCodePointCount() * sizeof(dest[0]));
+        getOutputCodePoints(0 /* start */, getTotalNodeCodePointCount(), dest);
         DUMP_WORD_AND_SCORE("OUTPUT");
     }
 
+    // Writes count code points of the whole suggestion from start on to dest, 0 past its end.
+    void getOutputCodePoints(const int start, const int count, int *const dest) const {
+        mDicNodeState.mDicNodeStateOutput.getCodePoints(start, count, dest);
+    }
+
+    // Moves the output code points kept in this node to the shared output arena. Nodes created
+    // from this one afterwards refer to them instead of copying them.
+    AK_FORCE_INLINE void commitOutputCodePoints() {
+        mDicNodeState.mDicNodeStateOutput.commitCodePoints();
+    }
+
+    // Makes this node keep its output in outputArena, which must be the arena of its output or
+    // extend it; the nodes derived from it follow.
+    void setOutputArena(DicNodeOutputArena *const outputArena) {
+        mDicNodeState.mDicNodeStateOutput.setArena(outputArena);
+    }
+
+    // Moves the output of this node to the base of its arena; see
+    // DicNodeOutputArena::initAsExtensionOf().
+    void moveOutputToBaseArena() {
+        mDicNodeState.mDicNodeStateOutput.moveToBaseArena();
+    }
+
     // "Total" in this context (and other methods in this class) means the whole suggestion. When
     // this represents a multi-word suggestion, the referenced PtNode (in mDicNodeState) is only
     // the one that corresponds to the last word of the suggestion, and all the previous words
@@ -265,8 +319,10 @@ class DicNode {
         if (!hasMultipleWords()) {
             return 0;
         }
-        return CharUtils::getSpaceCount(mDicNodeState.mDicNodeStateOutput.getCodePointBuf(),
-                mDicNodeState.mDicNodeStateOutput.getPrevWordsLength());
+        const int prevWordsLength = mDicNodeState.mDicNodeStateOutput.getPrevWordsLength();
+        int prevWordsCodePoints[MAX_WORD_LENGTH];
+        getOutputCodePoints(0 /* start */, prevWordsLength, prevWordsCodePoints);
+        return CharUtils::getSpaceCount(prevWordsCodePoints, prevWordsLength);
     }
 
     int getSecondWordFirstInputIndex(const ProximityInfoState *const pInfoState) const {
@@ -311,10 +367,6 @@ class DicNode {
         return mDicNodeState.mDicNodeStateScoring.getCompoundDistance(languageWeight);
     }
 
-    AK_FORCE_INLINE const int *getOutputWordBuf() const {
-        return mDicNodeState.mDicNodeStateOutput.getCodePointBuf();
-    }
-
     int getPrevCodePointG(int pointerId) const {
         return mDicNodeState.mDicNodeStateInput.getPrevCodePoint(pointerId);
     }
@@ -427,36 +479,54 @@ class DicNode {
 #endif
     }
 
+    // Whether this dicNode is better than the right one. Nodes that tie on everything else are
+    // told apart by their push orders, the earlier push first, so that nodes pushed in a search
+    // are in a strict total order: which ones a bounded queue keeps and the order they come out
+    // in do not depend on the order they are pushed in nor on where they are stored.
     AK_FORCE_INLINE bool compare(const DicNode *right) const {
-        // Promote exact matches to prevent them from being pruned.
-        const bool leftExactMatch = ErrorTypeUtils::isExactMatch(getContainedErrorTypes());
-        const bool rightExactMatch = ErrorTypeUtils::isExactMatch(right->getContainedErrorTypes());
-        if (leftExactMatch != rightExactMatch) {
-            return leftExactMatch;
-        }
-        const float diff =
-                right->getNormalizedCompoundDistance() - getNormalizedCompoundDistance();
-        static const float MIN_DIFF = 0.000001f;
-        if (diff > MIN_DIFF) {
-            return true;
-        } else if (diff < -MIN_DIFF) {
-            return false;
+        const int keyOrder = compareKeys(
+                ErrorTypeUtils::isExactMatch(getContainedErrorTypes()),
+                getDistanceKey(getNormalizedCompoundDistance()),
+                ErrorTypeUtils::isExactMatch(right->getContainedErrorTypes()),
+                getDistanceKey(right->getNormalizedCompoundDistance()));
+        if (keyOrder != 0) {
+            return keyOrder > 0;
         }
         const int depth = getNodeCodePointCount();
         const int depthDiff = right->getNodeCodePointCount() - depth;
         if (depthDiff != 0) {
             return depthDiff > 0;
         }
-        for (int i = 0; i < depth; ++i) {
-            const int codePoint = mDicNodeState.mDicNodeStateOutput.getCurrentWordCodePointAt(i);
-            const int rightCodePoint =
-                    right->mDicNodeState.mDicNodeStateOutput.getCurrentWordCodePointAt(i);
-            if (codePoint != rightCodePoint) {
-                return rightCodePoint > codePoint;
-            }
+        const int wordOrder = mDicNodeState.mDicNodeStateOutput.compareCurrentWords(
+                &right->mDicNodeState.mDicNodeStateOutput, depth);
+        if (wordOrder != 0) {
+            return wordOrder < 0;
+        }
+        return mPushOrder < right->mPushOrder;
+    }
+
+    // The normalized compound distance as compare() sees it. Distances within the same
+    // millionth are equal, so that rounding noise does not rank nodes; unlike a tolerance on
+    // their difference, this keeps the order transitive.
+    static AK_FORCE_INLINE float getDistanceKey(const float normalizedCompoundDistance) {
+        static const float DISTANCE_KEY_SCALE = 1000000.0f;
+        return floorf(normalizedCompoundDistance * DISTANCE_KEY_SCALE);
+    }
+
+    // The first and cheapest part of compare(), on keys that can be kept apart from the nodes.
+    // Returns 1 when the left node is better, -1 when the right one is and 0 when the rest of
+    // compare() decides.
+    static AK_FORCE_INLINE int compareKeys(const bool leftExactMatch,
+            const float leftDistanceKey, const bool rightExactMatch,
+            const float rightDistanceKey) {
+        // Promote exact matches to prevent them from being pruned.
+        if (leftExactMatch != rightExactMatch) {
+            return leftExactMatch ? 1 : -1;
+        }
+        if (leftDistanceKey != rightDistanceKey) {
+            return leftDistanceKey < rightDistanceKey ? 1 : -1;
         }
-        // Compare pointer values here for stable comparison
-        return this > right;
+        return 0;
     }
 
  private:
@@ -464,6 +534,7 @@ class DicNode {
     DicNodeState mDicNodeState;
     // TODO: Remove
     bool mIsCachedForNextSuggestion;
+    uint64_t mPushOrder;
 
     AK_FORCE_INLINE int getTotalInputIndex() const {
         int index = 0;
@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dic_node_checkpoints.h"
+
+namespace latinime {
+
+// Look-ahead corrections, such as transpositions, make the dicNodes pushed at a step depend on
+// the points after it.
+const int DicNodeCheckpoints::CACHE_BACK_LENGTH = 3;
+// A checkpoint takes about 40KB, so 8 of them add about 300KB to a session and let an edit in
+// the last 10 points of the input, or 7 backspaces in a row, resume.
+const int DicNodeCheckpoints::DEFAULT_MAX_COUNT = 8;
+
+} // namespace latinime
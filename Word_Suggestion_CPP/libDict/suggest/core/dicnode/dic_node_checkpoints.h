@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_DIC_NODE_CHECKPOINTS_H
+#define LATINIME_DIC_NODE_CHECKPOINTS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "../../../defines.h"
+
+#include "dic_node.h"
+#include "dic_nodes_cache.h"
+
+namespace latinime {
+
+/**
+ * Beams of the last steps of a search, each with the input index of its step, kept so that a
+ * later search on an input starting with the same touch points can resume from a step instead
+ * of from the root: on an appended code point, a deleted one or one changed in the middle of
+ * the input alike.
+ *
+ * The dicNodes popped at a step have been pushed by expansions that looked up to
+ * CACHE_BACK_LENGTH input points ahead of the step, so the beam of the step at inputIndex only
+ * serves inputs whose first inputIndex + CACHE_BACK_LENGTH points are unchanged. The costs of
+ * the terminals also depend on the input size: a checkpoint keeps the terminal queue as its step
+ * started, and an input of the same size resumes exactly, with the suggestions a search from the
+ * root would give. An input of another size resumes without the terminals of the earlier steps.
+ *
+ * The checkpoints form a stack ordered by input index, bounded by a maximum count: when it is
+ * full the oldest checkpoint gives its storage to the new one. Each checkpoint takes the
+ * dicNodes of one beam, so the count trades memory for how far back an edit can resume.
+ */
+class DicNodeCheckpoints {
+ public:
+    static const int CACHE_BACK_LENGTH;
+    static const int DEFAULT_MAX_COUNT;
+
+    class Checkpoint {
+     public:
+        Checkpoint()
+                : mInputIndex(0), mInputSize(0), mStepOrdinal(0), mExpandedDicNodeCount(0),
+                  mOutputEntryCount(0), mDicNodes(), mTerminalDicNodes() {}
+
+        int getInputIndex() const { return mInputIndex; }
+        // Size of the input of the search the checkpoint was taken in.
+        int getInputSize() const { return mInputSize; }
+        uint32_t getStepOrdinal() const { return mStepOrdinal; }
+        // DicNodes the search had expanded from the root before the step.
+        int getExpandedDicNodeCount() const { return mExpandedDicNodeCount; }
+        // Entries of the output arena the dicNodes refer to; the ones appended later belong to
+        // the steps after this one.
+        int getOutputEntryCount() const { return mOutputEntryCount; }
+        const std::vector<DicNode> *getDicNodes() const { return &mDicNodes; }
+        const std::vector<DicNode> *getTerminalDicNodes() const { return &mTerminalDicNodes; }
+
+     private:
+        friend class DicNodeCheckpoints;
+
+        int mInputIndex;
+        int mInputSize;
+        uint32_t mStepOrdinal;
+        int mExpandedDicNodeCount;
+        int mOutputEntryCount;
+        std::vector<DicNode> mDicNodes;
+        std::vector<DicNode> mTerminalDicNodes;
+    };
+
+    explicit DicNodeCheckpoints(const int maxCount)
+            : mMaxCount(std::max(maxCount, 0)), mCount(0), mIsOpen(false), mCheckpoints() {}
+
+    // 0 keeps no checkpoint, so that every search starts at the root.
+    void setMaxCount(const int maxCount) {
+        mMaxCount = std::max(maxCount, 0);
+        if (mCount > mMaxCount) {
+            std::rotate(mCheckpoints.begin(), mCheckpoints.begin() + (mCount - mMaxCount),
+                    mCheckpoints.begin() + mCount);
+            mCount = mMaxCount;
+        }
+        mIsOpen = false;
+        // One spare checkpoint takes the beam of the open step while the stack is full.
+        mCheckpoints.resize(std::min(mCheckpoints.size(), static_cast<size_t>(mMaxCount + 1)));
+        mCheckpoints.shrink_to_fit();
+    }
+
+    int getMaxCount() const { return mMaxCount; }
+    int getCount() const { return mCount; }
+
+    // Input index of the last checkpoint, NOT_AN_INDEX when there is none.
+    int getLastInputIndex() const {
+        return mCount > 0 ? mCheckpoints[mCount - 1].mInputIndex : NOT_AN_INDEX;
+    }
+
+    // Starts the checkpoint of the current step of cache, which must be past the last one, in
+    // a search on inputSize points that has expanded expandedDicNodeCount dicNodes from the
+    // root. The dicNodes popped at the step are added to it until commit() or abandon().
+    void begin(const DicNodesCache *const cache, const int inputSize,
+            const int expandedDicNodeCount) {
+        if (mMaxCount == 0) {
+            return;
+        }
+        if (static_cast<int>(mCheckpoints.size()) <= mCount) {
+            mCheckpoints.emplace_back();
+        }
+        Checkpoint *const checkpoint = &mCheckpoints[mCount];
+        checkpoint->mInputIndex = cache->getInputIndex();
+        checkpoint->mInputSize = inputSize;
+        checkpoint->mStepOrdinal = cache->getStepOrdinal();
+        checkpoint->mExpandedDicNodeCount = expandedDicNodeCount;
+        checkpoint->mDicNodes.clear();
+        checkpoint->mTerminalDicNodes.clear();
+        cache->copyTerminalDicNodesTo(&checkpoint->mTerminalDicNodes);
+        mIsOpen = true;
+    }
+
+    AK_FORCE_INLINE void add(const DicNode *const dicNode) {
+        if (mIsOpen) {
+            mCheckpoints[mCount].mDicNodes.push_back(*dicNode);
+        }
+    }
+
+    // Keeps the open checkpoint, the step being done, dropping the oldest one if the stack is
+    // full.
+    void commit(const int outputEntryCount) {
+        if (!mIsOpen) {
+            return;
+        }
+        mCheckpoints[mCount].mOutputEntryCount = outputEntryCount;
+        if (mCount < mMaxCount) {
+            mCount++;
+        } else {
+            std::rotate(mCheckpoints.begin(), mCheckpoints.begin() + 1,
+                    mCheckpoints.begin() + mCount + 1);
+        }
+        mIsOpen = false;
+    }
+
+    // Drops the open checkpoint, of a step that was not done.
+    void abandon() {
+        mIsOpen = false;
+    }
+
+    void clear() {
+        mCount = 0;
+        mIsOpen = false;
+    }
+
+    // Returns the last checkpoint that serves an input of inputSize points whose first
+    // matchingInputSize points are unchanged, and drops the ones after it, whose dicNodes the
+    // resumed search replaces. With exactOnly, only a checkpoint taken on an input of the same
+    // size serves. Returns nullptr, dropping them all, when there is none.
+    const Checkpoint *resume(const int matchingInputSize, const int inputSize,
+            const bool exactOnly) {
+        mIsOpen = false;
+        while (mCount > 0 && (mCheckpoints[mCount - 1].mInputIndex + CACHE_BACK_LENGTH
+                > matchingInputSize
+                || (exactOnly && mCheckpoints[mCount - 1].mInputSize != inputSize))) {
+            mCount--;
+        }
+        return mCount > 0 ? &mCheckpoints[mCount - 1] : nullptr;
+    }
+
+    size_t getMemorySize() const {
+        size_t memorySize = mCheckpoints.capacity() * sizeof(Checkpoint);
+        for (const Checkpoint &checkpoint : mCheckpoints) {
+            memorySize += (checkpoint.mDicNodes.capacity()
+                    + checkpoint.mTerminalDicNodes.capacity()) * sizeof(DicNode);
+        }
+        return memorySize;
+    }
+
+ private:
+    DISALLOW_IMPLICIT_CONSTRUCTORS(DicNodeCheckpoints);
+
+    int mMaxCount;
+    int mCount;
+    // Whether mCheckpoints[mCount] is being filled by the current step.
+    bool mIsOpen;
+    // The first mCount are kept, from the oldest to the last; the others only lend their
+    // storage to the next ones.
+    std::vector<Checkpoint> mCheckpoints;
+};
+} // namespace latinime
+#endif // LATINIME_DIC_NODE_CHECKPOINTS_H
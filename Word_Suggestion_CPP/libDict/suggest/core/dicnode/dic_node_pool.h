@@ -17,71 +17,128 @@
 #ifndef LATINIME_DIC_NODE_POOL_H
 #define LATINIME_DIC_NODE_POOL_H
 
-#include <deque>
-#include <unordered_set>
-#include <vector>
+#include <cstdint>
+#include <memory>
+#include <new>
 #include "../../../defines.h"
 
 #include "dic_node.h"
 
 namespace latinime {
 
+// DicNode instances addressed by their index, so that queues can refer to them with small
+// handles. One pool is shared by all the queues of a session: a node moves between queues as
+// an index. Instances are kept back to back in one cache-line-aligned block in index order, and
+// a free instance holds the index of the next free one in its own storage, so the pool takes no
+// more memory than its nodes.
+//
+// Which slot a node gets decides nothing: DicNode::compare() breaks full ties by push order, not
+// by where the nodes are stored.
 class DicNodePool {
  public:
-    explicit DicNodePool(const int capacity) : mDicNodes(), mPooledDicNodes() {
-        reset(capacity);
+    // Indices are kept in 16 bits.
+    static const int MAX_CAPACITY = UINT16_MAX + 1;
+
+    explicit DicNodePool(const int capacity)
+            : mBuffer(), mSlots(nullptr), mCapacity(0), mFreeCount(0),
+              mFirstFreeIndex(NOT_AN_INDEX) {
+        reserve(capacity);
+    }
+
+    ~DicNodePool() {
+        destroySlots();
     }
 
-    void reset(const int capacity) {
-        if (capacity == static_cast<int>(mDicNodes.size())
-                && capacity == static_cast<int>(mPooledDicNodes.size())) {
-            // No need to reset.
+    // Grows the pool to at least capacity instances. The instances move, so no instance may be
+    // taken out of the pool when it grows.
+    void reserve(const int capacity) {
+        if (capacity <= mCapacity) {
             return;
         }
-        mDicNodes.resize(capacity);
-        mDicNodes.shrink_to_fit();
-        mPooledDicNodes.clear();
-        for (auto &dicNode : mDicNodes) {
-            mPooledDicNodes.emplace_back(&dicNode);
+        ASSERT(mFreeCount == mCapacity);
+        ASSERT(capacity <= MAX_CAPACITY);
+        destroySlots();
+        mBuffer.reset(new uint8_t[capacity * sizeof(Slot) + CACHE_LINE_SIZE - 1]);
+        const uintptr_t bufferAddress = reinterpret_cast<uintptr_t>(mBuffer.get());
+        mSlots = reinterpret_cast<Slot *>((bufferAddress + CACHE_LINE_SIZE - 1)
+                & ~static_cast<uintptr_t>(CACHE_LINE_SIZE - 1));
+        for (int i = 0; i < capacity; ++i) {
+            new (&mSlots[i]) Slot();
+            mSlots[i].mNextFreeIndex = i + 1 < capacity ? i + 1 : NOT_AN_INDEX;
         }
+        mCapacity = capacity;
+        mFreeCount = capacity;
+        mFirstFreeIndex = 0;
     }
 
-    // Get a DicNode instance from the pool. The instance has to be returned by returnInstance().
-    DicNode *getInstance() {
-        if (mPooledDicNodes.empty()) {
-            return nullptr;
-        }
-        DicNode *const dicNode = mPooledDicNodes.back();
-        mPooledDicNodes.pop_back();
-        return dicNode;
+    int getCapacity() const {
+        return mCapacity;
     }
 
-    // Return an instance that has been removed from the pool by getInstance() to the pool. The
-    // instance must not be used after returning without getInstance().
-    void placeBackInstance(DicNode *dicNode) {
-        mPooledDicNodes.emplace_back(dicNode);
+    // Index that the next acquireIndex() returns, or NOT_AN_INDEX when the pool is exhausted.
+    AK_FORCE_INLINE int peekFreeIndex() const {
+        return mFirstFreeIndex;
     }
 
-    void dump() const {
-        AKLOGI("\n\n\n\n\n===========================");
-        std::unordered_set<const DicNode*> usedDicNodes;
-        for (const auto &dicNode : mDicNodes) {
-            usedDicNodes.insert(&dicNode);
-        }
-        for (const auto &dicNodePtr : mPooledDicNodes) {
-            usedDicNodes.erase(dicNodePtr);
+    // Takes an instance out of the pool; it has to be returned by releaseIndex(). Returns
+    // NOT_AN_INDEX when the pool is exhausted.
+    AK_FORCE_INLINE int acquireIndex() {
+        const int index = mFirstFreeIndex;
+        if (index != NOT_AN_INDEX) {
+            mFirstFreeIndex = mSlots[index].mNextFreeIndex;
+            mFreeCount--;
         }
-        for (const auto &usedDicNodePtr : usedDicNodes) {
-            usedDicNodePtr->dump("DIC_NODE_POOL: ");
-        }
-        AKLOGI("===========================\n\n\n\n\n");
+        return index;
+    }
+
+    // Returns an instance taken by acquireIndex() to the pool. The instance must not be used
+    // after returning without acquireIndex().
+    AK_FORCE_INLINE void releaseIndex(const int index) {
+        mSlots[index].mNextFreeIndex = mFirstFreeIndex;
+        mFirstFreeIndex = index;
+        mFreeCount++;
+    }
+
+    AK_FORCE_INLINE DicNode *getDicNode(const int index) {
+        return &mSlots[index].mDicNode;
+    }
+
+    AK_FORCE_INLINE const DicNode *getDicNode(const int index) const {
+        return &mSlots[index].mDicNode;
+    }
+
+    size_t getMemorySize() const {
+        return mBuffer ? mCapacity * sizeof(Slot) + CACHE_LINE_SIZE - 1 : 0;
     }
 
  private:
     DISALLOW_IMPLICIT_CONSTRUCTORS(DicNodePool);
 
-    std::vector<DicNode> mDicNodes;
-    std::deque<DicNode*> mPooledDicNodes;
+    static const int CACHE_LINE_SIZE = 64;
+
+    // A node taken out of the pool is always initialized by copy before it is read, so a free
+    // node can hold the free list instead.
+    union Slot {
+        Slot() : mDicNode() {}
+        ~Slot() {}
+
+        DicNode mDicNode;
+        // Index of the next free slot while this one is free.
+        int mNextFreeIndex;
+    };
+
+    void destroySlots() {
+        for (int i = 0; i < mCapacity; ++i) {
+            mSlots[i].~Slot();
+        }
+    }
+
+    std::unique_ptr<uint8_t[]> mBuffer;
+    Slot *mSlots;
+    int mCapacity;
+    int mFreeCount;
+    // Last in, first out.
+    int mFirstFreeIndex;
 };
 } // namespace latinime
 #endif // LATINIME_DIC_NODE_POOL_H
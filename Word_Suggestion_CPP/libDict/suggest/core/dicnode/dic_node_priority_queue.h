@@ -18,20 +18,32 @@
 #define LATINIME_DIC_NODE_PRIORITY_QUEUE_H
 
 #include <algorithm>
-#include <queue>
+#include <cstdint>
+#include <limits>
 #include <vector>
 
-
 #include "dic_node.h"
 #include "dic_node_pool.h"
 #include "../../../defines.h"
+#include "../../../utils/min_max_heap.h"
 
 namespace latinime {
 
+/**
+ * Bounded priority queue of dicNodes. The nodes live in a pool that may be shared with other
+ * queues and are ordered by a min-max heap of small entries that carry the leading comparison
+ * keys of DicNode::compare() next to the pool index, so most comparisons never touch a node. A
+ * candidate pushed into a full queue is compared with the worst entry before it is copied, and
+ * nodes are taken out worst first.
+ *
+ * The queue takes up to capacity + 2 nodes from the pool: the queued ones, the one a push into
+ * a full queue copies before it gives up the worst, and the last popped one.
+ */
 class DicNodePriorityQueue {
  public:
-    AK_FORCE_INLINE explicit DicNodePriorityQueue(const int capacity)
-            : mMaxSize(capacity), mDicNodesQueue(), mDicNodePool(capacity) {
+    AK_FORCE_INLINE DicNodePriorityQueue(const int capacity, DicNodePool *const dicNodePool)
+            : mMaxSize(capacity), mDicNodePool(dicNodePool), mPoppedIndex(NOT_AN_INDEX),
+              mEntries(EntryComparator(dicNodePool)) {
         clear();
     }
 
@@ -39,7 +51,7 @@ class DicNodePriorityQueue {
     AK_FORCE_INLINE ~DicNodePriorityQueue() {}
 
     AK_FORCE_INLINE int getSize() const {
-        return static_cast<int>(mDicNodesQueue.size());
+        return static_cast<int>(mEntries.size());
     }
 
     AK_FORCE_INLINE int getMaxSize() const {
@@ -56,81 +68,175 @@ class DicNodePriorityQueue {
 
     AK_FORCE_INLINE void clearAndResize(const int maxSize) {
         mMaxSize = maxSize;
-        while (!mDicNodesQueue.empty()) {
-            mDicNodesQueue.pop();
+        for (size_t i = 0; i < mEntries.size(); ++i) {
+            mDicNodePool->releaseIndex(mEntries.getEntry(i).mIndex);
         }
-        mDicNodePool.reset(mMaxSize + 1);
+        mEntries.clear();
+        releasePoppedDicNode();
+        mEntries.reserve(mMaxSize + 1);
     }
 
-    AK_FORCE_INLINE void copyPush(const DicNode *const dicNode) {
-        DicNode *const pooledDicNode = newDicNode(dicNode);
-        if (!pooledDicNode) {
-            return;
+    // Returns false when a dicNode was dropped because the queue was full: either dicNode or
+    // the worst one in the queue.
+    AK_FORCE_INLINE bool copyPush(const DicNode *const dicNode) {
+        const int index = mDicNodePool->peekFreeIndex();
+        if (index == NOT_AN_INDEX) {
+            return false;
         }
+        const Entry entry(dicNode, index);
         if (getSize() < mMaxSize) {
-            mDicNodesQueue.push(pooledDicNode);
-            return;
+            DicNodeUtils::initByCopy(dicNode,
+                    mDicNodePool->getDicNode(mDicNodePool->acquireIndex()));
+            mEntries.push(entry);
+            return true;
+        }
+        if (mEntries.empty()) {
+            return false;
         }
-        if (betterThanWorstDicNode(pooledDicNode)) {
-            mDicNodePool.placeBackInstance(mDicNodesQueue.top());
-            mDicNodesQueue.pop();
-            mDicNodesQueue.push(pooledDicNode);
-            return;
+        const Entry &worstEntry = mEntries.getMax();
+        if (!EntryComparator::compare(entry, dicNode, worstEntry,
+                mDicNodePool->getDicNode(worstEntry.mIndex))) {
+            return false;
         }
-        mDicNodePool.placeBackInstance(pooledDicNode);
+        DicNodeUtils::initByCopy(dicNode,
+                mDicNodePool->getDicNode(mDicNodePool->acquireIndex()));
+        mDicNodePool->releaseIndex(worstEntry.mIndex);
+        mEntries.replaceMax(entry);
+        return false;
     }
 
-    AK_FORCE_INLINE void copyPop(DicNode *const dest) {
-        if (mDicNodesQueue.empty()) {
+    // Removes the worst dicNode and returns it without copying it. The returned dicNode may be
+    // modified and stays valid until the next pop from or clear of this queue.
+    AK_FORCE_INLINE DicNode *pop() {
+        releasePoppedDicNode();
+        if (mEntries.empty()) {
             ASSERT(false);
-            return;
+            return nullptr;
+        }
+        mPoppedIndex = mEntries.getMax().mIndex;
+        mEntries.popMax();
+        return mDicNodePool->getDicNode(mPoppedIndex);
+    }
+
+    // Smallest distance key of the queued dicNodes, of the exact matches among them only with
+    // exactMatchesOnly; see DicNode::getDistanceKey(). Infinity when there are none.
+    AK_FORCE_INLINE float getMinDistanceKey(const bool exactMatchesOnly) const {
+        float minDistanceKey = std::numeric_limits<float>::infinity();
+        for (size_t i = 0; i < mEntries.size(); ++i) {
+            const Entry &entry = mEntries.getEntry(i);
+            if (entry.mIsExactMatch || !exactMatchesOnly) {
+                minDistanceKey = std::min(minDistanceKey, entry.mDistanceKey);
+            }
+        }
+        return minDistanceKey;
+    }
+
+    // Number of queued dicNodes whose distance key is below distanceKey, or below
+    // exactMatchDistanceKey for exact matches.
+    AK_FORCE_INLINE int getCountCloserThan(const float distanceKey,
+            const float exactMatchDistanceKey) const {
+        int count = 0;
+        for (size_t i = 0; i < mEntries.size(); ++i) {
+            const Entry &entry = mEntries.getEntry(i);
+            count += entry.mDistanceKey
+                    < (entry.mIsExactMatch ? exactMatchDistanceKey : distanceKey) ? 1 : 0;
+        }
+        return count;
+    }
+
+    // Appends copies of the queued dicNodes to dest, in no particular order.
+    void copyDicNodesTo(std::vector<DicNode> *const dest) const {
+        for (size_t i = 0; i < mEntries.size(); ++i) {
+            dest->push_back(*mDicNodePool->getDicNode(mEntries.getEntry(i).mIndex));
+        }
+    }
+
+    // Writes the queued dicNodes to outDicNodes from the best to the worst, the reverse of the
+    // order pop() takes them out in, up to maxCount of them, and returns their count. Only the
+    // entries are sorted: the dicNodes are not copied and stay valid until the queue is cleared.
+    // The queue is consumed: it must be cleared before it is pushed to or popped from.
+    int sortAndGetDicNodes(const int maxCount, const DicNode **const outDicNodes) {
+        releasePoppedDicNode();
+        const Entry *const entries = mEntries.sortAndGetEntries();
+        const int count = std::min(getSize(), maxCount);
+        for (int i = 0; i < count; ++i) {
+            outDicNodes[i] = mDicNodePool->getDicNode(entries[i].mIndex);
         }
-        DicNode *node = mDicNodesQueue.top();
-        if (dest) {
+        return count;
+    }
+
+    AK_FORCE_INLINE void copyPop(DicNode *const dest) {
+        DicNode *const node = pop();
+        if (node && dest) {
             DicNodeUtils::initByCopy(node, dest);
         }
-        mDicNodePool.placeBackInstance(node);
-        mDicNodesQueue.pop();
     }
 
-    AK_FORCE_INLINE void dump() {
-        mDicNodePool.dump();
+    AK_FORCE_INLINE void dump() const {
+        AKLOGI("\n\n\n\n\n===========================");
+        for (size_t i = 0; i < mEntries.size(); ++i) {
+            mDicNodePool->getDicNode(mEntries.getEntry(i).mIndex)->dump("DIC_NODE_POOL: ");
+        }
+        AKLOGI("===========================\n\n\n\n\n");
+    }
+
+    // Bytes of the heap; the pool is accounted for by its owner.
+    size_t getMemorySize() const {
+        return mEntries.capacity() * sizeof(Entry);
     }
 
  private:
     DISALLOW_IMPLICIT_CONSTRUCTORS(DicNodePriorityQueue);
 
-    AK_FORCE_INLINE static bool compareDicNode(const DicNode *const left,
-            const DicNode *const right) {
-        return left->compare(right);
+    AK_FORCE_INLINE void releasePoppedDicNode() {
+        if (mPoppedIndex != NOT_AN_INDEX) {
+            mDicNodePool->releaseIndex(mPoppedIndex);
+            mPoppedIndex = NOT_AN_INDEX;
+        }
     }
 
-    struct DicNodeComparator {
-        bool operator ()(const DicNode *left, const DicNode *right) const {
-            return compareDicNode(left, right);
-        }
+    struct Entry {
+        AK_FORCE_INLINE Entry(const DicNode *const dicNode, const int index)
+                : mDistanceKey(DicNode::getDistanceKey(dicNode->getNormalizedCompoundDistance())),
+                  mIndex(static_cast<uint16_t>(index)),
+                  mIsExactMatch(ErrorTypeUtils::isExactMatch(dicNode->getContainedErrorTypes())) {}
+
+        float mDistanceKey;
+        uint16_t mIndex;
+        bool mIsExactMatch;
     };
 
-    typedef std::priority_queue<DicNode *, std::vector<DicNode *>, DicNodeComparator> DicNodesQueue;
-    int mMaxSize;
-    DicNodesQueue mDicNodesQueue;
-    DicNodePool mDicNodePool;
+    // Orders entries as DicNode::compare() orders their nodes, better first.
+    class EntryComparator {
+     public:
+        explicit EntryComparator(const DicNodePool *const dicNodePool)
+                : mDicNodePool(dicNodePool) {}
 
-    AK_FORCE_INLINE bool betterThanWorstDicNode(const DicNode *const dicNode) const {
-        DicNode *worstNode = mDicNodesQueue.top();
-        if (!worstNode) {
-            return true;
+        AK_FORCE_INLINE bool operator()(const Entry &left, const Entry &right) const {
+            return compare(left, mDicNodePool->getDicNode(left.mIndex), right,
+                    mDicNodePool->getDicNode(right.mIndex));
         }
-        return compareDicNode(dicNode, worstNode);
-    }
 
-    AK_FORCE_INLINE DicNode *newDicNode(const DicNode *const dicNode) {
-        DicNode *newNode = mDicNodePool.getInstance();
-        if (newNode) {
-            DicNodeUtils::initByCopy(dicNode, newNode);
+        // leftDicNode and rightDicNode are only read when the keys tie.
+        static AK_FORCE_INLINE bool compare(const Entry &left, const DicNode *const leftDicNode,
+                const Entry &right, const DicNode *const rightDicNode) {
+            const int keyOrder = DicNode::compareKeys(left.mIsExactMatch, left.mDistanceKey,
+                    right.mIsExactMatch, right.mDistanceKey);
+            if (keyOrder != 0) {
+                return keyOrder > 0;
+            }
+            return leftDicNode->compare(rightDicNode);
         }
-        return newNode;
-    }
+
+     private:
+        const DicNodePool *mDicNodePool;
+    };
+
+    int mMaxSize;
+    DicNodePool *const mDicNodePool;
+    // Pool index of the node returned by the last pop(), kept out of the pool until the next one.
+    int mPoppedIndex;
+    MinMaxHeap<Entry, EntryComparator> mEntries;
 };
 } // namespace latinime
 #endif // LATINIME_DIC_NODE_PRIORITY_QUEUE_H
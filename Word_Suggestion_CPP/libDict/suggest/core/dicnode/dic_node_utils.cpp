@@ -29,8 +29,10 @@ namespace latinime {
 
 /* static */ void DicNodeUtils::initAsRoot(
         const DictionaryStructureWithBufferPolicy *const dictionaryStructurePolicy,
-        const int *const prevWordsPtNodePos, DicNode *const newRootDicNode) {
-    newRootDicNode->initAsRoot(dictionaryStructurePolicy->getRootPosition(), prevWordsPtNodePos);
+        const int dictionaryIndex, const int *const prevWordsPtNodePos,
+        DicNodeOutputArena *const outputArena, DicNode *const newRootDicNode) {
+    newRootDicNode->initAsRoot(dictionaryStructurePolicy->getRootPosition(),
+            static_cast<uint8_t>(dictionaryIndex), prevWordsPtNodePos, outputArena);
 }
 
 /*static */ void DicNodeUtils::initAsRootWithPreviousWord(
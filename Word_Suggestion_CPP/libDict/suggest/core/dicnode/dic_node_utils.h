@@ -22,6 +22,7 @@
 namespace latinime {
 
 class DicNode;
+class DicNodeOutputArena;
 class DicNodeVector;
 class DictionaryStructureWithBufferPolicy;
 class MultiBigramMap;
@@ -30,7 +31,8 @@ class DicNodeUtils {
  public:
     static void initAsRoot(
             const DictionaryStructureWithBufferPolicy *const dictionaryStructurePolicy,
-            const int *const prevWordPtNodePos, DicNode *const newRootDicNode);
+            const int dictionaryIndex, const int *const prevWordPtNodePos,
+            DicNodeOutputArena *const outputArena, DicNode *const newRootDicNode);
     static void initAsRootWithPreviousWord(
             const DictionaryStructureWithBufferPolicy *const dictionaryStructurePolicy,
             const DicNode *const prevWordLastDicNode, DicNode *const newRootDicNode);
@@ -17,6 +17,7 @@
 #ifndef LATINIME_DIC_NODE_VECTOR_H
 #define LATINIME_DIC_NODE_VECTOR_H
 
+#include <cstddef>
 #include <vector>
 
 #include "../../../defines.h"
@@ -80,6 +81,10 @@ class DicNodeVector {
         return &mDicNodes.front();
     }
 
+    size_t getMemorySize() const {
+        return mDicNodes.capacity() * sizeof(DicNode);
+    }
+
  private:
     DISALLOW_COPY_AND_ASSIGN(DicNodeVector);
     std::vector<DicNode> mDicNodes;
@@ -18,9 +18,13 @@
 #define LATINIME_DIC_NODES_CACHE_H
 
 #include <algorithm>
+#include <cstdint>
+#include <vector>
+
 #include "../../../defines.h"
 
 #include "dic_node_priority_queue.h"
+#include "../session/query_stats.h"
 
 namespace latinime {
 
@@ -28,39 +32,75 @@ class DicNode;
 
 /**
  * Class for controlling dicNode search priority queue and lexicon trie traversal.
+ *
+ * Every push of a dicNode into the active, next active or terminal queue gives it a push order
+ * made of the step of the search, the rank of the expanded dicNode in the step (the number of
+ * dicNodes popped from the active queue so far) and the rank of the push in that expansion.
+ * compare() breaks full ties on it, so the queues end up the same whichever order the dicNodes
+ * of a step are expanded in, as long as each expansion pushes its dicNodes in the same order.
  */
 class DicNodesCache {
  public:
-    AK_FORCE_INLINE explicit DicNodesCache(const bool usesLargeCapacityCache)
-            : mUsesLargeCapacityCache(usesLargeCapacityCache),
-              mDicNodePriorityQueue0(getCacheCapacity()),
-              mDicNodePriorityQueue1(getCacheCapacity()),
-              mDicNodePriorityQueue2(getCacheCapacity()),
-              mDicNodePriorityQueueForTerminal(MAX_RESULTS),
+    // Pushes and pops are counted in queryStats.
+    AK_FORCE_INLINE DicNodesCache(const bool usesLargeCapacityCache, QueryStats *const queryStats)
+            : mUsesLargeCapacityCache(usesLargeCapacityCache), mQueryStats(queryStats),
+              mDicNodePool(getDicNodePoolCapacity(MAX_RESULTS)),
+              mDicNodePriorityQueue0(getCacheCapacity(), &mDicNodePool),
+              mDicNodePriorityQueue1(getCacheCapacity(), &mDicNodePool),
+              mDicNodePriorityQueueForTerminal(MAX_RESULTS, &mDicNodePool),
               mActiveDicNodes(&mDicNodePriorityQueue0),
               mNextActiveDicNodes(&mDicNodePriorityQueue1),
-              mCachedDicNodesForContinuousSuggestion(&mDicNodePriorityQueue2),
               mTerminalDicNodes(&mDicNodePriorityQueueForTerminal),
-              mInputIndex(0), mLastCachedInputIndex(0) {}
+              mInputIndex(0), mStepOrdinal(0), mExpansionOrdinal(0), mPushOrdinal(0),
+              mIsActiveDicNodesTrimmed(false) {}
 
     AK_FORCE_INLINE virtual ~DicNodesCache() {}
 
     AK_FORCE_INLINE void reset(const int nextActiveSize, const int terminalSize) {
         mInputIndex = 0;
-        mLastCachedInputIndex = 0;
+        mStepOrdinal = 0;
+        mExpansionOrdinal = 0;
+        mPushOrdinal = 0;
+        mIsActiveDicNodesTrimmed = false;
         // The size of current active DicNode queue doesn't have to be changed.
         mActiveDicNodes->clear();
         // nextActiveSize is used to limit the next iteration's active DicNode size.
         const int nextActiveSizeFittingToTheCapacity = std::min(nextActiveSize, getCacheCapacity());
         mNextActiveDicNodes->clearAndResize(nextActiveSizeFittingToTheCapacity);
         mTerminalDicNodes->clearAndResize(terminalSize);
-        // The size of cached DicNode queue doesn't have to be changed.
-        mCachedDicNodesForContinuousSuggestion->clear();
+        // All the queues are empty, so the pool may grow for a larger terminal queue.
+        mDicNodePool.reserve(getDicNodePoolCapacity(terminalSize));
     }
 
-    AK_FORCE_INLINE void continueSearch() {
+    // Restarts the search at the step at inputIndex, with stepOrdinal, of which dicNodes is the
+    // beam; see DicNodeCheckpoints. The restored dicNodes keep their push orders, which are all
+    // of earlier steps. With terminalDicNodes, the terminal queue as the step started, the
+    // search goes on exactly as the one the beam was taken from, so the beam is not trimmed
+    // again; without, the terminals of the earlier steps are lost.
+    AK_FORCE_INLINE void continueSearch(const int inputIndex, const uint32_t stepOrdinal,
+            const std::vector<DicNode> *const dicNodes,
+            const std::vector<DicNode> *const terminalDicNodes) {
         resetTemporaryCaches();
-        restoreActiveDicNodesFromCache();
+        if (DEBUG_DICT) {
+            AKLOGI("Restore %d nodes. inputIndex = %d.", static_cast<int>(dicNodes->size()),
+                    inputIndex);
+        }
+        mInputIndex = inputIndex;
+        mStepOrdinal = stepOrdinal;
+        mExpansionOrdinal = 0;
+        mPushOrdinal = 0;
+        for (const DicNode &dicNode : *dicNodes) {
+            if (DEBUG_DICT_FULL || DEBUG_CACHE) {
+                dicNode.dump("RESTORE");
+            }
+            mActiveDicNodes->copyPush(&dicNode);
+        }
+        if (terminalDicNodes) {
+            for (const DicNode &dicNode : *terminalDicNodes) {
+                mTerminalDicNodes->copyPush(&dicNode);
+            }
+            mIsActiveDicNodesTrimmed = true;
+        }
     }
 
     AK_FORCE_INLINE void advanceActiveDicNodes() {
@@ -72,10 +112,95 @@ class DicNodesCache {
         }
         mNextActiveDicNodes =
                 moveNodesAndReturnReusableEmptyQueue(mNextActiveDicNodes, &mActiveDicNodes);
+        mIsActiveDicNodesTrimmed = false;
+        advanceStepOrdinal();
+    }
+
+    // Readies this cache, as the one of a worker expanding some of the dicNodes of the current
+    // step of the search in cache, to take the dicNodes they push: the next active and
+    // terminal queues get the bounds of the ones of cache, and the pushes are ordered as they
+    // would be in cache. See takeExpandedDicNodes().
+    void resetForExpansionStep(const DicNodesCache *const cache) {
+        mInputIndex = cache->mInputIndex;
+        mStepOrdinal = cache->mStepOrdinal;
+        mExpansionOrdinal = 0;
+        mPushOrdinal = 0;
+        const int terminalSize = cache->mTerminalDicNodes->getMaxSize();
+        mActiveDicNodes->clear();
+        mNextActiveDicNodes->clearAndResize(cache->mNextActiveDicNodes->getMaxSize());
+        mTerminalDicNodes->clearAndResize(terminalSize);
+        mDicNodePool.reserve(getDicNodePoolCapacity(terminalSize));
+    }
+
+    // Orders the pushes that follow as the ones of the expansion of the dicNode popped from the
+    // active queue as the expansionOrdinal-th of the step; see getExpansionOrdinal().
+    AK_FORCE_INLINE void beginExpansion(const int expansionOrdinal) {
+        mExpansionOrdinal = expansionOrdinal;
+        mPushOrdinal = 0;
+    }
+
+    // How many dicNodes have been popped from the active queue in the current step.
+    int getExpansionOrdinal() const { return mExpansionOrdinal; }
+
+    // Moves the dicNodes workerCache took since resetForExpansionStep() to the next active and
+    // terminal queues of this cache, with their push orders. Their outputs are moved to the base
+    // arena of the worker's arena on the way; see DicNodeOutputArena::initAsExtensionOf().
+    void takeExpandedDicNodes(DicNodesCache *const workerCache) {
+        while (workerCache->mNextActiveDicNodes->getSize() > 0) {
+            DicNode *const dicNode = workerCache->mNextActiveDicNodes->pop();
+            dicNode->moveOutputToBaseArena();
+            if (!mNextActiveDicNodes->copyPush(dicNode)) {
+                mQueryStats->evictedDicNodeCount++;
+            }
+        }
+        while (workerCache->mTerminalDicNodes->getSize() > 0) {
+            DicNode *const dicNode = workerCache->mTerminalDicNodes->pop();
+            dicNode->moveOutputToBaseArena();
+            mTerminalDicNodes->copyPush(dicNode);
+        }
+    }
+
+    // Drops the worst active dicNodes until at most maxSize are left, unless they are a beam
+    // restored with its terminals, which its step trimmed already.
+    void trimActiveDicNodes(const int maxSize) {
+        if (mIsActiveDicNodesTrimmed) {
+            return;
+        }
+        while (mActiveDicNodes->getSize() > maxSize) {
+            mActiveDicNodes->pop();
+            mQueryStats->trimmedDicNodeCount++;
+        }
+    }
+
+    // Distance keys of the active and terminal dicNodes, for choosing how many active dicNodes
+    // to expand; see Traversal::getActiveDicNodeLimit() and DicNodePriorityQueue.
+    float getMinActiveDistanceKey(const bool exactMatchesOnly) const {
+        return mActiveDicNodes->getMinDistanceKey(exactMatchesOnly);
+    }
+    int getActiveCountCloserThan(const float distanceKey) const {
+        return mActiveDicNodes->getCountCloserThan(distanceKey, distanceKey);
+    }
+    int getTerminalCountCloserThan(const float distanceKey,
+            const float exactMatchDistanceKey) const {
+        return mTerminalDicNodes->getCountCloserThan(distanceKey, exactMatchDistanceKey);
+    }
+    int getMaxTerminalSize() const { return mTerminalDicNodes->getMaxSize(); }
+    void copyTerminalDicNodesTo(std::vector<DicNode> *const dest) const {
+        mTerminalDicNodes->copyDicNodesTo(dest);
     }
 
+    bool usesLargeCapacityCache() const { return mUsesLargeCapacityCache; }
     int activeSize() const { return mActiveDicNodes->getSize(); }
     int terminalSize() const { return mTerminalDicNodes->getSize(); }
+    // Heap bytes held by the dicNode pool and the priority queues.
+    size_t getMemorySize() const {
+        return mDicNodePool.getMemorySize()
+                + mDicNodePriorityQueue0.getMemorySize() + mDicNodePriorityQueue1.getMemorySize()
+                + mDicNodePriorityQueueForTerminal.getMemorySize();
+    }
+    // Input index and ordinal of the current step.
+    int getInputIndex() const { return mInputIndex; }
+    uint32_t getStepOrdinal() const { return mStepOrdinal; }
     bool isLookAheadCorrectionInputIndex(const int inputIndex) const {
         return inputIndex == mInputIndex - 1;
     }
@@ -86,63 +211,45 @@ class DicNodesCache {
     }
 
     AK_FORCE_INLINE void copyPushTerminal(DicNode *dicNode) {
+        mQueryStats->terminalDicNodeCount++;
+        dicNode->setPushOrder(getNextPushOrder());
         mTerminalDicNodes->copyPush(dicNode);
     }
 
     AK_FORCE_INLINE void copyPushActive(DicNode *dicNode) {
-        mActiveDicNodes->copyPush(dicNode);
-    }
-
-    AK_FORCE_INLINE void copyPushContinue(DicNode *dicNode) {
-        mCachedDicNodesForContinuousSuggestion->copyPush(dicNode);
+        mQueryStats->pushedDicNodeCount++;
+        dicNode->setPushOrder(getNextPushOrder());
+        if (!mActiveDicNodes->copyPush(dicNode)) {
+            mQueryStats->evictedDicNodeCount++;
+        }
     }
 
     AK_FORCE_INLINE void copyPushNextActive(DicNode *dicNode) {
-        mNextActiveDicNodes->copyPush(dicNode);
-    }
-
-    void popTerminal(DicNode *dest) {
-        mTerminalDicNodes->copyPop(dest);
-    }
-
-    void popActive(DicNode *dest) {
-        mActiveDicNodes->copyPop(dest);
-    }
-
-    bool hasCachedDicNodesForContinuousSuggestion() const {
-        return mCachedDicNodesForContinuousSuggestion
-                && mCachedDicNodesForContinuousSuggestion->getSize() > 0;
+        mQueryStats->pushedDicNodeCount++;
+        dicNode->setPushOrder(getNextPushOrder());
+        if (!mNextActiveDicNodes->copyPush(dicNode)) {
+            mQueryStats->evictedDicNodeCount++;
+        }
     }
 
-    AK_FORCE_INLINE bool isCacheBorderForTyping(const int inputSize) const {
-        // TODO: Move this variable to header
-        static const int CACHE_BACK_LENGTH = 3;
-        const int cacheInputIndex = inputSize - CACHE_BACK_LENGTH;
-        const bool shouldCache = (cacheInputIndex == mInputIndex)
-                && (cacheInputIndex != mLastCachedInputIndex);
-        return shouldCache;
+    // Writes the terminal dicNodes to outDicNodes from the best to the worst, up to maxCount of
+    // them, and returns their count; see DicNodePriorityQueue::sortAndGetDicNodes(). They are
+    // read in place and stay valid until the next search resets or restores the queues.
+    int sortAndGetTerminalDicNodes(const int maxCount, const DicNode **const outDicNodes) {
+        return mTerminalDicNodes->sortAndGetDicNodes(maxCount, outDicNodes);
     }
 
-    AK_FORCE_INLINE void updateLastCachedInputIndex() {
-        mLastCachedInputIndex = mInputIndex;
+    // The returned dicNode is not copied out of the active queue; it stays valid until the
+    // next popActive() or until the queues are advanced, reset or restored.
+    DicNode *popActive() {
+        mQueryStats->expandedDicNodeCount++;
+        beginExpansion(mExpansionOrdinal + 1);
+        return mActiveDicNodes->pop();
     }
 
  private:
     DISALLOW_COPY_AND_ASSIGN(DicNodesCache);
 
-    AK_FORCE_INLINE void restoreActiveDicNodesFromCache() {
-        if (DEBUG_DICT) {
-            AKLOGI("Restore %d nodes. inputIndex = %d.",
-                    mCachedDicNodesForContinuousSuggestion->getSize(), mLastCachedInputIndex);
-        }
-        if (DEBUG_DICT_FULL || DEBUG_CACHE) {
-            mCachedDicNodesForContinuousSuggestion->dump();
-        }
-        mInputIndex = mLastCachedInputIndex;
-        mCachedDicNodesForContinuousSuggestion = moveNodesAndReturnReusableEmptyQueue(
-                mCachedDicNodesForContinuousSuggestion, &mActiveDicNodes);
-    }
-
     AK_FORCE_INLINE static DicNodePriorityQueue *moveNodesAndReturnReusableEmptyQueue(
             DicNodePriorityQueue *src, DicNodePriorityQueue **dest) {
         const int srcMaxSize = src->getMaxSize();
@@ -159,32 +266,57 @@ class DicNodesCache {
                 LARGE_PRIORITY_QUEUE_CAPACITY : SMALL_PRIORITY_QUEUE_CAPACITY;
     }
 
+    // Nodes the queues take from the pool at most; see DicNodePriorityQueue. The queues trade
+    // roles but only the terminal one is resized past the cache capacity.
+    AK_FORCE_INLINE int getDicNodePoolCapacity(const int terminalSize) const {
+        return 2 * (getCacheCapacity() + 2) + terminalSize + 2;
+    }
+
+    AK_FORCE_INLINE void advanceStepOrdinal() {
+        mStepOrdinal++;
+        mExpansionOrdinal = 0;
+        mPushOrdinal = 0;
+    }
+
+    AK_FORCE_INLINE uint64_t getNextPushOrder() {
+        return (static_cast<uint64_t>(mStepOrdinal) << 48)
+                | (static_cast<uint64_t>(mExpansionOrdinal) << 32) | mPushOrdinal++;
+    }
+
     AK_FORCE_INLINE void resetTemporaryCaches() {
         mActiveDicNodes->clear();
         mNextActiveDicNodes->clear();
         mTerminalDicNodes->clear();
+        mIsActiveDicNodesTrimmed = false;
     }
 
     static const int LARGE_PRIORITY_QUEUE_CAPACITY;
     static const int SMALL_PRIORITY_QUEUE_CAPACITY;
 
     const bool mUsesLargeCapacityCache;
+    QueryStats *const mQueryStats;
     // Instances
+    // The nodes of all the queues. Moving nodes from a queue to another hands its pool indices
+    // over without copying the nodes.
+    DicNodePool mDicNodePool;
     DicNodePriorityQueue mDicNodePriorityQueue0;
     DicNodePriorityQueue mDicNodePriorityQueue1;
-    DicNodePriorityQueue mDicNodePriorityQueue2;
     DicNodePriorityQueue mDicNodePriorityQueueForTerminal;
 
     // Active dicNodes currently being expanded.
     DicNodePriorityQueue *mActiveDicNodes;
     // Next dicNodes to be expanded.
     DicNodePriorityQueue *mNextActiveDicNodes;
-    // Cached dicNodes used for continuous suggestion.
-    DicNodePriorityQueue *mCachedDicNodesForContinuousSuggestion;
     // Current top terminal dicNodes.
     DicNodePriorityQueue *mTerminalDicNodes;
     int mInputIndex;
-    int mLastCachedInputIndex;
+    // Parts of the push order; see the class comment. The step ordinal goes back to the one of a
+    // checkpoint when the search resumes from it.
+    uint32_t mStepOrdinal;
+    int mExpansionOrdinal;
+    uint32_t mPushOrdinal;
+    // Whether the active dicNodes are a beam restored with its terminals; see continueSearch().
+    bool mIsActiveDicNodesTrimmed;
 };
 } // namespace latinime
 #endif // LATINIME_DIC_NODES_CACHE_H
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_DIC_NODE_OUTPUT_ARENA_H
+#define LATINIME_DIC_NODE_OUTPUT_ARENA_H
+
+#include <vector>
+
+#include "../../../../defines.h"
+
+namespace latinime {
+
+/**
+ * Output code points of the dicNodes of a search, stored as a tree of shared prefixes. Each
+ * entry holds one code point and the index of the entry before it, so an output is referred to
+ * by the index of its last code point, and all outputs extending it share its entries. Entries
+ * are only appended; they stay valid until clear() or until truncate() drops them.
+ *
+ * An arena can also extend a base arena that is not appended to in the meantime, for a thread
+ * to add to outputs of the base arena without writing to it: indices below the entry count of
+ * the base are the base's entries, and entries appended to the extension follow them. Outputs
+ * are moved to the base later with moveToBase().
+ */
+class DicNodeOutputArena {
+ public:
+    DicNodeOutputArena()
+            : mBase(nullptr), mBaseEntryCount(0), mEntries(), mBaseIndices(),
+              mMovedEntryIndices() {}
+    ~DicNodeOutputArena() {}
+
+    AK_FORCE_INLINE void clear() {
+        mEntries.clear();
+        mBaseIndices.clear();
+    }
+
+    // Drops the entries appended after the first entryCount, the outputs of the dicNodes of a
+    // search step that is done again. Not for an arena extending another.
+    AK_FORCE_INLINE void truncate(const int entryCount) {
+        ASSERT(!mBase && entryCount <= getEntryCount());
+        mEntries.erase(mEntries.begin() + entryCount, mEntries.end());
+    }
+
+    // Clears this arena and makes it extend base as base is now. base must not extend another
+    // arena.
+    void initAsExtensionOf(DicNodeOutputArena *const base) {
+        clear();
+        mBase = base;
+        mBaseEntryCount = base->getEntryCount();
+    }
+
+    DicNodeOutputArena *getBase() const {
+        return mBase;
+    }
+
+    // Appends the entries of the output ending at index that are not in the base arena yet to
+    // it, once for all the outputs sharing them, and returns the index the output ends at in
+    // the base arena.
+    int moveToBase(const int index) {
+        mBaseIndices.resize(mEntries.size(), NOT_AN_INDEX);
+        mMovedEntryIndices.clear();
+        int baseIndex = index;
+        while (baseIndex >= mBaseEntryCount) {
+            const int entryIndex = baseIndex - mBaseEntryCount;
+            if (mBaseIndices[entryIndex] != NOT_AN_INDEX) {
+                break;
+            }
+            mMovedEntryIndices.push_back(entryIndex);
+            baseIndex = mEntries[entryIndex].mPrefixIndex;
+        }
+        if (baseIndex >= mBaseEntryCount) {
+            baseIndex = mBaseIndices[baseIndex - mBaseEntryCount];
+        }
+        for (auto it = mMovedEntryIndices.rbegin(); it != mMovedEntryIndices.rend(); ++it) {
+            baseIndex = mBase->append(baseIndex, &mEntries[*it].mCodePoint, 1);
+            mBaseIndices[*it] = baseIndex;
+        }
+        return baseIndex;
+    }
+
+    // Appends count code points to the output ending at prefixIndex (NOT_AN_INDEX for the
+    // empty output) and returns the index the new output ends at.
+    AK_FORCE_INLINE int append(int prefixIndex, const int *const codePoints, const int count) {
+        for (int i = 0; i < count; ++i) {
+            mEntries.push_back(Entry(prefixIndex, codePoints[i]));
+            prefixIndex = mBaseEntryCount + static_cast<int>(mEntries.size()) - 1;
+        }
+        return prefixIndex;
+    }
+
+    AK_FORCE_INLINE int getCodePoint(const int index) const {
+        if (index < mBaseEntryCount) {
+            return mBase->mEntries[index].mCodePoint;
+        }
+        return mEntries[index - mBaseEntryCount].mCodePoint;
+    }
+
+    AK_FORCE_INLINE int getPrefixIndex(const int index) const {
+        if (index < mBaseEntryCount) {
+            return mBase->mEntries[index].mPrefixIndex;
+        }
+        return mEntries[index - mBaseEntryCount].mPrefixIndex;
+    }
+
+    // Including the entries of the base arena.
+    int getEntryCount() const {
+        return mBaseEntryCount + static_cast<int>(mEntries.size());
+    }
+
+    size_t getMemorySize() const {
+        return mEntries.capacity() * sizeof(Entry) + mBaseIndices.capacity() * sizeof(int)
+                + mMovedEntryIndices.capacity() * sizeof(int);
+    }
+
+ private:
+    DISALLOW_COPY_AND_ASSIGN(DicNodeOutputArena);
+
+    struct Entry {
+        Entry(const int prefixIndex, const int codePoint)
+                : mPrefixIndex(prefixIndex), mCodePoint(codePoint) {}
+
+        int mPrefixIndex;
+        int mCodePoint;
+    };
+
+    DicNodeOutputArena *mBase;
+    int mBaseEntryCount;
+    std::vector<Entry> mEntries;
+    // Index in the base arena of each entry already moved there, NOT_AN_INDEX for the others.
+    std::vector<int> mBaseIndices;
+    // Entries being moved by moveToBase(), from the last one back.
+    std::vector<int> mMovedEntryIndices;
+};
+} // namespace latinime
+#endif // LATINIME_DIC_NODE_OUTPUT_ARENA_H
@@ -18,6 +18,7 @@
 #define LATINIME_DIC_NODE_PROPERTIES_H
 
 #include <cstdint>
+#include <cstring> // for memmove()
 
 #include "../../../../defines.h"
 
@@ -32,14 +33,16 @@ class DicNodeProperties {
             : mPtNodePos(NOT_A_DICT_POS), mChildrenPtNodeArrayPos(NOT_A_DICT_POS),
               mProbability(NOT_A_PROBABILITY), mDicNodeCodePoint(NOT_A_CODE_POINT),
               mIsTerminal(false), mHasChildrenPtNodes(false),
-              mIsBlacklistedOrNotAWord(false), mDepth(0), mLeavingDepth(0) {}
+              mIsBlacklistedOrNotAWord(false), mDictionaryIndex(0), mDepth(0),
+              mLeavingDepth(0) {}
 
     ~DicNodeProperties() {}
 
     // Should be called only once per DicNode is initialized.
     void init(const int pos, const int childrenPos, const int nodeCodePoint, const int probability,
             const bool isTerminal, const bool hasChildren, const bool isBlacklistedOrNotAWord,
-            const uint16_t depth, const uint16_t leavingDepth, const int *const prevWordsNodePos) {
+            const uint16_t depth, const uint16_t leavingDepth, const uint8_t dictionaryIndex,
+            const int *const prevWordsNodePos) {
         mPtNodePos = pos;
         mChildrenPtNodeArrayPos = childrenPos;
         mDicNodeCodePoint = nodeCodePoint;
@@ -47,13 +50,15 @@ class DicNodeProperties {
         mIsTerminal = isTerminal;
         mHasChildrenPtNodes = hasChildren;
         mIsBlacklistedOrNotAWord = isBlacklistedOrNotAWord;
+        mDictionaryIndex = dictionaryIndex;
         mDepth = depth;
         mLeavingDepth = leavingDepth;
         memmove(mPrevWordsTerminalPtNodePos, prevWordsNodePos, sizeof(mPrevWordsTerminalPtNodePos));
     }
 
     // Init for root with prevWordsPtNodePos which is used for n-gram
-    void init(const int rootPtNodeArrayPos, const int *const prevWordsNodePos) {
+    void init(const int rootPtNodeArrayPos, const uint8_t dictionaryIndex,
+            const int *const prevWordsNodePos) {
         mPtNodePos = NOT_A_DICT_POS;
         mChildrenPtNodeArrayPos = rootPtNodeArrayPos;
         mDicNodeCodePoint = NOT_A_CODE_POINT;
@@ -61,6 +66,7 @@ class DicNodeProperties {
         mIsTerminal = false;
         mHasChildrenPtNodes = true;
         mIsBlacklistedOrNotAWord = false;
+        mDictionaryIndex = dictionaryIndex;
         mDepth = 0;
         mLeavingDepth = 0;
         memmove(mPrevWordsTerminalPtNodePos, prevWordsNodePos, sizeof(mPrevWordsTerminalPtNodePos));
@@ -74,6 +80,7 @@ class DicNodeProperties {
         mIsTerminal = dicNodeProp->mIsTerminal;
         mHasChildrenPtNodes = dicNodeProp->mHasChildrenPtNodes;
         mIsBlacklistedOrNotAWord = dicNodeProp->mIsBlacklistedOrNotAWord;
+        mDictionaryIndex = dicNodeProp->mDictionaryIndex;
         mDepth = dicNodeProp->mDepth;
         mLeavingDepth = dicNodeProp->mLeavingDepth;
         memmove(mPrevWordsTerminalPtNodePos, dicNodeProp->mPrevWordsTerminalPtNodePos,
@@ -89,6 +96,7 @@ class DicNodeProperties {
         mIsTerminal = dicNodeProp->mIsTerminal;
         mHasChildrenPtNodes = dicNodeProp->mHasChildrenPtNodes;
         mIsBlacklistedOrNotAWord = dicNodeProp->mIsBlacklistedOrNotAWord;
+        mDictionaryIndex = dicNodeProp->mDictionaryIndex;
         mDepth = dicNodeProp->mDepth + 1; // Increment the depth of a passing child
         mLeavingDepth = dicNodeProp->mLeavingDepth;
         memmove(mPrevWordsTerminalPtNodePos, dicNodeProp->mPrevWordsTerminalPtNodePos,
@@ -136,6 +144,11 @@ class DicNodeProperties {
         return mPrevWordsTerminalPtNodePos;
     }
 
+    // Index of the dictionary of the PtNode in the DictionaryGroup of the search.
+    uint8_t getDictionaryIndex() const {
+        return mDictionaryIndex;
+    }
+
  private:
     // Caution!!!
     // Use a default copy constructor and an assign operator because shallow copies are ok
@@ -147,6 +160,7 @@ class DicNodeProperties {
     bool mIsTerminal;
     bool mHasChildrenPtNodes;
     bool mIsBlacklistedOrNotAWord;
+    uint8_t mDictionaryIndex;
     uint16_t mDepth;
     uint16_t mLeavingDepth;
     int mPrevWordsTerminalPtNodePos[MAX_PREV_WORD_COUNT_FOR_N_GRAM];
@@ -47,9 +47,9 @@ class DicNodeState {
     }
 
     // Init for root
-    void init() {
+    void init(DicNodeOutputArena *const outputArena) {
         mDicNodeStateInput.init();
-        mDicNodeStateOutput.init();
+        mDicNodeStateOutput.init(outputArena);
         mDicNodeStateScoring.init();
     }
 
@@ -19,54 +19,66 @@
 
 #include <algorithm>
 #include <cstdint>
-#include <cstring> // for memmove()
 
 #include "../../../../defines.h"
-
+#include "dic_node_output_arena.h"
 
 namespace latinime {
 
 // Class to have information to be output. This can contain previous words when the suggestion
 // is a multi-word suggestion.
+//
+// The output is not kept in the node. Its code points up to the last commitCodePoints() live in
+// a DicNodeOutputArena, shared with every node derived from this one, and only the few code
+// points added since are kept here. Copying a node thus copies a reference to the shared prefix
+// instead of the whole word. The first code points of the current word are also kept here, as
+// comparing nodes reads them far more often than the rest.
 class DicNodeStateOutput {
  public:
     DicNodeStateOutput()
-            : mOutputtedCodePointCount(0), mCurrentWordStart(0), mPrevWordCount(0),
+            : mArena(nullptr), mPrefixIndex(NOT_AN_INDEX), mOutputtedCodePointCount(0),
+              mPendingCodePointCount(0), mCurrentWordStart(0), mPrevWordCount(0),
               mPrevWordsLength(0), mPrevWordStart(0), mSecondWordFirstInputIndex(NOT_AN_INDEX) {}
 
     ~DicNodeStateOutput() {}
 
-    // Init for root
-    void init() {
+    // Init for root. The arena must outlive every node derived from this one.
+    void init(DicNodeOutputArena *const arena) {
+        mArena = arena;
+        mPrefixIndex = NOT_AN_INDEX;
         mOutputtedCodePointCount = 0;
+        mPendingCodePointCount = 0;
         mCurrentWordStart = 0;
-        mOutputCodePoints[0] = 0;
         mPrevWordCount = 0;
         mPrevWordsLength = 0;
         mPrevWordStart = 0;
         mSecondWordFirstInputIndex = NOT_AN_INDEX;
+        clearCurrentWordHead();
     }
 
     // Init for next word.
     void init(const DicNodeStateOutput *const stateOutput) {
-        mOutputtedCodePointCount = stateOutput->mOutputtedCodePointCount + 1;
-        memmove(mOutputCodePoints, stateOutput->mOutputCodePoints,
-                stateOutput->mOutputtedCodePointCount * sizeof(mOutputCodePoints[0]));
-        mOutputCodePoints[stateOutput->mOutputtedCodePointCount] = KEYCODE_SPACE;
+        initByCopy(stateOutput);
+        const int space = KEYCODE_SPACE;
+        appendCodePoints(&space, 1);
         mCurrentWordStart = stateOutput->mOutputtedCodePointCount + 1;
         mPrevWordCount = std::min(static_cast<int16_t>(stateOutput->mPrevWordCount + 1),
                 static_cast<int16_t>(MAX_RESULTS));
         mPrevWordsLength = stateOutput->mOutputtedCodePointCount + 1;
         mPrevWordStart = stateOutput->mCurrentWordStart;
-        mSecondWordFirstInputIndex = stateOutput->mSecondWordFirstInputIndex;
+        clearCurrentWordHead();
     }
 
-    void initByCopy(const DicNodeStateOutput *const stateOutput) {
-        memmove(mOutputCodePoints, stateOutput->mOutputCodePoints,
-                stateOutput->mOutputtedCodePointCount * sizeof(mOutputCodePoints[0]));
+    AK_FORCE_INLINE void initByCopy(const DicNodeStateOutput *const stateOutput) {
+        mArena = stateOutput->mArena;
+        mPrefixIndex = stateOutput->mPrefixIndex;
         mOutputtedCodePointCount = stateOutput->mOutputtedCodePointCount;
-        if (mOutputtedCodePointCount < MAX_WORD_LENGTH) {
-            mOutputCodePoints[mOutputtedCodePointCount] = 0;
+        mPendingCodePointCount = stateOutput->mPendingCodePointCount;
+        for (int i = 0; i < mPendingCodePointCount; ++i) {
+            mPendingCodePoints[i] = stateOutput->mPendingCodePoints[i];
+        }
+        for (int i = 0; i < CURRENT_WORD_HEAD_LENGTH; ++i) {
+            mCurrentWordHead[i] = stateOutput->mCurrentWordHead[i];
         }
         mCurrentWordStart = stateOutput->mCurrentWordStart;
         mPrevWordCount = stateOutput->mPrevWordCount;
@@ -81,22 +93,83 @@ class DicNodeStateOutput {
             const int additionalCodePointCount = std::min(
                     static_cast<int>(mergedNodeCodePointCount),
                     MAX_WORD_LENGTH - mOutputtedCodePointCount);
-            memmove(&mOutputCodePoints[mOutputtedCodePointCount], mergedNodeCodePoints,
-                    additionalCodePointCount * sizeof(mOutputCodePoints[0]));
-            mOutputtedCodePointCount = static_cast<uint16_t>(
-                    mOutputtedCodePointCount + additionalCodePointCount);
-            if (mOutputtedCodePointCount < MAX_WORD_LENGTH) {
-                mOutputCodePoints[mOutputtedCodePointCount] = 0;
-            }
+            appendCodePoints(mergedNodeCodePoints, additionalCodePointCount);
+        }
+    }
+
+    // Moves the code points kept in this node to the arena, so that the nodes derived from it
+    // share them. Worth calling on a node before its children are created.
+    AK_FORCE_INLINE void commitCodePoints() {
+        if (mPendingCodePointCount > 0) {
+            mPrefixIndex = mArena->append(mPrefixIndex, mPendingCodePoints,
+                    mPendingCodePointCount);
+            mPendingCodePointCount = 0;
         }
     }
 
+    // Makes the output refer to arena, which must be its arena or extend it.
+    void setArena(DicNodeOutputArena *const arena) {
+        mArena = arena;
+    }
+
+    // Moves the committed code points to the base of the arena, which must extend another one,
+    // and makes the output refer to the base.
+    void moveToBaseArena() {
+        mPrefixIndex = mArena->moveToBase(mPrefixIndex);
+        mArena = mArena->getBase();
+    }
+
     int getCurrentWordCodePointAt(const int index) const {
-        return mOutputCodePoints[mCurrentWordStart + index];
+        if (index < CURRENT_WORD_HEAD_LENGTH) {
+            return mCurrentWordHead[index];
+        }
+        return getOutputCodePointAt(mCurrentWordStart + index);
     }
 
-    const int *getCodePointBuf() const {
-        return mOutputCodePoints;
+    // Code point at id of the whole output, 0 past its end.
+    int getOutputCodePointAt(const int id) const {
+        int codePoint = 0;
+        getCodePoints(id, 1, &codePoint);
+        return codePoint;
+    }
+
+    // Writes the code points of the output from start on to dest[0, count), 0 past its end.
+    // Reading from the arena walks back from the end of the output, so reading several code
+    // points in one call is much cheaper than reading them one by one.
+    void getCodePoints(const int start, const int count, int *const dest) const {
+        ReverseCodePointReader reader(this, start + count);
+        for (int i = count - 1; i >= 0; --i) {
+            dest[i] = reader.readPrevious();
+        }
+    }
+
+    // Compares the first length code points of the current words of this output and of right
+    // in code point order: negative when this one comes first, positive when right does and 0
+    // when they are the same. Past their heads, the words are read from their ends and the
+    // reading stops where they share arena entries, so words that only differ near their ends
+    // compare quickly.
+    int compareCurrentWords(const DicNodeStateOutput *const right, const int length) const {
+        const int headLength = std::min(length, CURRENT_WORD_HEAD_LENGTH);
+        for (int i = 0; i < headLength; ++i) {
+            if (mCurrentWordHead[i] != right->mCurrentWordHead[i]) {
+                return mCurrentWordHead[i] < right->mCurrentWordHead[i] ? -1 : 1;
+            }
+        }
+        ReverseCodePointReader reader(this, mCurrentWordStart + length);
+        ReverseCodePointReader rightReader(right, right->mCurrentWordStart + length);
+        int order = 0;
+        for (int i = length - 1; i >= CURRENT_WORD_HEAD_LENGTH; --i) {
+            if (reader.isAtSameEntryAs(&rightReader)) {
+                // The rest of both words is the same prefix.
+                break;
+            }
+            const int codePoint = reader.readPrevious();
+            const int rightCodePoint = rightReader.readPrevious();
+            if (codePoint != rightCodePoint) {
+                order = codePoint < rightCodePoint ? -1 : 1;
+            }
+        }
+        return order;
     }
 
     void setSecondWordFirstInputIndex(const int inputIndex) {
@@ -120,13 +193,81 @@ class DicNodeStateOutput {
         return mPrevWordStart;
     }
 
-    int getOutputCodePointAt(const int id) const {
-        return mOutputCodePoints[id];
-    }
-
  private:
     DISALLOW_COPY_AND_ASSIGN(DicNodeStateOutput);
 
+    // Code points kept in the node before they go to the arena. Most trie nodes add one code
+    // point, so a few are enough for a node and the children created from it.
+    static const int MAX_PENDING_CODE_POINT_COUNT = 4;
+    // Leading code points of the current word kept in the node; ties between nodes are mostly
+    // decided by them.
+    static const int CURRENT_WORD_HEAD_LENGTH = 4;
+
+    // Reads the code points of an output before a given end one by one, from the last one back.
+    class ReverseCodePointReader {
+     public:
+        AK_FORCE_INLINE ReverseCodePointReader(const DicNodeStateOutput *const output,
+                const int end)
+                : mOutput(output), mPosition(end), mIndex(output->mPrefixIndex),
+                  mCommittedCount(output->mOutputtedCodePointCount
+                          - output->mPendingCodePointCount) {
+            for (int i = mCommittedCount; i > end; --i) {
+                mIndex = mOutput->mArena->getPrefixIndex(mIndex);
+            }
+        }
+
+        // Returns the code point before the last one read, 0 past the end of the output.
+        AK_FORCE_INLINE int readPrevious() {
+            --mPosition;
+            if (mPosition >= mCommittedCount) {
+                return mPosition < mOutput->mOutputtedCodePointCount
+                        ? mOutput->mPendingCodePoints[mPosition - mCommittedCount] : 0;
+            }
+            const int codePoint = mOutput->mArena->getCodePoint(mIndex);
+            mIndex = mOutput->mArena->getPrefixIndex(mIndex);
+            return codePoint;
+        }
+
+        // Whether the code points left to read are the same arena entries as the ones left to
+        // read by the other reader.
+        AK_FORCE_INLINE bool isAtSameEntryAs(const ReverseCodePointReader *const other) const {
+            return mPosition <= mCommittedCount && other->mPosition <= other->mCommittedCount
+                    && mIndex == other->mIndex && mIndex != NOT_AN_INDEX;
+        }
+
+     private:
+        const DicNodeStateOutput *const mOutput;
+        int mPosition;
+        int mIndex;
+        const int mCommittedCount;
+    };
+
+    AK_FORCE_INLINE void clearCurrentWordHead() {
+        for (int i = 0; i < CURRENT_WORD_HEAD_LENGTH; ++i) {
+            mCurrentWordHead[i] = 0;
+        }
+    }
+
+    AK_FORCE_INLINE void appendCodePoints(const int *const codePoints, const int count) {
+        const int currentWordLength = mOutputtedCodePointCount - mCurrentWordStart;
+        for (int i = 0; i < count && currentWordLength + i < CURRENT_WORD_HEAD_LENGTH; ++i) {
+            mCurrentWordHead[currentWordLength + i] = codePoints[i];
+        }
+        if (mPendingCodePointCount + count > MAX_PENDING_CODE_POINT_COUNT) {
+            commitCodePoints();
+            if (count > MAX_PENDING_CODE_POINT_COUNT) {
+                mPrefixIndex = mArena->append(mPrefixIndex, codePoints, count);
+                mOutputtedCodePointCount = static_cast<uint16_t>(mOutputtedCodePointCount + count);
+                return;
+            }
+        }
+        for (int i = 0; i < count; ++i) {
+            mPendingCodePoints[mPendingCodePointCount + i] = codePoints[i];
+        }
+        mPendingCodePointCount = static_cast<uint16_t>(mPendingCodePointCount + count);
+        mOutputtedCodePointCount = static_cast<uint16_t>(mOutputtedCodePointCount + count);
+    }
+
     // When the DicNode represents "this is a pen":
     // mOutputtedCodePointCount is 13, which is total code point count of "this is a pen" including
     // spaces.
@@ -136,15 +277,22 @@ class DicNodeStateOutput {
     // mPrevWordStart is the start index of "a"; thus, it is 8.
     // mSecondWordFirstInputIndex is the first input index of "is".
 
+    DicNodeOutputArena *mArena;
+    // Arena index of the last committed code point, NOT_AN_INDEX when none is committed.
+    int mPrefixIndex;
     uint16_t mOutputtedCodePointCount;
-    int mOutputCodePoints[MAX_WORD_LENGTH];
+    // The last mPendingCodePointCount code points of the output are in mPendingCodePoints.
+    uint16_t mPendingCodePointCount;
+    int mPendingCodePoints[MAX_PENDING_CODE_POINT_COUNT];
+    // The first code points of the current word, 0 past its end.
+    int mCurrentWordHead[CURRENT_WORD_HEAD_LENGTH];
     int16_t mCurrentWordStart;
-    // Previous word count in mOutputCodePoints.
+    // Previous word count in the output.
     int16_t mPrevWordCount;
-    // Total length of previous words in mOutputCodePoints. This is being used by the algorithm
+    // Total length of previous words in the output. This is being used by the algorithm
     // that may want to look at the previous word information.
     int16_t mPrevWordsLength;
-    // Start index of the previous word in mOutputCodePoints. This is being used for auto commit.
+    // Start index of the previous word in the output. This is being used for auto commit.
     int16_t mPrevWordStart;
     int mSecondWordFirstInputIndex;
 };
@@ -44,6 +44,10 @@ class BloomFilter {
         return mFilter.test(getIndex(position));
     }
 
+    AK_FORCE_INLINE void clear() {
+        mFilter.reset();
+    }
+
  private:
     DISALLOW_ASSIGNMENT_OPERATOR(BloomFilter);
 
@@ -16,10 +16,10 @@
 
 #define LOG_TAG "LatinIME: dictionary.cpp"
 
-#include <iostream>
 #include "dictionary.h"
 #include "../../../defines.h"
 
+#include "dictionary_group.h"
 #include "dictionary_utils.h"
 #include "../policy/dictionary_header_structure_policy.h"
 #include "../result/suggestion_results.h"
@@ -37,12 +37,10 @@ const int Dictionary::HEADER_ATTRIBUTE_BUFFER_SIZE = 32;
 
 Dictionary::Dictionary(DictionaryStructureWithBufferPolicy::StructurePolicyPtr dictionaryStructureWithBufferPolicy)
         : mDictionaryStructureWithBufferPolicy(std::move(dictionaryStructureWithBufferPolicy)),
-          mGestureSuggest(new Suggest(GestureSuggestPolicyFactory::getGestureSuggestPolicy())),
-          mTypingSuggest(new Suggest(TypingSuggestPolicyFactory::getTypingSuggestPolicy())) {
-              
-              static const SuggestPolicy *policy = TypingSuggestPolicyFactory::getTypingSuggestPolicy();
-              const Traversal *traversal = policy->getTraversal();
-              std::cout << traversal << std::endl;
+          mGestureSuggest(
+                  new PolicySuggest(GestureSuggestPolicyFactory::getGestureSuggestPolicy())),
+          mTypingSuggest(new TypingSuggest(TypingSuggestPolicyFactory::getTypingSuggestPolicy())),
+          mDigraphCodePoints(mDictionaryStructureWithBufferPolicy->getHeaderStructurePolicy()) {
 }
 
 void Dictionary::getSuggestions(ProximityInfo *proximityInfo, DicTraverseSession *traverseSession,
@@ -50,15 +48,31 @@ void Dictionary::getSuggestions(ProximityInfo *proximityInfo, DicTraverseSession
         int inputSize, const PrevWordsInfo *const prevWordsInfo,
         const SuggestOptions *const suggestOptions, const float languageWeight,
         SuggestionResults *const outSuggestionResults) const {
+    const DictionaryGroup dictionaryGroup(this);
+    getSuggestions(&dictionaryGroup, proximityInfo, traverseSession, xcoordinates, ycoordinates,
+            times, pointerIds, inputCodePoints, inputSize, prevWordsInfo, suggestOptions,
+            languageWeight, outSuggestionResults);
+}
+
+void Dictionary::getSuggestions(const DictionaryGroup *const dictionaryGroup,
+        ProximityInfo *proximityInfo, DicTraverseSession *traverseSession,
+        int *xcoordinates, int *ycoordinates, int *times, int *pointerIds, int *inputCodePoints,
+        int inputSize, const PrevWordsInfo *const prevWordsInfo,
+        const SuggestOptions *const suggestOptions, const float languageWeight,
+        SuggestionResults *const outSuggestionResults) const {
+    ASSERT(dictionaryGroup->getDictionary(0) == this);
     TimeKeeper::setCurrentTime();
-    traverseSession->init(this, prevWordsInfo, suggestOptions);
+    QueryStats *const queryStats = traverseSession->getQueryStats();
+    queryStats->reset();
+    const QueryStats::Clock::time_point startTime = QueryStats::Clock::now();
+    traverseSession->init(dictionaryGroup, prevWordsInfo, suggestOptions);
+    traverseSession->startSearchBudget(startTime);
+    queryStats->sessionInitNanos = QueryStats::getElapsedNanos(startTime);
     const auto &suggest = suggestOptions->isGesture() ? mGestureSuggest : mTypingSuggest;
-    
-    std::cout << &mTypingSuggest << std::endl;
-    
     suggest->getSuggestions(proximityInfo, traverseSession, xcoordinates,
             ycoordinates, times, pointerIds, inputCodePoints, inputSize,
             languageWeight, outSuggestionResults);
+    queryStats->totalNanos = QueryStats::getElapsedNanos(startTime);
     if (DEBUG_DICT) {
         outSuggestionResults->dumpSuggestions();
     }
@@ -21,6 +21,7 @@
 #include "../../../defines.h"
 
 //#include "jni.h"
+#include "digraph_code_points.h"
 #include "ngram_listener.h"
 //#include "property/word_property.h"
 #include "../policy/dictionary_header_structure_policy.h"
@@ -29,6 +30,7 @@
 
 namespace latinime {
 
+class DictionaryGroup;
 class DictionaryStructureWithBufferPolicy;
 class DicTraverseSession;
 class PrevWordsInfo;
@@ -68,6 +70,15 @@ class Dictionary {
             const SuggestOptions *const suggestOptions, const float languageWeight,
             SuggestionResults *const outSuggestionResults) const;
 
+    // As above, walking the dictionaries of dictionaryGroup, whose main dictionary must be this
+    // one, in the same search; see DictionaryGroup.
+    void getSuggestions(const DictionaryGroup *const dictionaryGroup,
+            ProximityInfo *proximityInfo, DicTraverseSession *traverseSession,
+            int *xcoordinates, int *ycoordinates, int *times, int *pointerIds, int *inputCodePoints,
+            int inputSize, const PrevWordsInfo *const prevWordsInfo,
+            const SuggestOptions *const suggestOptions, const float languageWeight,
+            SuggestionResults *const outSuggestionResults) const;
+
     void getPredictions(const PrevWordsInfo *const prevWordsInfo,
             SuggestionResults *const outSuggestionResults) const;
 
@@ -110,6 +121,10 @@ class Dictionary {
         return mDictionaryStructureWithBufferPolicy.get();
     }
 
+    const DigraphCodePoints *getDigraphCodePoints() const {
+        return &mDigraphCodePoints;
+    }
+
     const DictionaryStructureWithBufferPolicy::StructurePolicyPtr
             mDictionaryStructureWithBufferPolicy;
  private:
@@ -137,6 +152,7 @@ class Dictionary {
 
     const SuggestInterfacePtr mGestureSuggest;
     const SuggestInterfacePtr mTypingSuggest;
+    const DigraphCodePoints mDigraphCodePoints;
 
 //    void logDictionaryInfo(JNIEnv *const env) const;
 };
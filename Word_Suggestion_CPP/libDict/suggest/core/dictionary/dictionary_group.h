@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_DICTIONARY_GROUP_H
+#define LATINIME_DICTIONARY_GROUP_H
+
+#include "../../../defines.h"
+
+namespace latinime {
+
+class Dictionary;
+
+/**
+ * The dictionaries one search walks at once: a main dictionary and up to
+ * MAX_DICTIONARY_COUNT - 1 others, such as a user dictionary or a list of contacts. The search
+ * starts at the root of each of them and keeps their dicNodes in the same queues, so the input
+ * is set up and matched once and the beam is shared; each dicNode carries the index of its
+ * dictionary in the group.
+ *
+ * Each dictionary has a language weight, which multiplies the language cost of its words: 1,
+ * the weight of the main dictionary, scores them as the main dictionary does, a lower weight
+ * favours them and a higher one demotes them. The header of the main dictionary decides the
+ * settings of the whole search, such as the multiple word cost and exact match boosting.
+ */
+class DictionaryGroup {
+ public:
+    static const int MAX_DICTIONARY_COUNT = 4;
+
+    DictionaryGroup() : mDictionaryCount(0), mDictionaries(), mLanguageWeights() {}
+
+    explicit DictionaryGroup(const Dictionary *const mainDictionary)
+            : mDictionaryCount(0), mDictionaries(), mLanguageWeights() {
+        addDictionary(mainDictionary, 1.0f /* languageWeight */);
+    }
+
+    // Copyable: a session keeps the group of its last search.
+
+    // Adds a dictionary after those already in the group; the first one added is the main
+    // dictionary. Returns false, leaving the group as it was, when the group is full.
+    bool addDictionary(const Dictionary *const dictionary, const float languageWeight) {
+        if (mDictionaryCount >= MAX_DICTIONARY_COUNT) {
+            return false;
+        }
+        mDictionaries[mDictionaryCount] = dictionary;
+        mLanguageWeights[mDictionaryCount] = languageWeight;
+        ++mDictionaryCount;
+        return true;
+    }
+
+    int getDictionaryCount() const {
+        return mDictionaryCount;
+    }
+
+    const Dictionary *getDictionary(const int index) const {
+        return mDictionaries[index];
+    }
+
+    float getLanguageWeight(const int index) const {
+        return mLanguageWeights[index];
+    }
+
+    bool hasSameDictionaries(const DictionaryGroup *const dictionaryGroup) const {
+        if (mDictionaryCount != dictionaryGroup->mDictionaryCount) {
+            return false;
+        }
+        for (int i = 0; i < mDictionaryCount; ++i) {
+            if (mDictionaries[i] != dictionaryGroup->mDictionaries[i]
+                    || mLanguageWeights[i] != dictionaryGroup->mLanguageWeights[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+ private:
+    int mDictionaryCount;
+    const Dictionary *mDictionaries[MAX_DICTIONARY_COUNT];
+    float mLanguageWeights[MAX_DICTIONARY_COUNT];
+};
+} // namespace latinime
+#endif // LATINIME_DICTIONARY_GROUP_H
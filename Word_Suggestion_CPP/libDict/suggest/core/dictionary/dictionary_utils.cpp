@@ -19,6 +19,7 @@
 #include "../dicnode/dic_node.h"
 #include "../dicnode/dic_node_priority_queue.h"
 #include "../dicnode/dic_node_vector.h"
+#include "../dicnode/internal/dic_node_output_arena.h"
 #include "dictionary.h"
 #include "digraph_utils.h"
 #include "../session/prev_words_info.h"
@@ -37,8 +38,10 @@ namespace latinime {
     int prevWordsPtNodePos[MAX_PREV_WORD_COUNT_FOR_N_GRAM];
     emptyPrevWordsInfo.getPrevWordsTerminalPtNodePos(dictionaryStructurePolicy,
             prevWordsPtNodePos, false /* tryLowerCaseSearch */);
+    DicNodeOutputArena outputArena;
     current.emplace_back();
-    DicNodeUtils::initAsRoot(dictionaryStructurePolicy, prevWordsPtNodePos, &current.front());
+    DicNodeUtils::initAsRoot(dictionaryStructurePolicy, 0 /* dictionaryIndex */,
+            prevWordsPtNodePos, &outputArena, &current.front());
     for (int i = 0; i < codePointCount; ++i) {
         // The base-lower input is used to ignore case errors and accent errors.
         const int codePoint = CharUtils::toBaseLowerCase(codePoints[i]);
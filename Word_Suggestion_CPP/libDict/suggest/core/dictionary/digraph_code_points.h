@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_DIGRAPH_CODE_POINTS_H
+#define LATINIME_DIGRAPH_CODE_POINTS_H
+
+#include <cstdint>
+
+#include "../../../defines.h"
+#include "digraph_utils.h"
+
+namespace latinime {
+
+class DictionaryHeaderStructurePolicy;
+
+/**
+ * The code points that have a digraph in a dictionary, such as the German umlauts, which the
+ * search also matches as the two letters they stand for.
+ *
+ * DigraphUtils::hasDigraphForCodePoint() looks up the digraph type in the header and scans its
+ * digraphs, for every child of every expanded dicNode. The answer only depends on the dictionary
+ * and the code point, so it is computed once for the Latin-1 code points, where the composite
+ * glyphs are, and read as a bit. Other code points ask DigraphUtils as before.
+ */
+class DigraphCodePoints {
+ public:
+    explicit DigraphCodePoints(const DictionaryHeaderStructurePolicy *const headerPolicy)
+            : mHeaderPolicy(headerPolicy), mHasDigraphs(DigraphUtils::hasDigraphs(headerPolicy)),
+              mBits() {
+        if (!mHasDigraphs) {
+            return;
+        }
+        for (int codePoint = 0; codePoint < TABLE_SIZE; ++codePoint) {
+            if (DigraphUtils::hasDigraphForCodePoint(headerPolicy, codePoint)) {
+                mBits[codePoint / BITS_PER_WORD] |= 1ull << (codePoint % BITS_PER_WORD);
+            }
+        }
+    }
+
+    // Whether any code point has a digraph; the search skips the check when none has.
+    bool hasDigraphs() const {
+        return mHasDigraphs;
+    }
+
+    // Same as DigraphUtils::hasDigraphForCodePoint() for the header of the dictionary.
+    AK_FORCE_INLINE bool hasDigraphForCodePoint(const int codePoint) const {
+        if (static_cast<unsigned int>(codePoint) < static_cast<unsigned int>(TABLE_SIZE)) {
+            return (mBits[codePoint / BITS_PER_WORD] >> (codePoint % BITS_PER_WORD)) & 1;
+        }
+        return mHasDigraphs && DigraphUtils::hasDigraphForCodePoint(mHeaderPolicy, codePoint);
+    }
+
+ private:
+    DISALLOW_IMPLICIT_CONSTRUCTORS(DigraphCodePoints);
+
+    static const int TABLE_SIZE = 0x100;
+    static const int BITS_PER_WORD = 64;
+
+    const DictionaryHeaderStructurePolicy *const mHeaderPolicy;
+    const bool mHasDigraphs;
+    uint64_t mBits[TABLE_SIZE / BITS_PER_WORD];
+};
+} // namespace latinime
+#endif // LATINIME_DIGRAPH_CODE_POINTS_H
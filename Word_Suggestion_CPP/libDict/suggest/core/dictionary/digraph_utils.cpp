@@ -32,6 +32,14 @@ const DigraphUtils::digraph_t DigraphUtils::GERMAN_UMLAUT_DIGRAPHS[] =
 const DigraphUtils::DigraphType DigraphUtils::USED_DIGRAPH_TYPES[] =
         { DIGRAPH_TYPE_GERMAN_UMLAUT };
 
+// Returns whether any code point has a digraph in the given dictionary.
+/* static */ bool DigraphUtils::hasDigraphs(
+        const DictionaryHeaderStructurePolicy *const headerPolicy) {
+    const DigraphUtils::digraph_t *digraphs = nullptr;
+    return getAllDigraphsForDigraphTypeAndReturnSize(getDigraphTypeForDictionary(headerPolicy),
+            &digraphs) > 0;
+}
+
 /* static */ bool DigraphUtils::hasDigraphForCodePoint(
         const DictionaryHeaderStructurePolicy *const headerPolicy,
         const int compositeGlyphCodePoint) {
@@ -38,6 +38,7 @@ class DigraphUtils {
 
     typedef struct { int first; int second; int compositeGlyph; } digraph_t;
 
+    static bool hasDigraphs(const DictionaryHeaderStructurePolicy *const headerPolicy);
     static bool hasDigraphForCodePoint(const DictionaryHeaderStructurePolicy *const headerPolicy,
             const int compositeGlyphCodePoint);
     static int getDigraphCodePointForIndex(const int compositeGlyphCodePoint,
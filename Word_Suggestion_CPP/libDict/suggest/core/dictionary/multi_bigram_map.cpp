@@ -16,8 +16,9 @@
 
 #include "multi_bigram_map.h"
 
+#include <algorithm>
 #include <cstddef>
-#include <unordered_map>
+#include <cstdint>
 
 namespace latinime {
 
@@ -31,26 +32,41 @@ const size_t MultiBigramMap::MAX_CACHED_PREV_WORDS_IN_BIGRAM_MAP = 25;
 // Most common previous word contexts currently have 100 bigrams
 const int MultiBigramMap::BigramMap::DEFAULT_HASH_MAP_SIZE_FOR_EACH_BIGRAM_MAP = 100;
 
-// Look up the bigram probability for the given word pair from the cached bigram maps.
-// Also caches the bigrams if there is space remaining and they have not been cached already.
+size_t MultiBigramMap::getMemorySize() const {
+    size_t memorySize = mBigramMaps.capacity() * sizeof(BigramMap);
+    for (const BigramMap &bigramMap : mBigramMaps) {
+        memorySize += bigramMap.getMemorySize();
+    }
+    return memorySize;
+}
+
+// Caches the bigrams of the given previous words if there is space remaining and they have not
+// been cached already.
+void MultiBigramMap::cacheBigrams(const DictionaryStructureWithBufferPolicy *const structurePolicy,
+        const int *const prevWordsPtNodePos) {
+    if (!prevWordsPtNodePos || prevWordsPtNodePos[0] == NOT_A_DICT_POS) {
+        return;
+    }
+    if (mCachedBigramMapCount < MAX_CACHED_PREV_WORDS_IN_BIGRAM_MAP
+            && !getCachedBigramMap(prevWordsPtNodePos[0])) {
+        addBigramsForWordPosition(structurePolicy, prevWordsPtNodePos);
+    }
+}
+
+// Look up the bigram probability for the given word pair from the cached bigram maps, or from
+// the dictionary when the previous words are not cached.
 int MultiBigramMap::getBigramProbability(
         const DictionaryStructureWithBufferPolicy *const structurePolicy,
         const int *const prevWordsPtNodePos, const int nextWordPosition,
-        const int unigramProbability) {
+        const int unigramProbability) const {
     if (!prevWordsPtNodePos || prevWordsPtNodePos[0] == NOT_A_DICT_POS) {
         return structurePolicy->getProbability(unigramProbability, NOT_A_PROBABILITY);
     }
-    std::unordered_map<int, BigramMap>::const_iterator mapPosition =
-            mBigramMaps.find(prevWordsPtNodePos[0]);
-    if (mapPosition != mBigramMaps.end()) {
-        return mapPosition->second.getBigramProbability(structurePolicy, nextWordPosition,
+    const BigramMap *const bigramMap = getCachedBigramMap(prevWordsPtNodePos[0]);
+    if (bigramMap) {
+        return bigramMap->getBigramProbability(structurePolicy, nextWordPosition,
                 unigramProbability);
     }
-    if (mBigramMaps.size() < MAX_CACHED_PREV_WORDS_IN_BIGRAM_MAP) {
-        addBigramsForWordPosition(structurePolicy, prevWordsPtNodePos);
-        return mBigramMaps[prevWordsPtNodePos[0]].getBigramProbability(structurePolicy,
-                nextWordPosition, unigramProbability);
-    }
     return readBigramProbabilityFromBinaryDictionary(structurePolicy, prevWordsPtNodePos,
             nextWordPosition, unigramProbability);
 }
@@ -58,6 +74,8 @@ int MultiBigramMap::getBigramProbability(
 void MultiBigramMap::BigramMap::init(
         const DictionaryStructureWithBufferPolicy *const structurePolicy,
         const int *const prevWordsPtNodePos) {
+    clear();
+    mPrevWordPtNodePos = prevWordsPtNodePos[0];
     structurePolicy->iterateNgramEntries(prevWordsPtNodePos, this /* listener */);
 }
 
@@ -65,11 +83,10 @@ int MultiBigramMap::BigramMap::getBigramProbability(
         const DictionaryStructureWithBufferPolicy *const structurePolicy,
         const int nextWordPosition, const int unigramProbability) const {
     int bigramProbability = NOT_A_PROBABILITY;
-    if (mBloomFilter.isInFilter(nextWordPosition)) {
-        const std::unordered_map<int, int>::const_iterator bigramProbabilityIt =
-                mBigramMap.find(nextWordPosition);
-        if (bigramProbabilityIt != mBigramMap.end()) {
-            bigramProbability = bigramProbabilityIt->second;
+    if (mEntryCount > 0 && mBloomFilter.isInFilter(nextWordPosition)) {
+        const Entry &entry = mEntries[getSlotIndex(nextWordPosition)];
+        if (entry.mTargetPtNodePos == nextWordPosition) {
+            bigramProbability = entry.mProbability;
         }
     }
     return structurePolicy->getProbability(unigramProbability, bigramProbability);
@@ -80,22 +97,81 @@ void MultiBigramMap::BigramMap::onVisitEntry(const int ngramProbability,
     if (targetPtNodePos == NOT_A_DICT_POS) {
         return;
     }
-    mBigramMap[targetPtNodePos] = ngramProbability;
+    if (static_cast<size_t>(mEntryCount + 1) * 2 > mEntries.size()) {
+        grow();
+    }
+    Entry &entry = mEntries[getSlotIndex(targetPtNodePos)];
+    if (entry.mTargetPtNodePos == NOT_A_DICT_POS) {
+        entry.mTargetPtNodePos = targetPtNodePos;
+        mEntryCount++;
+    }
+    // The last probability given for a target wins.
+    entry.mProbability = ngramProbability;
     mBloomFilter.setInFilter(targetPtNodePos);
 }
 
+void MultiBigramMap::BigramMap::clear() {
+    if (mEntryCount > 0) {
+        const Entry emptyEntry = { NOT_A_DICT_POS, NOT_A_PROBABILITY };
+        std::fill(mEntries.begin(), mEntries.end(), emptyEntry);
+        mEntryCount = 0;
+    }
+    mBloomFilter.clear();
+}
+
+size_t MultiBigramMap::BigramMap::getSlotIndex(const int targetPtNodePos) const {
+    const size_t mask = mEntries.size() - 1;
+    // PtNode positions are byte offsets, so their low bits alone spread poorly.
+    uint32_t hash = static_cast<uint32_t>(targetPtNodePos) * 0x9E3779B1u;
+    hash ^= hash >> 16;
+    size_t index = hash & mask;
+    while (mEntries[index].mTargetPtNodePos != NOT_A_DICT_POS
+            && mEntries[index].mTargetPtNodePos != targetPtNodePos) {
+        index = (index + 1) & mask;
+    }
+    return index;
+}
+
+// Doubles the table, starting with room for the bigrams of most previous words, and puts the
+// entries back into it.
+void MultiBigramMap::BigramMap::grow() {
+    size_t size = 1;
+    while (size < static_cast<size_t>(DEFAULT_HASH_MAP_SIZE_FOR_EACH_BIGRAM_MAP) * 2) {
+        size *= 2;
+    }
+    size = std::max(size, mEntries.size() * 2);
+    const Entry emptyEntry = { NOT_A_DICT_POS, NOT_A_PROBABILITY };
+    std::vector<Entry> oldEntries(size, emptyEntry);
+    oldEntries.swap(mEntries);
+    for (const Entry &entry : oldEntries) {
+        if (entry.mTargetPtNodePos != NOT_A_DICT_POS) {
+            mEntries[getSlotIndex(entry.mTargetPtNodePos)] = entry;
+        }
+    }
+}
+
 void MultiBigramMap::addBigramsForWordPosition(
         const DictionaryStructureWithBufferPolicy *const structurePolicy,
         const int *const prevWordsPtNodePos) {
     if (prevWordsPtNodePos) {
-        mBigramMaps[prevWordsPtNodePos[0]].init(structurePolicy, prevWordsPtNodePos);
+        mBigramMaps[mCachedBigramMapCount++].init(structurePolicy, prevWordsPtNodePos);
+    }
+}
+
+const MultiBigramMap::BigramMap *MultiBigramMap::getCachedBigramMap(
+        const int prevWordPtNodePos) const {
+    for (size_t i = 0; i < mCachedBigramMapCount; ++i) {
+        if (mBigramMaps[i].getPrevWordPtNodePos() == prevWordPtNodePos) {
+            return &mBigramMaps[i];
+        }
     }
+    return nullptr;
 }
 
 int MultiBigramMap::readBigramProbabilityFromBinaryDictionary(
         const DictionaryStructureWithBufferPolicy *const structurePolicy,
         const int *const prevWordsPtNodePos, const int nextWordPosition,
-        const int unigramProbability) {
+        const int unigramProbability) const {
     const int bigramProbability = structurePolicy->getProbabilityOfPtNode(prevWordsPtNodePos,
             nextWordPosition);
     if (bigramProbability != NOT_A_PROBABILITY) {
@@ -18,7 +18,7 @@
 #define LATINIME_MULTI_BIGRAM_MAP_H
 
 #include <cstddef>
-#include <unordered_map>
+#include <vector>
 
 #include "../../../defines.h"
 
@@ -31,46 +31,83 @@ namespace latinime {
 
 // Class for caching bigram maps for multiple previous word contexts. This is useful since the
 // algorithm needs to look up the set of bigrams for every word pair that occurs in every
-// multi-word suggestion.
+// multi-word suggestion. The maps keep their storage when they are cleared, so that a session
+// only allocates for them until it has met its largest bigram lists.
 class MultiBigramMap {
  public:
-    MultiBigramMap() : mBigramMaps() {}
+    MultiBigramMap()
+            : mBigramMaps(MAX_CACHED_PREV_WORDS_IN_BIGRAM_MAP), mCachedBigramMapCount(0) {}
     ~MultiBigramMap() {}
 
-    // Look up the bigram probability for the given word pair from the cached bigram maps.
-    // Also caches the bigrams if there is space remaining and they have not been cached already.
+    // Caches the bigrams of the given previous words if there is space remaining and they have
+    // not been cached already. Called before a dicNode is expanded, with its previous words:
+    // the map does not change while the expansion looks bigrams up, so expansions can run
+    // concurrently, and which previous words are cached only depends on the order the dicNodes
+    // are popped in.
+    void cacheBigrams(const DictionaryStructureWithBufferPolicy *const structurePolicy,
+            const int *const prevWordsPtNodePos);
+
+    // Look up the bigram probability for the given word pair from the cached bigram maps, or
+    // from the dictionary when the previous words are not cached.
     int getBigramProbability(const DictionaryStructureWithBufferPolicy *const structurePolicy,
             const int *const prevWordsPtNodePos, const int nextWordPosition,
-            const int unigramProbability);
+            const int unigramProbability) const;
 
     void clear() {
-        mBigramMaps.clear();
+        mCachedBigramMapCount = 0;
     }
 
+    // Heap bytes held by the bigram maps.
+    size_t getMemorySize() const;
+
  private:
     DISALLOW_COPY_AND_ASSIGN(MultiBigramMap);
 
+    // Bigrams of one previous word, in an open addressing hash table of target PtNode positions
+    // with linear probing.
     class BigramMap : public NgramListener {
      public:
-        BigramMap() : mBigramMap(DEFAULT_HASH_MAP_SIZE_FOR_EACH_BIGRAM_MAP), mBloomFilter() {}
-        // Copy constructor needed for std::unordered_map.
-        BigramMap(const BigramMap &bigramMap)
-                : mBigramMap(bigramMap.mBigramMap), mBloomFilter(bigramMap.mBloomFilter) {}
+        BigramMap()
+                : mPrevWordPtNodePos(NOT_A_DICT_POS), mEntries(), mEntryCount(0),
+                  mBloomFilter() {}
         virtual ~BigramMap() {}
 
+        // Replaces the bigrams of the map with those of the given previous words.
         void init(const DictionaryStructureWithBufferPolicy *const structurePolicy,
                 const int *const prevWordsPtNodePos);
+        int getPrevWordPtNodePos() const { return mPrevWordPtNodePos; }
         int getBigramProbability(
                 const DictionaryStructureWithBufferPolicy *const structurePolicy,
                 const int nextWordPosition, const int unigramProbability) const;
         virtual void onVisitEntry(const int ngramProbability, const int targetPtNodePos);
+        size_t getMemorySize() const { return mEntries.capacity() * sizeof(Entry); }
 
      private:
+        DISALLOW_COPY_AND_ASSIGN(BigramMap);
+
+        struct Entry {
+            // NOT_A_DICT_POS for an empty slot.
+            int mTargetPtNodePos;
+            int mProbability;
+        };
+
         static const int DEFAULT_HASH_MAP_SIZE_FOR_EACH_BIGRAM_MAP;
-        std::unordered_map<int, int> mBigramMap;
+
+        int mPrevWordPtNodePos;
+        // A power of two slots, at most half of them used.
+        std::vector<Entry> mEntries;
+        int mEntryCount;
         BloomFilter mBloomFilter;
+
+        void clear();
+        // Index of the slot of targetPtNodePos, or of the empty slot it would go to. The table
+        // must not be empty.
+        size_t getSlotIndex(const int targetPtNodePos) const;
+        void grow();
     };
 
+    const BigramMap *getCachedBigramMap(const int prevWordPtNodePos) const;
+
     void addBigramsForWordPosition(
             const DictionaryStructureWithBufferPolicy *const structurePolicy,
             const int *const prevWordsPtNodePos);
@@ -78,10 +115,12 @@ class MultiBigramMap {
     int readBigramProbabilityFromBinaryDictionary(
             const DictionaryStructureWithBufferPolicy *const structurePolicy,
             const int *const prevWordsPtNodePos, const int nextWordPosition,
-            const int unigramProbability);
+            const int unigramProbability) const;
 
     static const size_t MAX_CACHED_PREV_WORDS_IN_BIGRAM_MAP;
-    std::unordered_map<int, BigramMap> mBigramMaps;
+    // The first mCachedBigramMapCount maps hold the cached previous words.
+    std::vector<BigramMap> mBigramMaps;
+    size_t mCachedBigramMapCount;
 };
 } // namespace latinime
 #endif // LATINIME_MULTI_BIGRAM_MAP_H
@@ -0,0 +1,333 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "LatinIME: keyboard_layout_file.cpp"
+
+#include "keyboard_layout_file.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+#include "proximity_info.h"
+
+namespace latinime {
+
+// "KBLY"
+const uint32_t KeyboardLayoutFile::MAGIC_NUMBER = 0x4B424C59;
+const int KeyboardLayoutFile::FORMAT_VERSION = 1;
+// magic, format version, header size, payload size, checksum
+const int KeyboardLayoutFile::HEADER_SIZE = 5 * sizeof(uint32_t);
+// Bounds used to reject corrupted sizes before any arithmetic on them.
+const int KeyboardLayoutFile::MAX_KEY_COUNT = 4096;
+const int KeyboardLayoutFile::MAX_PROXIMITY_CHARS_LENGTH = 1 << 20;
+
+namespace {
+
+const int SCALAR_FIELD_COUNT = 10;
+
+int getPayloadSize(const int keyCount, const int sweetSpotCount,
+        const int proximityCharsLength, const int derivedKeyCount) {
+    return KeyboardLayoutFile::LOCALE_FIELD_SIZE + SCALAR_FIELD_COUNT * sizeof(int32_t)
+            + proximityCharsLength * sizeof(int32_t)
+            + keyCount * 5 * sizeof(int32_t) + sweetSpotCount * 3 * sizeof(float)
+            + derivedKeyCount * (3 * sizeof(int32_t) + sizeof(float))
+            + derivedKeyCount * derivedKeyCount * sizeof(int32_t);
+}
+
+template<typename T>
+const T *readArray(const uint8_t **const pos, const int length) {
+    const T *const array = reinterpret_cast<const T *>(*pos);
+    *pos += length * sizeof(T);
+    return array;
+}
+
+template<typename T>
+void writeArray(const T *const array, const int length, std::vector<uint8_t> *const buffer) {
+    const uint8_t *const bytes = reinterpret_cast<const uint8_t *>(array);
+    buffer->insert(buffer->end(), bytes, bytes + length * sizeof(T));
+}
+
+template<typename T>
+void writeValue(const T value, std::vector<uint8_t> *const buffer) {
+    writeArray(&value, 1 /* length */, buffer);
+}
+
+// Writes length entries of array, or zeros when the source has no such data.
+template<typename T>
+void writeArrayOrZeros(const T *const array, const int length,
+        std::vector<uint8_t> *const buffer) {
+    if (array) {
+        writeArray(array, length, buffer);
+    } else {
+        buffer->insert(buffer->end(), length * sizeof(T), 0);
+    }
+}
+
+} // namespace
+
+/* static */ bool KeyboardLayoutFile::readLayout(const uint8_t *const buffer,
+        const int bufferSize, Layout *const outLayout) {
+    if (!buffer || bufferSize < HEADER_SIZE
+            || reinterpret_cast<uintptr_t>(buffer) % sizeof(int32_t) != 0) {
+        AKLOGE("Keyboard layout buffer is too small or misaligned. size: %d", bufferSize);
+        return false;
+    }
+    const uint32_t *const header = reinterpret_cast<const uint32_t *>(buffer);
+    if (header[0] != MAGIC_NUMBER) {
+        AKLOGE("Keyboard layout has an unknown magic number: %x", header[0]);
+        return false;
+    }
+    if (static_cast<int>(header[1]) != FORMAT_VERSION) {
+        AKLOGE("Keyboard layout has an unsupported version: %d", header[1]);
+        return false;
+    }
+    const uint32_t headerSize = header[2];
+    const uint32_t payloadSize = header[3];
+    if (headerSize < static_cast<uint32_t>(HEADER_SIZE) || headerSize % sizeof(int32_t) != 0
+            || headerSize > static_cast<uint32_t>(bufferSize)
+            || payloadSize > static_cast<uint32_t>(bufferSize) - headerSize) {
+        AKLOGE("Keyboard layout is truncated. size: %d", bufferSize);
+        return false;
+    }
+    const uint8_t *pos = buffer + headerSize;
+    if (computeChecksum(pos, payloadSize) != header[4]) {
+        AKLOGE("Keyboard layout checksum mismatch.");
+        return false;
+    }
+    if (payloadSize < LOCALE_FIELD_SIZE + SCALAR_FIELD_COUNT * sizeof(int32_t)) {
+        AKLOGE("Keyboard layout payload is too small. size: %d", payloadSize);
+        return false;
+    }
+
+    Layout layout;
+    layout.locale = reinterpret_cast<const char *>(pos);
+    if (!memchr(layout.locale, '\0', LOCALE_FIELD_SIZE)) {
+        AKLOGE("Keyboard layout locale is not terminated.");
+        return false;
+    }
+    pos += LOCALE_FIELD_SIZE;
+    const int32_t *const scalars = readArray<int32_t>(&pos, SCALAR_FIELD_COUNT);
+    layout.keyboardWidth = scalars[0];
+    layout.keyboardHeight = scalars[1];
+    layout.gridWidth = scalars[2];
+    layout.gridHeight = scalars[3];
+    layout.mostCommonKeyWidth = scalars[4];
+    layout.mostCommonKeyHeight = scalars[5];
+    layout.keyCount = scalars[6];
+    const int sweetSpotCount = scalars[7];
+    layout.proximityCharsLength = scalars[8];
+    layout.derivedKeyCount = scalars[9];
+    if (layout.gridWidth <= 0 || layout.gridHeight <= 0 || layout.mostCommonKeyWidth <= 0
+            || layout.keyCount < 0 || layout.keyCount > MAX_KEY_COUNT
+            || (sweetSpotCount != 0 && sweetSpotCount != layout.keyCount)
+            || layout.proximityCharsLength < 0
+            || layout.proximityCharsLength > MAX_PROXIMITY_CHARS_LENGTH
+            || layout.derivedKeyCount
+                    != std::min(layout.keyCount, MAX_KEY_COUNT_IN_A_KEYBOARD)) {
+        AKLOGE("Keyboard layout has invalid dimensions.");
+        return false;
+    }
+    if (static_cast<int>(payloadSize) != getPayloadSize(layout.keyCount, sweetSpotCount,
+            layout.proximityCharsLength, layout.derivedKeyCount)) {
+        AKLOGE("Keyboard layout payload size %d does not match its contents.", payloadSize);
+        return false;
+    }
+    layout.proximityChars = readArray<int>(&pos, layout.proximityCharsLength);
+    layout.keyXCoordinates = readArray<int>(&pos, layout.keyCount);
+    layout.keyYCoordinates = readArray<int>(&pos, layout.keyCount);
+    layout.keyWidths = readArray<int>(&pos, layout.keyCount);
+    layout.keyHeights = readArray<int>(&pos, layout.keyCount);
+    layout.keyCharCodes = readArray<int>(&pos, layout.keyCount);
+    if (sweetSpotCount > 0) {
+        layout.sweetSpotCenterXs = readArray<float>(&pos, sweetSpotCount);
+        layout.sweetSpotCenterYs = readArray<float>(&pos, sweetSpotCount);
+        layout.sweetSpotRadii = readArray<float>(&pos, sweetSpotCount);
+    }
+    layout.keyIndexToLowerCodePoints = readArray<int>(&pos, layout.derivedKeyCount);
+    layout.keyCenterXsG = readArray<int>(&pos, layout.derivedKeyCount);
+    layout.keyCenterYsG = readArray<int>(&pos, layout.derivedKeyCount);
+    layout.sweetSpotCenterYsG = readArray<float>(&pos, layout.derivedKeyCount);
+    layout.keyKeyDistancesG =
+            readArray<int>(&pos, layout.derivedKeyCount * layout.derivedKeyCount);
+    *outLayout = layout;
+    return true;
+}
+
+/* static */ bool KeyboardLayoutFile::compileLayout(const Layout &layout,
+        std::vector<uint8_t> *const outBuffer) {
+    if (layout.gridWidth <= 0 || layout.gridHeight <= 0 || layout.mostCommonKeyWidth <= 0
+            || layout.keyCount < 0 || layout.keyCount > MAX_KEY_COUNT
+            || layout.proximityCharsLength < 0
+            || layout.proximityCharsLength > MAX_PROXIMITY_CHARS_LENGTH
+            || (layout.proximityCharsLength > 0 && !layout.proximityChars)) {
+        AKLOGE("Keyboard layout to compile has invalid dimensions.");
+        return false;
+    }
+    const int sweetSpotCount = layout.hasSweetSpots() ? layout.keyCount : 0;
+    const int derivedKeyCount = std::min(layout.keyCount, MAX_KEY_COUNT_IN_A_KEYBOARD);
+    const int payloadSize = getPayloadSize(layout.keyCount, sweetSpotCount,
+            layout.proximityCharsLength, derivedKeyCount);
+
+    std::vector<uint8_t> &buffer = *outBuffer;
+    buffer.clear();
+    // Reserved up front: the layout read back below points into this buffer.
+    buffer.reserve(HEADER_SIZE + payloadSize);
+    buffer.insert(buffer.end(), HEADER_SIZE, 0);
+    char locale[LOCALE_FIELD_SIZE];
+    memset(locale, 0, sizeof(locale));
+    if (layout.locale) {
+        strncpy(locale, layout.locale, LOCALE_FIELD_SIZE - 1);
+    }
+    writeArray(locale, LOCALE_FIELD_SIZE, &buffer);
+    writeValue<int32_t>(layout.keyboardWidth, &buffer);
+    writeValue<int32_t>(layout.keyboardHeight, &buffer);
+    writeValue<int32_t>(layout.gridWidth, &buffer);
+    writeValue<int32_t>(layout.gridHeight, &buffer);
+    writeValue<int32_t>(layout.mostCommonKeyWidth, &buffer);
+    writeValue<int32_t>(layout.mostCommonKeyHeight, &buffer);
+    writeValue<int32_t>(layout.keyCount, &buffer);
+    writeValue<int32_t>(sweetSpotCount, &buffer);
+    writeValue<int32_t>(layout.proximityCharsLength, &buffer);
+    writeValue<int32_t>(derivedKeyCount, &buffer);
+    const int proximityCharsOffset = buffer.size();
+    writeArrayOrZeros(layout.proximityChars, layout.proximityCharsLength, &buffer);
+    writeArrayOrZeros(layout.keyXCoordinates, layout.keyCount, &buffer);
+    writeArrayOrZeros(layout.keyYCoordinates, layout.keyCount, &buffer);
+    writeArrayOrZeros(layout.keyWidths, layout.keyCount, &buffer);
+    writeArrayOrZeros(layout.keyHeights, layout.keyCount, &buffer);
+    writeArrayOrZeros(layout.keyCharCodes, layout.keyCount, &buffer);
+    if (sweetSpotCount > 0) {
+        writeArray(layout.sweetSpotCenterXs, sweetSpotCount, &buffer);
+        writeArray(layout.sweetSpotCenterYs, sweetSpotCount, &buffer);
+        writeArray(layout.sweetSpotRadii, sweetSpotCount, &buffer);
+    }
+
+    // Let ProximityInfo compute the derived tables from the arrays as they are stored, so that
+    // they are exactly what it would compute when loading the arrays without them.
+    Layout storedLayout;
+    storedLayout.locale = locale;
+    storedLayout.keyboardWidth = layout.keyboardWidth;
+    storedLayout.keyboardHeight = layout.keyboardHeight;
+    storedLayout.gridWidth = layout.gridWidth;
+    storedLayout.gridHeight = layout.gridHeight;
+    storedLayout.mostCommonKeyWidth = layout.mostCommonKeyWidth;
+    storedLayout.mostCommonKeyHeight = layout.mostCommonKeyHeight;
+    storedLayout.keyCount = layout.keyCount;
+    storedLayout.proximityCharsLength = layout.proximityCharsLength;
+    const uint8_t *pos = buffer.data() + proximityCharsOffset;
+    storedLayout.proximityChars = readArray<int>(&pos, layout.proximityCharsLength);
+    storedLayout.keyXCoordinates = readArray<int>(&pos, layout.keyCount);
+    storedLayout.keyYCoordinates = readArray<int>(&pos, layout.keyCount);
+    storedLayout.keyWidths = readArray<int>(&pos, layout.keyCount);
+    storedLayout.keyHeights = readArray<int>(&pos, layout.keyCount);
+    storedLayout.keyCharCodes = readArray<int>(&pos, layout.keyCount);
+    if (sweetSpotCount > 0) {
+        storedLayout.sweetSpotCenterXs = readArray<float>(&pos, sweetSpotCount);
+        storedLayout.sweetSpotCenterYs = readArray<float>(&pos, sweetSpotCount);
+        storedLayout.sweetSpotRadii = readArray<float>(&pos, sweetSpotCount);
+    }
+    const std::unique_ptr<const ProximityInfo> proximityInfo(new ProximityInfo(storedLayout));
+    writeArray(proximityInfo->mKeyIndexToLowerCodePointG, derivedKeyCount, &buffer);
+    writeArray(proximityInfo->mCenterXsG, derivedKeyCount, &buffer);
+    writeArray(proximityInfo->mCenterYsG, derivedKeyCount, &buffer);
+    writeArray(proximityInfo->mSweetSpotCenterYsG, derivedKeyCount, &buffer);
+    for (int i = 0; i < derivedKeyCount; ++i) {
+        writeArray(proximityInfo->mKeyKeyDistancesG[i], derivedKeyCount, &buffer);
+    }
+    if (static_cast<int>(buffer.size()) != HEADER_SIZE + payloadSize) {
+        AKLOGE("Keyboard layout size mismatch while compiling.");
+        ASSERT(false);
+        return false;
+    }
+
+    uint32_t header[HEADER_SIZE / sizeof(uint32_t)];
+    header[0] = MAGIC_NUMBER;
+    header[1] = FORMAT_VERSION;
+    header[2] = HEADER_SIZE;
+    header[3] = payloadSize;
+    header[4] = computeChecksum(buffer.data() + HEADER_SIZE, payloadSize);
+    memcpy(buffer.data(), header, HEADER_SIZE);
+    return true;
+}
+
+/* static */ bool KeyboardLayoutFile::writeLayoutFile(const char *const filePath,
+        const Layout &layout) {
+    std::vector<uint8_t> buffer;
+    if (!compileLayout(layout, &buffer)) {
+        return false;
+    }
+    FILE *const file = fopen(filePath, "wb");
+    if (!file) {
+        AKLOGE("File %s cannot be opened. errno: %d", filePath, errno);
+        return false;
+    }
+    if (fwrite(buffer.data(), buffer.size(), 1 /* count */, file) < 1) {
+        fclose(file);
+        remove(filePath);
+        AKLOGE("Keyboard layout cannot be written to the file %s.", filePath);
+        return false;
+    }
+    if (fclose(file) != 0) {
+        remove(filePath);
+        AKLOGE("File %s cannot be closed. errno: %d", filePath, errno);
+        return false;
+    }
+    return true;
+}
+
+// CRC-32 (IEEE 802.3, reflected), computed 8 bytes at a time with the slicing-by-8 tables.
+/* static */ uint32_t KeyboardLayoutFile::computeChecksum(const uint8_t *const data,
+        const int size) {
+    static const struct CrcTables {
+        CrcTables() {
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; ++bit) {
+                    crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+                }
+                mEntries[0][i] = crc;
+            }
+            for (uint32_t i = 0; i < 256; ++i) {
+                for (int slice = 1; slice < 8; ++slice) {
+                    const uint32_t previous = mEntries[slice - 1][i];
+                    mEntries[slice][i] = (previous >> 8) ^ mEntries[0][previous & 0xFF];
+                }
+            }
+        }
+        uint32_t mEntries[8][256];
+    } crcTables;
+    const uint32_t (*const table)[256] = crcTables.mEntries;
+    uint32_t crc = 0xFFFFFFFFu;
+    int i = 0;
+    for (; i + 8 <= size; i += 8) {
+        const uint8_t *const bytes = data + i;
+        crc ^= static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8)
+                | (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+        crc = table[7][crc & 0xFF] ^ table[6][(crc >> 8) & 0xFF]
+                ^ table[5][(crc >> 16) & 0xFF] ^ table[4][crc >> 24]
+                ^ table[3][bytes[4]] ^ table[2][bytes[5]] ^ table[1][bytes[6]]
+                ^ table[0][bytes[7]];
+    }
+    for (; i < size; ++i) {
+        crc = table[0][(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+} // namespace latinime
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_KEYBOARD_LAYOUT_FILE_H
+#define LATINIME_KEYBOARD_LAYOUT_FILE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "../../../defines.h"
+
+namespace latinime {
+
+/**
+ * Compiled keyboard layout file. It holds the arrays ProximityInfo is constructed from together
+ * with the tables ProximityInfo::initializeG() derives from them, so a layout can be loaded by
+ * mapping the file and copying the arrays, without any parsing or geometry computation.
+ *
+ * All fields are 32 bit values in host byte order; a file written on a host with a different
+ * byte order is rejected by its magic number.
+ *
+ *   header:  magic, format version, header size, payload size, CRC-32 of the payload
+ *   payload: locale (LOCALE_FIELD_SIZE bytes, NUL padded)
+ *            keyboard width, keyboard height, grid width, grid height,
+ *            most common key width, most common key height,
+ *            key count, sweet spot count, proximity chars length, derived key count
+ *            int   proximityChars[proximity chars length]
+ *            int   keyXCoordinates, keyYCoordinates, keyWidths, keyHeights,
+ *                  keyCharCodes[key count]
+ *            float sweetSpotCenterXs, sweetSpotCenterYs, sweetSpotRadii[sweet spot count]
+ *            int   keyIndexToLowerCodePoints, keyCenterXsG, keyCenterYsG[derived key count]
+ *            float sweetSpotCenterYsG[derived key count]
+ *            int   keyKeyDistancesG[derived key count * derived key count]
+ *
+ * The key count is not capped: keys beyond MAX_KEY_COUNT_IN_A_KEYBOARD are kept so callers can
+ * still map their code points to coordinates. The sweet spot count is either the key count or 0
+ * for layouts without touch position correction data. The derived key count is the number of
+ * keys ProximityInfo actually uses.
+ */
+class KeyboardLayoutFile {
+ public:
+    static const uint32_t MAGIC_NUMBER;
+    static const int FORMAT_VERSION;
+    static const int LOCALE_FIELD_SIZE = 16;
+
+    // Plain view of a layout. When read from a file, all pointers point into the file buffer and
+    // are only valid as long as that buffer is. The sweet spot arrays are null for a layout
+    // without touch position correction data, and the derived tables are null for a layout that
+    // has not been compiled yet. All other arrays have keyCount entries.
+    struct Layout {
+        Layout()
+                : locale(nullptr), keyboardWidth(0), keyboardHeight(0), gridWidth(0),
+                  gridHeight(0), mostCommonKeyWidth(0), mostCommonKeyHeight(0), keyCount(0),
+                  proximityCharsLength(0), proximityChars(nullptr), keyXCoordinates(nullptr),
+                  keyYCoordinates(nullptr), keyWidths(nullptr), keyHeights(nullptr),
+                  keyCharCodes(nullptr), sweetSpotCenterXs(nullptr), sweetSpotCenterYs(nullptr),
+                  sweetSpotRadii(nullptr), derivedKeyCount(0), keyIndexToLowerCodePoints(nullptr),
+                  keyCenterXsG(nullptr), keyCenterYsG(nullptr), sweetSpotCenterYsG(nullptr),
+                  keyKeyDistancesG(nullptr) {}
+
+        bool hasSweetSpots() const {
+            return sweetSpotCenterXs && sweetSpotCenterYs && sweetSpotRadii;
+        }
+
+        bool hasDerivedTables() const {
+            return keyIndexToLowerCodePoints && keyCenterXsG && keyCenterYsG
+                    && sweetSpotCenterYsG && keyKeyDistancesG;
+        }
+
+        const char *locale;
+        int keyboardWidth;
+        int keyboardHeight;
+        int gridWidth;
+        int gridHeight;
+        int mostCommonKeyWidth;
+        int mostCommonKeyHeight;
+        int keyCount;
+        int proximityCharsLength;
+        const int *proximityChars;
+        const int *keyXCoordinates;
+        const int *keyYCoordinates;
+        const int *keyWidths;
+        const int *keyHeights;
+        const int *keyCharCodes;
+        const float *sweetSpotCenterXs;
+        const float *sweetSpotCenterYs;
+        const float *sweetSpotRadii;
+        int derivedKeyCount;
+        const int *keyIndexToLowerCodePoints;
+        const int *keyCenterXsG;
+        const int *keyCenterYsG;
+        const float *sweetSpotCenterYsG;
+        // Row-major, derivedKeyCount x derivedKeyCount.
+        const int *keyKeyDistancesG;
+    };
+
+    // Validates the header, the checksum and the array sizes, and points outLayout into buffer.
+    // buffer has to be aligned for int access.
+    static bool readLayout(const uint8_t *const buffer, const int bufferSize,
+            Layout *const outLayout);
+
+    // Compiles a layout into the file format. Its derived tables, if any, are ignored and
+    // recomputed by ProximityInfo.
+    static bool compileLayout(const Layout &layout, std::vector<uint8_t> *const outBuffer);
+
+    static bool writeLayoutFile(const char *const filePath, const Layout &layout);
+
+    // CRC-32 (IEEE 802.3) of the data, as stored in the header for the payload.
+    static uint32_t computeChecksum(const uint8_t *const data, const int size);
+
+ private:
+    DISALLOW_IMPLICIT_CONSTRUCTORS(KeyboardLayoutFile);
+
+    static const int HEADER_SIZE;
+    static const int MAX_KEY_COUNT;
+    static const int MAX_PROXIMITY_CHARS_LENGTH;
+};
+} // namespace latinime
+#endif // LATINIME_KEYBOARD_LAYOUT_FILE_H
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_PROXIMITY_CODE_POINT_MATCHER_H
+#define LATINIME_PROXIMITY_CODE_POINT_MATCHER_H
+
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "../../../defines.h"
+
+namespace latinime {
+
+/**
+ * Compares a code point against the MAX_PROXIMITY_CHARS_SIZE proximity code points of an input
+ * point at once. The proximity code points are loaded into vector registers when the matcher is
+ * made, so that the children of a dicNode, which are all matched against the same input point,
+ * only load them once.
+ *
+ * Uses AVX2 when the build enables it, SSE2 on any other x86-64 build and a plain loop elsewhere;
+ * all give the same masks.
+ */
+class ProximityCodePointMatcher {
+ public:
+    AK_FORCE_INLINE explicit ProximityCodePointMatcher(const int *const proximityCodePoints) {
+#if defined(__AVX2__)
+        for (int i = 0; i < SLOT_VECTOR_COUNT; ++i) {
+            mSlots[i] = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i *>(proximityCodePoints + i * SLOTS_PER_VECTOR));
+        }
+#elif defined(__SSE2__)
+        for (int i = 0; i < SLOT_VECTOR_COUNT; ++i) {
+            mSlots[i] = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i *>(proximityCodePoints + i * SLOTS_PER_VECTOR));
+        }
+#else
+        mProximityCodePoints = proximityCodePoints;
+#endif
+    }
+
+    // Returns a mask with bit j set when the j-th proximity code point is codePoint or
+    // otherCodePoint.
+    AK_FORCE_INLINE uint32_t getMatchingSlots(const int codePoint,
+            const int otherCodePoint) const {
+        uint32_t slots = 0;
+#if defined(__AVX2__)
+        const __m256i codePoints = _mm256_set1_epi32(codePoint);
+        const __m256i otherCodePoints = _mm256_set1_epi32(otherCodePoint);
+        for (int i = 0; i < SLOT_VECTOR_COUNT; ++i) {
+            const __m256i matches = _mm256_or_si256(_mm256_cmpeq_epi32(mSlots[i], codePoints),
+                    _mm256_cmpeq_epi32(mSlots[i], otherCodePoints));
+            slots |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(matches)))
+                    << (i * SLOTS_PER_VECTOR);
+        }
+#elif defined(__SSE2__)
+        const __m128i codePoints = _mm_set1_epi32(codePoint);
+        const __m128i otherCodePoints = _mm_set1_epi32(otherCodePoint);
+        __m128i matches[SLOT_VECTOR_COUNT];
+        for (int i = 0; i < SLOT_VECTOR_COUNT; ++i) {
+            matches[i] = _mm_or_si128(_mm_cmpeq_epi32(mSlots[i], codePoints),
+                    _mm_cmpeq_epi32(mSlots[i], otherCodePoints));
+        }
+        // Narrows the 32-bit lanes, all ones or all zeros, to one byte per slot, in order.
+        const __m128i matchBytes = _mm_packs_epi16(_mm_packs_epi32(matches[0], matches[1]),
+                _mm_packs_epi32(matches[2], matches[3]));
+        slots = static_cast<uint32_t>(_mm_movemask_epi8(matchBytes));
+#else
+        for (int j = 0; j < MAX_PROXIMITY_CHARS_SIZE; ++j) {
+            if (mProximityCodePoints[j] == codePoint || mProximityCodePoints[j] == otherCodePoint) {
+                slots |= 1u << j;
+            }
+        }
+#endif
+        return slots;
+    }
+
+ private:
+    DISALLOW_IMPLICIT_CONSTRUCTORS(ProximityCodePointMatcher);
+
+#if defined(__AVX2__)
+    static const int SLOTS_PER_VECTOR = 8;
+#elif defined(__SSE2__)
+    static const int SLOTS_PER_VECTOR = 4;
+#endif
+#if defined(__AVX2__) || defined(__SSE2__)
+    static_assert(MAX_PROXIMITY_CHARS_SIZE % SLOTS_PER_VECTOR == 0,
+            "The proximity code points must fill whole vectors");
+    static const int SLOT_VECTOR_COUNT = MAX_PROXIMITY_CHARS_SIZE / SLOTS_PER_VECTOR;
+#endif
+#if !defined(__AVX2__) && defined(__SSE2__)
+    static_assert(SLOT_VECTOR_COUNT == 4, "The SSE2 masks are packed from 4 vectors");
+#endif
+
+#if defined(__AVX2__)
+    __m256i mSlots[SLOT_VECTOR_COUNT];
+#elif defined(__SSE2__)
+    __m128i mSlots[SLOT_VECTOR_COUNT];
+#else
+    const int *mProximityCodePoints;
+#endif
+};
+} // namespace latinime
+#endif // LATINIME_PROXIMITY_CODE_POINT_MATCHER_H
@@ -33,18 +33,44 @@
 #include "../../../utils/char_utils.h"
 
 namespace latinime {
-    void copyArray(int * source, int * destination, int len){
-        for (int i=0;i <len; i++)
-            destination[i] = source[i];
-    }
-    void copyArray(char * source, char * destination, int len){
-        for (int i=0;i <len; i++)
-            destination[i] = source[i];
-    }
-    void copyArray(float * source, float * destination, int len){
-        for (int i=0;i <len; i++)
-            destination[i] = source[i];
+
+static KeyboardLayoutFile::Layout toLayout(const char *const localeStr,
+        const int keyboardWidth, const int keyboardHeight, const int gridWidth,
+        const int gridHeight, const int mostCommonKeyWidth, const int mostCommonKeyHeight,
+        const int *const proximityChars, const int proximityCharsLength, const int keyCount,
+        const int *const keyXCoordinates, const int *const keyYCoordinates,
+        const int *const keyWidths, const int *const keyHeights, const int *const keyCharCodes,
+        const float *const sweetSpotCenterXs, const float *const sweetSpotCenterYs,
+        const float *const sweetSpotRadii) {
+    KeyboardLayoutFile::Layout layout;
+    layout.locale = localeStr;
+    layout.keyboardWidth = keyboardWidth;
+    layout.keyboardHeight = keyboardHeight;
+    layout.gridWidth = gridWidth;
+    layout.gridHeight = gridHeight;
+    layout.mostCommonKeyWidth = mostCommonKeyWidth;
+    layout.mostCommonKeyHeight = mostCommonKeyHeight;
+    layout.keyCount = keyCount;
+    layout.proximityCharsLength = proximityCharsLength;
+    layout.proximityChars = proximityChars;
+    layout.keyXCoordinates = keyXCoordinates;
+    layout.keyYCoordinates = keyYCoordinates;
+    layout.keyWidths = keyWidths;
+    layout.keyHeights = keyHeights;
+    layout.keyCharCodes = keyCharCodes;
+    layout.sweetSpotCenterXs = sweetSpotCenterXs;
+    layout.sweetSpotCenterYs = sweetSpotCenterYs;
+    layout.sweetSpotRadii = sweetSpotRadii;
+    return layout;
+}
+
+template<typename T>
+static void copyArray(const T *const source, T *const destination, const int length) {
+    if (source && length > 0) {
+        memcpy(destination, source, sizeof(T) * length);
     }
+}
+
 ProximityInfo::ProximityInfo(char* LocaleStr,
          int keyboardWidth,  int keyboardHeight,  int gridWidth,
          int gridHeight,  int mostCommonKeyWidth,  int mostCommonKeyHeight,
@@ -52,51 +78,54 @@ ProximityInfo::ProximityInfo(char* LocaleStr,
          int* keyYCoordinates,  int* keyWidths,  int* keyHeights,
          int* keyCharCodes,  float* sweetSpotCenterXs,
          float* sweetSpotCenterYs,  float* sweetSpotRadii)
-        :
-        GRID_WIDTH(gridWidth), GRID_HEIGHT(gridHeight),
-          MOST_COMMON_KEY_WIDTH(mostCommonKeyWidth),
-          MOST_COMMON_KEY_WIDTH_SQUARE(mostCommonKeyWidth * mostCommonKeyWidth),
+        : ProximityInfo(toLayout(LocaleStr, keyboardWidth, keyboardHeight, gridWidth,
+                  gridHeight, mostCommonKeyWidth, mostCommonKeyHeight, proximityChars,
+                  proximityCharsLength, keyCount, keyXCoordinates, keyYCoordinates, keyWidths,
+                  keyHeights, keyCharCodes, sweetSpotCenterXs, sweetSpotCenterYs,
+                  sweetSpotRadii)) {}
+
+ProximityInfo::ProximityInfo(const KeyboardLayoutFile::Layout &layout)
+        : GRID_WIDTH(layout.gridWidth), GRID_HEIGHT(layout.gridHeight),
+          MOST_COMMON_KEY_WIDTH(layout.mostCommonKeyWidth),
+          MOST_COMMON_KEY_WIDTH_SQUARE(layout.mostCommonKeyWidth * layout.mostCommonKeyWidth),
           NORMALIZED_SQUARED_MOST_COMMON_KEY_HYPOTENUSE(1.0f +
-                  GeometryUtils::SQUARE_FLOAT(static_cast<float>(mostCommonKeyHeight) /
-                          static_cast<float>(mostCommonKeyWidth))),
-          CELL_WIDTH((keyboardWidth + gridWidth - 1) / gridWidth),
-          CELL_HEIGHT((keyboardHeight + gridHeight - 1) / gridHeight),
-          KEY_COUNT(std::min(keyCount, MAX_KEY_COUNT_IN_A_KEYBOARD)),
-          KEYBOARD_WIDTH(keyboardWidth), KEYBOARD_HEIGHT(keyboardHeight),
+                  GeometryUtils::SQUARE_FLOAT(static_cast<float>(layout.mostCommonKeyHeight) /
+                          static_cast<float>(layout.mostCommonKeyWidth))),
+          CELL_WIDTH((layout.keyboardWidth + layout.gridWidth - 1) / layout.gridWidth),
+          CELL_HEIGHT((layout.keyboardHeight + layout.gridHeight - 1) / layout.gridHeight),
+          KEY_COUNT(std::min(layout.keyCount, MAX_KEY_COUNT_IN_A_KEYBOARD)),
+          KEYBOARD_WIDTH(layout.keyboardWidth), KEYBOARD_HEIGHT(layout.keyboardHeight),
           KEYBOARD_HYPOTENUSE(hypotf(KEYBOARD_WIDTH, KEYBOARD_HEIGHT)),
-          HAS_TOUCH_POSITION_CORRECTION_DATA(keyCount > 0 && keyXCoordinates && keyYCoordinates
-                  && keyWidths && keyHeights && keyCharCodes && sweetSpotCenterXs
-                  && sweetSpotCenterYs && sweetSpotRadii),
-          mProximityCharsArray(new int[GRID_WIDTH * GRID_HEIGHT * MAX_PROXIMITY_CHARS_SIZE
-                  /* proximityCharsLength */]),
-          mLowerCodePointToKeyMap() {
-//        std::copy( std::begin(LocaleStr), std::end(LocaleStr), std::begin(mLocaleStr));
-//        std::copy( std::begin(proximityChars), std::end(proximityChars), std::begin(mProximityCharsArray));
-//        std::copy( std::begin(keyXCoordinates), std::end(keyXCoordinates),   std::begin(mKeyXCoordinates));
-//        std::copy( std::begin(keyYCoordinates), std::end(keyYCoordinates), std::begin( mKeyYCoordinates));
-//        std::copy( std::begin(keyWidths) , std::end(keyWidths), std::begin(mKeyWidths));
-//        std::copy( std::begin(keyHeights), std::end(keyHeights) ,std::begin(mKeyHeights));
-//        std::copy( std::begin(keyCharCodes), std::end(keyCharCodes), std::begin(mKeyCodePoints));
-//        std::copy( std::begin(sweetSpotCenterYs), std::end(sweetSpotCenterYs), std::begin(mSweetSpotCenterXs));
-//        std::copy( std::begin(sweetSpotCenterYs), std::end(sweetSpotCenterYs), std::begin(mSweetSpotCenterYs));
-//        std::copy( std::begin(sweetSpotRadii), std::end(sweetSpotRadii), std::begin(mSweetSpotRadii));
-        copyArray(LocaleStr, mLocaleStr, MAX_LOCALE_STRING_LENGTH);
-        copyArray(proximityChars, mProximityCharsArray, proximityCharsLength);
-        copyArray(keyXCoordinates, mKeyXCoordinates, KEY_COUNT);
-        copyArray(keyYCoordinates, mKeyYCoordinates, KEY_COUNT);
-        copyArray(keyWidths,mKeyWidths,KEY_COUNT);
-        copyArray(keyHeights, mKeyHeights, KEY_COUNT);
-        copyArray(keyCharCodes, mKeyCodePoints,KEY_COUNT);
-        copyArray(sweetSpotCenterXs, mSweetSpotCenterXs,KEY_COUNT);
-        copyArray(sweetSpotCenterYs, mSweetSpotCenterYs,KEY_COUNT);
-        copyArray(sweetSpotRadii, mSweetSpotRadii,KEY_COUNT);
+          HAS_TOUCH_POSITION_CORRECTION_DATA(layout.keyCount > 0 && layout.keyXCoordinates
+                  && layout.keyYCoordinates && layout.keyWidths && layout.keyHeights
+                  && layout.keyCharCodes && layout.sweetSpotCenterXs
+                  && layout.sweetSpotCenterYs && layout.sweetSpotRadii),
+          mProximityCharsArray(new int[GRID_WIDTH * GRID_HEIGHT * MAX_PROXIMITY_CHARS_SIZE]),
+          mLowerCodePointToKeyMap(NOT_AN_INDEX) {
+    // The locale is not used for the additional proximity characters; it has always been
+    // cleared here.
     memset(mLocaleStr, 0, sizeof(mLocaleStr));
+    const int proximityCharsArraySize = GRID_WIDTH * GRID_HEIGHT * MAX_PROXIMITY_CHARS_SIZE;
+    const int proximityCharsLength =
+            std::max(0, std::min(layout.proximityCharsLength, proximityCharsArraySize));
+    copyArray(layout.proximityChars, mProximityCharsArray, proximityCharsLength);
+    memset(mProximityCharsArray + proximityCharsLength, 0,
+            sizeof(int) * (proximityCharsArraySize - proximityCharsLength));
+    copyArray(layout.keyXCoordinates, mKeyXCoordinates, KEY_COUNT);
+    copyArray(layout.keyYCoordinates, mKeyYCoordinates, KEY_COUNT);
+    copyArray(layout.keyWidths, mKeyWidths, KEY_COUNT);
+    copyArray(layout.keyHeights, mKeyHeights, KEY_COUNT);
+    copyArray(layout.keyCharCodes, mKeyCodePoints, KEY_COUNT);
+    copyArray(layout.sweetSpotCenterXs, mSweetSpotCenterXs, KEY_COUNT);
+    copyArray(layout.sweetSpotCenterYs, mSweetSpotCenterYs, KEY_COUNT);
+    copyArray(layout.sweetSpotRadii, mSweetSpotRadii, KEY_COUNT);
+    if (layout.hasDerivedTables() && layout.derivedKeyCount == KEY_COUNT) {
+        initializeFromDerivedTables(layout);
+    } else {
         initializeG();
-    
+    }
 }
 
-
-
 ProximityInfo::~ProximityInfo() {
     delete[] mProximityCharsArray;
 }
@@ -166,7 +195,7 @@ void ProximityInfo::initializeG() {
             const float gapY = sweetSpotCenterY - mCenterYsG[i];
             mSweetSpotCenterYsG[i] = static_cast<int>(mCenterYsG[i] + gapY * verticalScale);
         }
-        mLowerCodePointToKeyMap[lowerCode] = i;
+        mLowerCodePointToKeyMap.put(lowerCode, i);
         mKeyIndexToOriginalCodePoint[i] = code;
         mKeyIndexToLowerCodePointG[i] = lowerCode;
     }
@@ -190,6 +219,18 @@ void ProximityInfo::initializeG() {
     }
 }
 
+void ProximityInfo::initializeFromDerivedTables(const KeyboardLayoutFile::Layout &layout) {
+    copyArray(layout.keyCenterXsG, mCenterXsG, KEY_COUNT);
+    copyArray(layout.keyCenterYsG, mCenterYsG, KEY_COUNT);
+    copyArray(layout.sweetSpotCenterYsG, mSweetSpotCenterYsG, KEY_COUNT);
+    copyArray(layout.keyIndexToLowerCodePoints, mKeyIndexToLowerCodePointG, KEY_COUNT);
+    copyArray(mKeyCodePoints, mKeyIndexToOriginalCodePoint, KEY_COUNT);
+    for (int i = 0; i < KEY_COUNT; ++i) {
+        mLowerCodePointToKeyMap.put(mKeyIndexToLowerCodePointG[i], i);
+        copyArray(layout.keyKeyDistancesG + i * KEY_COUNT, mKeyKeyDistancesG[i], KEY_COUNT);
+    }
+}
+
 // referencePointX is used only for keys wider than most common key width. When the referencePointX
 // is NOT_A_COORDINATE, this method calculates the return value without using the line segment.
 // isGeometric is currently not used because we don't have extra X coordinates sweet spots for
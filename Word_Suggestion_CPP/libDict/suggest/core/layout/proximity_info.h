@@ -17,12 +17,12 @@
 #ifndef LATINIME_PROXIMITY_INFO_H
 #define LATINIME_PROXIMITY_INFO_H
 
-#include <unordered_map>
-
 #include "../../../defines.h"
 
 // #include "jni.h"
+#include "keyboard_layout_file.h"
 #include "proximity_info_utils.h"
+#include "../../../utils/code_point_map.h"
 
 namespace latinime {
 
@@ -35,6 +35,9 @@ class ProximityInfo {
                   int* keyYCoordinates,  int* keyWidths,  int* keyHeights,
                   int* keyCharCodes,  float* sweetSpotCenterXs,
                   float* sweetSpotCenterYs,  float* sweetSpotRadii);
+    // Copies the layout's arrays. When the layout carries its derived tables (e.g. it was read
+    // from a compiled layout file), they are used as they are instead of being recomputed.
+    explicit ProximityInfo(const KeyboardLayoutFile::Layout &layout);
     ~ProximityInfo();
     bool hasSpaceProximity(const int x, const int y) const;
     float getNormalizedSquaredDistanceFromCenterFloatG(
@@ -89,8 +92,11 @@ class ProximityInfo {
 
  private:
     DISALLOW_IMPLICIT_CONSTRUCTORS(ProximityInfo);
+    // Reads the derived tables when compiling a layout file.
+    friend class KeyboardLayoutFile;
 
     void initializeG();
+    void initializeFromDerivedTables(const KeyboardLayoutFile::Layout &layout);
 
     const int GRID_WIDTH;
     const int GRID_HEIGHT;
@@ -118,7 +124,8 @@ class ProximityInfo {
     // Sweet spots for geometric input. Note that we have extra sweet spots only for Y coordinates.
     float mSweetSpotCenterYsG[MAX_KEY_COUNT_IN_A_KEYBOARD];
     float mSweetSpotRadii[MAX_KEY_COUNT_IN_A_KEYBOARD];
-    std::unordered_map<int, int> mLowerCodePointToKeyMap;
+    // Lower case code point to key index, NOT_AN_INDEX for code points not on the keyboard.
+    CodePointMap<int> mLowerCodePointToKeyMap;
     int mKeyIndexToOriginalCodePoint[MAX_KEY_COUNT_IN_A_KEYBOARD];
     int mKeyIndexToLowerCodePointG[MAX_KEY_COUNT_IN_A_KEYBOARD];
     int mCenterXsG[MAX_KEY_COUNT_IN_A_KEYBOARD];
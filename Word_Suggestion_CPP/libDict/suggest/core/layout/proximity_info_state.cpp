@@ -45,10 +45,12 @@ void ProximityInfoState::initInputParams(const int pointerId, const float maxPoi
         const int *const xCoordinates, const int *const yCoordinates, const int *const times,
         const int *const pointerIds, const bool isGeometric) {
     ASSERT(isGeometric || (inputSize < MAX_WORD_LENGTH));
-    mIsContinuousSuggestionPossible = (mHasBeenUpdatedByGeometricInput != isGeometric) ?
-            false : ProximityInfoStateUtils::checkAndReturnIsContinuousSuggestionPossible(
+    mMatchingSampledInputSize = (mHasBeenUpdatedByGeometricInput != isGeometric) ?
+            0 : ProximityInfoStateUtils::getMatchingSampledInputSize(
                     inputSize, xCoordinates, yCoordinates, times, mSampledInputSize,
                     &mSampledInputXs, &mSampledInputYs, &mSampledTimes, &mSampledInputIndice);
+    mIsContinuousSuggestionPossible = mHasBeenUpdatedByGeometricInput == isGeometric
+            && inputSize >= mSampledInputSize && mMatchingSampledInputSize == mSampledInputSize;
     if (DEBUG_DICT) {
         AKLOGI("isContinuousSuggestionPossible = %s",
                 (mIsContinuousSuggestionPossible ? "true" : "false"));
@@ -159,6 +161,8 @@ void ProximityInfoState::initInputParams(const int pointerId, const float maxPoi
         ProximityInfoStateUtils::initPrimaryInputWord(
                 inputSize, mInputProximities, mPrimaryInputWord);
     }
+    ProximityInfoStateUtils::initProximitySlotMasks(mInputProximities, mProximitySlotMasks,
+            mAdditionalProximitySlotMasks, mBaseLowerPrimaryCodePoints);
     if (DEBUG_GEO_FULL) {
         AKLOGI("ProximityState init finished: %d points out of %d", mSampledInputSize, inputSize);
     }
@@ -200,8 +204,7 @@ float ProximityInfoState::getPointToKeyByIdLength(
 // to the non-accented version.
 ProximityType ProximityInfoState::getProximityType(const int index, const int codePoint,
         const bool checkProximityChars, int *proximityIndex) const {
-    const int *currentCodePoints = getProximityCodePointsAt(index);
-    const int firstCodePoint = currentCodePoints[0];
+    const int firstCodePoint = getPrimaryCodePointAt(index);
     const int baseLowerC = CharUtils::toBaseLowerCase(codePoint);
 
     // The first char in the array is what user typed. If it matches right away, that means the
@@ -214,42 +217,32 @@ ProximityType ProximityInfoState::getProximityType(const int index, const int co
 
     // If the non-accented, lowercased version of that first character matches c, then we have a
     // non-accented version of the accented character the user typed. Treat it as a close char.
-    if (CharUtils::toBaseLowerCase(firstCodePoint) == baseLowerC) {
+    if (mBaseLowerPrimaryCodePoints[index] == baseLowerC) {
         return PROXIMITY_CHAR;
     }
 
-    // Not an exact nor an accent-alike match: search the list of close keys
-    int j = 1;
-    while (j < MAX_PROXIMITY_CHARS_SIZE
-            && currentCodePoints[j] > ADDITIONAL_PROXIMITY_CHAR_DELIMITER_CODE) {
-        const bool matched = (currentCodePoints[j] == baseLowerC
-                || currentCodePoints[j] == codePoint);
-        if (matched) {
-            if (proximityIndex) {
-                *proximityIndex = j;
-            }
-            return PROXIMITY_CHAR;
-        }
-        ++j;
-    }
-    if (j < MAX_PROXIMITY_CHARS_SIZE
-            && currentCodePoints[j] == ADDITIONAL_PROXIMITY_CHAR_DELIMITER_CODE) {
-        ++j;
-        while (j < MAX_PROXIMITY_CHARS_SIZE
-                && currentCodePoints[j] > ADDITIONAL_PROXIMITY_CHAR_DELIMITER_CODE) {
-            const bool matched = (currentCodePoints[j] == baseLowerC
-                    || currentCodePoints[j] == codePoint);
-            if (matched) {
-                if (proximityIndex) {
-                    *proximityIndex = j;
-                }
-                return ADDITIONAL_PROXIMITY_CHAR;
-            }
-            ++j;
+    // Not an exact nor an accent-alike match: search the list of close keys, all at once.
+    const ProximityCodePointMatcher matcher(getProximityCodePointsAt(index));
+    return getProximityTypeOfMatchingSlots(index, matcher.getMatchingSlots(baseLowerC, codePoint),
+            proximityIndex);
+}
+
+void ProximityInfoState::getProximityTypes(const int index, const int *const codePoints,
+        const int count, ProximityType *const outProximityTypes) const {
+    const int firstCodePoint = getPrimaryCodePointAt(index);
+    const ProximityCodePointMatcher matcher(getProximityCodePointsAt(index));
+    for (int i = 0; i < count; ++i) {
+        const int codePoint = codePoints[i];
+        const int baseLowerC = CharUtils::toBaseLowerCase(codePoint);
+        if (firstCodePoint == baseLowerC || firstCodePoint == codePoint) {
+            outProximityTypes[i] = MATCH_CHAR;
+        } else if (mBaseLowerPrimaryCodePoints[index] == baseLowerC) {
+            outProximityTypes[i] = PROXIMITY_CHAR;
+        } else {
+            outProximityTypes[i] = getProximityTypeOfMatchingSlots(index,
+                    matcher.getMatchingSlots(baseLowerC, codePoint), nullptr /* proximityIndex */);
         }
     }
-    // Was not included, signal this as a substitution character.
-    return SUBSTITUTION_CHAR;
 }
 
 ProximityType ProximityInfoState::getProximityTypeG(const int index, const int codePoint) const {
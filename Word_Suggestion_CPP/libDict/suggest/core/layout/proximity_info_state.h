@@ -17,12 +17,14 @@
 #ifndef LATINIME_PROXIMITY_INFO_STATE_H
 #define LATINIME_PROXIMITY_INFO_STATE_H
 
+#include <cstdint>
 #include <cstring> // for memset()
 #include <unordered_map>
 #include <vector>
 
 #include "../../../defines.h"
 
+#include "proximity_code_point_matcher.h"
 #include "proximity_info_params.h"
 #include "proximity_info_state_utils.h"
 
@@ -47,7 +49,8 @@ class ProximityInfoState {
             : mProximityInfo(nullptr), mMaxPointToKeyLength(0.0f), mAverageSpeed(0.0f),
               mHasTouchPositionCorrectionData(false), mMostCommonKeyWidthSquare(0),
               mKeyCount(0), mCellHeight(0), mCellWidth(0), mGridHeight(0), mGridWidth(0),
-              mIsContinuousSuggestionPossible(false), mHasBeenUpdatedByGeometricInput(false),
+              mIsContinuousSuggestionPossible(false), mMatchingSampledInputSize(0),
+              mHasBeenUpdatedByGeometricInput(false),
               mSampledInputXs(), mSampledInputYs(), mSampledTimes(), mSampledInputIndice(),
               mSampledLengthCache(), mBeelineSpeedPercentiles(),
               mSampledNormalizedSquaredLengthCache(), mSpeedRates(), mDirections(),
@@ -55,6 +58,9 @@ class ProximityInfoState {
               mTouchPositionCorrectionEnabled(false), mSampledInputSize(0),
               mMostProbableStringProbability(0.0f) {
         memset(mInputProximities, 0, sizeof(mInputProximities));
+        memset(mProximitySlotMasks, 0, sizeof(mProximitySlotMasks));
+        memset(mAdditionalProximitySlotMasks, 0, sizeof(mAdditionalProximitySlotMasks));
+        memset(mBaseLowerPrimaryCodePoints, 0, sizeof(mBaseLowerPrimaryCodePoints));
         memset(mPrimaryInputWord, 0, sizeof(mPrimaryInputWord));
         memset(mMostProbableString, 0, sizeof(mMostProbableString));
     }
@@ -143,6 +149,11 @@ class ProximityInfoState {
         return mIsContinuousSuggestionPossible;
     }
 
+    // Number of leading sampled points of the previous input that the current one repeats.
+    int getMatchingSampledInputSize() const {
+        return mMatchingSampledInputSize;
+    }
+
     // TODO: Rename s/Length/NormalizedSquaredLength/
     float getPointToKeyByIdLength(const int inputIndex, const int keyId) const;
     // TODO: Rename s/Length/NormalizedSquaredLength/
@@ -150,6 +161,10 @@ class ProximityInfoState {
 
     ProximityType getProximityType(const int index, const int codePoint,
             const bool checkProximityChars, int *proximityIndex = 0) const;
+    // Sets outProximityTypes[i] to getProximityType(index, codePoints[i], true), for the count
+    // code points, such as those of the children of a dicNode, typed at the same input point.
+    void getProximityTypes(const int index, const int *const codePoints, const int count,
+            ProximityType *const outProximityTypes) const;
 
     ProximityType getProximityTypeG(const int index, const int codePoint) const;
 
@@ -192,6 +207,25 @@ class ProximityInfoState {
         return ProximityInfoStateUtils::getProximityCodePointsAt(mInputProximities, index);
     }
 
+    // The proximity type of a code point that is neither the typed code point at index nor its
+    // base lower case letter, given the proximity code points at index it matches.
+    AK_FORCE_INLINE ProximityType getProximityTypeOfMatchingSlots(const int index,
+            const uint32_t matchingSlots, int *const proximityIndex) const {
+        // The close keys come before the additional proximity chars, so the lowest matching
+        // slot is the one a scan of both would stop at.
+        const uint32_t slots = matchingSlots
+                & (mProximitySlotMasks[index] | mAdditionalProximitySlotMasks[index]);
+        if (slots == 0) {
+            return SUBSTITUTION_CHAR;
+        }
+        const int slot = __builtin_ctz(slots);
+        if (proximityIndex) {
+            *proximityIndex = slot;
+        }
+        return (mProximitySlotMasks[index] & (1u << slot)) != 0
+                ? PROXIMITY_CHAR : ADDITIONAL_PROXIMITY_CHAR;
+    }
+
     // const
     const ProximityInfo *mProximityInfo;
     float mMaxPointToKeyLength;
@@ -204,6 +238,7 @@ class ProximityInfoState {
     int mGridHeight;
     int mGridWidth;
     bool mIsContinuousSuggestionPossible;
+    int mMatchingSampledInputSize;
     bool mHasBeenUpdatedByGeometricInput;
 
     std::vector<int> mSampledInputXs;
@@ -225,6 +260,10 @@ class ProximityInfoState {
     std::vector<std::vector<int>> mSampledSearchKeyVectors;
     bool mTouchPositionCorrectionEnabled;
     int mInputProximities[MAX_PROXIMITY_CHARS_SIZE * MAX_WORD_LENGTH];
+    // Per input point, see ProximityInfoStateUtils::initProximitySlotMasks().
+    uint32_t mProximitySlotMasks[MAX_WORD_LENGTH];
+    uint32_t mAdditionalProximitySlotMasks[MAX_WORD_LENGTH];
+    int mBaseLowerPrimaryCodePoints[MAX_WORD_LENGTH];
     int mSampledInputSize;
     int mPrimaryInputWord[MAX_WORD_LENGTH];
     float mMostProbableStringProbability;
@@ -29,6 +29,7 @@
 #include "normal_distribution_2d.h"
 #include "proximity_info.h"
 #include "proximity_info_params.h"
+#include "../../../utils/char_utils.h"
 
 namespace latinime {
 
@@ -147,6 +148,37 @@ namespace latinime {
     return getProximityCodePointsAt(inputProximities, index)[0];
 }
 
+/* static */ void ProximityInfoStateUtils::initProximitySlotMasks(
+        const int *const inputProximities, uint32_t *const outProximitySlotMasks,
+        uint32_t *const outAdditionalProximitySlotMasks,
+        int *const outBaseLowerPrimaryCodePoints) {
+    for (int i = 0; i < MAX_WORD_LENGTH; ++i) {
+        const int *const codePoints = getProximityCodePointsAt(inputProximities, i);
+        // The first code point is the typed one. The close keys follow it up to the delimiter,
+        // then the additional proximity chars; a code point below the delimiter ends either.
+        uint32_t proximitySlots = 0;
+        int j = 1;
+        while (j < MAX_PROXIMITY_CHARS_SIZE
+                && codePoints[j] > ADDITIONAL_PROXIMITY_CHAR_DELIMITER_CODE) {
+            proximitySlots |= 1u << j;
+            ++j;
+        }
+        uint32_t additionalProximitySlots = 0;
+        if (j < MAX_PROXIMITY_CHARS_SIZE
+                && codePoints[j] == ADDITIONAL_PROXIMITY_CHAR_DELIMITER_CODE) {
+            ++j;
+            while (j < MAX_PROXIMITY_CHARS_SIZE
+                    && codePoints[j] > ADDITIONAL_PROXIMITY_CHAR_DELIMITER_CODE) {
+                additionalProximitySlots |= 1u << j;
+                ++j;
+            }
+        }
+        outProximitySlotMasks[i] = proximitySlots;
+        outAdditionalProximitySlotMasks[i] = additionalProximitySlots;
+        outBaseLowerPrimaryCodePoints[i] = CharUtils::toBaseLowerCase(codePoints[0]);
+    }
+}
+
 /* static */ void ProximityInfoStateUtils::initPrimaryInputWord(const int inputSize,
         const int *const inputProximities, int *primaryInputWord) {
     memset(primaryInputWord, 0, sizeof(primaryInputWord[0]) * MAX_WORD_LENGTH);
@@ -902,32 +934,29 @@ namespace latinime {
     return true;
 }
 
-/* static */ bool ProximityInfoStateUtils::checkAndReturnIsContinuousSuggestionPossible(
+/* static */ int ProximityInfoStateUtils::getMatchingSampledInputSize(
         const int inputSize, const int *const xCoordinates, const int *const yCoordinates,
         const int *const times, const int sampledInputSize,
         const std::vector<int> *const sampledInputXs, const std::vector<int> *const sampledInputYs,
         const std::vector<int> *const sampledTimes,
         const std::vector<int> *const sampledInputIndices) {
-    if (inputSize < sampledInputSize) {
-        return false;
-    }
     for (int i = 0; i < sampledInputSize; ++i) {
         const int index = (*sampledInputIndices)[i];
         if (index >= inputSize) {
-            return false;
+            return i;
         }
         if (xCoordinates[index] != (*sampledInputXs)[i]
                 || yCoordinates[index] != (*sampledInputYs)[i]) {
-            return false;
+            return i;
         }
         if (!times) {
             continue;
         }
         if (times[index] != (*sampledTimes)[i]) {
-            return false;
+            return i;
         }
     }
-    return true;
+    return sampledInputSize;
 }
 
 // Get a word that is detected by tracing the most probable string into codePointBuf and
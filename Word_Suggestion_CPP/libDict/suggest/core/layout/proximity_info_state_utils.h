@@ -18,6 +18,7 @@
 #define LATINIME_PROXIMITY_INFO_STATE_UTILS_H
 
 #include <bitset>
+#include <cstdint>
 #include <unordered_map>
 #include <vector>
 
@@ -46,6 +47,13 @@ class ProximityInfoStateUtils {
             std::vector<int> *sampledInputIndice);
     static const int *getProximityCodePointsAt(const int *const inputProximities, const int index);
     static int getPrimaryCodePointAt(const int *const inputProximities, const int index);
+    // Sets, for each of the MAX_WORD_LENGTH input points, the masks of the proximity code points
+    // that are close keys and additional proximity chars, as ProximityInfoState::
+    // getProximityType() scans them, and the base lower case of the primary code point.
+    static void initProximitySlotMasks(const int *const inputProximities,
+            uint32_t *const outProximitySlotMasks,
+            uint32_t *const outAdditionalProximitySlotMasks,
+            int *const outBaseLowerPrimaryCodePoints);
     static void popInputData(std::vector<int> *sampledInputXs, std::vector<int> *sampledInputYs,
             std::vector<int> *sampledInputTimes, std::vector<int> *sampledLengthCache,
             std::vector<int> *sampledInputIndice);
@@ -97,7 +105,8 @@ class ProximityInfoStateUtils {
             const std::vector<int> *const sampledTimes,
             const std::vector<float> *const sampledSpeedRates,
             const std::vector<int> *const sampledBeelineSpeedPercentiles);
-    static bool checkAndReturnIsContinuousSuggestionPossible(const int inputSize,
+    // Number of leading sampled points that the input repeats.
+    static int getMatchingSampledInputSize(const int inputSize,
             const int *const xCoordinates, const int *const yCoordinates, const int *const times,
             const int sampledInputSize, const std::vector<int> *const sampledInputXs,
             const std::vector<int> *const sampledInputYs,
@@ -18,19 +18,19 @@
 #define LATINIME_PROXIMITY_INFO_UTILS_H
 
 #include <cmath>
-#include <unordered_map>
 
 #include "../../../defines.h"
 
 #include "additional_proximity_chars.h"
 #include "geometry_utils.h"
 #include "../../../utils/char_utils.h"
+#include "../../../utils/code_point_map.h"
 
 namespace latinime {
 class ProximityInfoUtils {
  public:
     static AK_FORCE_INLINE int getKeyIndexOf(const int keyCount, const int c,
-            const std::unordered_map<int, int> *const codeToKeyMap) {
+            const CodePointMap<int> *const codeToKeyMap) {
         if (keyCount == 0) {
             // We do not have the coordinate data
             return NOT_AN_INDEX;
@@ -38,12 +38,7 @@ class ProximityInfoUtils {
         if (c == NOT_A_CODE_POINT) {
             return NOT_AN_INDEX;
         }
-        const int lowerCode = CharUtils::toLowerCase(c);
-        std::unordered_map<int, int>::const_iterator mapPos = codeToKeyMap->find(lowerCode);
-        if (mapPos != codeToKeyMap->end()) {
-            return mapPos->second;
-        }
-        return NOT_AN_INDEX;
+        return codeToKeyMap->get(CharUtils::toLowerCase(c));
     }
 
     static AK_FORCE_INLINE void initializeProximities(const int *const inputCodes,
@@ -53,7 +48,7 @@ class ProximityInfoUtils {
             const int *const proximityCharsArray, const int cellHeight, const int cellWidth,
             const int gridWidth, const int mostCommonKeyWidth, const int keyCount,
             const char *const localeStr,
-            const std::unordered_map<int, int> *const codeToKeyMap, int *inputProximities) {
+            const CodePointMap<int> *const codeToKeyMap, int *inputProximities) {
         // Initialize
         // - mInputCodes
         // - mNormalizedSquaredDistances
@@ -145,7 +140,7 @@ class ProximityInfoUtils {
             const int *const proximityCharsArray, const int cellHeight, const int cellWidth,
             const int gridWidth, const int mostCommonKeyWidth, const int keyCount,
             const int x, const int y, const int primaryKey, const char *const localeStr,
-            const std::unordered_map<int, int> *const codeToKeyMap, int *proximities) {
+            const CodePointMap<int> *const codeToKeyMap, int *proximities) {
         const int mostCommonKeyWidthSquare = mostCommonKeyWidth * mostCommonKeyWidth;
         int insertPos = 0;
         proximities[insertPos++] = primaryKey;
@@ -22,10 +22,14 @@
 
 namespace latinime {
 
+class DicNodeVector;
 class DicTraverseSession;
 
 class Traversal {
  public:
+    // Most children getProximityTypes() classifies in one call.
+    static const int MAX_PROXIMITY_TYPE_BATCH_SIZE = 32;
+
     virtual int getMaxPointerCount() const = 0;
     virtual bool allowsErrorCorrections(const DicNode *const dicNode) const = 0;
     virtual bool isOmission(const DicTraverseSession *const traverseSession,
@@ -42,11 +46,19 @@ class Traversal {
             const DicNode *const dicNode) const = 0;
     virtual ProximityType getProximityType(const DicTraverseSession *const traverseSession,
             const DicNode *const dicNode, const DicNode *const childDicNode) const = 0;
+    // Sets outProximityTypes[i] to getProximityType() of the (start + i)-th of childDicNodes,
+    // the children of dicNode, for count <= MAX_PROXIMITY_TYPE_BATCH_SIZE of them.
+    virtual void getProximityTypes(const DicTraverseSession *const traverseSession,
+            const DicNode *const dicNode, DicNodeVector *const childDicNodes, const int start,
+            const int count, ProximityType *const outProximityTypes) const = 0;
     virtual bool needsToTraverseAllUserInput() const = 0;
     virtual float getMaxSpatialDistance() const = 0;
     virtual int getDefaultExpandDicNodeSize() const = 0;
     virtual int getMaxCacheSize(const int inputSize) const = 0;
     virtual int getTerminalCacheSize() const = 0;
+    // Number of the best active dicNodes to expand in the step about to start; the others are
+    // dropped. Called at the start of every step of the search.
+    virtual int getActiveDicNodeLimit(const DicTraverseSession *const traverseSession) const = 0;
     virtual bool isPossibleOmissionChildNode(const DicTraverseSession *const traverseSession,
             const DicNode *const parentDicNode, const DicNode *const dicNode) const = 0;
     virtual bool isGoodToTraverseNextWord(const DicNode *const dicNode) const = 0;
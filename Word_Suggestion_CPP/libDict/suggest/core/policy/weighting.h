@@ -19,18 +19,26 @@
 
 #include "../../../defines.h"
 
+#include "../dicnode/dic_node.h"
+#include "../dicnode/dic_node_profiler.h"
+#include "../dicnode/dic_node_utils.h"
 #include "../dictionary/error_type_utils.h"
+#include "../dictionary/multi_bigram_map.h"
+#include "../session/dic_traverse_session.h"
 
 namespace latinime {
 
-class DicNode;
-class DicTraverseSession;
-struct DicNode_InputStateG;
-class MultiBigramMap;
-
+/**
+ * Costs of the edges of the search. The static functions that add them are templates on the
+ * weighting policy: instantiated on Weighting they reach the costs through its virtual
+ * functions, and on a final policy class they let the compiler inline the costs and fold the
+ * switches on the correction type. A policy whose cost functions are not public makes Weighting
+ * a friend.
+ */
 class Weighting {
  public:
-    static void addCostAndForwardInputIndex(const Weighting *const weighting,
+    template<class WeightingPolicy>
+    static void addCostAndForwardInputIndex(const WeightingPolicy *const weighting,
             const CorrectionType correctionType,
             const DicTraverseSession *const traverseSession,
             const DicNode *const parentDicNode, DicNode *const dicNode,
@@ -96,16 +104,201 @@ class Weighting {
  private:
     DISALLOW_COPY_AND_ASSIGN(Weighting);
 
-    static float getSpatialCost(const Weighting *const weighting,
+    template<class WeightingPolicy>
+    static float getSpatialCost(const WeightingPolicy *const weighting,
             const CorrectionType correctionType, const DicTraverseSession *const traverseSession,
             const DicNode *const parentDicNode, const DicNode *const dicNode,
             DicNode_InputStateG *const inputStateG);
-    static float getLanguageCost(const Weighting *const weighting,
+    template<class WeightingPolicy>
+    static float getLanguageCost(const WeightingPolicy *const weighting,
             const CorrectionType correctionType, const DicTraverseSession *const traverseSession,
             const DicNode *const parentDicNode, const DicNode *const dicNode,
             MultiBigramMap *const multiBigramMap);
     // TODO: Move to TypingWeighting and GestureWeighting?
     static int getForwardInputCount(const CorrectionType correctionType);
+    static void profile(const CorrectionType correctionType, DicNode *const node);
 };
+
+/* static */ AK_FORCE_INLINE void Weighting::profile(const CorrectionType correctionType,
+        DicNode *const node) {
+#if DEBUG_DICT
+    switch (correctionType) {
+    case CT_OMISSION:
+        PROF_OMISSION(node->mProfiler);
+        return;
+    case CT_ADDITIONAL_PROXIMITY:
+        PROF_ADDITIONAL_PROXIMITY(node->mProfiler);
+        return;
+    case CT_SUBSTITUTION:
+        PROF_SUBSTITUTION(node->mProfiler);
+        return;
+    case CT_NEW_WORD_SPACE_OMISSION:
+        PROF_NEW_WORD(node->mProfiler);
+        return;
+    case CT_MATCH:
+        PROF_MATCH(node->mProfiler);
+        return;
+    case CT_COMPLETION:
+        PROF_COMPLETION(node->mProfiler);
+        return;
+    case CT_TERMINAL:
+        PROF_TERMINAL(node->mProfiler);
+        return;
+    case CT_TERMINAL_INSERTION:
+        PROF_TERMINAL_INSERTION(node->mProfiler);
+        return;
+    case CT_NEW_WORD_SPACE_SUBSTITUTION:
+        PROF_SPACE_SUBSTITUTION(node->mProfiler);
+        return;
+    case CT_INSERTION:
+        PROF_INSERTION(node->mProfiler);
+        return;
+    case CT_TRANSPOSITION:
+        PROF_TRANSPOSITION(node->mProfiler);
+        return;
+    default:
+        // do nothing
+        return;
+    }
+#else
+    // do nothing
+#endif
+}
+
+template<class WeightingPolicy>
+/* static */ AK_FORCE_INLINE void Weighting::addCostAndForwardInputIndex(
+        const WeightingPolicy *const weighting,
+        const CorrectionType correctionType, const DicTraverseSession *const traverseSession,
+        const DicNode *const parentDicNode, DicNode *const dicNode,
+        MultiBigramMap *const multiBigramMap) {
+    const int inputSize = traverseSession->getInputSize();
+    DicNode_InputStateG inputStateG;
+    inputStateG.mNeedsToUpdateInputStateG = false; // Don't use input info by default
+    const float spatialCost = Weighting::getSpatialCost(weighting, correctionType,
+            traverseSession, parentDicNode, dicNode, &inputStateG);
+    const float languageCost = Weighting::getLanguageCost(weighting, correctionType,
+            traverseSession, parentDicNode, dicNode, multiBigramMap);
+    const ErrorTypeUtils::ErrorType errorType = weighting->getErrorType(correctionType,
+            traverseSession, parentDicNode, dicNode);
+    profile(correctionType, dicNode);
+    if (inputStateG.mNeedsToUpdateInputStateG) {
+        dicNode->updateInputIndexG(&inputStateG);
+    } else {
+        dicNode->forwardInputIndex(0, getForwardInputCount(correctionType),
+                (correctionType == CT_TRANSPOSITION));
+    }
+    dicNode->addCost(spatialCost, languageCost, weighting->needsToNormalizeCompoundDistance(),
+            inputSize, errorType);
+    if (CT_NEW_WORD_SPACE_OMISSION == correctionType) {
+        // When we are on a terminal, we save the current distance for evaluating
+        // when to auto-commit partial suggestions.
+        dicNode->saveNormalizedCompoundDistanceAfterFirstWordIfNoneYet();
+    }
+}
+
+template<class WeightingPolicy>
+/* static */ AK_FORCE_INLINE float Weighting::getSpatialCost(
+        const WeightingPolicy *const weighting,
+        const CorrectionType correctionType, const DicTraverseSession *const traverseSession,
+        const DicNode *const parentDicNode, const DicNode *const dicNode,
+        DicNode_InputStateG *const inputStateG) {
+    switch(correctionType) {
+    case CT_OMISSION:
+        return weighting->getOmissionCost(parentDicNode, dicNode);
+    case CT_ADDITIONAL_PROXIMITY:
+        // only used for typing
+        return weighting->getAdditionalProximityCost();
+    case CT_SUBSTITUTION:
+        // only used for typing
+        return weighting->getSubstitutionCost();
+    case CT_NEW_WORD_SPACE_OMISSION:
+        return weighting->getNewWordSpatialCost(traverseSession, dicNode, inputStateG);
+    case CT_MATCH:
+        return weighting->getMatchedCost(traverseSession, dicNode, inputStateG);
+    case CT_COMPLETION:
+        return weighting->getCompletionCost(traverseSession, dicNode);
+    case CT_TERMINAL:
+        return weighting->getTerminalSpatialCost(traverseSession, dicNode);
+    case CT_TERMINAL_INSERTION:
+        return weighting->getTerminalInsertionCost(traverseSession, dicNode);
+    case CT_NEW_WORD_SPACE_SUBSTITUTION:
+        return weighting->getSpaceSubstitutionCost(traverseSession, dicNode);
+    case CT_INSERTION:
+        return weighting->getInsertionCost(traverseSession, parentDicNode, dicNode);
+    case CT_TRANSPOSITION:
+        return weighting->getTranspositionCost(traverseSession, parentDicNode, dicNode);
+    default:
+        return 0.0f;
+    }
+}
+
+template<class WeightingPolicy>
+/* static */ AK_FORCE_INLINE float Weighting::getLanguageCost(
+        const WeightingPolicy *const weighting,
+        const CorrectionType correctionType, const DicTraverseSession *const traverseSession,
+        const DicNode *const parentDicNode, const DicNode *const dicNode,
+        MultiBigramMap *const multiBigramMap) {
+    switch(correctionType) {
+    case CT_OMISSION:
+        return 0.0f;
+    case CT_SUBSTITUTION:
+        return 0.0f;
+    case CT_NEW_WORD_SPACE_OMISSION:
+        return weighting->getNewWordBigramLanguageCost(
+                traverseSession, parentDicNode, multiBigramMap);
+    case CT_MATCH:
+        return 0.0f;
+    case CT_COMPLETION:
+        return 0.0f;
+    case CT_TERMINAL: {
+        const float languageImprobability =
+                DicNodeUtils::getBigramNodeImprobability(
+                        traverseSession->getDictionaryStructurePolicy(
+                                dicNode->getDictionaryIndex()), dicNode, multiBigramMap);
+        return weighting->getTerminalLanguageCost(traverseSession, dicNode, languageImprobability);
+    }
+    case CT_TERMINAL_INSERTION:
+        return 0.0f;
+    case CT_NEW_WORD_SPACE_SUBSTITUTION:
+        return weighting->getNewWordBigramLanguageCost(
+                traverseSession, parentDicNode, multiBigramMap);
+    case CT_INSERTION:
+        return 0.0f;
+    case CT_TRANSPOSITION:
+        return 0.0f;
+    default:
+        return 0.0f;
+    }
+}
+
+/* static */ AK_FORCE_INLINE int Weighting::getForwardInputCount(
+        const CorrectionType correctionType) {
+    switch(correctionType) {
+        case CT_OMISSION:
+            return 0;
+        case CT_ADDITIONAL_PROXIMITY:
+            return 0; /* 0 because CT_MATCH will be called */
+        case CT_SUBSTITUTION:
+            return 0; /* 0 because CT_MATCH will be called */
+        case CT_NEW_WORD_SPACE_OMISSION:
+            return 0;
+        case CT_MATCH:
+            return 1;
+        case CT_COMPLETION:
+            return 1;
+        case CT_TERMINAL:
+            return 0;
+        case CT_TERMINAL_INSERTION:
+            return 1;
+        case CT_NEW_WORD_SPACE_SUBSTITUTION:
+            return 1;
+        case CT_INSERTION:
+            return 2; /* look ahead + skip the current char */
+        case CT_TRANSPOSITION:
+            return 2; /* look ahead + skip the current char */
+        default:
+            return 0;
+    }
+}
 } // namespace latinime
 #endif // LATINIME_WEIGHTING_H
@@ -17,7 +17,8 @@
 #ifndef LATINIME_SUGGESTED_WORD_H
 #define LATINIME_SUGGESTED_WORD_H
 
-#include <vector>
+#include <algorithm>
+#include <cstring>
 
 #include "../../../defines.h"
 
@@ -29,7 +30,7 @@ class SuggestedWord {
  public:
     class Comparator {
      public:
-        bool operator()(const SuggestedWord &left, const SuggestedWord &right) {
+        bool operator()(const SuggestedWord &left, const SuggestedWord &right) const {
             if (left.getScore() != right.getScore()) {
                 return left.getScore() > right.getScore();
             }
@@ -40,19 +41,26 @@ class SuggestedWord {
         DISALLOW_ASSIGNMENT_OPERATOR(Comparator);
     };
 
+    // Constructs an empty word so that fixed-capacity arrays of SuggestedWord can be declared.
+    SuggestedWord()
+            : mCodePointCount(0), mScore(0), mType(0), mIndexToPartialCommit(NOT_AN_INDEX),
+              mAutoCommitFirstWordConfidence(NOT_A_FIRST_WORD_CONFIDENCE) {}
+
     SuggestedWord(const int *const codePoints, const int codePointCount,
             const int score, const int type, const int indexToPartialCommit,
             const int autoCommitFirstWordConfidence)
-            : mCodePoints(codePoints, codePoints + codePointCount), mScore(score),
-              mType(type), mIndexToPartialCommit(indexToPartialCommit),
-              mAutoCommitFirstWordConfidence(autoCommitFirstWordConfidence) {}
+            : mCodePointCount(std::min(std::max(codePointCount, 0), MAX_WORD_LENGTH)),
+              mScore(score), mType(type), mIndexToPartialCommit(indexToPartialCommit),
+              mAutoCommitFirstWordConfidence(autoCommitFirstWordConfidence) {
+        memmove(mCodePoints, codePoints, sizeof(mCodePoints[0]) * mCodePointCount);
+    }
 
     const int *getCodePoint() const {
-        return &mCodePoints.at(0);
+        return mCodePoints;
     }
 
     int getCodePointCount() const {
-        return mCodePoints.size();
+        return mCodePointCount;
     }
 
     int getScore() const {
@@ -72,9 +80,9 @@ class SuggestedWord {
     }
 
  private:
-    DISALLOW_DEFAULT_CONSTRUCTOR(SuggestedWord);
-
-    std::vector<int> mCodePoints;
+    // Code points are stored inline so that building results never touches the heap.
+    int mCodePoints[MAX_WORD_LENGTH];
+    int mCodePointCount;
     int mScore;
     int mType;
     int mIndexToPartialCommit;
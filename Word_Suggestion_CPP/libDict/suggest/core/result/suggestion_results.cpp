@@ -20,6 +20,9 @@
 
 namespace latinime {
 
+// Definition of a constant initialized in its class, which std::min takes by reference.
+const int SuggestionResults::MAX_SUGGESTION_COUNT;
+
 // void SuggestionResults::outputSuggestions(JNIEnv *env, jintArray outSuggestionCount,
 //         jintArray outputCodePointsArray, jintArray outScoresArray, jintArray outSpaceIndicesArray,
 //         jintArray outTypesArray, jintArray outAutoCommitFirstWordConfidenceArray,
@@ -66,40 +69,79 @@ void SuggestionResults::addSuggestion(const int *const codePoints, const int cod
                 codePointCount);
         return;
     }
-    if (getSuggestionCount() >= mMaxSuggestionCount) {
-        const SuggestedWord &mWorstSuggestion = mSuggestedWords.top();
+    if (mMaxSuggestionCount <= 0) {
+        return;
+    }
+    const SuggestedWord::Comparator comparator;
+    // A word found again, through another correction or another dictionary of the group, keeps
+    // the best of its scores along with the type that came with it.
+    for (int i = 0; i < mSuggestionCount; ++i) {
+        SuggestedWord &suggestedWord = mSuggestedWords[i];
+        if (suggestedWord.getCodePointCount() != codePointCount
+                || !std::equal(codePoints, codePoints + codePointCount,
+                        suggestedWord.getCodePoint())) {
+            continue;
+        }
+        if (score > suggestedWord.getScore()) {
+            suggestedWord = SuggestedWord(codePoints, codePointCount, score, type,
+                    indexToPartialCommit, autocimmitFirstWordConfindence);
+            std::make_heap(mSuggestedWords, mSuggestedWords + mSuggestionCount, comparator);
+        }
+        return;
+    }
+    if (mSuggestionCount >= mMaxSuggestionCount) {
+        const SuggestedWord &mWorstSuggestion = mSuggestedWords[0];
         if (score > mWorstSuggestion.getScore() || (score == mWorstSuggestion.getScore()
                 && codePointCount < mWorstSuggestion.getCodePointCount())) {
-            mSuggestedWords.pop();
+            std::pop_heap(mSuggestedWords, mSuggestedWords + mSuggestionCount, comparator);
+            --mSuggestionCount;
         } else {
             return;
         }
     }
-    mSuggestedWords.push(SuggestedWord(codePoints, codePointCount, score, type,
-            indexToPartialCommit, autocimmitFirstWordConfindence));
+    mSuggestedWords[mSuggestionCount] = SuggestedWord(codePoints, codePointCount, score, type,
+            indexToPartialCommit, autocimmitFirstWordConfindence);
+    ++mSuggestionCount;
+    std::push_heap(mSuggestedWords, mSuggestedWords + mSuggestionCount, comparator);
+}
+
+const SuggestedWord *SuggestionResults::sortAndGetSuggestedWords() {
+    // sort_heap pops the heap back to front, which leaves words of the same score shortest
+    // first. Reverse each run of equal scores to get back the pop order of the heap.
+    std::sort_heap(mSuggestedWords, mSuggestedWords + mSuggestionCount,
+            SuggestedWord::Comparator());
+    int runStart = 0;
+    for (int i = 1; i <= mSuggestionCount; ++i) {
+        if (i == mSuggestionCount
+                || mSuggestedWords[i].getScore() != mSuggestedWords[runStart].getScore()) {
+            std::reverse(mSuggestedWords + runStart, mSuggestedWords + i);
+            runStart = i;
+        }
+    }
+    return mSuggestedWords;
 }
 
 void SuggestionResults::getSortedScores(int *const outScores) const {
-    auto copyOfSuggestedWords = mSuggestedWords;
-    while (!copyOfSuggestedWords.empty()) {
-        const SuggestedWord &suggestedWord = copyOfSuggestedWords.top();
-        outScores[copyOfSuggestedWords.size() - 1] = suggestedWord.getScore();
-        copyOfSuggestedWords.pop();
+    // A heap popped back to front is sorted from the best to the worst.
+    SuggestedWord copyOfSuggestedWords[MAX_SUGGESTION_COUNT];
+    std::copy(mSuggestedWords, mSuggestedWords + mSuggestionCount, copyOfSuggestedWords);
+    std::sort_heap(copyOfSuggestedWords, copyOfSuggestedWords + mSuggestionCount,
+            SuggestedWord::Comparator());
+    for (int i = 0; i < mSuggestionCount; ++i) {
+        outScores[i] = copyOfSuggestedWords[i].getScore();
     }
 }
 
 void SuggestionResults::dumpSuggestions() const {
     AKLOGE("language weight: %f", mLanguageWeight);
-    std::vector<SuggestedWord> suggestedWords;
-    auto copyOfSuggestedWords = mSuggestedWords;
-    while (!copyOfSuggestedWords.empty()) {
-        suggestedWords.push_back(copyOfSuggestedWords.top());
-        copyOfSuggestedWords.pop();
-    }
-    int index = 0;
-    for (auto it = suggestedWords.rbegin(); it != suggestedWords.rend(); ++it) {
-        DUMP_SUGGESTION(it->getCodePoint(), it->getCodePointCount(), index, it->getScore());
-        index++;
+    SuggestedWord copyOfSuggestedWords[MAX_SUGGESTION_COUNT];
+    std::copy(mSuggestedWords, mSuggestedWords + mSuggestionCount, copyOfSuggestedWords);
+    std::sort_heap(copyOfSuggestedWords, copyOfSuggestedWords + mSuggestionCount,
+            SuggestedWord::Comparator());
+    for (int index = 0; index < mSuggestionCount; ++index) {
+        DUMP_SUGGESTION(copyOfSuggestedWords[index].getCodePoint(),
+                copyOfSuggestedWords[index].getCodePointCount(), index,
+                copyOfSuggestedWords[index].getScore());
     }
 }
 
@@ -17,6 +17,7 @@
 #ifndef LATINIME_SUGGESTION_RESULTS_H
 #define LATINIME_SUGGESTION_RESULTS_H
 
+#include <algorithm>
 #include <queue>
 #include <vector>
 
@@ -27,11 +28,18 @@
 
 namespace latinime {
 
+// Keeps the best suggestions of a query in a bounded heap with fixed capacity, so that a
+// SuggestionResults can live on the stack and collecting results does not allocate. Each word
+// is kept once, with its best score.
 class SuggestionResults {
  public:
+    // Capacity of the result heap; larger requested counts are clamped to it.
+    static const int MAX_SUGGESTION_COUNT = MAX_RESULTS;
+
     explicit SuggestionResults(const int maxSuggestionCount)
-            : mMaxSuggestionCount(maxSuggestionCount), mLanguageWeight(NOT_A_LANGUAGE_WEIGHT),
-              mSuggestedWords() {}
+            : mMaxSuggestionCount(std::min(std::max(maxSuggestionCount, 0),
+                      MAX_SUGGESTION_COUNT)),
+              mLanguageWeight(NOT_A_LANGUAGE_WEIGHT), mSuggestionCount(0), mIsTruncated(false) {}
 
     // Returns suggestion count.
 //    void outputSuggestions(JNIEnv *env, jintArray outSuggestionCount, jintArray outCodePointsArray,
@@ -44,6 +52,27 @@ class SuggestionResults {
     void getSortedScores(int *const outScores) const;
     void dumpSuggestions() const;
 
+    // Sorts the suggestions in place from the best to the worst and returns them. Suggestions
+    // with the same score keep the order std::priority_queue used to pop them in (the longer
+    // word first). The results are consumed: call clear() before adding new suggestions.
+    const SuggestedWord *sortAndGetSuggestedWords();
+
+    void clear() {
+        mSuggestionCount = 0;
+        mLanguageWeight = NOT_A_LANGUAGE_WEIGHT;
+        mIsTruncated = false;
+    }
+
+    // Whether the search stopped at its deadline or dicNode limit, leaving the suggestions found
+    // until then; see SuggestOptions::getSearchDeadlineMicros().
+    void setTruncated(const bool isTruncated) {
+        mIsTruncated = isTruncated;
+    }
+
+    bool isTruncated() const {
+        return mIsTruncated;
+    }
+
     void setLanguageWeight(const float languageWeight) {
         mLanguageWeight = languageWeight;
     }
@@ -53,24 +82,31 @@ class SuggestionResults {
     }
 
     int getSuggestionCount() const {
-        return mSuggestedWords.size();
+        return mSuggestionCount;
     }
     int getMaxSuggestionCount(){
         return mMaxSuggestionCount;
     }
+    // Returns a copy of the results as a heap with the worst suggestion on top. This allocates;
+    // use sortAndGetSuggestedWords() on latency sensitive paths.
     std::priority_queue<
             SuggestedWord, std::vector<SuggestedWord>, SuggestedWord::Comparator> getSuggestedWords(){
-                return mSuggestedWords;
+                return std::priority_queue<SuggestedWord, std::vector<SuggestedWord>,
+                        SuggestedWord::Comparator>(SuggestedWord::Comparator(),
+                                std::vector<SuggestedWord>(mSuggestedWords,
+                                        mSuggestedWords + mSuggestionCount));
             }
 
     const int mMaxSuggestionCount;
     float mLanguageWeight;
-    std::priority_queue<
-            SuggestedWord, std::vector<SuggestedWord>, SuggestedWord::Comparator> mSuggestedWords;
  private:
     DISALLOW_IMPLICIT_CONSTRUCTORS(SuggestionResults);
 
-    
+    // mSuggestedWords[0, mSuggestionCount) is a heap ordered by SuggestedWord::Comparator, i.e.
+    // the worst suggestion is at the front.
+    SuggestedWord mSuggestedWords[MAX_SUGGESTION_COUNT];
+    int mSuggestionCount;
+    bool mIsTruncated;
 };
 } // namespace latinime
 #endif // LATINIME_SUGGESTION_RESULTS_H
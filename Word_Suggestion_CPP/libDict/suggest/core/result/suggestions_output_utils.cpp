@@ -17,7 +17,6 @@
 #include "suggestions_output_utils.h"
 
 #include <algorithm>
-#include <vector>
 
 #include "../dicnode/dic_node.h"
 #include "../dicnode/dic_node_utils.h"
@@ -35,27 +34,26 @@ const int SuggestionsOutputUtils::MIN_LEN_FOR_MULTI_WORD_AUTOCORRECT = 16;
 /* static */ void SuggestionsOutputUtils::outputSuggestions(
         const Scoring *const scoringPolicy, DicTraverseSession *traverseSession,
         const float languageWeight, SuggestionResults *const outSuggestionResults) {
+    // The terminals are read in place from the terminal queue, best first.
+    const DicNode *terminals[MAX_RESULTS];
 #if DEBUG_EVALUATE_MOST_PROBABLE_STRING
     const int terminalSize = 0;
 #else
-    const int terminalSize = traverseSession->getDicTraverseCache()->terminalSize();
+    const int terminalSize = traverseSession->getDicTraverseCache()->sortAndGetTerminalDicNodes(
+            NELEMS(terminals), terminals);
 #endif
-    std::vector<DicNode> terminals(terminalSize);
-    for (int index = terminalSize - 1; index >= 0; --index) {
-        traverseSession->getDicTraverseCache()->popTerminal(&terminals[index]);
-    }
     // Compute a language weight when an invalid language weight is passed.
     // NOT_A_LANGUAGE_WEIGHT (-1) is assumed as an invalid language weight.
     const float languageWeightToOutputSuggestions = (languageWeight < 0.0f) ?
             scoringPolicy->getAdjustedLanguageWeight(
-                    traverseSession, terminals.data(), terminalSize) : languageWeight;
+                    traverseSession, terminals, terminalSize) : languageWeight;
     outSuggestionResults->setLanguageWeight(languageWeightToOutputSuggestions);
     // Force autocorrection for obvious long multi-word suggestions when the top suggestion is
     // a long multiple words suggestion.
     // TODO: Implement a smarter auto-commit method for handling multi-word suggestions.
     const bool forceCommitMultiWords = scoringPolicy->autoCorrectsToMultiWordSuggestionIfTop()
             && (traverseSession->getInputSize() >= MIN_LEN_FOR_MULTI_WORD_AUTOCORRECT
-                    && !terminals.empty() && terminals.front().hasMultipleWords());
+                    && terminalSize > 0 && terminals[0]->hasMultipleWords());
     // TODO: have partial commit work even with multiple pointers.
     const bool outputSecondWordFirstLetterInputIndex =
             traverseSession->isOnlyOnePointerUsed(0 /* pointerId */);
@@ -63,8 +61,8 @@ const int SuggestionsOutputUtils::MIN_LEN_FOR_MULTI_WORD_AUTOCORRECT = 16;
             getHeaderStructurePolicy()->shouldBoostExactMatches();
 
     // Output suggestion results here
-    for (auto &terminalDicNode : terminals) {
-        outputSuggestionsOfDicNode(scoringPolicy, traverseSession, &terminalDicNode,
+    for (int i = 0; i < terminalSize; ++i) {
+        outputSuggestionsOfDicNode(scoringPolicy, traverseSession, terminals[i],
                 languageWeightToOutputSuggestions, boostExactMatches, forceCommitMultiWords,
                 outputSecondWordFirstLetterInputIndex, outSuggestionResults);
     }
@@ -85,9 +83,10 @@ const int SuggestionsOutputUtils::MIN_LEN_FOR_MULTI_WORD_AUTOCORRECT = 16;
             scoringPolicy->getDoubleLetterDemotionDistanceCost(terminalDicNode);
     const float compoundDistance = terminalDicNode->getCompoundDistance(languageWeight)
             + doubleLetterCost;
-    const bool isPossiblyOffensiveWord =
-            traverseSession->getDictionaryStructurePolicy()->getProbability(
-                    terminalDicNode->getProbability(), NOT_A_PROBABILITY) <= 0;
+    const DictionaryStructureWithBufferPolicy *const dictionaryStructurePolicy =
+            traverseSession->getDictionaryStructurePolicy(terminalDicNode->getDictionaryIndex());
+    const bool isPossiblyOffensiveWord = dictionaryStructurePolicy->getProbability(
+            terminalDicNode->getProbability(), NOT_A_PROBABILITY) <= 0;
     const bool isExactMatch =
             ErrorTypeUtils::isExactMatch(terminalDicNode->getContainedErrorTypes());
     const bool isExactMatchWithIntentionalOmission =
@@ -140,9 +139,9 @@ const int SuggestionsOutputUtils::MIN_LEN_FOR_MULTI_WORD_AUTOCORRECT = 16;
     // TODO: Check shortcuts during traversal for multiple words suggestions.
     if (!terminalDicNode->hasMultipleWords()) {
         BinaryDictionaryShortcutIterator shortcutIt(
-                traverseSession->getDictionaryStructurePolicy()->getShortcutsStructurePolicy(),
-                traverseSession->getDictionaryStructurePolicy()
-                        ->getShortcutPositionOfPtNode(terminalDicNode->getPtNodePos()));
+                dictionaryStructurePolicy->getShortcutsStructurePolicy(),
+                dictionaryStructurePolicy->getShortcutPositionOfPtNode(
+                        terminalDicNode->getPtNodePos()));
         const bool sameAsTyped = scoringPolicy->sameAsTyped(traverseSession, terminalDicNode);
         outputShortcuts(&shortcutIt, finalScore, sameAsTyped, outSuggestionResults);
     }
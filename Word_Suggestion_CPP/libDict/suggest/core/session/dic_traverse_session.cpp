@@ -17,9 +17,13 @@
 
 
 #include "dic_traverse_session.h"
+
+#include <cstring>
+
 #include "../dictionary/dictionary.h"
 #include "../policy/dictionary_header_structure_policy.h"
 #include "../policy/dictionary_structure_with_buffer_policy.h"
+#include "../suggest_options.h"
 #include "prev_words_info.h"
 #include "dic_traverse_session.h"
 
@@ -29,36 +33,99 @@ namespace latinime {
 // (e.g. main dictionary) from small dictionaries (e.g. contacts...)
 const int DicTraverseSession::DICTIONARY_SIZE_THRESHOLD_TO_USE_LARGE_CACHE_FOR_SUGGESTION =
         256 * 1024;
+// A dicNode takes a few hundred nanoseconds to expand, so reading the clock every 8 of them
+// costs little and overshoots the deadline by a few microseconds at most.
+const int DicTraverseSession::SEARCH_DEADLINE_CHECK_INTERVAL = 8;
 
-void DicTraverseSession::init(const Dictionary *const dictionary,
+void DicTraverseSession::init(const DictionaryGroup *const dictionaryGroup,
         const PrevWordsInfo *const prevWordsInfo, const SuggestOptions *const suggestOptions) {
-    mDictionary = dictionary;
+    const bool isDictionaryChanged = !mDictionaryGroup.hasSameDictionaries(dictionaryGroup);
+    mDictionaryGroup = *dictionaryGroup;
+    bool isPrevWordsChanged = false;
+    for (int i = 0; i < mDictionaryGroup.getDictionaryCount(); ++i) {
+        mDictionaryStructurePolicies[i] =
+                mDictionaryGroup.getDictionary(i)->getDictionaryStructurePolicy();
+        mDigraphCodePoints[i] = mDictionaryGroup.getDictionary(i)->getDigraphCodePoints();
+        int prevWordsPtNodePos[MAX_PREV_WORD_COUNT_FOR_N_GRAM];
+        prevWordsInfo->getPrevWordsTerminalPtNodePos(mDictionaryStructurePolicies[i],
+                prevWordsPtNodePos, true /* tryLowerCaseSearch */);
+        isPrevWordsChanged |= memcmp(mPrevWordsPtNodePos[i], prevWordsPtNodePos,
+                sizeof(mPrevWordsPtNodePos[i])) != 0;
+        memmove(mPrevWordsPtNodePos[i], prevWordsPtNodePos, sizeof(mPrevWordsPtNodePos[i]));
+    }
     mMultiWordCostMultiplier = getDictionaryStructurePolicy()->getHeaderStructurePolicy()
             ->getMultiWordCostMultiplier();
     mSuggestOptions = suggestOptions;
-    prevWordsInfo->getPrevWordsTerminalPtNodePos(
-            getDictionaryStructurePolicy(), mPrevWordsPtNodePos, true /* tryLowerCaseSearch */);
+    // A beam trimmed by the adaptive beam lacks dicNodes the full search keeps, and the other
+    // way round.
+    const bool isBeamChanged = mUsesAdaptiveBeam != suggestOptions->useAdaptiveBeam();
+    mUsesAdaptiveBeam = suggestOptions->useAdaptiveBeam();
+    // Checkpointed dicNodes carry costs computed in the previous context. A pooled session may
+    // be handed a request for other dictionaries or another previous word, so the checkpoints
+    // cannot be used to continue the search in that case.
+    if (isDictionaryChanged || isPrevWordsChanged || isBeamChanged) {
+        mDicNodeCheckpoints.clear();
+    }
+}
+
+void DicTraverseSession::startSearchBudget(const QueryStats::Clock::time_point queryStartTime) {
+    const int searchDeadlineMicros = mSuggestOptions->getSearchDeadlineMicros();
+    mHasSearchDeadline = searchDeadlineMicros > 0;
+    mSearchDeadline = queryStartTime + std::chrono::microseconds(searchDeadlineMicros);
+    mNextSearchDeadlineCheckCount = 0;
+    mMaxExpandedDicNodeCount = mSuggestOptions->getMaxExpandedDicNodeCount();
 }
 
 void DicTraverseSession::setupForGetSuggestions(const ProximityInfo *pInfo,
         const int *inputCodePoints, const int inputSize, const int *const inputXs,
         const int *const inputYs, const int *const times, const int *const pointerIds,
         const float maxSpatialDistance, const int maxPointerCount) {
+    if (mProximityInfo != pInfo) {
+        mDicNodeCheckpoints.clear();
+    }
     mProximityInfo = pInfo;
     mMaxPointerCount = maxPointerCount;
     initializeProximityInfoStates(inputCodePoints, inputXs, inputYs, times, pointerIds, inputSize,
             maxSpatialDistance, maxPointerCount);
 }
 
-const DictionaryStructureWithBufferPolicy *DicTraverseSession::getDictionaryStructurePolicy()
-        const {
-    return mDictionary->getDictionaryStructurePolicy();
-}
-
 void DicTraverseSession::resetCache(const int thresholdForNextActiveDicNodes, const int maxWords) {
     mDicNodesCache.reset(thresholdForNextActiveDicNodes /* nextActiveSize */,
             maxWords /* terminalSize */);
-    mMultiBigramMap.clear();
+    mDicNodeOutputArena.clear();
+    // The checkpoints refer to the outputs just cleared.
+    mDicNodeCheckpoints.clear();
+    for (int i = 0; i < DictionaryGroup::MAX_DICTIONARY_COUNT; ++i) {
+        mMultiBigramMaps[i].clear();
+    }
+    mResumedExpandedDicNodeCount = 0;
+}
+
+bool DicTraverseSession::continueSearchFromCheckpoint() {
+    const DicNodeCheckpoints::Checkpoint *const checkpoint =
+            mDicNodeCheckpoints.resume(getMatchingInputSize(), mInputSize, mResumesExactlyOnly);
+    if (!checkpoint) {
+        return false;
+    }
+    // The outputs appended after the checkpoint belong to the steps done again.
+    mDicNodeOutputArena.truncate(checkpoint->getOutputEntryCount());
+    // The terminal costs depend on the input size, so the terminals of the earlier steps only
+    // carry over to an input of the same size.
+    const bool isExactResume = checkpoint->getInputSize() == mInputSize;
+    mDicNodesCache.continueSearch(checkpoint->getInputIndex(), checkpoint->getStepOrdinal(),
+            checkpoint->getDicNodes(),
+            isExactResume ? checkpoint->getTerminalDicNodes() : nullptr);
+    mResumedExpandedDicNodeCount = isExactResume ? checkpoint->getExpandedDicNodeCount() : 0;
+    return true;
+}
+
+void DicTraverseSession::setExpansionThreadCount(const int threadCount) {
+    if (threadCount == getExpansionThreadCount()) {
+        return;
+    }
+    mExpansionWorkers.reset(threadCount > 1
+            ? new ExpansionWorkers(threadCount, mDicNodesCache.usesLargeCapacityCache())
+            : nullptr);
 }
 
 void DicTraverseSession::initializeProximityInfoStates(const int *const inputCodePoints,
@@ -17,18 +17,26 @@
 #ifndef LATINIME_DIC_TRAVERSE_SESSION_H
 #define LATINIME_DIC_TRAVERSE_SESSION_H
 
+#include <algorithm>
+#include <memory>
 #include <vector>
 #include "../../../defines.h"
 
 // #include "jni.h"
+#include "../dicnode/dic_node_checkpoints.h"
 #include "../dicnode/dic_nodes_cache.h"
+#include "../dicnode/internal/dic_node_output_arena.h"
+#include "../dictionary/dictionary_group.h"
 #include "../dictionary/multi_bigram_map.h"
 #include "../layout/proximity_info_state.h"
+#include "expansion_scratch.h"
+#include "expansion_workers.h"
+#include "query_stats.h"
 
 namespace latinime {
 
-class Dictionary;
 class DictionaryStructureWithBufferPolicy;
+class DigraphCodePoints;
 class PrevWordsInfo;
 class ProximityInfo;
 class SuggestOptions;
@@ -48,38 +56,156 @@ class DicTraverseSession {
     }
 
     AK_FORCE_INLINE DicTraverseSession(bool usesLargeCache)
-            : mProximityInfo(nullptr), mDictionary(nullptr), mSuggestOptions(nullptr),
-              mDicNodesCache(usesLargeCache), mMultiBigramMap(), mInputSize(0), mMaxPointerCount(1),
-              mMultiWordCostMultiplier(1.0f) {
+            : mProximityInfo(nullptr), mDictionaryGroup(), mDictionaryStructurePolicies(),
+              mDigraphCodePoints(), mSuggestOptions(nullptr), mUsesAdaptiveBeam(false),
+              mQueryStats(),
+              mDicNodesCache(usesLargeCache, &mQueryStats), mDicNodeOutputArena(),
+              mDicNodeCheckpoints(DicNodeCheckpoints::DEFAULT_MAX_COUNT), mMultiBigramMaps(),
+              mExpansionScratch(), mExpansionWorkers(), mHasSearchDeadline(false), mSearchDeadline(),
+              mNextSearchDeadlineCheckCount(0), mMaxExpandedDicNodeCount(0),
+              mResumedExpandedDicNodeCount(0), mResumesExactlyOnly(false), mInputSize(0),
+              mMaxPointerCount(1), mMultiWordCostMultiplier(1.0f) {
         // NOTE: mProximityInfoStates is an array of instances.
         // No need to initialize it explicitly here.
-        for (size_t i = 0; i < NELEMS(mPrevWordsPtNodePos); ++i) {
-            mPrevWordsPtNodePos[i] = NOT_A_DICT_POS;
+        for (int i = 0; i < DictionaryGroup::MAX_DICTIONARY_COUNT; ++i) {
+            for (size_t j = 0; j < NELEMS(mPrevWordsPtNodePos[i]); ++j) {
+                mPrevWordsPtNodePos[i][j] = NOT_A_DICT_POS;
+            }
         }
     }
 
     // Non virtual inline destructor -- never inherit this class
     AK_FORCE_INLINE ~DicTraverseSession() {}
 
-    void init(const Dictionary *dictionary, const PrevWordsInfo *const prevWordsInfo,
-            const SuggestOptions *const suggestOptions);
+    // Sets the session up for a search of the dictionaries of dictionaryGroup, which is copied.
+    void init(const DictionaryGroup *const dictionaryGroup,
+            const PrevWordsInfo *const prevWordsInfo, const SuggestOptions *const suggestOptions);
     // TODO: Remove and merge into init
     void setupForGetSuggestions(const ProximityInfo *pInfo, const int *inputCodePoints,
             const int inputSize, const int *const inputXs, const int *const inputYs,
             const int *const times, const int *const pointerIds, const float maxSpatialDistance,
             const int maxPointerCount);
     void resetCache(const int thresholdForNextActiveDicNodes, const int maxWords);
+    // Restarts the search at the last checkpoint that the current input can resume from, and
+    // returns false, leaving the search as it was, when there is none.
+    bool continueSearchFromCheckpoint();
+    // DicNodes the search has expanded since the root, including those of the steps a resumed
+    // search skipped when it is exact; see DicNodeCheckpoints.
+    int getExpandedDicNodeCountFromRoot() const {
+        return mResumedExpandedDicNodeCount + mQueryStats.expandedDicNodeCount;
+    }
 
-    const DictionaryStructureWithBufferPolicy *getDictionaryStructurePolicy() const;
+    // Sets the search budget of a query started at queryStartTime from the suggest options
+    // given to init().
+    void startSearchBudget(const QueryStats::Clock::time_point queryStartTime);
+
+    // Returns whether the search has used up the deadline or the dicNode limit of its suggest
+    // options, and then marks the query as truncated. Cheap enough to call before every dicNode
+    // expansion: the clock is only read every SEARCH_DEADLINE_CHECK_INTERVAL expanded dicNodes.
+    AK_FORCE_INLINE bool isSearchBudgetExhausted() {
+        if (mQueryStats.isTruncatedSearch) {
+            return true;
+        }
+        const int expandedDicNodeCount = getExpandedDicNodeCountFromRoot();
+        if (mMaxExpandedDicNodeCount > 0 && expandedDicNodeCount >= mMaxExpandedDicNodeCount) {
+            mQueryStats.isTruncatedSearch = true;
+        } else if (mHasSearchDeadline
+                && expandedDicNodeCount >= mNextSearchDeadlineCheckCount) {
+            mNextSearchDeadlineCheckCount =
+                    expandedDicNodeCount + SEARCH_DEADLINE_CHECK_INTERVAL;
+            mQueryStats.isTruncatedSearch = QueryStats::Clock::now() >= mSearchDeadline;
+        }
+        return mQueryStats.isTruncatedSearch;
+    }
+
+    // Number of threads expanding the dicNodes of each search step, including the one calling
+    // getSuggestions(). 1, the default, expands them on the calling thread only; any number
+    // gives the same suggestions. The other threads stay with the session until it is deleted
+    // or the count is set back to 1.
+    void setExpansionThreadCount(const int threadCount);
+    int getExpansionThreadCount() const {
+        return mExpansionWorkers ? mExpansionWorkers->getThreadCount() : 1;
+    }
+    // Null when the dicNodes are expanded on the calling thread only.
+    ExpansionWorkers *getExpansionWorkers() { return mExpansionWorkers.get(); }
+    // Scratch dicNodes of the expansions run on the calling thread.
+    ExpansionScratch *getExpansionScratch() { return &mExpansionScratch; }
+
+    // Number of search steps whose beams are kept for the next query to resume from; see
+    // DicNodeCheckpoints. Each takes up to a beam of dicNodes. 1 only keeps the step that an
+    // appended code point resumes from, 0 restarts every search at the root.
+    void setMaxCheckpointCount(const int maxCheckpointCount) {
+        if (maxCheckpointCount != mDicNodeCheckpoints.getMaxCount()) {
+            mDicNodeCheckpoints.setMaxCount(maxCheckpointCount);
+        }
+    }
+    int getMaxCheckpointCount() const { return mDicNodeCheckpoints.getMaxCount(); }
+    // Drops the checkpoints so that the next search restarts at the root.
+    void discardCheckpoints() { mDicNodeCheckpoints.clear(); }
+    // Whether a search only resumes from a checkpoint taken on an input of the same size, and
+    // then gives the suggestions of a search from the root. False, the default, also resumes
+    // after an appended or deleted code point, which some terminals of the skipped steps may
+    // then be missing from.
+    void setResumesExactlyOnly(const bool resumesExactlyOnly) {
+        mResumesExactlyOnly = resumesExactlyOnly;
+    }
+    bool resumesExactlyOnly() const { return mResumesExactlyOnly; }
+
+    // The policy of the main dictionary, whose header decides the settings of the search.
+    const DictionaryStructureWithBufferPolicy *getDictionaryStructurePolicy() const {
+        return mDictionaryStructurePolicies[0];
+    }
+    // The policy of the dictionary the dicNodes of dictionaryIndex walk; see
+    // DicNode::getDictionaryIndex().
+    const DictionaryStructureWithBufferPolicy *getDictionaryStructurePolicy(
+            const int dictionaryIndex) const {
+        return mDictionaryStructurePolicies[dictionaryIndex];
+    }
+    // The code points with digraphs in the dictionary of dictionaryIndex.
+    const DigraphCodePoints *getDigraphCodePoints(const int dictionaryIndex) const {
+        return mDigraphCodePoints[dictionaryIndex];
+    }
+    const DictionaryGroup *getDictionaryGroup() const { return &mDictionaryGroup; }
+    // Multiplies the language cost of the words of the dictionary of dictionaryIndex.
+    float getLanguageWeight(const int dictionaryIndex) const {
+        return mDictionaryGroup.getLanguageWeight(dictionaryIndex);
+    }
 
     //--------------------
     // getters and setters
     //--------------------
     const ProximityInfo *getProximityInfo() const { return mProximityInfo; }
     const SuggestOptions *getSuggestOptions() const { return mSuggestOptions; }
-    const int *getPrevWordsPtNodePos() const { return mPrevWordsPtNodePos; }
+    // Positions of the previous words in the dictionary of dictionaryIndex.
+    const int *getPrevWordsPtNodePos(const int dictionaryIndex) const {
+        return mPrevWordsPtNodePos[dictionaryIndex];
+    }
     DicNodesCache *getDicTraverseCache() { return &mDicNodesCache; }
-    MultiBigramMap *getMultiBigramMap() { return &mMultiBigramMap; }
+    const DicNodesCache *getDicTraverseCache() const { return &mDicNodesCache; }
+    // Output code points of the dicNodes in the cache and in the checkpoints.
+    DicNodeOutputArena *getDicNodeOutputArena() { return &mDicNodeOutputArena; }
+    DicNodeCheckpoints *getDicNodeCheckpoints() { return &mDicNodeCheckpoints; }
+    // Stats of the query running or last run on this session.
+    QueryStats *getQueryStats() { return &mQueryStats; }
+    const QueryStats *getQueryStats() const { return &mQueryStats; }
+
+    // Approximate number of bytes held by the session. The dicNode pools, the checkpoints and
+    // the output arenas, including those of the expansion threads, account for nearly all of
+    // it; the growing buffers of the proximity info states are not counted.
+    size_t getMemorySize() const {
+        size_t memorySize = sizeof(DicTraverseSession) + mDicNodesCache.getMemorySize()
+                + mDicNodeOutputArena.getMemorySize() + mDicNodeCheckpoints.getMemorySize()
+                + mExpansionScratch.getMemorySize()
+                + (mExpansionWorkers ? mExpansionWorkers->getMemorySize() : 0);
+        for (int i = 0; i < DictionaryGroup::MAX_DICTIONARY_COUNT; ++i) {
+            memorySize += mMultiBigramMaps[i].getMemorySize();
+        }
+        return memorySize;
+    }
+    // Bigrams of the dictionary of dictionaryIndex, whose PtNode positions key them.
+    MultiBigramMap *getMultiBigramMap(const int dictionaryIndex) {
+        return &mMultiBigramMaps[dictionaryIndex];
+    }
     const ProximityInfoState *getProximityInfoState(int id) const {
         return &mProximityInfoStates[id];
     }
@@ -123,28 +249,30 @@ class DicTraverseSession {
         return proximityType;
     }
 
+    // Whether the beam of the current step is to be checkpointed: the step is far enough from
+    // the end of the input for a later input to share all the points it depends on, and past
+    // the last checkpoint.
     AK_FORCE_INLINE bool isCacheBorderForTyping(const int inputSize) const {
-        return mDicNodesCache.isCacheBorderForTyping(inputSize);
+        const int inputIndex = mDicNodesCache.getInputIndex();
+        return inputIndex + DicNodeCheckpoints::CACHE_BACK_LENGTH <= inputSize
+                && inputIndex > mDicNodeCheckpoints.getLastInputIndex();
     }
 
     /**
-     * Returns whether or not it is possible to continue suggestion from the previous search.
+     * Returns the number of leading input points the current input shares with the one of the
+     * previous search, over all the pointers in use.
      */
-    // TODO: Remove. No need to check once the session is fully implemented.
-    bool isContinuousSuggestionPossible() const {
-        if (!mDicNodesCache.hasCachedDicNodesForContinuousSuggestion()) {
-            return false;
-        }
+    int getMatchingInputSize() const {
         ASSERT(mMaxPointerCount <= MAX_POINTER_COUNT_G);
+        int matchingInputSize = mInputSize;
         for (int i = 0; i < mMaxPointerCount; ++i) {
             const ProximityInfoState *const pInfoState = getProximityInfoState(i);
-            // If a proximity info state is not continuous suggestion possible,
-            // do not continue searching.
-            if (pInfoState->isUsed() && !pInfoState->isContinuousSuggestionPossible()) {
-                return false;
+            if (pInfoState->isUsed()) {
+                matchingInputSize =
+                        std::min(matchingInputSize, pInfoState->getMatchingSampledInputSize());
             }
         }
-        return true;
+        return matchingInputSize;
     }
 
     bool isTouchPositionCorrectionEnabled() const {
@@ -160,18 +288,40 @@ class DicTraverseSession {
     // threshold to start caching
     static const int CACHE_START_INPUT_LENGTH_THRESHOLD;
     static const int DICTIONARY_SIZE_THRESHOLD_TO_USE_LARGE_CACHE_FOR_SUGGESTION;
+    static const int SEARCH_DEADLINE_CHECK_INTERVAL;
     void initializeProximityInfoStates(const int *const inputCodePoints, const int *const inputXs,
             const int *const inputYs, const int *const times, const int *const pointerIds,
             const int inputSize, const float maxSpatialDistance, const int maxPointerCount);
 
-    int mPrevWordsPtNodePos[MAX_PREV_WORD_COUNT_FOR_N_GRAM];
+    int mPrevWordsPtNodePos[DictionaryGroup::MAX_DICTIONARY_COUNT]
+            [MAX_PREV_WORD_COUNT_FOR_N_GRAM];
     const ProximityInfo *mProximityInfo;
-    const Dictionary *mDictionary;
+    DictionaryGroup mDictionaryGroup;
+    const DictionaryStructureWithBufferPolicy *mDictionaryStructurePolicies[
+            DictionaryGroup::MAX_DICTIONARY_COUNT];
+    const DigraphCodePoints *mDigraphCodePoints[DictionaryGroup::MAX_DICTIONARY_COUNT];
     const SuggestOptions *mSuggestOptions;
+    // SuggestOptions::useAdaptiveBeam() of the search the checkpoints come from.
+    bool mUsesAdaptiveBeam;
 
+    QueryStats mQueryStats;
     DicNodesCache mDicNodesCache;
-    // Temporary cache for bigram frequencies
-    MultiBigramMap mMultiBigramMap;
+    // Kept across continued searches, since the dicNodes of the checkpoints refer to it.
+    DicNodeOutputArena mDicNodeOutputArena;
+    DicNodeCheckpoints mDicNodeCheckpoints;
+    // Temporary cache for bigram frequencies, by dictionary
+    MultiBigramMap mMultiBigramMaps[DictionaryGroup::MAX_DICTIONARY_COUNT];
+    ExpansionScratch mExpansionScratch;
+    std::unique_ptr<ExpansionWorkers> mExpansionWorkers;
+    // Search budget of the current query, see isSearchBudgetExhausted().
+    bool mHasSearchDeadline;
+    QueryStats::Clock::time_point mSearchDeadline;
+    int mNextSearchDeadlineCheckCount;
+    int mMaxExpandedDicNodeCount;
+    // DicNodes expanded before the checkpoint an exact resume restarted at, counted against
+    // mMaxExpandedDicNodeCount as a search from the root would have.
+    int mResumedExpandedDicNodeCount;
+    bool mResumesExactlyOnly;
     ProximityInfoState mProximityInfoStates[MAX_POINTER_COUNT_G];
 
     int mInputSize;
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "dic_traverse_session_pool.h"
+
+#include "dic_traverse_session.h"
+
+namespace latinime {
+
+DicTraverseSessionPool::DicTraverseSessionPool(const long dictSize, const int maxSessionCount)
+        : mDictSize(dictSize), mMaxSessionCount(maxSessionCount), mMutex(),
+          mSessionReleasedCondition(), mAllSessions(), mIdleSessions() {}
+
+DicTraverseSessionPool::~DicTraverseSessionPool() {
+    for (DicTraverseSession *const session : mAllSessions) {
+        DicTraverseSession::releaseSessionInstance(session);
+    }
+}
+
+DicTraverseSession *DicTraverseSessionPool::acquireSession() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (mIdleSessions.empty()) {
+        if (mMaxSessionCount <= 0 || static_cast<int>(mAllSessions.size()) < mMaxSessionCount) {
+            DicTraverseSession *const session = static_cast<DicTraverseSession *>(
+                    DicTraverseSession::getSessionInstance(mDictSize));
+            mAllSessions.push_back(session);
+            return session;
+        }
+        mSessionReleasedCondition.wait(lock);
+    }
+    // Hand out the most recently returned session; its node pools are the most likely to still
+    // be in cache.
+    DicTraverseSession *const session = mIdleSessions.back();
+    mIdleSessions.pop_back();
+    return session;
+}
+
+void DicTraverseSessionPool::releaseSession(DicTraverseSession *const session) {
+    if (!session) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mIdleSessions.push_back(session);
+    }
+    mSessionReleasedCondition.notify_one();
+}
+
+int DicTraverseSessionPool::getSessionCount() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return static_cast<int>(mAllSessions.size());
+}
+
+int DicTraverseSessionPool::getIdleSessionCount() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return static_cast<int>(mIdleSessions.size());
+}
+
+} // namespace latinime
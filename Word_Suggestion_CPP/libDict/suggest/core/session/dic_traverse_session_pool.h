@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_DIC_TRAVERSE_SESSION_POOL_H
+#define LATINIME_DIC_TRAVERSE_SESSION_POOL_H
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "../../../defines.h"
+
+namespace latinime {
+
+class DicTraverseSession;
+
+/**
+ * Pool of DicTraverseSession instances sharing one dictionary. A session holds all the mutable
+ * search state of a query, so concurrent queries against the same Dictionary only need to check
+ * out distinct sessions. Sessions are created lazily; when maxSessionCount is reached,
+ * acquireSession() blocks until another thread returns a session.
+ */
+class DicTraverseSessionPool {
+ public:
+    // Checks a session out on construction and returns it to the pool on destruction.
+    class ScopedSession {
+     public:
+        explicit ScopedSession(DicTraverseSessionPool *const pool)
+                : mPool(pool), mSession(pool->acquireSession()) {}
+        ~ScopedSession() { mPool->releaseSession(mSession); }
+
+        DicTraverseSession *get() const { return mSession; }
+
+     private:
+        DISALLOW_IMPLICIT_CONSTRUCTORS(ScopedSession);
+
+        DicTraverseSessionPool *const mPool;
+        DicTraverseSession *const mSession;
+    };
+
+    // maxSessionCount <= 0 means the pool grows without bound.
+    DicTraverseSessionPool(const long dictSize, const int maxSessionCount);
+    ~DicTraverseSessionPool();
+
+    DicTraverseSession *acquireSession();
+    void releaseSession(DicTraverseSession *const session);
+
+    int getSessionCount() const;
+    int getIdleSessionCount() const;
+
+ private:
+    DISALLOW_IMPLICIT_CONSTRUCTORS(DicTraverseSessionPool);
+
+    const long mDictSize;
+    const int mMaxSessionCount;
+    mutable std::mutex mMutex;
+    std::condition_variable mSessionReleasedCondition;
+    std::vector<DicTraverseSession *> mAllSessions;
+    std::vector<DicTraverseSession *> mIdleSessions;
+};
+} // namespace latinime
+#endif // LATINIME_DIC_TRAVERSE_SESSION_POOL_H
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_EXPANSION_SCRATCH_H
+#define LATINIME_EXPANSION_SCRATCH_H
+
+#include <cstddef>
+
+#include "../../../defines.h"
+#include "../dicnode/dic_node.h"
+#include "../dicnode/dic_node_vector.h"
+
+namespace latinime {
+
+/**
+ * Scratch dicNodes of the expansion of one dicNode; see Suggest::expandDicNode(). Each
+ * expansion clears the vectors it uses before filling them, so they keep their capacity across
+ * the expansions and queries of the session or thread that owns them and only allocate while
+ * growing to the largest PtNode array met.
+ */
+class ExpansionScratch {
+ public:
+    ExpansionScratch()
+            : mChildDicNodes(), mCorrectionChildDicNodes(), mTranspositionChildDicNodes(),
+              mCorrectionDicNode() {}
+
+    // Children of the expanded dicNode.
+    DicNodeVector *getChildDicNodes() { return &mChildDicNodes; }
+    // Children of the omission, insertion or transposition being tried for the expanded
+    // dicNode, and the children of the first of those for a transposition.
+    DicNodeVector *getCorrectionChildDicNodes() { return &mCorrectionChildDicNodes; }
+    DicNodeVector *getTranspositionChildDicNodes() { return &mTranspositionChildDicNodes; }
+    // Copy of a child for the omission or digraph tried from it.
+    DicNode *getCorrectionDicNode() { return &mCorrectionDicNode; }
+
+    size_t getMemorySize() const {
+        return mChildDicNodes.getMemorySize() + mCorrectionChildDicNodes.getMemorySize()
+                + mTranspositionChildDicNodes.getMemorySize();
+    }
+
+ private:
+    DISALLOW_COPY_AND_ASSIGN(ExpansionScratch);
+
+    DicNodeVector mChildDicNodes;
+    DicNodeVector mCorrectionChildDicNodes;
+    DicNodeVector mTranspositionChildDicNodes;
+    DicNode mCorrectionDicNode;
+};
+} // namespace latinime
+#endif // LATINIME_EXPANSION_SCRATCH_H
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_EXPANSION_WORKERS_H
+#define LATINIME_EXPANSION_WORKERS_H
+
+#include <memory>
+#include <vector>
+
+#include "../../../defines.h"
+#include "../../../utils/work_stealing_pool.h"
+#include "../dicnode/dic_node.h"
+#include "../dicnode/dic_nodes_cache.h"
+#include "../dicnode/internal/dic_node_output_arena.h"
+#include "expansion_scratch.h"
+#include "query_stats.h"
+
+namespace latinime {
+
+/**
+ * Threads expanding the dicNodes of a search step together, and the state each of them expands
+ * dicNodes into. See Suggest::expandCurrentDicNodesInParallel().
+ */
+class ExpansionWorkers {
+ public:
+    // What one thread expands dicNodes into: queues bounded as the ones of the session, an
+    // arena extending the output arena of the session, and the counters of its pushes.
+    class Worker {
+     public:
+        explicit Worker(const bool usesLargeCapacityCache)
+                : mQueryStats(), mDicNodesCache(usesLargeCapacityCache, &mQueryStats),
+                  mDicNodeOutputArena(), mExpansionScratch() {}
+
+        QueryStats *getQueryStats() { return &mQueryStats; }
+        DicNodesCache *getDicNodesCache() { return &mDicNodesCache; }
+        DicNodeOutputArena *getDicNodeOutputArena() { return &mDicNodeOutputArena; }
+        ExpansionScratch *getExpansionScratch() { return &mExpansionScratch; }
+
+        size_t getMemorySize() const {
+            return sizeof(Worker) + mDicNodesCache.getMemorySize()
+                    + mDicNodeOutputArena.getMemorySize() + mExpansionScratch.getMemorySize();
+        }
+
+     private:
+        DISALLOW_IMPLICIT_CONSTRUCTORS(Worker);
+
+        QueryStats mQueryStats;
+        DicNodesCache mDicNodesCache;
+        DicNodeOutputArena mDicNodeOutputArena;
+        ExpansionScratch mExpansionScratch;
+    };
+
+    ExpansionWorkers(const int threadCount, const bool usesLargeCapacityCache)
+            : mThreadPool(threadCount), mWorkers(), mDicNodes(), mExpansionOrdinals() {
+        for (int i = 0; i < mThreadPool.getThreadCount(); ++i) {
+            mWorkers.emplace_back(new Worker(usesLargeCapacityCache));
+        }
+    }
+
+    int getThreadCount() const { return mThreadPool.getThreadCount(); }
+    WorkStealingPool *getThreadPool() { return &mThreadPool; }
+    Worker *getWorker(const int threadIndex) { return mWorkers[threadIndex].get(); }
+    // The dicNodes of the step being expanded, in the order they were popped, and the
+    // expansion ordinal each was popped with; see DicNodesCache::getExpansionOrdinal().
+    std::vector<DicNode> *getDicNodes() { return &mDicNodes; }
+    std::vector<int> *getExpansionOrdinals() { return &mExpansionOrdinals; }
+
+    size_t getMemorySize() const {
+        size_t memorySize = sizeof(ExpansionWorkers) + mDicNodes.capacity() * sizeof(DicNode)
+                + mExpansionOrdinals.capacity() * sizeof(int);
+        for (const std::unique_ptr<Worker> &worker : mWorkers) {
+            memorySize += worker->getMemorySize();
+        }
+        return memorySize;
+    }
+
+ private:
+    DISALLOW_IMPLICIT_CONSTRUCTORS(ExpansionWorkers);
+
+    WorkStealingPool mThreadPool;
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+    std::vector<DicNode> mDicNodes;
+    std::vector<int> mExpansionOrdinals;
+};
+} // namespace latinime
+#endif // LATINIME_EXPANSION_WORKERS_H
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_QUERY_STATS_H
+#define LATINIME_QUERY_STATS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+#include "../../../defines.h"
+
+namespace latinime {
+
+/**
+ * Stage timings and search counters of the last query run on a DicTraverseSession. They are
+ * always collected; the cost is a few clock reads per expansion step and some counter
+ * increments, which is negligible next to the search itself. Durations are read from a
+ * monotonic clock and are in nanoseconds.
+ */
+struct QueryStats {
+    typedef std::chrono::steady_clock Clock;
+
+    // Steps past this many are added to the last entry of expansionStepNanos.
+    static const int MAX_EXPANSION_STEP_COUNT = MAX_WORD_LENGTH;
+
+    QueryStats() {
+        reset();
+    }
+
+    void reset() {
+        sessionInitNanos = 0;
+        proximitySetupNanos = 0;
+        initializeSearchNanos = 0;
+        expansionNanos = 0;
+        outputSuggestionsNanos = 0;
+        totalNanos = 0;
+        expansionStepCount = 0;
+        expandedDicNodeCount = 0;
+        pushedDicNodeCount = 0;
+        evictedDicNodeCount = 0;
+        terminalDicNodeCount = 0;
+        beamSizeSum = 0;
+        trimmedDicNodeCount = 0;
+        isContinuedSearch = false;
+        isTruncatedSearch = false;
+    }
+
+    void addExpansionStep(const int64_t nanos) {
+        const int index = std::min(expansionStepCount, MAX_EXPANSION_STEP_COUNT - 1);
+        expansionStepNanos[index] = (index < expansionStepCount ? expansionStepNanos[index] : 0)
+                + nanos;
+        expansionStepCount++;
+        expansionNanos += nanos;
+    }
+
+    // Adds the dicNode counters of stats, kept apart by a thread of a parallel expansion step.
+    void addDicNodeCounts(const QueryStats &stats) {
+        expandedDicNodeCount += stats.expandedDicNodeCount;
+        pushedDicNodeCount += stats.pushedDicNodeCount;
+        evictedDicNodeCount += stats.evictedDicNodeCount;
+        terminalDicNodeCount += stats.terminalDicNodeCount;
+    }
+
+    static AK_FORCE_INLINE int64_t getElapsedNanos(const Clock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start)
+                .count();
+    }
+
+    // DicTraverseSession::init(): previous word lookup.
+    int64_t sessionInitNanos;
+    // DicTraverseSession::setupForGetSuggestions(): proximity info states of the input.
+    int64_t proximitySetupNanos;
+    // Suggest::initializeSearch(): restoring a checkpoint or starting at the root.
+    int64_t initializeSearchNanos;
+    // Sum of all expansion steps.
+    int64_t expansionNanos;
+    // SuggestionsOutputUtils::outputSuggestions(): scoring the terminals.
+    int64_t outputSuggestionsNanos;
+    // From the start of session init to the end of outputSuggestions.
+    int64_t totalNanos;
+    // Number of Suggest::expandCurrentDicNodes() calls; the first
+    // min(expansionStepCount, MAX_EXPANSION_STEP_COUNT) entries of expansionStepNanos are set.
+    int expansionStepCount;
+    int64_t expansionStepNanos[MAX_EXPANSION_STEP_COUNT];
+    // DicNodes taken off the active queue and expanded.
+    int expandedDicNodeCount;
+    // DicNodes offered to the active and next active queues.
+    int pushedDicNodeCount;
+    // DicNodes dropped because a queue was full: either the offered one or the worst queued one.
+    int evictedDicNodeCount;
+    // Terminal dicNodes offered to the terminal queue.
+    int terminalDicNodeCount;
+    // Sum over the expansion steps of the number of active dicNodes the step kept, as chosen
+    // by Traversal::getActiveDicNodeLimit(); divided by expansionStepCount, the mean beam size.
+    int beamSizeSum;
+    // Active dicNodes dropped at the start of a step instead of being expanded.
+    int trimmedDicNodeCount;
+    // Whether the search continued from a checkpoint of an earlier query; see
+    // DicNodeCheckpoints.
+    bool isContinuedSearch;
+    // Whether the search stopped at the deadline or dicNode limit of the suggest options before
+    // it was done; the suggestions are then the best of the terminals found until then.
+    bool isTruncatedSearch;
+};
+} // namespace latinime
+#endif // LATINIME_QUERY_STATS_H
@@ -15,87 +15,131 @@
  */
 
 #include "suggest.h"
+
+#include <algorithm>
+#include <vector>
+
 #include "dicnode/dic_node.h"
 #include "dicnode/dic_node_priority_queue.h"
 #include "dicnode/dic_node_vector.h"
 #include "dictionary/dictionary.h"
-#include "dictionary/digraph_utils.h"
+#include "dictionary/digraph_code_points.h"
 #include "layout/proximity_info.h"
 #include "policy/dictionary_structure_with_buffer_policy.h"
+#include "policy/scoring.h"
 #include "policy/traversal.h"
 #include "policy/weighting.h"
+#include "result/suggestion_results.h"
 #include "result/suggestions_output_utils.h"
 #include "session/dic_traverse_session.h"
+#include "session/expansion_scratch.h"
+#include "session/expansion_workers.h"
+#include "../policyimpl/typing/typing_scoring.h"
+#include "../policyimpl/typing/typing_traversal.h"
+#include "../policyimpl/typing/typing_weighting.h"
+#include "../../utils/time_keeper.h"
 
 namespace latinime {
 
+// Definition of a constant initialized in its class, which std::min takes by reference.
+const int Traversal::MAX_PROXIMITY_TYPE_BATCH_SIZE;
+
 // Initialization of class constants.
-const int Suggest::MIN_CONTINUOUS_SUGGESTION_INPUT_SIZE = 2;
+template<class TraversalPolicy, class WeightingPolicy, class ScoringPolicy, int MaxPointerCount>
+const int Suggest<TraversalPolicy, WeightingPolicy, ScoringPolicy, MaxPointerCount>::
+        MIN_CONTINUOUS_SUGGESTION_INPUT_SIZE = 2;
+// Fewer dicNodes are expanded on the calling thread only, as the work would not make up for
+// waking up the other threads.
+template<class TraversalPolicy, class WeightingPolicy, class ScoringPolicy, int MaxPointerCount>
+const int Suggest<TraversalPolicy, WeightingPolicy, ScoringPolicy, MaxPointerCount>::
+        MIN_DIC_NODE_COUNT_FOR_PARALLEL_EXPANSION = 16;
 
 /**
  * Returns a set of suggestions for the given input touch points. The commitPoint argument indicates
  * whether to prematurely commit the suggested words up to the given point for sentence-level
  * suggestion.
  *
- * Note: Currently does not support concurrent calls across threads. Continuous suggestion is
- * automatically activated for sequential calls that share the same starting input.
+ * Note: Concurrent calls are supported as long as each thread uses its own traverseSession (see
+ * DicTraverseSessionPool). Continuous suggestion is automatically activated for sequential calls
+ * on the same session that share the same starting input: the search resumes from the beam of
+ * the last step that the shared input points fully determine (see DicNodeCheckpoints), whether
+ * the input was extended, shortened or changed past them.
  * TODO: Stop detecting continuous suggestion. Start using traverseSession instead.
  */
-void Suggest::getSuggestions(ProximityInfo *pInfo, void *traverseSession,
-        int *inputXs, int *inputYs, int *times, int *pointerIds, int *inputCodePoints,
-        int inputSize, const float languageWeight,
+template<class TraversalPolicy, class WeightingPolicy, class ScoringPolicy, int MaxPointerCount>
+void Suggest<TraversalPolicy, WeightingPolicy, ScoringPolicy, MaxPointerCount>::getSuggestions(
+        ProximityInfo *pInfo, void *traverseSession, int *inputXs, int *inputYs, int *times,
+        int *pointerIds, int *inputCodePoints, int inputSize, const float languageWeight,
         SuggestionResults *const outSuggestionResults) const {
-    PROF_OPEN;
-    PROF_START(0);
-    
-    printf("%p, %p, %p", TRAVERSAL, WEIGHTING, SCORING);
-    
     const float maxSpatialDistance = TRAVERSAL->getMaxSpatialDistance();
     DicTraverseSession *tSession = static_cast<DicTraverseSession *>(traverseSession);
+    QueryStats *const queryStats = tSession->getQueryStats();
+    QueryStats::Clock::time_point stageStartTime = QueryStats::Clock::now();
     tSession->setupForGetSuggestions(pInfo, inputCodePoints, inputSize, inputXs, inputYs, times,
-            pointerIds, maxSpatialDistance, TRAVERSAL->getMaxPointerCount());
+            pointerIds, maxSpatialDistance,
+            std::min(TRAVERSAL->getMaxPointerCount(), MaxPointerCount));
+    queryStats->proximitySetupNanos = QueryStats::getElapsedNanos(stageStartTime);
     // TODO: Add the way to evaluate cache
 
+    stageStartTime = QueryStats::Clock::now();
     initializeSearch(tSession);
-    PROF_END(0);
-    PROF_START(1);
+    queryStats->initializeSearchNanos = QueryStats::getElapsedNanos(stageStartTime);
 
-    // keep expanding search dicNodes until all have terminated.
-    while (tSession->getDicTraverseCache()->activeSize() > 0) {
+    // keep expanding search dicNodes until all have terminated or the search budget is used up.
+    while (tSession->getDicTraverseCache()->activeSize() > 0
+            && !tSession->isSearchBudgetExhausted()) {
+        stageStartTime = QueryStats::Clock::now();
+        tSession->getDicTraverseCache()->trimActiveDicNodes(
+                TRAVERSAL->getActiveDicNodeLimit(tSession));
+        queryStats->beamSizeSum += tSession->getDicTraverseCache()->activeSize();
         expandCurrentDicNodes(tSession);
+        if (queryStats->isTruncatedSearch) {
+            // The beam of a step cut short may lack dicNodes that a complete step would have
+            // kept, so no later query may resume from it. The earlier steps were complete.
+            tSession->getDicNodeCheckpoints()->abandon();
+        } else {
+            tSession->getDicNodeCheckpoints()->commit(
+                    tSession->getDicNodeOutputArena()->getEntryCount());
+        }
         tSession->getDicTraverseCache()->advanceActiveDicNodes();
         tSession->getDicTraverseCache()->advanceInputIndex(inputSize);
+        queryStats->addExpansionStep(QueryStats::getElapsedNanos(stageStartTime));
     }
-    PROF_END(1);
-    PROF_START(2);
+    stageStartTime = QueryStats::Clock::now();
     SuggestionsOutputUtils::outputSuggestions(
             SCORING, tSession, languageWeight, outSuggestionResults);
-    PROF_END(2);
-    PROF_CLOSE;
+    queryStats->outputSuggestionsNanos = QueryStats::getElapsedNanos(stageStartTime);
+    outSuggestionResults->setTruncated(queryStats->isTruncatedSearch);
 }
 
 /**
- * Initializes the search at the root of the lexicon trie. Note that when possible the search will
- * continue suggestion from where it left off during the last call.
+ * Initializes the search at the roots of the lexicon tries of the dictionaries of the session.
+ * Note that when possible the search will continue suggestion from a step of an earlier call.
  */
-void Suggest::initializeSearch(DicTraverseSession *traverseSession) const {
+template<class TraversalPolicy, class WeightingPolicy, class ScoringPolicy, int MaxPointerCount>
+void Suggest<TraversalPolicy, WeightingPolicy, ScoringPolicy, MaxPointerCount>::initializeSearch(
+        DicTraverseSession *traverseSession) const {
 //    if (!traverseSession->getProximityInfoState(0)->isUsed()) {
 //        return;
 //    }
 
     if (traverseSession->getInputSize() > MIN_CONTINUOUS_SUGGESTION_INPUT_SIZE
-            && traverseSession->isContinuousSuggestionPossible()) {
+            && traverseSession->continueSearchFromCheckpoint()) {
         // Continue suggestion
-        traverseSession->getDicTraverseCache()->continueSearch();
+        traverseSession->getQueryStats()->isContinuedSearch = true;
     } else {
         // Restart recognition at the root.
         traverseSession->resetCache(TRAVERSAL->getMaxCacheSize(traverseSession->getInputSize()),
                 TRAVERSAL->getTerminalCacheSize());
-        // Create a new dic node here
-        DicNode rootNode;
-        DicNodeUtils::initAsRoot(traverseSession->getDictionaryStructurePolicy(),
-                traverseSession->getPrevWordsPtNodePos(), &rootNode);
-        traverseSession->getDicTraverseCache()->copyPushActive(&rootNode);
+        // Create a new dic node here for each dictionary; their descendants share the queues.
+        const int dictionaryCount = traverseSession->getDictionaryGroup()->getDictionaryCount();
+        for (int i = 0; i < dictionaryCount; ++i) {
+            DicNode rootNode;
+            DicNodeUtils::initAsRoot(traverseSession->getDictionaryStructurePolicy(i), i,
+                    traverseSession->getPrevWordsPtNodePos(i),
+                    traverseSession->getDicNodeOutputArena(), &rootNode);
+            traverseSession->getDicTraverseCache()->copyPushActive(&rootNode);
+        }
     }
 }
 
@@ -103,131 +147,242 @@ void Suggest::initializeSearch(DicTraverseSession *traverseSession) const {
  * Expands the dicNodes in the current search priority queue by advancing to the possible child
  * nodes based on the next touch point(s) (or no touch points for lookahead)
  */
-void Suggest::expandCurrentDicNodes(DicTraverseSession *traverseSession) const {
+template<class TraversalPolicy, class WeightingPolicy, class ScoringPolicy, int MaxPointerCount>
+void Suggest<TraversalPolicy, WeightingPolicy, ScoringPolicy, MaxPointerCount>::
+        expandCurrentDicNodes(DicTraverseSession *traverseSession) const {
     const int inputSize = traverseSession->getInputSize();
-    DicNodeVector childDicNodes(TRAVERSAL->getDefaultExpandDicNodeSize());
-    DicNode correctionDicNode;
+    DicNodesCache *const dicNodesCache = traverseSession->getDicTraverseCache();
 
     // TODO: Find more efficient caching
     const bool shouldDepthLevelCache = TRAVERSAL->shouldDepthLevelCache(traverseSession);
     if (shouldDepthLevelCache) {
-        traverseSession->getDicTraverseCache()->updateLastCachedInputIndex();
+        traverseSession->getDicNodeCheckpoints()->begin(dicNodesCache, inputSize,
+                traverseSession->getExpandedDicNodeCountFromRoot());
     }
     if (DEBUG_CACHE) {
         AKLOGI("expandCurrentDicNodes depth level cache = %d, inputSize = %d",
                 shouldDepthLevelCache, inputSize);
     }
-    while (traverseSession->getDicTraverseCache()->activeSize() > 0) {
-        DicNode dicNode;
-        traverseSession->getDicTraverseCache()->popActive(&dicNode);
-        if (dicNode.isTotalInputSizeExceedingLimit()) {
+    ExpansionWorkers *const expansionWorkers = traverseSession->getExpansionWorkers();
+    if (expansionWorkers
+            && dicNodesCache->activeSize() >= MIN_DIC_NODE_COUNT_FOR_PARALLEL_EXPANSION) {
+        expandCurrentDicNodesInParallel(traverseSession, expansionWorkers, shouldDepthLevelCache);
+        return;
+    }
+    ExpansionScratch *const expansionScratch = traverseSession->getExpansionScratch();
+    while (dicNodesCache->activeSize() > 0 && !traverseSession->isSearchBudgetExhausted()) {
+        DicNode *const dicNode = dicNodesCache->popActive();
+        if (!prepareDicNodeForExpansion(traverseSession, dicNode, shouldDepthLevelCache)) {
             return;
         }
-        childDicNodes.clear();
-        const int point0Index = dicNode.getInputIndex(0);
-        const bool canDoLookAheadCorrection =
-                TRAVERSAL->canDoLookAheadCorrection(traverseSession, &dicNode);
-        const bool isLookAheadCorrection = canDoLookAheadCorrection
-                && traverseSession->getDicTraverseCache()->
-                        isLookAheadCorrectionInputIndex(static_cast<int>(point0Index));
-        const bool isCompletion = dicNode.isCompletion(inputSize);
-
-        const bool shouldNodeLevelCache =
-                TRAVERSAL->shouldNodeLevelCache(traverseSession, &dicNode);
-        if (shouldDepthLevelCache || shouldNodeLevelCache) {
-            if (DEBUG_CACHE) {
-                dicNode.dump("PUSH_CACHE");
-            }
-            traverseSession->getDicTraverseCache()->copyPushContinue(&dicNode);
-            dicNode.setCached();
+        expandDicNode(traverseSession, dicNodesCache, dicNode, expansionScratch);
+    }
+}
+
+/**
+ * Expands the dicNodes in the current search priority queue as expandCurrentDicNodes() does, on
+ * the threads of expansionWorkers. The dicNodes are popped and prepared on the calling thread,
+ * which also fills the checkpoint of the step and the bigram map, so that these only
+ * depend on the order of the queue. Each thread then expands dicNodes into queues and an output
+ * arena of its own, the dictionary and the bigram map being only read, and the dicNodes its
+ * queues kept are finally moved to the queues of the session. Every expansion pushes in the
+ * order it would on a single thread and the queues order dicNodes by their push orders on
+ * ties, so the queues of the session end with the same dicNodes as expandCurrentDicNodes().
+ */
+template<class TraversalPolicy, class WeightingPolicy, class ScoringPolicy, int MaxPointerCount>
+void Suggest<TraversalPolicy, WeightingPolicy, ScoringPolicy, MaxPointerCount>::
+        expandCurrentDicNodesInParallel(DicTraverseSession *traverseSession,
+                ExpansionWorkers *expansionWorkers, const bool shouldDepthLevelCache) const {
+    DicNodesCache *const dicNodesCache = traverseSession->getDicTraverseCache();
+    std::vector<DicNode> *const dicNodes = expansionWorkers->getDicNodes();
+    std::vector<int> *const expansionOrdinals = expansionWorkers->getExpansionOrdinals();
+    dicNodes->clear();
+    expansionOrdinals->clear();
+    while (dicNodesCache->activeSize() > 0 && !traverseSession->isSearchBudgetExhausted()) {
+        DicNode *const dicNode = dicNodesCache->popActive();
+        if (!prepareDicNodeForExpansion(traverseSession, dicNode, shouldDepthLevelCache)) {
+            break;
         }
+        dicNodes->push_back(*dicNode);
+        expansionOrdinals->push_back(dicNodesCache->getExpansionOrdinal());
+    }
+    const int threadCount = expansionWorkers->getThreadCount();
+    for (int i = 0; i < threadCount; ++i) {
+        ExpansionWorkers::Worker *const worker = expansionWorkers->getWorker(i);
+        worker->getDicNodesCache()->resetForExpansionStep(dicNodesCache);
+        worker->getDicNodeOutputArena()->initAsExtensionOf(
+                traverseSession->getDicNodeOutputArena());
+    }
+    // Probabilities may depend on the time the query started at.
+    const int currentTime = TimeKeeper::peekCurrentTime();
+    expansionWorkers->getThreadPool()->run(static_cast<int>(dicNodes->size()),
+            [&](const int dicNodeIndex, const int threadIndex) {
+                ExpansionWorkers::Worker *const worker = expansionWorkers->getWorker(threadIndex);
+                TimeKeeper::setCurrentTime(currentTime);
+                DicNode *const dicNode = &(*dicNodes)[dicNodeIndex];
+                dicNode->setOutputArena(worker->getDicNodeOutputArena());
+                worker->getDicNodesCache()->beginExpansion((*expansionOrdinals)[dicNodeIndex]);
+                expandDicNode(traverseSession, worker->getDicNodesCache(), dicNode,
+                        worker->getExpansionScratch());
+            });
+    QueryStats *const queryStats = traverseSession->getQueryStats();
+    for (int i = 0; i < threadCount; ++i) {
+        ExpansionWorkers::Worker *const worker = expansionWorkers->getWorker(i);
+        dicNodesCache->takeExpandedDicNodes(worker->getDicNodesCache());
+        queryStats->addDicNodeCounts(*worker->getQueryStats());
+        worker->getQueryStats()->reset();
+    }
+}
 
-        if (dicNode.isInDigraph()) {
-            // Finish digraph handling if the node is in the middle of a digraph expansion.
-            processDicNodeAsDigraph(traverseSession, &dicNode);
-        } else if (isLookAheadCorrection) {
-            // The algorithm maintains a small set of "deferred" nodes that have not consumed the
-            // latest touch point yet. These are needed to apply look-ahead correction operations
-            // that require special handling of the latest touch point. For example, with insertions
-            // (e.g., "thiis" -> "this") the latest touch point should not be consumed at all.
-            processDicNodeAsTransposition(traverseSession, &dicNode);
-            processDicNodeAsInsertion(traverseSession, &dicNode);
-        } else { // !isLookAheadCorrection
-            // Only consider typing error corrections if the normalized compound distance is
-            // below a spatial distance threshold.
-            // NOTE: the threshold may need to be updated if scoring model changes.
-            // TODO: Remove. Do not prune node here.
-            const bool allowsErrorCorrections = TRAVERSAL->allowsErrorCorrections(&dicNode);
-            // Process for handling space substitution (e.g., hevis => he is)
-            if (allowsErrorCorrections
-                    && TRAVERSAL->isSpaceSubstitutionTerminal(traverseSession, &dicNode)) {
-                createNextWordDicNode(traverseSession, &dicNode, true /* spaceSubstitution */);
-            }
+/**
+ * Prepares a dicNode popped from the active queue for its expansion and adds it to the checkpoint
+ * of the step if needed. Returns false when it is past the input, in which case neither it nor
+ * the rest of the queue are expanded.
+ */
+template<class TraversalPolicy, class WeightingPolicy, class ScoringPolicy, int MaxPointerCount>
+bool Suggest<TraversalPolicy, WeightingPolicy, ScoringPolicy, MaxPointerCount>::
+        prepareDicNodeForExpansion(DicTraverseSession *traverseSession, DicNode *dicNode,
+                const bool shouldDepthLevelCache) const {
+    if (dicNode->isTotalInputSizeExceedingLimit()) {
+        return false;
+    }
+    // Lets the children and the checkpointed copy of this node share its output.
+    dicNode->commitOutputCodePoints();
+    // All the bigrams the expansion looks up follow the previous words of this node.
+    const int dictionaryIndex = dicNode->getDictionaryIndex();
+    traverseSession->getMultiBigramMap(dictionaryIndex)->cacheBigrams(
+            traverseSession->getDictionaryStructurePolicy(dictionaryIndex),
+            dicNode->getPrevWordsTerminalPtNodePos());
+    const bool shouldNodeLevelCache = TRAVERSAL->shouldNodeLevelCache(traverseSession, dicNode);
+    if (shouldDepthLevelCache || shouldNodeLevelCache) {
+        if (DEBUG_CACHE) {
+            dicNode->dump("PUSH_CACHE");
+        }
+        traverseSession->getDicNodeCheckpoints()->add(dicNode);
+        dicNode->setCached();
+    }
+    return true;
+}
 
-            DicNodeUtils::getAllChildDicNodes(
-                    &dicNode, traverseSession->getDictionaryStructurePolicy(), &childDicNodes);
+/**
+ * Expands one dicNode, pushing the resulting dicNodes to dicNodesCache, with the scratch dicNodes
+ * of expansionScratch.
+ */
+template<class TraversalPolicy, class WeightingPolicy, class ScoringPolicy, int MaxPointerCount>
+void Suggest<TraversalPolicy, WeightingPolicy, ScoringPolicy, MaxPointerCount>::expandDicNode(
+        DicTraverseSession *traverseSession, DicNodesCache *dicNodesCache, DicNode *dicNode,
+        ExpansionScratch *expansionScratch) const {
+    const int inputSize = traverseSession->getInputSize();
+    DicNodeVector *const childDicNodes = expansionScratch->getChildDicNodes();
+    DicNode *const correctionDicNode = expansionScratch->getCorrectionDicNode();
+    childDicNodes->clear();
+    const int point0Index = dicNode->getInputIndex(0);
+    const bool canDoLookAheadCorrection =
+            TRAVERSAL->canDoLookAheadCorrection(traverseSession, dicNode);
+    const bool isLookAheadCorrection = canDoLookAheadCorrection
+            && dicNodesCache->isLookAheadCorrectionInputIndex(static_cast<int>(point0Index));
+    const bool isCompletion = dicNode->isCompletion(inputSize);
+    const DictionaryStructureWithBufferPolicy *const dictionaryStructurePolicy =
+            traverseSession->getDictionaryStructurePolicy(dicNode->getDictionaryIndex());
+    const DigraphCodePoints *const digraphCodePoints =
+            traverseSession->getDigraphCodePoints(dicNode->getDictionaryIndex());
+    const bool hasDigraphs = digraphCodePoints->hasDigraphs();
 
-            const int childDicNodesSize = childDicNodes.getSizeAndLock();
-            for (int i = 0; i < childDicNodesSize; ++i) {
-                DicNode *const childDicNode = childDicNodes[i];
-                if (isCompletion) {
-                    // Handle forward lookahead when the lexicon letter exceeds the input size.
-                    processDicNodeAsMatch(traverseSession, childDicNode);
-                    continue;
-                }
-                if (DigraphUtils::hasDigraphForCodePoint(
-                        traverseSession->getDictionaryStructurePolicy()
-                                ->getHeaderStructurePolicy(),
-                        childDicNode->getNodeCodePoint())) {
-                    correctionDicNode.initByCopy(childDicNode);
-                    correctionDicNode.advanceDigraphIndex();
-                    processDicNodeAsDigraph(traverseSession, &correctionDicNode);
-                }
-                if (TRAVERSAL->isOmission(traverseSession, &dicNode, childDicNode,
-                        allowsErrorCorrections)) {
-                    // TODO: (Gesture) Change weight between omission and substitution errors
-                    // TODO: (Gesture) Terminal node should not be handled as omission
-                    correctionDicNode.initByCopy(childDicNode);
-                    processDicNodeAsOmission(traverseSession, &correctionDicNode);
-                }
-                const ProximityType proximityType = TRAVERSAL->getProximityType(
-                        traverseSession, &dicNode, childDicNode);
-                switch (proximityType) {
-                    // TODO: Consider the difference of proximityType here
-                    case MATCH_CHAR:
-                    case PROXIMITY_CHAR:
-                        processDicNodeAsMatch(traverseSession, childDicNode);
-                        break;
-                    case ADDITIONAL_PROXIMITY_CHAR:
-                        if (allowsErrorCorrections) {
-                            processDicNodeAsAdditionalProximityChar(traverseSession, &dicNode,
-                                    childDicNode);
-                        }
-                        break;
-                    case SUBSTITUTION_CHAR:
-                        if (allowsErrorCorrections) {
-                            processDicNodeAsSubstitution(traverseSession, &dicNode, childDicNode);
-                        }
-                        break;
-                    case UNRELATED_CHAR:
-                        // Just drop this dicNode and do nothing.
-                        break;
-                    default:
-                        // Just drop this dicNode and do nothing.
-                        break;
-                }
-            }
+    if (dicNode->isInDigraph()) {
+        // Finish digraph handling if the node is in the middle of a digraph expansion.
+        processDicNodeAsDigraph(traverseSession, dicNodesCache, dicNode);
+    } else if (isLookAheadCorrection) {
+        // The algorithm maintains a small set of "deferred" nodes that have not consumed the
+        // latest touch point yet. These are needed to apply look-ahead correction operations
+        // that require special handling of the latest touch point. For example, with insertions
+        // (e.g., "thiis" -> "this") the latest touch point should not be consumed at all.
+        processDicNodeAsTransposition(traverseSession, dicNodesCache, dicNode, expansionScratch);
+        processDicNodeAsInsertion(traverseSession, dicNodesCache, dicNode, expansionScratch);
+    } else { // !isLookAheadCorrection
+        // Only consider typing error corrections if the normalized compound distance is
+        // below a spatial distance threshold.
+        // NOTE: the threshold may need to be updated if scoring model changes.
+        // TODO: Remove. Do not prune node here.
+        const bool allowsErrorCorrections = TRAVERSAL->allowsErrorCorrections(dicNode);
+        // Process for handling space substitution (e.g., hevis => he is)
+        if (allowsErrorCorrections
+                && TRAVERSAL->isSpaceSubstitutionTerminal(traverseSession, dicNode)) {
+            createNextWordDicNode(traverseSession, dicNodesCache, dicNode,
+                    true /* spaceSubstitution */);
+        }
+
+        DicNodeUtils::getAllChildDicNodes(dicNode, dictionaryStructurePolicy, childDicNodes);
 
-            // Push the dicNode for look-ahead correction
-            if (allowsErrorCorrections && canDoLookAheadCorrection) {
-                traverseSession->getDicTraverseCache()->copyPushNextActive(&dicNode);
+        const int childDicNodesSize = childDicNodes->getSizeAndLock();
+        // The children are all matched against the input point of dicNode, so their proximity
+        // types are looked up a batch at a time.
+        ProximityType proximityTypes[Traversal::MAX_PROXIMITY_TYPE_BATCH_SIZE];
+        for (int i = 0; i < childDicNodesSize; ++i) {
+            DicNode *const childDicNode = (*childDicNodes)[i];
+            if (isCompletion) {
+                // Handle forward lookahead when the lexicon letter exceeds the input size.
+                processDicNodeAsMatch(traverseSession, dicNodesCache, childDicNode);
+                continue;
+            }
+            if (hasDigraphs && digraphCodePoints->hasDigraphForCodePoint(
+                    childDicNode->getNodeCodePoint())) {
+                correctionDicNode->initByCopy(childDicNode);
+                correctionDicNode->advanceDigraphIndex();
+                processDicNodeAsDigraph(traverseSession, dicNodesCache, correctionDicNode);
+            }
+            if (TRAVERSAL->isOmission(traverseSession, dicNode, childDicNode,
+                    allowsErrorCorrections)) {
+                // TODO: (Gesture) Change weight between omission and substitution errors
+                // TODO: (Gesture) Terminal node should not be handled as omission
+                correctionDicNode->initByCopy(childDicNode);
+                processDicNodeAsOmission(traverseSession, dicNodesCache, correctionDicNode,
+                        expansionScratch);
+            }
+            const int batchIndex = i % Traversal::MAX_PROXIMITY_TYPE_BATCH_SIZE;
+            if (batchIndex == 0) {
+                TRAVERSAL->getProximityTypes(traverseSession, dicNode, childDicNodes, i,
+                        std::min(childDicNodesSize - i, Traversal::MAX_PROXIMITY_TYPE_BATCH_SIZE),
+                        proximityTypes);
+            }
+            const ProximityType proximityType = proximityTypes[batchIndex];
+            switch (proximityType) {
+                // TODO: Consider the difference of proximityType here
+                case MATCH_CHAR:
+                case PROXIMITY_CHAR:
+                    processDicNodeAsMatch(traverseSession, dicNodesCache, childDicNode);
+                    break;
+                case ADDITIONAL_PROXIMITY_CHAR:
+                    if (allowsErrorCorrections) {
+                        processDicNodeAsAdditionalProximityChar(traverseSession, dicNodesCache,
+                                dicNode, childDicNode);
+                    }
+                    break;
+                case SUBSTITUTION_CHAR:
+                    if (allowsErrorCorrections) {
+                        processDicNodeAsSubstitution(traverseSession, dicNodesCache, dicNode,
+                                childDicNode);
+                    }
+                    break;
+                case UNRELATED_CHAR:
+                    // Just drop this dicNode and do nothing.
+                    break;
+                default:
+                    // Just drop this dicNode and do nothing.
+                    break;
             }
         }
+
+        // Push the dicNode for look-ahead correction
+        if (allowsErrorCorrections && canDoLookAheadCorrection) {
+            dicNodesCache->copyPushNextActive(dicNode);
+        }
     }
 }
 
-void Suggest::processTerminalDicNode(
-        DicTraverseSession *traverseSession, DicNode *dicNode) const {
+template<class TraversalPolicy, class WeightingPolicy, class ScoringPolicy, int MaxPointerCount>
+void Suggest<TraversalPolicy, WeightingPolicy, ScoringPolicy, MaxPointerCount>::
+        processTerminalDicNode(DicTraverseSession *traverseSession, DicNodesCache *dicNodesCache,
+                DicNode *dicNode) const {
     if (dicNode->getCompoundDistance() >= static_cast<float>(MAX_VALUE_FOR_WEIGHTING)) {
         return;
     }
@@ -242,67 +397,80 @@ void Suggest::processTerminalDicNode(
     }
     // Create a non-cached node here.
     DicNode terminalDicNode(*dicNode);
+    MultiBigramMap *const multiBigramMap =
+            traverseSession->getMultiBigramMap(dicNode->getDictionaryIndex());
     if (TRAVERSAL->needsToTraverseAllUserInput()
             && dicNode->getInputIndex(0) < traverseSession->getInputSize()) {
         Weighting::addCostAndForwardInputIndex(WEIGHTING, CT_TERMINAL_INSERTION, traverseSession, 0,
-                &terminalDicNode, traverseSession->getMultiBigramMap());
+                &terminalDicNode, multiBigramMap);
     }
     Weighting::addCostAndForwardInputIndex(WEIGHTING, CT_TERMINAL, traverseSession, 0,
-            &terminalDicNode, traverseSession->getMultiBigramMap());
-    traverseSession->getDicTraverseCache()->copyPushTerminal(&terminalDicNode);
+            &terminalDicNode, multiBigramMap);
+    dicNodesCache->copyPushTerminal(&terminalDicNode);
 }
 
 /**
  * Adds the expanded dicNode to the next search priority queue. Also creates an additional next word
  * (by the space omission error correction) search path if input dicNode is on a terminal.
  */
-void Suggest::processExpandedDicNode(
-        DicTraverseSession *traverseSession, DicNode *dicNode) const {
-    processTerminalDicNode(traverseSession, dicNode);
+template<class TraversalPolicy, class WeightingPolicy, class ScoringPolicy, int MaxPointerCount>
+void Suggest<TraversalPolicy, WeightingPolicy, ScoringPolicy, MaxPointerCount>::
+        processExpandedDicNode(DicTraverseSession *traverseSession, DicNodesCache *dicNodesCache,
+                DicNode *dicNode) const {
+    processTerminalDicNode(traverseSession, dicNodesCache, dicNode);
     if (dicNode->getCompoundDistance() < static_cast<float>(MAX_VALUE_FOR_WEIGHTING)) {
         if (TRAVERSAL->isSpaceOmissionTerminal(traverseSession, dicNode)) {
-            createNextWordDicNode(traverseSession, dicNode, false /* spaceSubstitution */);
+            createNextWordDicNode(traverseSession, dicNodesCache, dicNode,
+                    false /* spaceSubstitution */);
         }
         const int allowsLookAhead = !(dicNode->hasMultipleWords()
                 && dicNode->isCompletion(traverseSession->getInputSize()));
         if (dicNode->hasChildren() && allowsLookAhead) {
-            traverseSession->getDicTraverseCache()->copyPushNextActive(dicNode);
+            dicNodesCache->copyPushNextActive(dicNode);
         }
     }
 }
 
-void Suggest::processDicNodeAsMatch(DicTraverseSession *traverseSession,
-        DicNode *childDicNode) const {
+template<class TraversalPolicy, class WeightingPolicy, class ScoringPolicy, int MaxPointerCount>
+void Suggest<TraversalPolicy, WeightingPolicy, ScoringPolicy, MaxPointerCount>::
+        processDicNodeAsMatch(DicTraverseSession *traverseSession, DicNodesCache *dicNodesCache,
+                DicNode *childDicNode) const {
     weightChildNode(traverseSession, childDicNode);
-    processExpandedDicNode(traverseSession, childDicNode);
+    processExpandedDicNode(traverseSession, dicNodesCache, childDicNode);
 }
 
-void Suggest::processDicNodeAsAdditionalProximityChar(DicTraverseSession *traverseSession,
-        DicNode *dicNode, DicNode *childDicNode) const {
+template<class TraversalPolicy, class WeightingPolicy, class ScoringPolicy, int MaxPointerCount>
+void Suggest<TraversalPolicy, WeightingPolicy, ScoringPolicy, MaxPointerCount>::
+        processDicNodeAsAdditionalProximityChar(DicTraverseSession *traverseSession,
+                DicNodesCache *dicNodesCache, DicNode *dicNode, DicNode *childDicNode) const {
     // Note: Most types of corrections don't need to look up the bigram information since they do
     // not treat the node as a terminal. There is no need to pass the bigram map in these cases.
     Weighting::addCostAndForwardInputIndex(WEIGHTING, CT_ADDITIONAL_PROXIMITY,
             traverseSession, dicNode, childDicNode, 0 /* multiBigramMap */);
     weightChildNode(traverseSession, childDicNode);
-    processExpandedDicNode(traverseSession, childDicNode);
+    processExpandedDicNode(traverseSession, dicNodesCache, childDicNode);
 }
 
-void Suggest::processDicNodeAsSubstitution(DicTraverseSession *traverseSession,
-        DicNode *dicNode, DicNode *childDicNode) const {
+template<class TraversalPolicy, class WeightingPolicy, class ScoringPolicy, int MaxPointerCount>
+void Suggest<TraversalPolicy, WeightingPolicy, ScoringPolicy, MaxPointerCount>::
+        processDicNodeAsSubstitution(DicTraverseSession *traverseSession,
+                DicNodesCache *dicNodesCache, DicNode *dicNode, DicNode *childDicNode) const {
     Weighting::addCostAndForwardInputIndex(WEIGHTING, CT_SUBSTITUTION, traverseSession,
             dicNode, childDicNode, 0 /* multiBigramMap */);
     weightChildNode(traverseSession, childDicNode);
-    processExpandedDicNode(traverseSession, childDicNode);
+    processExpandedDicNode(traverseSession, dicNodesCache, childDicNode);
 }
 
 // Process the DicNode codepoint as a digraph. This means that composite glyphs like the German
 // u-umlaut is expanded to the transliteration "ue". Note that this happens in parallel with
 // the normal non-digraph traversal, so both "uber" and "ueber" can be corrected to "[u-umlaut]ber".
-void Suggest::processDicNodeAsDigraph(DicTraverseSession *traverseSession,
-        DicNode *childDicNode) const {
+template<class TraversalPolicy, class WeightingPolicy, class ScoringPolicy, int MaxPointerCount>
+void Suggest<TraversalPolicy, WeightingPolicy, ScoringPolicy, MaxPointerCount>::
+        processDicNodeAsDigraph(DicTraverseSession *traverseSession, DicNodesCache *dicNodesCache,
+                DicNode *childDicNode) const {
     weightChildNode(traverseSession, childDicNode);
     childDicNode->advanceDigraphIndex();
-    processExpandedDicNode(traverseSession, childDicNode);
+    processExpandedDicNode(traverseSession, dicNodesCache, childDicNode);
 }
 
 /**
@@ -312,11 +480,15 @@ void Suggest::processDicNodeAsDigraph(DicTraverseSession *traverseSession,
  * the possible *next* letters after the omission to better limit search to plausible omissions.
  * Note that apostrophes are handled as omissions.
  */
-void Suggest::processDicNodeAsOmission(
-        DicTraverseSession *traverseSession, DicNode *dicNode) const {
-    DicNodeVector childDicNodes;
-    DicNodeUtils::getAllChildDicNodes(
-            dicNode, traverseSession->getDictionaryStructurePolicy(), &childDicNodes);
+template<class TraversalPolicy, class WeightingPolicy, class ScoringPolicy, int MaxPointerCount>
+void Suggest<TraversalPolicy, WeightingPolicy, ScoringPolicy, MaxPointerCount>::
+        processDicNodeAsOmission(DicTraverseSession *traverseSession, DicNodesCache *dicNodesCache,
+                DicNode *dicNode, ExpansionScratch *expansionScratch) const {
+    DicNodeVector &childDicNodes = *expansionScratch->getCorrectionChildDicNodes();
+    childDicNodes.clear();
+    DicNodeUtils::getAllChildDicNodes(dicNode,
+            traverseSession->getDictionaryStructurePolicy(dicNode->getDictionaryIndex()),
+            &childDicNodes);
 
     const int size = childDicNodes.getSizeAndLock();
     for (int i = 0; i < size; i++) {
@@ -328,7 +500,7 @@ void Suggest::processDicNodeAsOmission(
         if (!TRAVERSAL->isPossibleOmissionChildNode(traverseSession, dicNode, childDicNode)) {
             continue;
         }
-        processExpandedDicNode(traverseSession, childDicNode);
+        processExpandedDicNode(traverseSession, dicNodesCache, childDicNode);
     }
 }
 
@@ -336,11 +508,15 @@ void Suggest::processDicNodeAsOmission(
  * Handle the dicNode as an insertion error (e.g., thiis => this). Skip the current touch point and
  * consider matches for the next touch point.
  */
-void Suggest::processDicNodeAsInsertion(DicTraverseSession *traverseSession,
-        DicNode *dicNode) const {
+template<class TraversalPolicy, class WeightingPolicy, class ScoringPolicy, int MaxPointerCount>
+void Suggest<TraversalPolicy, WeightingPolicy, ScoringPolicy, MaxPointerCount>::
+        processDicNodeAsInsertion(DicTraverseSession *traverseSession, DicNodesCache *dicNodesCache,
+                DicNode *dicNode, ExpansionScratch *expansionScratch) const {
     const int16_t pointIndex = dicNode->getInputIndex(0);
-    DicNodeVector childDicNodes;
-    DicNodeUtils::getAllChildDicNodes(dicNode, traverseSession->getDictionaryStructurePolicy(),
+    DicNodeVector &childDicNodes = *expansionScratch->getCorrectionChildDicNodes();
+    childDicNodes.clear();
+    DicNodeUtils::getAllChildDicNodes(dicNode,
+            traverseSession->getDictionaryStructurePolicy(dicNode->getDictionaryIndex()),
             &childDicNodes);
     const int size = childDicNodes.getSizeAndLock();
     for (int i = 0; i < size; i++) {
@@ -351,20 +527,25 @@ void Suggest::processDicNodeAsInsertion(DicTraverseSession *traverseSession,
         DicNode *const childDicNode = childDicNodes[i];
         Weighting::addCostAndForwardInputIndex(WEIGHTING, CT_INSERTION, traverseSession,
                 dicNode, childDicNode, 0 /* multiBigramMap */);
-        processExpandedDicNode(traverseSession, childDicNode);
+        processExpandedDicNode(traverseSession, dicNodesCache, childDicNode);
     }
 }
 
 /**
  * Handle the dicNode as a transposition error (e.g., thsi => this). Swap the next two touch points.
  */
-void Suggest::processDicNodeAsTransposition(DicTraverseSession *traverseSession,
-        DicNode *dicNode) const {
+template<class TraversalPolicy, class WeightingPolicy, class ScoringPolicy, int MaxPointerCount>
+void Suggest<TraversalPolicy, WeightingPolicy, ScoringPolicy, MaxPointerCount>::
+        processDicNodeAsTransposition(DicTraverseSession *traverseSession,
+                DicNodesCache *dicNodesCache, DicNode *dicNode,
+                ExpansionScratch *expansionScratch) const {
     const int16_t pointIndex = dicNode->getInputIndex(0);
-    DicNodeVector childDicNodes1;
-    DicNodeVector childDicNodes2;
-    DicNodeUtils::getAllChildDicNodes(dicNode, traverseSession->getDictionaryStructurePolicy(),
-            &childDicNodes1);
+    const DictionaryStructureWithBufferPolicy *const dictionaryStructurePolicy =
+            traverseSession->getDictionaryStructurePolicy(dicNode->getDictionaryIndex());
+    DicNodeVector &childDicNodes1 = *expansionScratch->getCorrectionChildDicNodes();
+    DicNodeVector &childDicNodes2 = *expansionScratch->getTranspositionChildDicNodes();
+    childDicNodes1.clear();
+    DicNodeUtils::getAllChildDicNodes(dicNode, dictionaryStructurePolicy, &childDicNodes1);
     const int childSize1 = childDicNodes1.getSizeAndLock();
     for (int i = 0; i < childSize1; i++) {
         const ProximityType matchedId1 = traverseSession->getProximityInfoState(0)
@@ -375,8 +556,8 @@ void Suggest::processDicNodeAsTransposition(DicTraverseSession *traverseSession,
         }
         if (childDicNodes1[i]->hasChildren()) {
             childDicNodes2.clear();
-            DicNodeUtils::getAllChildDicNodes(childDicNodes1[i],
-                    traverseSession->getDictionaryStructurePolicy(), &childDicNodes2);
+            DicNodeUtils::getAllChildDicNodes(childDicNodes1[i], dictionaryStructurePolicy,
+                    &childDicNodes2);
             const int childSize2 = childDicNodes2.getSizeAndLock();
             for (int j = 0; j < childSize2; j++) {
                 DicNode *const childDicNode2 = childDicNodes2[j];
@@ -388,7 +569,7 @@ void Suggest::processDicNodeAsTransposition(DicTraverseSession *traverseSession,
                 }
                 Weighting::addCostAndForwardInputIndex(WEIGHTING, CT_TRANSPOSITION,
                         traverseSession, childDicNodes1[i], childDicNode2, 0 /* multiBigramMap */);
-                processExpandedDicNode(traverseSession, childDicNode2);
+                processExpandedDicNode(traverseSession, dicNodesCache, childDicNode2);
             }
         }
     }
@@ -397,7 +578,9 @@ void Suggest::processDicNodeAsTransposition(DicTraverseSession *traverseSession,
 /**
  * Weight child dicNode by aligning it to the key
  */
-void Suggest::weightChildNode(DicTraverseSession *traverseSession, DicNode *dicNode) const {
+template<class TraversalPolicy, class WeightingPolicy, class ScoringPolicy, int MaxPointerCount>
+void Suggest<TraversalPolicy, WeightingPolicy, ScoringPolicy, MaxPointerCount>::weightChildNode(
+        DicTraverseSession *traverseSession, DicNode *dicNode) const {
     const int inputSize = traverseSession->getInputSize();
     if (dicNode->isCompletion(inputSize)) {
         Weighting::addCostAndForwardInputIndex(WEIGHTING, CT_COMPLETION, traverseSession,
@@ -412,26 +595,32 @@ void Suggest::weightChildNode(DicTraverseSession *traverseSession, DicNode *dicN
  * Creates a new dicNode that represents a space insertion at the end of the input dicNode. Also
  * incorporates the unigram / bigram score for the ending word into the new dicNode.
  */
-void Suggest::createNextWordDicNode(DicTraverseSession *traverseSession, DicNode *dicNode,
-        const bool spaceSubstitution) const {
+template<class TraversalPolicy, class WeightingPolicy, class ScoringPolicy, int MaxPointerCount>
+void Suggest<TraversalPolicy, WeightingPolicy, ScoringPolicy, MaxPointerCount>::
+        createNextWordDicNode(DicTraverseSession *traverseSession, DicNodesCache *dicNodesCache,
+                DicNode *dicNode, const bool spaceSubstitution) const {
     if (!TRAVERSAL->isGoodToTraverseNextWord(dicNode)) {
         return;
     }
 
-    // Create a non-cached node here.
+    // Create a non-cached node here. The next word is in the dictionary of the previous one.
+    const int dictionaryIndex = dicNode->getDictionaryIndex();
     DicNode newDicNode;
     DicNodeUtils::initAsRootWithPreviousWord(
-            traverseSession->getDictionaryStructurePolicy(), dicNode, &newDicNode);
+            traverseSession->getDictionaryStructurePolicy(dictionaryIndex), dicNode, &newDicNode);
     const CorrectionType correctionType = spaceSubstitution ?
             CT_NEW_WORD_SPACE_SUBSTITUTION : CT_NEW_WORD_SPACE_OMISSION;
     Weighting::addCostAndForwardInputIndex(WEIGHTING, correctionType, traverseSession, dicNode,
-            &newDicNode, traverseSession->getMultiBigramMap());
+            &newDicNode, traverseSession->getMultiBigramMap(dictionaryIndex));
     if (newDicNode.getCompoundDistance() < static_cast<float>(MAX_VALUE_FOR_WEIGHTING)) {
         // newDicNode is worth continuing to traverse.
         // CAVEAT: This pruning is important for speed. Remove this when we can afford not to prune
         // here because here is not the right place to do pruning. Pruning should take place only
         // in DicNodePriorityQueue.
-        traverseSession->getDicTraverseCache()->copyPushNextActive(&newDicNode);
+        dicNodesCache->copyPushNextActive(&newDicNode);
     }
 }
+
+template class Suggest<Traversal, Weighting, Scoring, MAX_POINTER_COUNT_G>;
+template class Suggest<TypingTraversal, TypingWeighting, TypingScoring, MAX_POINTER_COUNT>;
 } // namespace latinime
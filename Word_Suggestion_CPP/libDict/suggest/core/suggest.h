@@ -34,19 +34,42 @@ namespace latinime {
 //       priority of a suggested word
 
 class DicNode;
+class DicNodesCache;
 class DicTraverseSession;
+class ExpansionScratch;
+class ExpansionWorkers;
 class ProximityInfo;
 class Scoring;
 class SuggestionResults;
 class Traversal;
+class TypingScoring;
+class TypingTraversal;
+class TypingWeighting;
 class Weighting;
 
+/**
+ * The search, on the policies given as template arguments. On Traversal, Weighting and Scoring
+ * it reaches the policies of any SuggestPolicy through their virtual functions; on final policy
+ * classes the compiler inlines the policy calls made for every edge of the search and folds the
+ * switches on the correction type. MaxPointerCount bounds the pointers the input is set up for.
+ *
+ * The instantiations are PolicySuggest and TypingSuggest below, explicitly instantiated in
+ * suggest.cpp.
+ */
+template<class TraversalPolicy, class WeightingPolicy, class ScoringPolicy, int MaxPointerCount>
 class Suggest : public SuggestInterface {
  public:
+    // suggestPolicy must give policies of the classes of the template arguments.
     AK_FORCE_INLINE Suggest(const SuggestPolicy *const suggestPolicy)
-            : TRAVERSAL(suggestPolicy ? suggestPolicy->getTraversal() : nullptr),
-              SCORING(suggestPolicy ? suggestPolicy->getScoring() : nullptr),
-              WEIGHTING(suggestPolicy ? suggestPolicy->getWeighting() : nullptr) {}
+            : TRAVERSAL(suggestPolicy
+                      ? static_cast<const TraversalPolicy *>(suggestPolicy->getTraversal())
+                      : nullptr),
+              SCORING(suggestPolicy
+                      ? static_cast<const ScoringPolicy *>(suggestPolicy->getScoring())
+                      : nullptr),
+              WEIGHTING(suggestPolicy
+                      ? static_cast<const WeightingPolicy *>(suggestPolicy->getWeighting())
+                      : nullptr) {}
     AK_FORCE_INLINE virtual ~Suggest() {}
     void getSuggestions(ProximityInfo *pInfo, void *traverseSession, int *inputXs, int *inputYs,
             int *times, int *pointerIds, int *inputCodePoints, int inputSize,
@@ -54,30 +77,54 @@ class Suggest : public SuggestInterface {
 
  private:
     DISALLOW_IMPLICIT_CONSTRUCTORS(Suggest);
-    void createNextWordDicNode(DicTraverseSession *traverseSession, DicNode *dicNode,
-            const bool spaceSubstitution) const;
+    void createNextWordDicNode(DicTraverseSession *traverseSession,
+            DicNodesCache *dicNodesCache, DicNode *dicNode, const bool spaceSubstitution) const;
     void initializeSearch(DicTraverseSession *traverseSession) const;
     void expandCurrentDicNodes(DicTraverseSession *traverseSession) const;
-    void processTerminalDicNode(DicTraverseSession *traverseSession, DicNode *dicNode) const;
-    void processExpandedDicNode(DicTraverseSession *traverseSession, DicNode *dicNode) const;
+    void expandCurrentDicNodesInParallel(DicTraverseSession *traverseSession,
+            ExpansionWorkers *expansionWorkers, const bool shouldDepthLevelCache) const;
+    bool prepareDicNodeForExpansion(DicTraverseSession *traverseSession, DicNode *dicNode,
+            const bool shouldDepthLevelCache) const;
+    void expandDicNode(DicTraverseSession *traverseSession, DicNodesCache *dicNodesCache,
+            DicNode *dicNode, ExpansionScratch *expansionScratch) const;
+    void processTerminalDicNode(DicTraverseSession *traverseSession,
+            DicNodesCache *dicNodesCache, DicNode *dicNode) const;
+    void processExpandedDicNode(DicTraverseSession *traverseSession,
+            DicNodesCache *dicNodesCache, DicNode *dicNode) const;
     void weightChildNode(DicTraverseSession *traverseSession, DicNode *dicNode) const;
-    void processDicNodeAsOmission(DicTraverseSession *traverseSession, DicNode *dicNode) const;
-    void processDicNodeAsDigraph(DicTraverseSession *traverseSession, DicNode *dicNode) const;
+    void processDicNodeAsOmission(DicTraverseSession *traverseSession,
+            DicNodesCache *dicNodesCache, DicNode *dicNode,
+            ExpansionScratch *expansionScratch) const;
+    void processDicNodeAsDigraph(DicTraverseSession *traverseSession,
+            DicNodesCache *dicNodesCache, DicNode *dicNode) const;
     void processDicNodeAsTransposition(DicTraverseSession *traverseSession,
-            DicNode *dicNode) const;
-    void processDicNodeAsInsertion(DicTraverseSession *traverseSession, DicNode *dicNode) const;
+            DicNodesCache *dicNodesCache, DicNode *dicNode,
+            ExpansionScratch *expansionScratch) const;
+    void processDicNodeAsInsertion(DicTraverseSession *traverseSession,
+            DicNodesCache *dicNodesCache, DicNode *dicNode,
+            ExpansionScratch *expansionScratch) const;
     void processDicNodeAsAdditionalProximityChar(DicTraverseSession *traverseSession,
-            DicNode *dicNode, DicNode *childDicNode) const;
-    void processDicNodeAsSubstitution(DicTraverseSession *traverseSession, DicNode *dicNode,
-            DicNode *childDicNode) const;
+            DicNodesCache *dicNodesCache, DicNode *dicNode, DicNode *childDicNode) const;
+    void processDicNodeAsSubstitution(DicTraverseSession *traverseSession,
+            DicNodesCache *dicNodesCache, DicNode *dicNode, DicNode *childDicNode) const;
     void processDicNodeAsMatch(DicTraverseSession *traverseSession,
-            DicNode *childDicNode) const;
+            DicNodesCache *dicNodesCache, DicNode *childDicNode) const;
+
+    static_assert(1 <= MaxPointerCount && MaxPointerCount <= MAX_POINTER_COUNT_G,
+            "The input state is sized for MAX_POINTER_COUNT_G pointers");
 
     static const int MIN_CONTINUOUS_SUGGESTION_INPUT_SIZE;
+    static const int MIN_DIC_NODE_COUNT_FOR_PARALLEL_EXPANSION;
 
-    const Traversal *const TRAVERSAL;
-    const Scoring *const SCORING;
-    const Weighting *const WEIGHTING;
+    const TraversalPolicy *const TRAVERSAL;
+    const ScoringPolicy *const SCORING;
+    const WeightingPolicy *const WEIGHTING;
 };
+
+// For the policies of any SuggestPolicy, such as the gesture one.
+typedef Suggest<Traversal, Weighting, Scoring, MAX_POINTER_COUNT_G> PolicySuggest;
+// For TypingSuggestPolicy, whose traversal uses a single pointer.
+typedef Suggest<TypingTraversal, TypingWeighting, TypingScoring, MAX_POINTER_COUNT>
+        TypingSuggest;
 } // namespace latinime
 #endif // LATINIME_SUGGEST_IMPL_H
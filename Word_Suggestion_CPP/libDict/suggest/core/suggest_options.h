@@ -17,12 +17,33 @@
 #ifndef LATINIME_SUGGEST_OPTIONS_H
 #define LATINIME_SUGGEST_OPTIONS_H
 
+#include <algorithm>
+
 #include "../../defines.h"
 
 namespace latinime {
 
 class SuggestOptions{
  public:
+    // Slots of the options in the array given to the constructor. Need to update
+    // com.android.inputmethod.latin.NativeSuggestOptions when you add, remove or reorder options.
+    static const int IS_GESTURE = 0;
+    static const int USE_FULL_EDIT_DISTANCE = 1;
+    static const int BLOCK_OFFENSIVE_WORDS = 2;
+    static const int SPACE_AWARE_GESTURE_ENABLED = 3;
+    // Additional features options are stored after the other options and used as setting values of
+    // experimental features, up to ADDITIONAL_FEATURES_OPTION_COUNT of them.
+    static const int ADDITIONAL_FEATURES_OPTIONS = 4;
+    static const int ADDITIONAL_FEATURES_OPTION_COUNT = 8;
+    // The search budget options come after the slots of the additional features, so that arrays
+    // laid out before they existed keep their meaning and leave the search unbounded.
+    static const int SEARCH_DEADLINE_MICROS =
+            ADDITIONAL_FEATURES_OPTIONS + ADDITIONAL_FEATURES_OPTION_COUNT;
+    static const int MAX_EXPANDED_DIC_NODE_COUNT = SEARCH_DEADLINE_MICROS + 1;
+    // Options that trade the suggestions for speed come last, off unless set.
+    static const int USE_ADAPTIVE_BEAM = MAX_EXPANDED_DIC_NODE_COUNT + 1;
+    static const int OPTION_COUNT = USE_ADAPTIVE_BEAM + 1;
+
     SuggestOptions(const int *const options, const int length)
             : mOptions(options), mLength(length) {}
 
@@ -42,23 +63,35 @@ class SuggestOptions{
         return getBoolOption(SPACE_AWARE_GESTURE_ENABLED);
     }
 
+    // Time a typing query may take, in microseconds from the start of
+    // Dictionary::getSuggestions(). 0 means no deadline.
+    AK_FORCE_INLINE int getSearchDeadlineMicros() const {
+        return std::max(getIntOption(SEARCH_DEADLINE_MICROS), 0);
+    }
+
+    // Number of dicNodes a typing query may expand. 0 means no limit.
+    AK_FORCE_INLINE int getMaxExpandedDicNodeCount() const {
+        return std::max(getIntOption(MAX_EXPANDED_DIC_NODE_COUNT), 0);
+    }
+
+    // Whether a typing query expands only the active dicNodes close to the best one at each
+    // step; see TypingTraversal::getActiveDicNodeLimit(). It expands about 2% fewer dicNodes
+    // than the full search, and some lower-ranked suggestions for misspelled input differ, so
+    // it stays off unless set.
+    AK_FORCE_INLINE bool useAdaptiveBeam() const {
+        return getBoolOption(USE_ADAPTIVE_BEAM);
+    }
+
     AK_FORCE_INLINE bool getAdditionalFeaturesBoolOption(const int key) const {
+        if (key < 0 || key >= ADDITIONAL_FEATURES_OPTION_COUNT) {
+            return false;
+        }
         return getBoolOption(key + ADDITIONAL_FEATURES_OPTIONS);
     }
 
  private:
     DISALLOW_IMPLICIT_CONSTRUCTORS(SuggestOptions);
 
-    // Need to update com.android.inputmethod.latin.NativeSuggestOptions when you add, remove or
-    // reorder options.
-    static const int IS_GESTURE = 0;
-    static const int USE_FULL_EDIT_DISTANCE = 1;
-    static const int BLOCK_OFFENSIVE_WORDS = 2;
-    static const int SPACE_AWARE_GESTURE_ENABLED = 3;
-    // Additional features options are stored after the other options and used as setting values of
-    // experimental features.
-    static const int ADDITIONAL_FEATURES_OPTIONS = 4;
-
     const int *const mOptions;
     const int mLength;
 
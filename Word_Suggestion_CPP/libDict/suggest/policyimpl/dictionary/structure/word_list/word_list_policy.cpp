@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../../../../../suggest/policyimpl/dictionary/structure/word_list/word_list_policy.h"
+
+#include <algorithm>
+
+#include "../../../../../defines.h"
+#include "../../../../../suggest/core/dicnode/dic_node.h"
+#include "../../../../../suggest/core/dicnode/dic_node_vector.h"
+#include "../../../../../suggest/core/dictionary/property/unigram_property.h"
+#include "../../../../../suggest/policyimpl/dictionary/utils/probability_utils.h"
+#include "../../../../../utils/char_utils.h"
+
+namespace latinime {
+
+const int WordListPolicy::ROOT_POS = 0;
+
+void WordListPolicy::createAndGetAllChildDicNodes(const DicNode *const dicNode,
+        DicNodeVector *const childDicNodes) const {
+    if (!dicNode->hasChildren()) {
+        return;
+    }
+    const int childrenPos = dicNode->getChildrenPtNodeArrayPos();
+    if (childrenPos != ROOT_POS && !isValidPtNodePos(childrenPos)) {
+        AKLOGE("Children PtNode array position is invalid. pos: %d, PtNode count: %zu",
+                childrenPos, mPtNodes.size());
+        ASSERT(false);
+        return;
+    }
+    for (int pos = mPtNodes[childrenPos].mFirstChildPos; pos != NOT_A_DICT_POS;
+            pos = mPtNodes[pos].mNextSiblingPos) {
+        const PtNode &ptNode = mPtNodes[pos];
+        // Skip PtNodes don't start with Unicode code point because they represent non-word
+        // information.
+        if (!CharUtils::isInUnicodeSpace(ptNode.mCodePoint)) {
+            continue;
+        }
+        childDicNodes->pushLeavingChild(dicNode, pos, pos /* childrenPtNodeArrayPos */,
+                ptNode.mProbability, ptNode.isTerminal(),
+                ptNode.mFirstChildPos != NOT_A_DICT_POS, ptNode.mIsBlacklistedOrNotAWord,
+                1 /* mergedNodeCodePointCount */, &ptNode.mCodePoint);
+    }
+}
+
+int WordListPolicy::getCodePointsAndProbabilityAndReturnCodePointCount(
+        const int terminalPtNodePos, const int maxCodePointCount, int *const outCodePoints,
+        int *const outUnigramProbability) const {
+    *outUnigramProbability = NOT_A_PROBABILITY;
+    if (!isValidPtNodePos(terminalPtNodePos)) {
+        return 0;
+    }
+    int codePointCount = 0;
+    for (int pos = terminalPtNodePos; pos != ROOT_POS; pos = mPtNodes[pos].mParentPos) {
+        if (codePointCount >= maxCodePointCount) {
+            return 0;
+        }
+        outCodePoints[codePointCount++] = mPtNodes[pos].mCodePoint;
+    }
+    // The code points were read from the terminal PtNode up.
+    std::reverse(outCodePoints, outCodePoints + codePointCount);
+    *outUnigramProbability = mPtNodes[terminalPtNodePos].mProbability;
+    return codePointCount;
+}
+
+int WordListPolicy::getTerminalPtNodePositionOfWord(const int *const inWord,
+        const int length, const bool forceLowerCaseSearch) const {
+    int pos = ROOT_POS;
+    for (int i = 0; i < length && pos != NOT_A_DICT_POS; ++i) {
+        pos = findChildPtNodePos(pos,
+                forceLowerCaseSearch ? CharUtils::toLowerCase(inWord[i]) : inWord[i]);
+    }
+    if (pos == NOT_A_DICT_POS || pos == ROOT_POS || !mPtNodes[pos].isTerminal()) {
+        return NOT_A_DICT_POS;
+    }
+    return pos;
+}
+
+int WordListPolicy::getProbability(const int unigramProbability,
+        const int bigramProbability) const {
+    if (unigramProbability == NOT_A_PROBABILITY) {
+        return NOT_A_PROBABILITY;
+    } else if (bigramProbability == NOT_A_PROBABILITY) {
+        return ProbabilityUtils::backoff(unigramProbability);
+    } else {
+        return bigramProbability;
+    }
+}
+
+int WordListPolicy::getProbabilityOfPtNode(const int *const prevWordsPtNodePos,
+        const int ptNodePos) const {
+    if (!isValidPtNodePos(ptNodePos)) {
+        return NOT_A_PROBABILITY;
+    }
+    const PtNode &ptNode = mPtNodes[ptNodePos];
+    if (ptNode.mIsBlacklistedOrNotAWord) {
+        return NOT_A_PROBABILITY;
+    }
+    if (prevWordsPtNodePos) {
+        // Without n-grams, no word has a probability after previous words.
+        return NOT_A_PROBABILITY;
+    }
+    return getProbability(ptNode.mProbability, NOT_A_PROBABILITY);
+}
+
+bool WordListPolicy::addUnigramEntry(const int *const word, const int length,
+        const UnigramProperty *const unigramProperty) {
+    if (length <= 0 || length > MAX_WORD_LENGTH) {
+        AKLOGE("The word is too long to insert to the word list. length: %d", length);
+        return false;
+    }
+    if (unigramProperty->representsBeginningOfSentence()) {
+        AKLOGE("A word list cannot hold the beginning-of-sentence marker.");
+        return false;
+    }
+    int pos = ROOT_POS;
+    for (int i = 0; i < length; ++i) {
+        int childPos = findChildPtNodePos(pos, word[i]);
+        if (childPos == NOT_A_DICT_POS) {
+            childPos = static_cast<int>(mPtNodes.size());
+            mPtNodes.emplace_back(word[i], pos);
+            // New children go last, so that the search meets them in the order they came.
+            int *lastLink = &mPtNodes[pos].mFirstChildPos;
+            while (*lastLink != NOT_A_DICT_POS) {
+                lastLink = &mPtNodes[*lastLink].mNextSiblingPos;
+            }
+            *lastLink = childPos;
+        }
+        pos = childPos;
+    }
+    PtNode &terminalPtNode = mPtNodes[pos];
+    terminalPtNode.mProbability = unigramProperty->getProbability();
+    terminalPtNode.mIsBlacklistedOrNotAWord =
+            unigramProperty->isBlacklisted() || unigramProperty->isNotAWord();
+    return true;
+}
+
+int WordListPolicy::getNextWordAndNextToken(const int token, int *const outCodePoints,
+        int *const outCodePointCount) {
+    *outCodePointCount = 0;
+    const int ptNodeCount = static_cast<int>(mPtNodes.size());
+    if (token < 0 || token >= ptNodeCount) {
+        AKLOGE("Given token %d is invalid.", token);
+        return 0;
+    }
+    int pos = token == 0 ? ROOT_POS + 1 : token;
+    while (pos < ptNodeCount && !mPtNodes[pos].isTerminal()) {
+        ++pos;
+    }
+    if (pos >= ptNodeCount) {
+        // The list is empty.
+        return 0;
+    }
+    int unigramProbability = NOT_A_PROBABILITY;
+    *outCodePointCount = getCodePointsAndProbabilityAndReturnCodePointCount(pos,
+            MAX_WORD_LENGTH, outCodePoints, &unigramProbability);
+    int nextToken = pos + 1;
+    while (nextToken < ptNodeCount && !mPtNodes[nextToken].isTerminal()) {
+        ++nextToken;
+    }
+    // 0 once all words have been iterated.
+    return nextToken < ptNodeCount ? nextToken : 0;
+}
+
+int WordListPolicy::findChildPtNodePos(const int ptNodePos, const int codePoint) const {
+    for (int pos = mPtNodes[ptNodePos].mFirstChildPos; pos != NOT_A_DICT_POS;
+            pos = mPtNodes[pos].mNextSiblingPos) {
+        if (mPtNodes[pos].mCodePoint == codePoint) {
+            return pos;
+        }
+    }
+    return NOT_A_DICT_POS;
+}
+
+} // namespace latinime
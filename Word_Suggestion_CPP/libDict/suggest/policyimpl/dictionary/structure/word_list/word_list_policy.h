@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_WORD_LIST_POLICY_H
+#define LATINIME_WORD_LIST_POLICY_H
+
+#include <cstddef>
+#include <vector>
+
+#include "../../../../../defines.h"
+#include "../../../../../suggest/core/policy/dictionary_structure_with_buffer_policy.h"
+#include "../../../../../suggest/policyimpl/dictionary/header/header_policy.h"
+#include "../../../../../suggest/policyimpl/dictionary/structure/v2/shortcut/shortcut_list_policy.h"
+
+namespace latinime {
+
+class DicNode;
+class DicNodeVector;
+
+/**
+ * Unigram-only dictionary kept as a trie of one code point per PtNode in a single vector, for
+ * small lists of words such as contacts that are built for a request or a few of them.
+ *
+ * A PtNode position is the index of the PtNode in the vector, which is also the position of the
+ * array of its children: the children of a PtNode are linked from its first child, in the order
+ * they were added. Index 0 is the root, which holds no code point. Unlike the on-memory version
+ * 4 dictionaries, the trie only allocates as it grows. Each PtNode keeps its parent, so that the
+ * code points of a word can be read up from its terminal PtNode.
+ */
+class WordListPolicy : public DictionaryStructureWithBufferPolicy {
+ public:
+    WordListPolicy(const std::vector<int> &locale,
+            const DictionaryHeaderStructurePolicy::AttributeMap *const attributeMap)
+            : mHeaderPolicy(FormatUtils::VERSION_4_DEV, locale, attributeMap),
+              mShortcutListPolicy(nullptr), mPtNodes(1 /* root */) {}
+
+    AK_FORCE_INLINE int getRootPosition() const {
+        return ROOT_POS;
+    }
+
+    void createAndGetAllChildDicNodes(const DicNode *const dicNode,
+            DicNodeVector *const childDicNodes) const;
+
+    int getCodePointsAndProbabilityAndReturnCodePointCount(
+            const int terminalPtNodePos, const int maxCodePointCount, int *const outCodePoints,
+            int *const outUnigramProbability) const;
+
+    int getTerminalPtNodePositionOfWord(const int *const inWord,
+            const int length, const bool forceLowerCaseSearch) const;
+
+    int getProbability(const int unigramProbability, const int bigramProbability) const;
+
+    int getProbabilityOfPtNode(const int *const prevWordsPtNodePos, const int ptNodePos) const;
+
+    void iterateNgramEntries(const int *const prevWordsPtNodePos,
+            NgramListener *const listener) const {
+        // There are no n-grams in a word list.
+    }
+
+    int getShortcutPositionOfPtNode(const int ptNodePos) const {
+        return NOT_A_DICT_POS;
+    }
+
+    const DictionaryHeaderStructurePolicy *getHeaderStructurePolicy() const {
+        return &mHeaderPolicy;
+    }
+
+    const DictionaryShortcutsStructurePolicy *getShortcutsStructurePolicy() const {
+        return &mShortcutListPolicy;
+    }
+
+    // Adds the word, or updates its probability and flags when it is already in the list.
+    bool addUnigramEntry(const int *const word, const int length,
+            const UnigramProperty *const unigramProperty);
+
+    bool removeUnigramEntry(const int *const word, const int length) {
+        AKLOGI("Warning: removeUnigramEntry() is called for a word list.");
+        return false;
+    }
+
+    bool addNgramEntry(const PrevWordsInfo *const prevWordsInfo,
+            const BigramProperty *const bigramProperty) {
+        AKLOGI("Warning: addNgramEntry() is called for a word list.");
+        return false;
+    }
+
+    bool removeNgramEntry(const PrevWordsInfo *const prevWordsInfo, const int *const word,
+            const int length) {
+        AKLOGI("Warning: removeNgramEntry() is called for a word list.");
+        return false;
+    }
+
+    bool flush(const char *const filePath) {
+        AKLOGI("Warning: flush() is called for a word list.");
+        return false;
+    }
+
+    bool flushWithGC(const char *const filePath) {
+        AKLOGI("Warning: flushWithGC() is called for a word list.");
+        return false;
+    }
+
+    bool needsToRunGC(const bool mindsBlockByGC) const {
+        return false;
+    }
+
+    void getProperty(const char *const query, const int queryLength, char *const outResult,
+            const int maxResultLength) {
+        // getProperty is not supported for this class.
+        if (maxResultLength > 0) {
+            outResult[0] = '\0';
+        }
+    }
+
+    // The token is the position of the next terminal PtNode.
+    int getNextWordAndNextToken(const int token, int *const outCodePoints,
+            int *const outCodePointCount);
+
+    bool isCorrupted() const {
+        return false;
+    }
+
+    size_t getMemorySize() const {
+        return mPtNodes.capacity() * sizeof(PtNode);
+    }
+
+ private:
+    DISALLOW_IMPLICIT_CONSTRUCTORS(WordListPolicy);
+
+    static const int ROOT_POS;
+
+    class PtNode {
+     public:
+        PtNode()
+                : mCodePoint(NOT_A_CODE_POINT), mProbability(NOT_A_PROBABILITY),
+                  mParentPos(NOT_A_DICT_POS),
+                  mFirstChildPos(NOT_A_DICT_POS), mNextSiblingPos(NOT_A_DICT_POS),
+                  mIsBlacklistedOrNotAWord(false) {}
+
+        PtNode(const int codePoint, const int parentPos)
+                : mCodePoint(codePoint), mProbability(NOT_A_PROBABILITY), mParentPos(parentPos),
+                  mFirstChildPos(NOT_A_DICT_POS), mNextSiblingPos(NOT_A_DICT_POS),
+                  mIsBlacklistedOrNotAWord(false) {}
+
+        bool isTerminal() const {
+            return mProbability != NOT_A_PROBABILITY;
+        }
+
+        int mCodePoint;
+        // NOT_A_PROBABILITY for PtNodes that do not end a word.
+        int mProbability;
+        int mParentPos;
+        int mFirstChildPos;
+        int mNextSiblingPos;
+        bool mIsBlacklistedOrNotAWord;
+    };
+
+    const HeaderPolicy mHeaderPolicy;
+    const ShortcutListPolicy mShortcutListPolicy;
+    std::vector<PtNode> mPtNodes;
+
+    AK_FORCE_INLINE bool isValidPtNodePos(const int ptNodePos) const {
+        return ptNodePos > ROOT_POS && ptNodePos < static_cast<int>(mPtNodes.size());
+    }
+
+    int findChildPtNodePos(const int ptNodePos, const int codePoint) const;
+};
+} // namespace latinime
+#endif // LATINIME_WORD_LIST_POLICY_H
@@ -32,6 +32,11 @@ const float ScoringParams::DIGRAPH_PENALTY_FOR_EXACT_MATCH = 0.03f;
 const int ScoringParams::MAX_CACHE_DIC_NODE_SIZE = 170;
 const int ScoringParams::MAX_CACHE_DIC_NODE_SIZE_FOR_SINGLE_POINT = 310;
 const int ScoringParams::THRESHOLD_SHORT_WORD_LENGTH = 4;
+// Active dicNodes farther than this from the best one are not expanded, once more than
+// MIN_ADAPTIVE_BEAM_SIZE of them are left. Completions of the same prefix are nearly tied on
+// distance until their language cost is added, so narrower margins drop good suggestions.
+const float ScoringParams::ADAPTIVE_BEAM_DISTANCE_MARGIN = 1.0f;
+const int ScoringParams::MIN_ADAPTIVE_BEAM_SIZE = 16;
 
 const float ScoringParams::DISTANCE_WEIGHT_LENGTH = 0.1524f;
 const float ScoringParams::PROXIMITY_COST = 0.0694f;
@@ -31,6 +31,8 @@ class ScoringParams {
     static const int MAX_CACHE_DIC_NODE_SIZE;
     static const int MAX_CACHE_DIC_NODE_SIZE_FOR_SINGLE_POINT;
     static const int THRESHOLD_SHORT_WORD_LENGTH;
+    static const float ADAPTIVE_BEAM_DISTANCE_MARGIN;
+    static const int MIN_ADAPTIVE_BEAM_SIZE;
 
     static const float EXACT_MATCH_PROMOTION;
     static const float CASE_ERROR_PENALTY_FOR_EXACT_MATCH;
@@ -28,7 +28,7 @@ namespace latinime {
 class DicNode;
 class DicTraverseSession;
 
-class TypingScoring : public Scoring {
+class TypingScoring final : public Scoring {
  public:
     static const TypingScoring *getInstance() { return &sInstance; }
 
@@ -36,7 +36,7 @@ class TypingScoring : public Scoring {
             const float languageWeight, SuggestionResults *const outSuggestionResults) const {}
 
     AK_FORCE_INLINE float getAdjustedLanguageWeight(DicTraverseSession *const traverseSession,
-            DicNode *const terminals, const int size) const {
+            const DicNode *const *const terminals, const int size) const {
         return 1.0f;
     }
 
@@ -75,8 +75,10 @@ class TypingScoring : public Scoring {
 
     AK_FORCE_INLINE bool sameAsTyped(const DicTraverseSession *const traverseSession,
             const DicNode *const dicNode) const {
+        int codePoints[MAX_WORD_LENGTH];
+        dicNode->getOutputCodePoints(0 /* start */, dicNode->getNodeCodePointCount(), codePoints);
         return traverseSession->getProximityInfoState(0)->sameAsTyped(
-                dicNode->getOutputWordBuf(), dicNode->getNodeCodePointCount());
+                codePoints, dicNode->getNodeCodePointCount());
     }
 
  private:
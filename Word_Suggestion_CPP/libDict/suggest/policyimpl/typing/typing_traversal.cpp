@@ -16,9 +16,44 @@
 
 #include "typing_traversal.h"
 
+#include <algorithm>
+#include <limits>
+
+#include "../../core/suggest_options.h"
+
 namespace latinime {
 const bool TypingTraversal::CORRECT_OMISSION = true;
 const bool TypingTraversal::CORRECT_NEW_WORD_SPACE_SUBSTITUTION = true;
 const bool TypingTraversal::CORRECT_NEW_WORD_SPACE_OMISSION = true;
 const TypingTraversal TypingTraversal::sInstance;
+
+// Stops the search when the terminal queue is already full of terminals that none of the active
+// dicNodes can beat, as distances never decrease. The language cost of a word is only added at
+// its terminal, so an active dicNode nearly always looks able to beat the terminals and the
+// stop seldom fires. Otherwise expands all the active dicNodes, or
+// with SuggestOptions::useAdaptiveBeam() the ones within ADAPTIVE_BEAM_DISTANCE_MARGIN of the
+// best one, and at least MIN_ADAPTIVE_BEAM_SIZE of them.
+int TypingTraversal::getActiveDicNodeLimit(const DicTraverseSession *const traverseSession) const {
+    const DicNodesCache *const cache = traverseSession->getDicTraverseCache();
+    const int activeSize = cache->activeSize();
+    const float minDistanceKey = cache->getMinActiveDistanceKey(false /* exactMatchesOnly */);
+    const float minExactMatchDistanceKey =
+            cache->getMinActiveDistanceKey(true /* exactMatchesOnly */);
+    // An active exact match still ranks above any terminal that is not one.
+    const bool hasExactMatch =
+            minExactMatchDistanceKey != std::numeric_limits<float>::infinity();
+    const int unbeatableTerminalCount = cache->getTerminalCountCloserThan(
+            hasExactMatch ? -std::numeric_limits<float>::infinity() : minDistanceKey,
+            minExactMatchDistanceKey);
+    if (unbeatableTerminalCount >= cache->getMaxTerminalSize()) {
+        return 0;
+    }
+    if (!traverseSession->getSuggestOptions()->useAdaptiveBeam()
+            || activeSize <= ScoringParams::MIN_ADAPTIVE_BEAM_SIZE) {
+        return activeSize;
+    }
+    const int beamSize = cache->getActiveCountCloserThan(
+            minDistanceKey + DicNode::getDistanceKey(ScoringParams::ADAPTIVE_BEAM_DISTANCE_MARGIN));
+    return std::max(beamSize, ScoringParams::MIN_ADAPTIVE_BEAM_SIZE);
+}
 }  // namespace latinime
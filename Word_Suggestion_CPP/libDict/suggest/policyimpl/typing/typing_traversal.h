@@ -30,7 +30,7 @@
 #include "../../../utils/char_utils.h"
 
 namespace latinime {
-class TypingTraversal : public Traversal {
+class TypingTraversal final : public Traversal {
  public:
     static const TypingTraversal *getInstance() { return &sInstance; }
 
@@ -129,6 +129,18 @@ class TypingTraversal : public Traversal {
                 true /* checkProximityChars */);
     }
 
+    AK_FORCE_INLINE void getProximityTypes(const DicTraverseSession *const traverseSession,
+            const DicNode *const dicNode, DicNodeVector *const childDicNodes, const int start,
+            const int count, ProximityType *const outProximityTypes) const {
+        ASSERT(count <= MAX_PROXIMITY_TYPE_BATCH_SIZE);
+        int codePoints[MAX_PROXIMITY_TYPE_BATCH_SIZE];
+        for (int i = 0; i < count; ++i) {
+            codePoints[i] = (*childDicNodes)[start + i]->getNodeCodePoint();
+        }
+        traverseSession->getProximityInfoState(0)->getProximityTypes(dicNode->getInputIndex(0),
+                codePoints, count, outProximityTypes);
+    }
+
     AK_FORCE_INLINE bool needsToTraverseAllUserInput() const {
         return true;
     }
@@ -150,6 +162,8 @@ class TypingTraversal : public Traversal {
         return MAX_RESULTS;
     }
 
+    int getActiveDicNodeLimit(const DicTraverseSession *const traverseSession) const;
+
     AK_FORCE_INLINE bool isPossibleOmissionChildNode(
             const DicTraverseSession *const traverseSession, const DicNode *const parentDicNode,
             const DicNode *const dicNode) const {
@@ -32,7 +32,7 @@ class DicNode;
 struct DicNode_InputStateG;
 class MultiBigramMap;
 
-class TypingWeighting : public Weighting {
+class TypingWeighting final : public Weighting {
  public:
     static const TypingWeighting *getInstance() { return &sInstance; }
 
@@ -158,9 +158,11 @@ class TypingWeighting : public Weighting {
     float getNewWordBigramLanguageCost(const DicTraverseSession *const traverseSession,
             const DicNode *const dicNode,
             MultiBigramMap *const multiBigramMap) const {
+        const int dictionaryIndex = dicNode->getDictionaryIndex();
         return DicNodeUtils::getBigramNodeImprobability(
-                traverseSession->getDictionaryStructurePolicy(),
-                dicNode, multiBigramMap) * ScoringParams::DISTANCE_WEIGHT_LANGUAGE;
+                traverseSession->getDictionaryStructurePolicy(dictionaryIndex),
+                dicNode, multiBigramMap) * ScoringParams::DISTANCE_WEIGHT_LANGUAGE
+                * traverseSession->getLanguageWeight(dictionaryIndex);
     }
 
     float getCompletionCost(const DicTraverseSession *const traverseSession,
@@ -176,7 +178,8 @@ class TypingWeighting : public Weighting {
 
     float getTerminalLanguageCost(const DicTraverseSession *const traverseSession,
             const DicNode *const dicNode, const float dicNodeLanguageImprobability) const {
-        return dicNodeLanguageImprobability * ScoringParams::DISTANCE_WEIGHT_LANGUAGE;
+        return dicNodeLanguageImprobability * ScoringParams::DISTANCE_WEIGHT_LANGUAGE
+                * traverseSession->getLanguageWeight(dicNode->getDictionaryIndex());
     }
 
     float getTerminalInsertionCost(const DicTraverseSession *const traverseSession,
@@ -206,11 +209,71 @@ class TypingWeighting : public Weighting {
         return cost * traverseSession->getMultiWordCostMultiplier();
     }
 
-    ErrorTypeUtils::ErrorType getErrorType(const CorrectionType correctionType,
-            const DicTraverseSession *const traverseSession,
-            const DicNode *const parentDicNode, const DicNode *const dicNode) const;
+    AK_FORCE_INLINE ErrorTypeUtils::ErrorType getErrorType(const CorrectionType correctionType,
+            const DicTraverseSession *const traverseSession, const DicNode *const parentDicNode,
+            const DicNode *const dicNode) const {
+        switch (correctionType) {
+            case CT_MATCH:
+                if (isProximityDicNode(traverseSession, dicNode)) {
+                    return ErrorTypeUtils::PROXIMITY_CORRECTION;
+                } else if (dicNode->isInDigraph()) {
+                    return ErrorTypeUtils::MATCH_WITH_DIGRAPH;
+                } else {
+                    // Compare the node code point with original primary code point on the keyboard.
+                    const ProximityInfoState *const pInfoState =
+                            traverseSession->getProximityInfoState(0);
+                    const int primaryOriginalCodePoint = pInfoState->getPrimaryOriginalCodePointAt(
+                            dicNode->getInputIndex(0));
+                    const int nodeCodePoint = dicNode->getNodeCodePoint();
+                    if (primaryOriginalCodePoint == nodeCodePoint) {
+                        // Node code point is same as original code point on the keyboard.
+                        return ErrorTypeUtils::NOT_AN_ERROR;
+                    } else if (CharUtils::toLowerCase(primaryOriginalCodePoint) ==
+                            CharUtils::toLowerCase(nodeCodePoint)) {
+                        // Only cases of the code points are different.
+                        return ErrorTypeUtils::MATCH_WITH_CASE_ERROR;
+                    } else if (CharUtils::toBaseCodePoint(primaryOriginalCodePoint) ==
+                            CharUtils::toBaseCodePoint(nodeCodePoint)) {
+                        // Node code point is a variant of original code point.
+                        return ErrorTypeUtils::MATCH_WITH_ACCENT_ERROR;
+                    } else {
+                        // Node code point is a variant of original code point and the cases are
+                        // also different.
+                        return ErrorTypeUtils::MATCH_WITH_ACCENT_ERROR
+                                | ErrorTypeUtils::MATCH_WITH_CASE_ERROR;
+                    }
+                }
+                break;
+            case CT_ADDITIONAL_PROXIMITY:
+                return  ErrorTypeUtils::PROXIMITY_CORRECTION;
+            case CT_OMISSION:
+                if (parentDicNode->canBeIntentionalOmission()) {
+                    return ErrorTypeUtils::INTENTIONAL_OMISSION;
+                } else {
+                    return ErrorTypeUtils::EDIT_CORRECTION;
+                }
+                break;
+            case CT_SUBSTITUTION:
+            case CT_INSERTION:
+            case CT_TERMINAL_INSERTION:
+            case CT_TRANSPOSITION:
+                return ErrorTypeUtils::EDIT_CORRECTION;
+            case CT_NEW_WORD_SPACE_OMISSION:
+            case CT_NEW_WORD_SPACE_SUBSTITUTION:
+                return ErrorTypeUtils::NEW_WORD;
+            case CT_TERMINAL:
+                return ErrorTypeUtils::NOT_AN_ERROR;
+            case CT_COMPLETION:
+                return ErrorTypeUtils::COMPLETION;
+            default:
+                return ErrorTypeUtils::NOT_AN_ERROR;
+        }
+    }
 
  private:
+    // Adds the costs through this class, so that they are inlined in the typing search.
+    friend class Weighting;
+
     DISALLOW_COPY_AND_ASSIGN(TypingWeighting);
     static const TypingWeighting sInstance;
 
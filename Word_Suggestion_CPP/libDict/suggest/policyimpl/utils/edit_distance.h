@@ -18,8 +18,11 @@
 #define LATINIME_EDIT_DISTANCE_H
 
 #include <algorithm>
-#include "edit_distance_policy.h"
+#include <cstdint>
 
+#include "edit_distance_policy.h"
+#include "damerau_levenshtein_edit_distance_policy.h"
+#include "../../../utils/char_utils.h"
 
 namespace latinime {
 
@@ -63,6 +66,95 @@ class EditDistance {
         return dp[(beforeLength + 1) * (afterLength + 1) - 1];
     }
 
+    // Same as getEditDistance() on a DamerauLevenshteinEditDistancePolicy of the strings, without
+    // the table: with unit costs, a column of the table is encoded in the bits of its vertical
+    // differences (Hyyro, 2003), so that each letter of string1 updates it in a few word
+    // operations. Only strings of up to 64 letters fit; longer ones go through the table.
+    static int getDamerauLevenshteinDistance(const int *const string0, const int length0,
+            const int *const string1, const int length1) {
+        return getDamerauLevenshteinDistanceWithin(string0, length0, string1, length1,
+                std::max(length0, length1));
+    }
+
+    // Returns the distance of getDamerauLevenshteinDistance() if it is at most maxDistance, and
+    // maxDistance + 1 otherwise. It stops as soon as the distance is known to exceed maxDistance:
+    // before the first letter if the lengths are too different, otherwise at the first letter of
+    // string1 after which the distance cannot come back down to maxDistance.
+    static int getDamerauLevenshteinDistanceWithin(const int *string0, int length0,
+            const int *string1, int length1, const int maxDistance) {
+        if (length0 > length1) {
+            // The distance is symmetric; the shorter string goes in the bits.
+            std::swap(string0, string1);
+            std::swap(length0, length1);
+        }
+        if (length1 - length0 > maxDistance) {
+            return maxDistance + 1;
+        }
+        if (length0 == 0) {
+            return length1;
+        }
+        if (length0 > MAX_BIT_PARALLEL_LENGTH) {
+            const DamerauLevenshteinEditDistancePolicy policy(string0, length0, string1, length1);
+            return std::min(static_cast<int>(getEditDistance(&policy)), maxDistance + 1);
+        }
+        // The positions of each distinct letter of string0.
+        int letters[MAX_BIT_PARALLEL_LENGTH];
+        uint64_t letterPositions[MAX_BIT_PARALLEL_LENGTH];
+        int letterCount = 0;
+        for (int i = 0; i < length0; ++i) {
+            const int letter = CharUtils::toBaseLowerCase(string0[i]);
+            int k = 0;
+            while (k < letterCount && letters[k] != letter) {
+                ++k;
+            }
+            if (k == letterCount) {
+                letters[letterCount] = letter;
+                letterPositions[letterCount] = 0;
+                ++letterCount;
+            }
+            letterPositions[k] |= static_cast<uint64_t>(1) << i;
+        }
+        const uint64_t lastRow = static_cast<uint64_t>(1) << (length0 - 1);
+        // Bit i of positiveVertical (negativeVertical) is set when the distance goes up (down)
+        // by one from row i to row i + 1 of the column; zeroDiagonal marks the rows whose
+        // distance is the one of the row above in the previous column.
+        uint64_t positiveVertical = ~static_cast<uint64_t>(0);
+        uint64_t negativeVertical = 0;
+        uint64_t zeroDiagonal = 0;
+        uint64_t prevMatches = 0;
+        int distance = length0;
+        for (int j = 0; j < length1; ++j) {
+            const int letter = CharUtils::toBaseLowerCase(string1[j]);
+            uint64_t matches = 0;
+            for (int k = 0; k < letterCount; ++k) {
+                if (letters[k] == letter) {
+                    matches = letterPositions[k];
+                    break;
+                }
+            }
+            const uint64_t transpositions = (((~zeroDiagonal) & matches) << 1) & prevMatches;
+            zeroDiagonal = (((matches & positiveVertical) + positiveVertical) ^ positiveVertical)
+                    | matches | negativeVertical | transpositions;
+            uint64_t positiveHorizontal = negativeVertical | ~(zeroDiagonal | positiveVertical);
+            uint64_t negativeHorizontal = zeroDiagonal & positiveVertical;
+            if (positiveHorizontal & lastRow) {
+                ++distance;
+            } else if (negativeHorizontal & lastRow) {
+                --distance;
+            }
+            // Each remaining letter lowers the distance by one at most.
+            if (distance - (length1 - j - 1) > maxDistance) {
+                return maxDistance + 1;
+            }
+            positiveHorizontal = (positiveHorizontal << 1) | 1;
+            negativeHorizontal <<= 1;
+            positiveVertical = negativeHorizontal | ~(zeroDiagonal | positiveHorizontal);
+            negativeVertical = positiveHorizontal & zeroDiagonal;
+            prevMatches = matches;
+        }
+        return distance;
+    }
+
     AK_FORCE_INLINE static void dumpEditDistance10ForDebug(const float *const editDistanceTable,
             const int editDistanceTableWidth, const int outputLength) {
         if (DEBUG_DICT) {
@@ -85,6 +177,8 @@ class EditDistance {
 
  private:
     DISALLOW_IMPLICIT_CONSTRUCTORS(EditDistance);
+
+    static const int MAX_BIT_PARALLEL_LENGTH = 64;
 };
 } // namespace latinime
 
@@ -21,7 +21,6 @@
 
 #include "../defines.h"
 #include "../suggest/policyimpl/utils/edit_distance.h"
-#include "../suggest/policyimpl/utils/damerau_levenshtein_edit_distance_policy.h"
 
 namespace latinime {
 
@@ -31,9 +30,7 @@ const int AutocorrectionThresholdUtils::FULL_WORD_MULTIPLIER = 2;
 
 /* static */ int AutocorrectionThresholdUtils::editDistance(const int *before,
         const int beforeLength, const int *after, const int afterLength) {
-    const DamerauLevenshteinEditDistancePolicy daemaruLevenshtein(
-            before, beforeLength, after, afterLength);
-    return static_cast<int>(EditDistance::getEditDistance(&daemaruLevenshtein));
+    return EditDistance::getDamerauLevenshteinDistance(before, beforeLength, after, afterLength);
 }
 
 // In dictionary.cpp, getSuggestion() method,
@@ -72,7 +69,9 @@ const int AutocorrectionThresholdUtils::FULL_WORD_MULTIPLIER = 2;
     if (0 == beforeLength || 0 == afterLength) {
         return 0.0f;
     }
-    const int distance = editDistance(before, beforeLength, after, afterLength);
+    // Any distance from afterLength up gives 0.0f below, so the distance is only needed under it.
+    const int distance = EditDistance::getDamerauLevenshteinDistanceWithin(before, beforeLength,
+            after, afterLength, afterLength - 1 /* maxDistance */);
     int spaceCount = 0;
     for (int i = 0; i < afterLength; ++i) {
         if (after[i] == KEYCODE_SPACE) {
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_CODE_POINT_MAP_H
+#define LATINIME_CODE_POINT_MAP_H
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "../defines.h"
+
+namespace latinime {
+
+/**
+ * Map from code points to small values, built once and then read on hot paths.
+ *
+ * The Basic Multilingual Plane is split into 128 code point blocks, which line up with the
+ * Unicode blocks of the scripts keyboards cover (Basic Latin, Latin-1, Devanagari, Bengali,
+ * Gurmukhi, ...). Each block that has an entry gets a dense array of values; all other blocks
+ * share one array filled with the default value, so a lookup is two array reads with no
+ * branches on the block. Code points outside the BMP (emoji) go to a single sorted fallback
+ * list.
+ *
+ * Not thread-safe for writing; concurrent reads of a map that is no longer written are fine.
+ */
+template<typename T>
+class CodePointMap {
+ public:
+    explicit CodePointMap(const T defaultValue)
+            : mDefaultValue(defaultValue), mBlocks(BLOCK_SIZE, defaultValue), mFallback() {
+        std::fill(mBlockIndices, mBlockIndices + BLOCK_COUNT, 0);
+    }
+
+    AK_FORCE_INLINE T get(const int codePoint) const {
+        if (static_cast<unsigned int>(codePoint) < static_cast<unsigned int>(DENSE_LIMIT)) {
+            return mBlocks[mBlockIndices[codePoint >> BLOCK_SHIFT] * BLOCK_SIZE
+                    + (codePoint & BLOCK_MASK)];
+        }
+        return getFromFallback(codePoint);
+    }
+
+    // Overwrites any value already stored for codePoint. Returns false when the map has run out
+    // of dense blocks, in which case the entry is not stored.
+    bool put(const int codePoint, const T value) {
+        if (static_cast<unsigned int>(codePoint) >= static_cast<unsigned int>(DENSE_LIMIT)) {
+            putToFallback(codePoint, value);
+            return true;
+        }
+        const int blockId = codePoint >> BLOCK_SHIFT;
+        if (mBlockIndices[blockId] == 0) {
+            const int blockIndex = static_cast<int>(mBlocks.size()) / BLOCK_SIZE;
+            if (blockIndex > MAX_BLOCK_INDEX) {
+                AKLOGE("CodePointMap: too many blocks for code point %x", codePoint);
+                return false;
+            }
+            mBlocks.resize(mBlocks.size() + BLOCK_SIZE, mDefaultValue);
+            mBlockIndices[blockId] = static_cast<uint8_t>(blockIndex);
+        }
+        mBlocks[mBlockIndices[blockId] * BLOCK_SIZE + (codePoint & BLOCK_MASK)] = value;
+        return true;
+    }
+
+    // Number of dense blocks in use, not counting the shared default block.
+    int getBlockCount() const {
+        return static_cast<int>(mBlocks.size()) / BLOCK_SIZE - 1;
+    }
+
+ private:
+    typedef std::pair<int, T> FallbackEntry;
+
+    static const int BLOCK_SHIFT = 7;
+    static const int BLOCK_SIZE = 1 << BLOCK_SHIFT;
+    static const int BLOCK_MASK = BLOCK_SIZE - 1;
+    static const int DENSE_LIMIT = 0x10000;
+    static const int BLOCK_COUNT = DENSE_LIMIT >> BLOCK_SHIFT;
+    static const int MAX_BLOCK_INDEX = UINT8_MAX;
+
+    static bool compareFallbackEntries(const FallbackEntry &left, const FallbackEntry &right) {
+        return left.first < right.first;
+    }
+
+    T getFromFallback(const int codePoint) const {
+        const typename std::vector<FallbackEntry>::const_iterator it = std::lower_bound(
+                mFallback.begin(), mFallback.end(), FallbackEntry(codePoint, mDefaultValue),
+                compareFallbackEntries);
+        if (it != mFallback.end() && it->first == codePoint) {
+            return it->second;
+        }
+        return mDefaultValue;
+    }
+
+    void putToFallback(const int codePoint, const T value) {
+        const FallbackEntry entry(codePoint, value);
+        const typename std::vector<FallbackEntry>::iterator it = std::lower_bound(
+                mFallback.begin(), mFallback.end(), entry, compareFallbackEntries);
+        if (it != mFallback.end() && it->first == codePoint) {
+            it->second = value;
+        } else {
+            mFallback.insert(it, entry);
+        }
+    }
+
+    const T mDefaultValue;
+    // Index of the dense array for each BMP block; 0 is the shared array of default values.
+    uint8_t mBlockIndices[BLOCK_COUNT];
+    std::vector<T> mBlocks;
+    std::vector<FallbackEntry> mFallback;
+};
+} // namespace latinime
+#endif // LATINIME_CODE_POINT_MAP_H
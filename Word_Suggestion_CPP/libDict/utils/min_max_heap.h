@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_MIN_MAX_HEAP_H
+#define LATINIME_MIN_MAX_HEAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "../defines.h"
+
+namespace latinime {
+
+/**
+ * Double-ended priority queue (Atkinson et al. min-max heap) giving access to both its least
+ * and its greatest entry. Entries on even levels are not greater than their descendants and
+ * entries on odd levels are not less than them, so the least entry is the root and the
+ * greatest one is a child of it. Push and both pops take O(log n) comparisons.
+ *
+ * less(a, b) must be a strict weak ordering. Entries are meant to be small handles; storage only
+ * grows past what has been reserved, so a heap reserved to its bound never allocates.
+ */
+template<typename T, typename Less>
+class MinMaxHeap {
+ public:
+    explicit MinMaxHeap(const Less &less)
+            : mLess(less), mEntries(), mMaxIndex(UNKNOWN_INDEX) {}
+
+    AK_FORCE_INLINE size_t size() const { return mEntries.size(); }
+    AK_FORCE_INLINE bool empty() const { return mEntries.empty(); }
+    AK_FORCE_INLINE void clear() {
+        mEntries.clear();
+        mMaxIndex = UNKNOWN_INDEX;
+    }
+    void reserve(const size_t capacity) { mEntries.reserve(capacity); }
+    size_t capacity() const { return mEntries.capacity(); }
+
+    // Entries in heap order, for visiting all of them; index must be less than size().
+    AK_FORCE_INLINE const T &getEntry(const size_t index) const {
+        return mEntries[index];
+    }
+
+    // Must not be called on an empty heap.
+    AK_FORCE_INLINE const T &getMin() const {
+        return mEntries[0];
+    }
+
+    // Must not be called on an empty heap.
+    AK_FORCE_INLINE const T &getMax() const {
+        return mEntries[getMaxIndex()];
+    }
+
+    AK_FORCE_INLINE void push(const T &entry) {
+        mEntries.push_back(entry);
+        bubbleUp(mEntries.size() - 1);
+        mMaxIndex = UNKNOWN_INDEX;
+    }
+
+    // Must not be called on an empty heap.
+    AK_FORCE_INLINE void popMin() {
+        removeAt(0);
+    }
+
+    // Must not be called on an empty heap.
+    AK_FORCE_INLINE void popMax() {
+        removeAt(getMaxIndex());
+    }
+
+    // Same as popMax() followed by push(entry), in one pass. Must not be called on an empty
+    // heap.
+    AK_FORCE_INLINE void replaceMax(const T &entry) {
+        fillHole(getMaxIndex(), entry);
+    }
+
+    // Sorts the entries in place from the least to the greatest and returns them, size() of
+    // them. The heap is consumed: it must be cleared before it is pushed to or popped from.
+    const T *sortAndGetEntries() {
+        std::sort(mEntries.begin(), mEntries.end(), mLess);
+        mMaxIndex = UNKNOWN_INDEX;
+        return mEntries.data();
+    }
+
+ private:
+    DISALLOW_IMPLICIT_CONSTRUCTORS(MinMaxHeap);
+
+    static const size_t UNKNOWN_INDEX = static_cast<size_t>(-1);
+
+    const Less mLess;
+    std::vector<T> mEntries;
+    // Where the greatest entry is, found on demand and kept until the next change: getMax() is
+    // often called repeatedly in between, and before popMax() or replaceMax().
+    mutable size_t mMaxIndex;
+
+    AK_FORCE_INLINE static bool isOnMinLevel(size_t index) {
+        bool isMinLevel = true;
+        for (++index; index > 1; index >>= 1) {
+            isMinLevel = !isMinLevel;
+        }
+        return isMinLevel;
+    }
+
+    // Whether left belongs above right on a level of the given kind.
+    template<bool IS_MIN_LEVEL>
+    AK_FORCE_INLINE bool isPreferred(const T &left, const T &right) const {
+        return IS_MIN_LEVEL ? mLess(left, right) : mLess(right, left);
+    }
+
+    AK_FORCE_INLINE size_t getMaxIndex() const {
+        if (mMaxIndex == UNKNOWN_INDEX) {
+            const size_t size = mEntries.size();
+            if (size <= 2) {
+                mMaxIndex = size - 1;
+            } else {
+                mMaxIndex = mLess(mEntries[1], mEntries[2]) ? 2 : 1;
+            }
+        }
+        return mMaxIndex;
+    }
+
+    AK_FORCE_INLINE void removeAt(const size_t index) {
+        const size_t lastIndex = mEntries.size() - 1;
+        if (index == lastIndex) {
+            mEntries.pop_back();
+            mMaxIndex = UNKNOWN_INDEX;
+            return;
+        }
+        const T last = mEntries[lastIndex];
+        mEntries.pop_back();
+        fillHole(index, last);
+    }
+
+    // Puts entry in place of the one at index. The hole first sinks to a leaf, each step pulling
+    // up the entry that belongs there, and entry is then bubbled up from that leaf. Entries
+    // put back mostly belong near the leaves, so this takes about half the comparisons of
+    // sinking them from the top.
+    AK_FORCE_INLINE void fillHole(size_t index, const T &entry) {
+        index = isOnMinLevel(index) ? sinkHole<true>(index) : sinkHole<false>(index);
+        mEntries[index] = entry;
+        bubbleUp(index);
+        mMaxIndex = UNKNOWN_INDEX;
+    }
+
+    // Moves a hole on a level of the given kind down to a leaf and returns where it ends. The
+    // entries pulled up keep the heap valid everywhere but at the hole.
+    template<bool IS_MIN_LEVEL>
+    size_t sinkHole(size_t hole) {
+        const size_t size = mEntries.size();
+        while (true) {
+            const size_t firstChild = 2 * hole + 1;
+            if (firstChild >= size) {
+                return hole;
+            }
+            const size_t firstGrandchild = 2 * firstChild + 1;
+            size_t preferred = firstChild;
+            if (firstGrandchild < size) {
+                // A child with children of its own never belongs above all of them, so only
+                // the grandchildren and a second child without children are candidates.
+                preferred = firstGrandchild;
+                const size_t grandchildEnd = std::min(firstGrandchild + 4, size);
+                for (size_t i = firstGrandchild + 1; i < grandchildEnd; ++i) {
+                    preferred = isPreferred<IS_MIN_LEVEL>(mEntries[i], mEntries[preferred])
+                            ? i : preferred;
+                }
+                const size_t secondChild = firstChild + 1;
+                if (firstGrandchild + 2 >= size
+                        && isPreferred<IS_MIN_LEVEL>(mEntries[secondChild], mEntries[preferred])) {
+                    preferred = secondChild;
+                }
+            } else if (firstChild + 1 < size
+                    && isPreferred<IS_MIN_LEVEL>(mEntries[firstChild + 1], mEntries[firstChild])) {
+                preferred = firstChild + 1;
+            }
+            mEntries[hole] = mEntries[preferred];
+            hole = preferred;
+            if (preferred < firstGrandchild) {
+                // Children picked here have no children.
+                return hole;
+            }
+        }
+    }
+
+    void bubbleUp(const size_t index) {
+        if (isOnMinLevel(index)) {
+            bubbleUp<true>(index);
+        } else {
+            bubbleUp<false>(index);
+        }
+    }
+
+    template<bool IS_MIN_LEVEL>
+    AK_FORCE_INLINE void bubbleUp(size_t index) {
+        if (index == 0) {
+            return;
+        }
+        // The parent is on the other kind of level; cross over when the entry belongs there.
+        const size_t parent = (index - 1) / 2;
+        if (isPreferred<!IS_MIN_LEVEL>(mEntries[index], mEntries[parent])) {
+            std::swap(mEntries[index], mEntries[parent]);
+            bubbleUpToGrandparents<!IS_MIN_LEVEL>(parent);
+        } else {
+            bubbleUpToGrandparents<IS_MIN_LEVEL>(index);
+        }
+    }
+
+    template<bool IS_MIN_LEVEL>
+    AK_FORCE_INLINE void bubbleUpToGrandparents(size_t index) {
+        const T entry = mEntries[index];
+        while (index >= 3) {
+            const size_t grandparent = ((index - 1) / 2 - 1) / 2;
+            if (!isPreferred<IS_MIN_LEVEL>(entry, mEntries[grandparent])) {
+                break;
+            }
+            mEntries[index] = mEntries[grandparent];
+            index = grandparent;
+        }
+        mEntries[index] = entry;
+    }
+};
+} // namespace latinime
+#endif // LATINIME_MIN_MAX_HEAP_H
@@ -20,22 +20,25 @@
 
 namespace latinime {
 
-int TimeKeeper::sCurrentTime;
-bool TimeKeeper::sSetForTesting;
+thread_local int TimeKeeper::sCurrentTime = 0;
+std::atomic<bool> TimeKeeper::sSetForTesting(false);
+std::atomic<int> TimeKeeper::sForcedCurrentTime(0);
 
 /* static  */ void TimeKeeper::setCurrentTime() {
-    if (!sSetForTesting) {
-        sCurrentTime = time(0);
-    }
+    sCurrentTime = time(0);
 }
 
-/* static */ void TimeKeeper::startTestModeWithForceCurrentTime(const int currentTime) {
+/* static */ void TimeKeeper::setCurrentTime(const int currentTime) {
     sCurrentTime = currentTime;
-    sSetForTesting = true;
+}
+
+/* static */ void TimeKeeper::startTestModeWithForceCurrentTime(const int currentTime) {
+    sForcedCurrentTime.store(currentTime, std::memory_order_relaxed);
+    sSetForTesting.store(true, std::memory_order_relaxed);
 }
 
 /* static */ void TimeKeeper::stopTestMode() {
-    sSetForTesting = false;
+    sSetForTesting.store(false, std::memory_order_relaxed);
 }
 
 } // namespace latinime
@@ -17,25 +17,37 @@
 #ifndef LATINIME_TIME_KEEPER_H
 #define LATINIME_TIME_KEEPER_H
 
+#include <atomic>
+
 #include "../defines.h"
 
 namespace latinime {
 
+// The current time is captured per thread at the start of each dictionary operation, so that
+// concurrent queries on different threads neither race on nor observe each other's timestamp.
 class TimeKeeper {
  public:
     static void setCurrentTime();
 
+    // Sets the current time of the calling thread to one captured on another thread, for work
+    // done on behalf of the operation running there.
+    static void setCurrentTime(const int currentTime);
+
     static void startTestModeWithForceCurrentTime(const int currentTime);
 
     static void stopTestMode();
 
-    static int peekCurrentTime() { return sCurrentTime; };
+    static int peekCurrentTime() {
+        return sSetForTesting.load(std::memory_order_relaxed) ?
+                sForcedCurrentTime.load(std::memory_order_relaxed) : sCurrentTime;
+    };
 
  private:
     DISALLOW_IMPLICIT_CONSTRUCTORS(TimeKeeper);
 
-    static int sCurrentTime;
-    static bool sSetForTesting;
+    static thread_local int sCurrentTime;
+    static std::atomic<bool> sSetForTesting;
+    static std::atomic<int> sForcedCurrentTime;
 };
 } // namespace latinime
 #endif /* LATINIME_TIME_KEEPER_H */
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "work_stealing_pool.h"
+
+namespace latinime {
+
+WorkStealingPool::WorkStealingPool(const int threadCount)
+        : mThreads(), mTaskRanges(new TaskRange[threadCount > 1 ? threadCount : 1]), mMutex(),
+          mBatchStartedCondition(), mBatchDoneCondition(), mTaskCaller(nullptr), mTask(nullptr),
+          mBatchOrdinal(0), mBusyThreadCount(0), mIsStopping(false) {
+    for (int threadIndex = 1; threadIndex < threadCount; ++threadIndex) {
+        mThreads.emplace_back(&WorkStealingPool::waitAndRunBatches, this, threadIndex);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mIsStopping = true;
+    }
+    mBatchStartedCondition.notify_all();
+    for (std::thread &thread : mThreads) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::runBatch(const int taskCount, const TaskCaller taskCaller,
+        const void *const task) {
+    const int threadCount = getThreadCount();
+    // The other threads are all waiting for the batch, so the shares need no locking here.
+    for (int threadIndex = 0; threadIndex < threadCount; ++threadIndex) {
+        mTaskRanges[threadIndex].mBegin = taskCount * threadIndex / threadCount;
+        mTaskRanges[threadIndex].mEnd = taskCount * (threadIndex + 1) / threadCount;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTaskCaller = taskCaller;
+        mTask = task;
+        mBusyThreadCount = threadCount - 1;
+        mBatchOrdinal++;
+    }
+    mBatchStartedCondition.notify_all();
+    runTasks(0 /* threadIndex */);
+    std::unique_lock<std::mutex> lock(mMutex);
+    mBatchDoneCondition.wait(lock, [this] { return mBusyThreadCount == 0; });
+    mTaskCaller = nullptr;
+    mTask = nullptr;
+}
+
+void WorkStealingPool::waitAndRunBatches(const int threadIndex) {
+    uint64_t batchOrdinal = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mBatchStartedCondition.wait(lock, [this, batchOrdinal] {
+                return mIsStopping || mBatchOrdinal != batchOrdinal;
+            });
+            if (mIsStopping) {
+                return;
+            }
+            batchOrdinal = mBatchOrdinal;
+        }
+        runTasks(threadIndex);
+        bool isBatchDone = false;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mBusyThreadCount--;
+            isBatchDone = mBusyThreadCount == 0;
+        }
+        if (isBatchDone) {
+            mBatchDoneCondition.notify_one();
+        }
+    }
+}
+
+void WorkStealingPool::runTasks(const int threadIndex) {
+    int taskIndex = 0;
+    while (takeTask(threadIndex, &taskIndex)) {
+        mTaskCaller(mTask, taskIndex, threadIndex);
+    }
+}
+
+bool WorkStealingPool::takeTask(const int threadIndex, int *const outTaskIndex) {
+    {
+        TaskRange *const ownRange = &mTaskRanges[threadIndex];
+        std::lock_guard<std::mutex> lock(ownRange->mMutex);
+        if (ownRange->mBegin < ownRange->mEnd) {
+            *outTaskIndex = ownRange->mBegin++;
+            return true;
+        }
+    }
+    const int threadCount = getThreadCount();
+    for (int i = 1; i < threadCount; ++i) {
+        TaskRange *const victimRange = &mTaskRanges[(threadIndex + i) % threadCount];
+        std::lock_guard<std::mutex> lock(victimRange->mMutex);
+        if (victimRange->mBegin < victimRange->mEnd) {
+            *outTaskIndex = --victimRange->mEnd;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace latinime
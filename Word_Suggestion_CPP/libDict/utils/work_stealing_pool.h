@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATINIME_WORK_STEALING_POOL_H
+#define LATINIME_WORK_STEALING_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../defines.h"
+
+namespace latinime {
+
+/**
+ * Fixed set of threads running batches of indexed tasks. The thread calling run() takes part as
+ * thread 0 and the pool keeps threadCount - 1 threads of its own waiting for the next batch.
+ *
+ * Each thread starts on an even share of the task indices, taken from the front. A thread done
+ * with its share takes tasks from the back of the share of another thread, so tasks of uneven
+ * cost still keep all threads busy until the batch is nearly done.
+ */
+class WorkStealingPool {
+ public:
+    explicit WorkStealingPool(const int threadCount);
+    ~WorkStealingPool();
+
+    int getThreadCount() const {
+        return static_cast<int>(mThreads.size()) + 1;
+    }
+
+    // Calls task(taskIndex, threadIndex) once for every task index in [0, taskCount), on any of
+    // the threads, and returns once all the calls have returned. Calls on the same thread do not
+    // overlap, so state indexed by threadIndex needs no locking. Only one run() may be in
+    // progress at a time. The threads call task through a pointer to it, so that running a
+    // batch allocates nothing whatever task captures.
+    template<class Task>
+    void run(const int taskCount, const Task &task) {
+        runBatch(taskCount, &callTask<Task>, &task);
+    }
+
+ private:
+    DISALLOW_IMPLICIT_CONSTRUCTORS(WorkStealingPool);
+
+    typedef void (*TaskCaller)(const void *const task, const int taskIndex,
+            const int threadIndex);
+
+    template<class Task>
+    static void callTask(const void *const task, const int taskIndex, const int threadIndex) {
+        (*static_cast<const Task *>(task))(taskIndex, threadIndex);
+    }
+
+    // Task indices [mBegin, mEnd) not taken yet from the share of a thread.
+    class TaskRange {
+     public:
+        TaskRange() : mMutex(), mBegin(0), mEnd(0) {}
+
+        std::mutex mMutex;
+        int mBegin;
+        int mEnd;
+
+     private:
+        DISALLOW_COPY_AND_ASSIGN(TaskRange);
+    };
+
+    void runBatch(const int taskCount, const TaskCaller taskCaller, const void *const task);
+    void waitAndRunBatches(const int threadIndex);
+    void runTasks(const int threadIndex);
+    bool takeTask(const int threadIndex, int *const outTaskIndex);
+
+    std::vector<std::thread> mThreads;
+    std::unique_ptr<TaskRange[]> mTaskRanges;
+    std::mutex mMutex;
+    std::condition_variable mBatchStartedCondition;
+    std::condition_variable mBatchDoneCondition;
+    // The following are guarded by mMutex.
+    TaskCaller mTaskCaller;
+    const void *mTask;
+    uint64_t mBatchOrdinal;
+    int mBusyThreadCount;
+    bool mIsStopping;
+};
+} // namespace latinime
+#endif // LATINIME_WORK_STEALING_POOL_H
@@ -0,0 +1,165 @@
+//
+// Checks that a search resuming from the checkpoints of the queries before it gives the
+// suggestions of a search from the root.
+//
+// Usage: checkpointResumeTest <dictionary> <layout directory>
+//
+// Each word of a fixed list is typed one code point at a time on a ComposingSession, backspaced
+// down to one code point, retyped, and edited in its middle, asking for suggestions after every
+// keystroke. Every suggestion list, scores included, must match the one of a session that types
+// the same input from scratch. That is checked for several checkpoint counts: with 0 no search
+// may resume, with 1 only appends, and with more backspaces as well. Exits with 1 on any
+// failure, and with 77, which ctest reports as skipped, when the dictionary or the layout
+// directory cannot be read.
+//
+
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ComposingSession.h"
+
+namespace {
+
+const int SKIPPED_EXIT_CODE = 77;
+
+// Typed words, with typos, long enough for backspaces to resume from a checkpoint.
+const char *const WORDS[] = {
+        "the", "thsi", "people", "tonigth", "beautful", "togehter", "experiance", "definitely",
+        "understanding", "responsibility",
+};
+
+bool isReadable(const char *path, const bool isDirectory) {
+    struct stat status;
+    return stat(path, &status) == 0 && S_ISDIR(status.st_mode) == isDirectory
+            && access(path, R_OK) == 0;
+}
+
+bool isSameResult(const SuggestionProvider::SuggestionBuffer &left,
+                  const SuggestionProvider::SuggestionBuffer &right) {
+    if (left.count != right.count) {
+        return false;
+    }
+    for (int index = 0; index < left.count; index++) {
+        if (strcmp(left.suggestions[index].utf8, right.suggestions[index].utf8) != 0
+            || left.suggestions[index].score != right.suggestions[index].score) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Queries and resumed queries of one kind of keystroke.
+class Scenario {
+public:
+    explicit Scenario(const char *name) : name(name) {}
+
+    const char *name;
+    int queryCount = 0;
+    int continuedCount = 0;
+    int mismatches = 0;
+};
+
+// Asks incremental for suggestions on its word as it is, and scratch for the same word typed
+// again after a reset, which restarts its search at the root.
+void check(ComposingSession *incremental, ComposingSession *scratch, Scenario *scenario) {
+    SuggestionProvider::SuggestionBuffer incrementalResult;
+    SuggestionProvider::SuggestionBuffer scratchResult;
+    QueryStats incrementalStats;
+    QueryStats scratchStats;
+    incremental->getSuggestions(&incrementalResult, &incrementalStats);
+    scratch->reset();
+    for (int index = 0; index < incremental->getInputSize(); index++) {
+        scratch->appendCodePoint(incremental->getInputCodePoints()[index]);
+    }
+    scratch->getSuggestions(&scratchResult, &scratchStats);
+
+    scenario->queryCount++;
+    if (incrementalStats.isContinuedSearch) {
+        scenario->continuedCount++;
+    }
+    if (scratchStats.isContinuedSearch || !isSameResult(incrementalResult, scratchResult)) {
+        if (scenario->mismatches++ < 10) {
+            // The words are ASCII.
+            const std::string typed(incremental->getInputCodePoints(),
+                                    incremental->getInputCodePoints()
+                                    + incremental->getInputSize());
+            fprintf(stderr, "%s: \"%s\" differs from a search from the root\n", scenario->name,
+                    typed.c_str());
+        }
+    }
+}
+
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <dictionary> <layout directory>\n", argv[0]);
+        return 1;
+    }
+    if (!isReadable(argv[1], false /* isDirectory */) || !isReadable(argv[2], true)) {
+        printf("skipped: cannot read %s or %s\n", argv[1], argv[2]);
+        return SKIPPED_EXIT_CODE;
+    }
+    SuggestionProvider provider(argv[1], std::string(argv[2]));
+
+    int failureCount = 0;
+    for (const int checkpointCount : {0, 1, 2, 8}) {
+        provider.setMaxCheckpointCount(checkpointCount);
+        ComposingSession incremental(&provider);
+        ComposingSession scratch(&provider);
+        Scenario type("type");
+        Scenario backspace("backspace");
+        Scenario retype("retype");
+        Scenario edit("edit");
+        for (const char *word : WORDS) {
+            const int length = (int) strlen(word);
+            incremental.reset();
+            for (int index = 0; index < length; index++) {
+                incremental.appendCodePoint(word[index]);
+                check(&incremental, &scratch, &type);
+            }
+            while (incremental.getInputSize() > 1) {
+                incremental.deleteLast();
+                check(&incremental, &scratch, &backspace);
+            }
+            for (int index = 1; index < length; index++) {
+                incremental.appendCodePoint(word[index]);
+                check(&incremental, &scratch, &retype);
+            }
+            // Changes the code point in the middle of the word, then changes it back.
+            const int middle = length / 2;
+            incremental.deleteCodePoint(middle);
+            incremental.insertCodePoint(middle, word[middle] == 'z' ? 'a' : word[middle] + 1);
+            check(&incremental, &scratch, &edit);
+            incremental.deleteCodePoint(middle);
+            incremental.insertCodePoint(middle, word[middle]);
+            check(&incremental, &scratch, &edit);
+        }
+
+        for (const Scenario *scenario : {&type, &backspace, &retype, &edit}) {
+            printf("%d checkpoints, %-9s: %3d queries, %3d continued, %d mismatches\n",
+                   checkpointCount, scenario->name, scenario->queryCount,
+                   scenario->continuedCount, scenario->mismatches);
+            failureCount += scenario->mismatches;
+        }
+        // Without checkpoints every search starts at the root. One checkpoint, the last step,
+        // only serves appends; a stack of them lets backspaces resume too.
+        const bool isResumeCountRight = checkpointCount == 0
+                ? type.continuedCount + backspace.continuedCount + retype.continuedCount
+                  + edit.continuedCount == 0
+                : type.continuedCount > 0 && retype.continuedCount > 0
+                  && (checkpointCount == 1 ? backspace.continuedCount == 0
+                                           : backspace.continuedCount > 0);
+        if (!isResumeCountRight) {
+            fprintf(stderr, "%d checkpoints: unexpected number of continued searches\n",
+                    checkpointCount);
+            failureCount++;
+        }
+    }
+    return failureCount == 0 ? 0 : 1;
+}
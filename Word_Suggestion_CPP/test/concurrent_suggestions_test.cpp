@@ -0,0 +1,168 @@
+//
+// Checks that queries running at once on one SuggestionProvider give the same suggestions as the
+// same queries run one at a time.
+//
+// Usage: concurrentSuggestionsTest <dictionary> <pairs file> <layout directory>
+//                                  [thread count=4] [pair count=100]
+//
+// The first pairs of the pairs file (see replayBenchmark) are replayed keystroke by keystroke on
+// one thread, then on every thread at once, each thread starting at another pair, on a provider
+// with an unbounded session pool. Every suggestion list, scores included, must match the one of
+// the serial run. Exits with 1 on any mismatch, and with 77, which ctest reports as skipped, when
+// the dictionary, the pairs file or the layout directory cannot be read.
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "SuggestionProvider.h"
+#include "libDict/suggest/core/session/prev_words_info.h"
+#include "libDict/suggest/core/suggest_options.h"
+
+namespace {
+
+const int SUGGESTION_COUNT = 5;
+const int SKIPPED_EXIT_CODE = 77;
+
+class Pair {
+public:
+    std::vector<int> prevWord;
+    std::vector<int> typedWord;
+};
+
+// Pairs of the pairs file, ASCII only.
+std::vector<Pair> readPairs(const char *path, int maxCount) {
+    std::vector<Pair> pairs;
+    std::ifstream in(path);
+    std::string line;
+    while ((int) pairs.size() < maxCount && std::getline(in, line)) {
+        const size_t tab = line.find('\t');
+        if (tab == std::string::npos) {
+            continue;
+        }
+        const std::string prevWord = line.substr(0, tab);
+        const std::string typedWord = line.substr(tab + 1);
+        if (typedWord.empty() || typedWord.size() > MAX_WORD_LENGTH
+            || prevWord.size() > MAX_WORD_LENGTH
+            || std::any_of(line.begin(), line.end(), [](char c) { return c & 0x80; })) {
+            continue;
+        }
+        Pair pair;
+        pair.prevWord.assign(prevWord.begin(), prevWord.end());
+        pair.typedWord.assign(typedWord.begin(), typedWord.end());
+        pairs.push_back(pair);
+    }
+    return pairs;
+}
+
+// The suggestions of a query: each word followed by its score.
+typedef std::vector<std::string> Result;
+
+Result toResult(const SuggestionProvider::SuggestionBuffer &buffer) {
+    Result result;
+    for (int i = 0; i < buffer.count; i++) {
+        result.push_back(std::string(buffer.suggestions[i].utf8) + " "
+                         + std::to_string(buffer.suggestions[i].score));
+    }
+    return result;
+}
+
+std::string toString(const Result &result) {
+    std::string text;
+    for (const std::string &suggestion : result) {
+        text += (text.empty() ? "" : ", ") + suggestion;
+    }
+    return text;
+}
+
+bool isReadable(const char *path, const bool isDirectory) {
+    struct stat status;
+    return stat(path, &status) == 0 && S_ISDIR(status.st_mode) == isDirectory
+            && access(path, R_OK) == 0;
+}
+
+// Replays the pairs from firstPair on, wrapping around: every prefix of the typed word, then the
+// predictions after the previous word. Results are given in the order of the pairs.
+std::vector<Result> replay(SuggestionProvider *provider, std::vector<Pair> &pairs,
+                           int firstPair) {
+    SuggestOptions suggestOptions(nullptr, 0);
+    SuggestionProvider::SuggestionBuffer buffer;
+    std::vector<std::vector<Result>> resultsByPair(pairs.size());
+    for (size_t i = 0; i < pairs.size(); i++) {
+        const size_t pairIndex = (firstPair + i) % pairs.size();
+        Pair &pair = pairs[pairIndex];
+        PrevWordsInfo prevWordsInfo(pair.prevWord.data(), (int) pair.prevWord.size(),
+                                    false /* isBeginningOfSentence */);
+        for (int length = 1; length <= (int) pair.typedWord.size(); length++) {
+            provider->getSuggestions(SUGGESTION_COUNT, pair.typedWord.data(), length,
+                                     &prevWordsInfo, &suggestOptions, &buffer);
+            resultsByPair[pairIndex].push_back(toResult(buffer));
+        }
+        provider->getEmptySuggestions(SUGGESTION_COUNT, &prevWordsInfo, &buffer);
+        resultsByPair[pairIndex].push_back(toResult(buffer));
+    }
+    std::vector<Result> results;
+    for (const std::vector<Result> &pairResults : resultsByPair) {
+        results.insert(results.end(), pairResults.begin(), pairResults.end());
+    }
+    return results;
+}
+
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        fprintf(stderr, "usage: %s <dictionary> <pairs file> <layout directory> "
+                        "[thread count] [pair count]\n", argv[0]);
+        return 1;
+    }
+    for (int arg = 1; arg <= 3; arg++) {
+        if (!isReadable(argv[arg], arg == 3 /* isDirectory */)) {
+            printf("skipped: cannot read %s\n", argv[arg]);
+            return SKIPPED_EXIT_CODE;
+        }
+    }
+    const int threadCount = argc > 4 ? atoi(argv[4]) : 4;
+    std::vector<Pair> pairs = readPairs(argv[2], argc > 5 ? atoi(argv[5]) : 100);
+    if (pairs.empty() || threadCount < 1) {
+        fprintf(stderr, "no pairs read from %s\n", argv[2]);
+        return 1;
+    }
+    SuggestionProvider provider(argv[1], argv[3], 0 /* maxSessionCount */);
+
+    const std::vector<Result> expected = replay(&provider, pairs, 0);
+    std::vector<std::vector<Result>> results(threadCount);
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < threadCount; thread++) {
+        threads.emplace_back([&, thread]() {
+            results[thread] = replay(&provider, pairs, (int) (thread * pairs.size() / threadCount));
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    int mismatchCount = 0;
+    for (int thread = 0; thread < threadCount; thread++) {
+        for (size_t query = 0; query < expected.size(); query++) {
+            if (results[thread][query] != expected[query]) {
+                if (mismatchCount++ < 10) {
+                    fprintf(stderr, "thread %d, query %zu: [%s] instead of [%s]\n", thread,
+                            query, toString(results[thread][query]).c_str(),
+                            toString(expected[query]).c_str());
+                }
+            }
+        }
+    }
+    printf("%d threads, %zu queries each, %d mismatches\n", threadCount, expected.size(),
+           mismatchCount);
+    return mismatchCount == 0 ? 0 : 1;
+}
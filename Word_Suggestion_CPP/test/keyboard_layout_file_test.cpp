@@ -0,0 +1,311 @@
+//
+// Checks the compiled keyboard layout format: a layout compiled to a file and mmapped back through
+// ProximityProvider gives the same ProximityInfo as the layout it was compiled from, damaged
+// files are rejected, and the CRC-32 of the header matches the standard check value.
+//
+// Usage: keyboardLayoutFileTest
+//
+// Needs no data: the layout is a QWERTY keyboard built in the test. Exits with 1 on any failure.
+//
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "ProximityProvider.h"
+
+namespace {
+
+const int KEY_WIDTH = 100;
+const int KEY_HEIGHT = 150;
+const int GRID_WIDTH = 32;
+const int GRID_HEIGHT = 16;
+
+int failureCount = 0;
+
+void check(bool condition, const char *what) {
+    if (!condition) {
+        fprintf(stderr, "failed: %s\n", what);
+        failureCount++;
+    }
+}
+
+// Owns the arrays a layout points into.
+class TestLayout {
+public:
+    TestLayout(bool hasSweetSpots) {
+        const char *const rows[] = {"qwertyuiop", "asdfghjkl", "zxcvbnm"};
+        for (int row = 0; row < 3; row++) {
+            const int rowLength = (int) strlen(rows[row]);
+            for (int column = 0; column < rowLength; column++) {
+                // Each row is centred on the keyboard.
+                addKey(rows[row][column], (10 - rowLength) * KEY_WIDTH / 2 + column * KEY_WIDTH,
+                       row * KEY_HEIGHT, KEY_WIDTH);
+            }
+        }
+        addKey(' ', 2 * KEY_WIDTH, 3 * KEY_HEIGHT, 6 * KEY_WIDTH);
+
+        // Every key whose rectangle, grown by a key width, holds the centre of the cell.
+        const int cellWidth = (KEYBOARD_WIDTH + GRID_WIDTH - 1) / GRID_WIDTH;
+        const int cellHeight = (KEYBOARD_HEIGHT + GRID_HEIGHT - 1) / GRID_HEIGHT;
+        proximityChars.assign(GRID_WIDTH * GRID_HEIGHT * MAX_PROXIMITY_CHARS_SIZE, 0);
+        for (int cell = 0; cell < GRID_WIDTH * GRID_HEIGHT; cell++) {
+            const int x = (cell % GRID_WIDTH) * cellWidth + cellWidth / 2;
+            const int y = (cell / GRID_WIDTH) * cellHeight + cellHeight / 2;
+            int count = 0;
+            for (size_t key = 0; key < keyCharCodes.size() && count < MAX_PROXIMITY_CHARS_SIZE;
+                 key++) {
+                if (x >= keyXCoordinates[key] - KEY_WIDTH
+                    && x < keyXCoordinates[key] + keyWidths[key] + KEY_WIDTH
+                    && y >= keyYCoordinates[key] - KEY_WIDTH
+                    && y < keyYCoordinates[key] + keyHeights[key] + KEY_WIDTH) {
+                    proximityChars[cell * MAX_PROXIMITY_CHARS_SIZE + count++] =
+                            keyCharCodes[key];
+                }
+            }
+        }
+
+        layout.locale = "en_US";
+        layout.keyboardWidth = KEYBOARD_WIDTH;
+        layout.keyboardHeight = KEYBOARD_HEIGHT;
+        layout.gridWidth = GRID_WIDTH;
+        layout.gridHeight = GRID_HEIGHT;
+        layout.mostCommonKeyWidth = KEY_WIDTH;
+        layout.mostCommonKeyHeight = KEY_HEIGHT;
+        layout.keyCount = (int) keyCharCodes.size();
+        layout.proximityCharsLength = (int) proximityChars.size();
+        layout.proximityChars = proximityChars.data();
+        layout.keyXCoordinates = keyXCoordinates.data();
+        layout.keyYCoordinates = keyYCoordinates.data();
+        layout.keyWidths = keyWidths.data();
+        layout.keyHeights = keyHeights.data();
+        layout.keyCharCodes = keyCharCodes.data();
+        if (hasSweetSpots) {
+            layout.sweetSpotCenterXs = sweetSpotCenterXs.data();
+            layout.sweetSpotCenterYs = sweetSpotCenterYs.data();
+            layout.sweetSpotRadii = sweetSpotRadii.data();
+        }
+    }
+
+    KeyboardLayoutFile::Layout layout;
+
+private:
+    static const int KEYBOARD_WIDTH = 10 * KEY_WIDTH;
+    static const int KEYBOARD_HEIGHT = 4 * KEY_HEIGHT;
+
+    std::vector<int> proximityChars;
+    std::vector<int> keyXCoordinates;
+    std::vector<int> keyYCoordinates;
+    std::vector<int> keyWidths;
+    std::vector<int> keyHeights;
+    std::vector<int> keyCharCodes;
+    std::vector<float> sweetSpotCenterXs;
+    std::vector<float> sweetSpotCenterYs;
+    std::vector<float> sweetSpotRadii;
+
+    void addKey(int code, int x, int y, int width) {
+        keyCharCodes.push_back(code);
+        keyXCoordinates.push_back(x);
+        keyYCoordinates.push_back(y);
+        keyWidths.push_back(width);
+        keyHeights.push_back(KEY_HEIGHT);
+        // Off-centre sweet spots, so that the geometric tables differ from the key centres.
+        sweetSpotCenterXs.push_back(x + width / 2.0f + 3.5f);
+        sweetSpotCenterYs.push_back(y + KEY_HEIGHT / 2.0f + 10.25f);
+        // The space key has no calibration data.
+        sweetSpotRadii.push_back(code == ' ' ? 0.0f : KEY_WIDTH * 0.6f);
+    }
+};
+
+// Compares everything ProximityInfo exposes, over the whole keyboard.
+bool isSameProximityInfo(const ProximityInfo &expected, const ProximityInfo &actual) {
+    if (expected.getKeyCount() != actual.getKeyCount()
+        || expected.getGridWidth() != actual.getGridWidth()
+        || expected.getGridHeight() != actual.getGridHeight()
+        || expected.getCellWidth() != actual.getCellWidth()
+        || expected.getCellHeight() != actual.getCellHeight()
+        || expected.getKeyboardWidth() != actual.getKeyboardWidth()
+        || expected.getKeyboardHeight() != actual.getKeyboardHeight()
+        || expected.getKeyboardHypotenuse() != actual.getKeyboardHypotenuse()
+        || expected.getMostCommonKeyWidth() != actual.getMostCommonKeyWidth()
+        || expected.getNormalizedSquaredMostCommonKeyHypotenuse()
+           != actual.getNormalizedSquaredMostCommonKeyHypotenuse()
+        || expected.hasTouchPositionCorrectionData() != actual.hasTouchPositionCorrectionData()) {
+        return false;
+    }
+    const int keyCount = expected.getKeyCount();
+    std::vector<int> keyCodes;
+    for (int key = 0; key < keyCount; key++) {
+        keyCodes.push_back(expected.getCodePointOf(key));
+        if (expected.getCodePointOf(key) != actual.getCodePointOf(key)
+            || expected.getOriginalCodePointOf(key) != actual.getOriginalCodePointOf(key)
+            || expected.getKeyIndexOf(keyCodes.back()) != actual.getKeyIndexOf(keyCodes.back())
+            || expected.hasSweetSpotData(key) != actual.hasSweetSpotData(key)
+            || expected.getSweetSpotCenterXAt(key) != actual.getSweetSpotCenterXAt(key)
+            || expected.getSweetSpotCenterYAt(key) != actual.getSweetSpotCenterYAt(key)
+            || expected.getSweetSpotRadiiAt(key) != actual.getSweetSpotRadiiAt(key)) {
+            return false;
+        }
+        for (int otherKey = 0; otherKey < keyCount; otherKey++) {
+            if (expected.getKeyKeyDistanceG(key, otherKey)
+                != actual.getKeyKeyDistanceG(key, otherKey)) {
+                return false;
+            }
+        }
+    }
+    std::vector<int> xs;
+    std::vector<int> ys;
+    for (int y = 0; y < expected.getKeyboardHeight(); y += 37) {
+        for (int x = 0; x < expected.getKeyboardWidth(); x += 29) {
+            if (expected.hasSpaceProximity(x, y) != actual.hasSpaceProximity(x, y)) {
+                return false;
+            }
+            for (int key = 0; key < keyCount; key++) {
+                for (int isGeometric = 0; isGeometric < 2; isGeometric++) {
+                    if (expected.getNormalizedSquaredDistanceFromCenterFloatG(key, x, y,
+                                                                              isGeometric)
+                        != actual.getNormalizedSquaredDistanceFromCenterFloatG(key, x, y,
+                                                                               isGeometric)
+                        || expected.getKeyCenterXOfKeyIdG(key, x, isGeometric)
+                           != actual.getKeyCenterXOfKeyIdG(key, x, isGeometric)
+                        || expected.getKeyCenterYOfKeyIdG(key, y, isGeometric)
+                           != actual.getKeyCenterYOfKeyIdG(key, y, isGeometric)) {
+                        return false;
+                    }
+                }
+            }
+            xs.push_back(x);
+            ys.push_back(y);
+        }
+    }
+    // One tap per key code at every sampled point, as the typing traversal asks for them.
+    std::vector<int> inputCodes(xs.size());
+    for (size_t i = 0; i < inputCodes.size(); i++) {
+        inputCodes[i] = keyCodes[i % keyCodes.size()];
+    }
+    for (size_t first = 0; first < inputCodes.size(); first += MAX_WORD_LENGTH) {
+        const int inputSize = (int) std::min(inputCodes.size() - first, (size_t) MAX_WORD_LENGTH);
+        std::vector<int> expectedCodes(inputSize * MAX_PROXIMITY_CHARS_SIZE);
+        std::vector<int> actualCodes(inputSize * MAX_PROXIMITY_CHARS_SIZE);
+        expected.initializeProximities(&inputCodes[first], &xs[first], &ys[first], inputSize,
+                                       expectedCodes.data());
+        actual.initializeProximities(&inputCodes[first], &xs[first], &ys[first], inputSize,
+                                     actualCodes.data());
+        if (expectedCodes != actualCodes) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Compiles the layout to a file and loads it the way the app does, through an mmap.
+void testRoundTrip(bool hasSweetSpots) {
+    const TestLayout testLayout(hasSweetSpots);
+    char path[] = "/tmp/keyboardLayoutFileTestXXXXXX.kbl";
+    const int fd = mkstemps(path, (int) ProximityProvider::COMPILED_LAYOUT_EXTENSION.size());
+    if (fd < 0) {
+        check(false, "creating a temporary layout file");
+        return;
+    }
+    close(fd);
+    check(KeyboardLayoutFile::writeLayoutFile(path, testLayout.layout), "writing the layout");
+    {
+        ProximityProvider provider(std::vector<std::string>(1, path));
+        const ProximityInfo *const proximityInfo = provider.getProximity('q');
+        const ProximityInfo expected(testLayout.layout);
+        check(proximityInfo && isSameProximityInfo(expected, *proximityInfo),
+              hasSweetSpots ? "round trip" : "round trip without sweet spots");
+    }
+    unlink(path);
+}
+
+std::vector<uint8_t> compile(const TestLayout &testLayout) {
+    std::vector<uint8_t> buffer;
+    check(KeyboardLayoutFile::compileLayout(testLayout.layout, &buffer), "compiling the layout");
+    return buffer;
+}
+
+bool isReadable(const std::vector<uint8_t> &buffer, int size) {
+    KeyboardLayoutFile::Layout layout;
+    return KeyboardLayoutFile::readLayout(buffer.data(), size, &layout);
+}
+
+void testRejections() {
+    const TestLayout testLayout(true /* hasSweetSpots */);
+    const std::vector<uint8_t> compiled = compile(testLayout);
+    const int size = (int) compiled.size();
+    check(isReadable(compiled, size), "reading the compiled layout");
+
+    check(!isReadable(compiled, size - 1), "rejecting a file missing its last byte");
+    check(!isReadable(compiled, size / 2), "rejecting a file cut in half");
+    check(!isReadable(compiled, 8), "rejecting a file cut inside the header");
+
+    // Header fields, see KeyboardLayoutFile: magic, version, header size, payload size, CRC.
+    std::vector<uint8_t> damaged = compiled;
+    damaged[0] ^= 0x01;
+    check(!isReadable(damaged, size), "rejecting a bad magic number");
+
+    damaged = compiled;
+    const uint32_t nextVersion = KeyboardLayoutFile::FORMAT_VERSION + 1;
+    memcpy(&damaged[1 * sizeof(uint32_t)], &nextVersion, sizeof(nextVersion));
+    check(!isReadable(damaged, size), "rejecting a wrong format version");
+
+    damaged = compiled;
+    damaged[4 * sizeof(uint32_t) + 2] ^= 0x40;
+    check(!isReadable(damaged, size), "rejecting a flipped byte of the CRC");
+
+    damaged = compiled;
+    damaged[size - 5] ^= 0x01;
+    check(!isReadable(damaged, size), "rejecting a flipped byte of the payload");
+}
+
+uint32_t computeBitwiseCrc(const uint8_t *data, int size) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (int i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+        }
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void testChecksum() {
+    const char *const checkInput = "123456789";
+    check(KeyboardLayoutFile::computeChecksum(
+                  reinterpret_cast<const uint8_t *>(checkInput), (int) strlen(checkInput))
+          == 0xCBF43926u, "CRC-32 of \"123456789\"");
+    check(KeyboardLayoutFile::computeChecksum(nullptr, 0) == 0, "CRC-32 of no data");
+
+    // Every length and alignment around the 8 byte blocks, against the bitwise definition.
+    std::vector<uint8_t> data(80);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = (uint8_t) (i * 131 + 7);
+    }
+    bool isSame = true;
+    for (int offset = 0; offset < 8; offset++) {
+        for (int size = 0; offset + size <= (int) data.size(); size++) {
+            isSame = isSame && KeyboardLayoutFile::computeChecksum(&data[offset], size)
+                               == computeBitwiseCrc(&data[offset], size);
+        }
+    }
+    check(isSame, "slicing-by-8 CRC-32 against the bitwise CRC-32");
+}
+
+}
+
+int main() {
+    testRoundTrip(true /* hasSweetSpots */);
+    testRoundTrip(false /* hasSweetSpots */);
+    testRejections();
+    testChecksum();
+    printf("%d failures\n", failureCount);
+    return failureCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,181 @@
+//
+// Checks that SessionManager keeps its sessions under the memory budget by hibernating the least
+// recently used ones, that a hibernated session gives the same suggestions once woken, and that
+// a session in use is neither hibernated nor removed.
+//
+// Usage: sessionManagerTest <dictionary> <layout directory>
+//
+// The budget is half of what the sessions hold when none is hibernated. Exits with 1 on any failure, and with 77, which ctest reports as skipped, when
+// the dictionary or the layout directory cannot be read.
+//
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "SessionManager.h"
+
+namespace {
+
+const int SKIPPED_EXIT_CODE = 77;
+// Typed one per key, in this order.
+const char *const WORDS[] = {"hello", "tonigth", "people", "beautful", "understanding"};
+const int WORD_COUNT = sizeof(WORDS) / sizeof(WORDS[0]);
+
+int failureCount = 0;
+
+void check(bool condition, const char *what) {
+    if (!condition) {
+        fprintf(stderr, "failed: %s\n", what);
+        failureCount++;
+    }
+}
+
+bool isReadable(const char *path, const bool isDirectory) {
+    struct stat status;
+    return stat(path, &status) == 0 && S_ISDIR(status.st_mode) == isDirectory
+            && access(path, R_OK) == 0;
+}
+
+bool isSameResult(const SuggestionProvider::SuggestionBuffer &left,
+                  const SuggestionProvider::SuggestionBuffer &right) {
+    if (left.count != right.count) {
+        return false;
+    }
+    for (int index = 0; index < left.count; index++) {
+        if (strcmp(left.suggestions[index].utf8, right.suggestions[index].utf8) != 0
+            || left.suggestions[index].score != right.suggestions[index].score) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string getKey(int index) {
+    return "user" + std::to_string(index);
+}
+
+// Types the word on the session of the key, one keystroke per use of the session, as a server
+// handling one request per keystroke would. Returns the suggestions for the whole word.
+void typeWord(SessionManager *sessionManager, const std::string &key, const char *word,
+              SuggestionProvider::SuggestionBuffer *outSuggestions) {
+    for (const char *codePoint = word; *codePoint; codePoint++) {
+        SessionManager::ScopedSession session(sessionManager, key);
+        session->appendCodePoint(*codePoint);
+        session->getSuggestions(outSuggestions);
+    }
+}
+
+bool isHibernating(SessionManager *sessionManager, const std::string &key) {
+    SessionManager::ScopedSession session(sessionManager, key);
+    return session->isHibernating();
+}
+
+// The bytes the sessions of all the words hold once released, with their traverse sessions.
+size_t getLiveSessionsSize(SuggestionProvider *provider) {
+    SessionManager sessionManager(provider, SIZE_MAX);
+    SuggestionProvider::SuggestionBuffer suggestions;
+    for (int index = 0; index < WORD_COUNT; index++) {
+        typeWord(&sessionManager, getKey(index), WORDS[index], &suggestions);
+    }
+    check(sessionManager.getLiveSessionCount() == WORD_COUNT, "no hibernation without budget");
+    return sessionManager.getBytesHeld();
+}
+
+void testHibernation(SuggestionProvider *provider, size_t byteBudget) {
+    SessionManager sessionManager(provider, byteBudget);
+    SuggestionProvider::SuggestionBuffer expected[WORD_COUNT];
+    for (int index = 0; index < WORD_COUNT; index++) {
+        typeWord(&sessionManager, getKey(index), WORDS[index], &expected[index]);
+        check(sessionManager.getBytesHeld() <= byteBudget, "bytes held within the budget");
+    }
+    check(sessionManager.getSessionCount() == WORD_COUNT, "hibernated sessions kept");
+    const int liveSessionCount = sessionManager.getLiveSessionCount();
+    check(liveSessionCount > 0 && liveSessionCount < WORD_COUNT, "some sessions hibernated");
+    // The least recently used sessions went first.
+    for (int index = 0; index < WORD_COUNT; index++) {
+        check(isHibernating(&sessionManager, getKey(index))
+              == (index < WORD_COUNT - liveSessionCount),
+              "least recently used sessions hibernated");
+    }
+
+    // Woken up, a session has kept its word and searches it again from the root.
+    for (int index = 0; index < WORD_COUNT; index++) {
+        SuggestionProvider::SuggestionBuffer suggestions;
+        {
+            SessionManager::ScopedSession session(&sessionManager, getKey(index));
+            check(session->getInputSize() == (int) strlen(WORDS[index]), "word kept");
+            session->getSuggestions(&suggestions);
+            check(!session->isHibernating(), "session woken by a query");
+        }
+        check(isSameResult(suggestions, expected[index]), "same suggestions after hibernation");
+        // The budget holds any session, so the one just used stays live.
+        check(!isHibernating(&sessionManager, getKey(index))
+              && sessionManager.getBytesHeld() <= byteBudget, "budget kept after waking");
+    }
+}
+
+void testSessionInUse(SuggestionProvider *provider, size_t byteBudget) {
+    SessionManager sessionManager(provider, byteBudget);
+    SuggestionProvider::SuggestionBuffer expected;
+    typeWord(&sessionManager, getKey(0), WORDS[0], &expected);
+    SessionManager::ScopedSession heldSession(&sessionManager, getKey(0));
+    SuggestionProvider::SuggestionBuffer suggestions;
+    heldSession->getSuggestions(&suggestions);
+
+    // The held session is the least recently used one, and stays live while the others are
+    // hibernated around it.
+    for (int index = 1; index < WORD_COUNT; index++) {
+        typeWord(&sessionManager, getKey(index), WORDS[index], &suggestions);
+        check(!heldSession->isHibernating(), "session in use not hibernated");
+    }
+    check(sessionManager.getSessionCount() == WORD_COUNT
+          && sessionManager.getLiveSessionCount() < WORD_COUNT, "session in use kept");
+    heldSession->getSuggestions(&suggestions);
+    check(isSameResult(suggestions, expected), "session in use unchanged");
+}
+
+void testRemoval(SuggestionProvider *provider) {
+    // Even a hibernated session is over this budget, so released sessions are removed.
+    SessionManager sessionManager(provider, 1 /* byteBudget */);
+    SuggestionProvider::SuggestionBuffer suggestions;
+    {
+        SessionManager::ScopedSession heldSession(&sessionManager, getKey(0));
+        heldSession->appendCodePoint('h');
+        heldSession->getSuggestions(&suggestions);
+        typeWord(&sessionManager, getKey(1), WORDS[1], &suggestions);
+        check(sessionManager.getSessionCount() == 1, "released session removed");
+        check(!heldSession->isHibernating() && heldSession->getInputSize() == 1,
+              "session in use not removed");
+    }
+    check(sessionManager.getSessionCount() == 0 && sessionManager.getBytesHeld() == 0,
+          "all sessions removed once released");
+    SessionManager::ScopedSession session(&sessionManager, getKey(0));
+    check(session->getInputSize() == 0, "removed session starts over");
+}
+
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <dictionary> <layout directory>\n", argv[0]);
+        return 1;
+    }
+    if (!isReadable(argv[1], false /* isDirectory */) || !isReadable(argv[2], true)) {
+        printf("skipped: cannot read %s or %s\n", argv[1], argv[2]);
+        return SKIPPED_EXIT_CODE;
+    }
+    SuggestionProvider provider(argv[1], std::string(argv[2]), 0 /* maxSessionCount */);
+
+    const size_t byteBudget = getLiveSessionsSize(&provider) / 2;
+    testHibernation(&provider, byteBudget);
+    testSessionInUse(&provider, byteBudget);
+    testRemoval(&provider);
+    printf("budget %zu KB, %d failures\n", byteBudget / 1024, failureCount);
+    return failureCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,221 @@
+//
+// Checks that suggestions found more than once keep their best score, and that the words of a
+// SuggestionProvider::WordList are scored like the words of the dictionary.
+//
+// Usage: wordListTest <dictionary> <layout directory>
+//
+// SuggestionResults is checked on its own first. Then words typed exactly are looked up with
+// word lists: a word of a list must score as a dictionary word of the same length and
+// probability, follow its probability as it is added again, and a word both in a list and in
+// the dictionary must come back once, with the better of its two scores. Exits with 1 on any
+// failure, and with 77, which ctest reports as skipped, when the dictionary or the layout
+// directory cannot be read.
+//
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "SuggestionProvider.h"
+#include "libDict/suggest/core/session/prev_words_info.h"
+#include "libDict/suggest/core/suggest_options.h"
+
+namespace {
+
+const int SKIPPED_EXIT_CODE = 77;
+const int SUGGESTION_COUNT = 10;
+// In the dictionary, and typed exactly.
+const char *const DICTIONARY_WORD = "hello";
+// Not in the dictionary, of the same length.
+const char *const LIST_WORD = "zqxjv";
+
+int failureCount = 0;
+
+void check(bool condition, const char *what) {
+    if (!condition) {
+        fprintf(stderr, "failed: %s\n", what);
+        failureCount++;
+    }
+}
+
+bool isReadable(const char *path, const bool isDirectory) {
+    struct stat status;
+    return stat(path, &status) == 0 && S_ISDIR(status.st_mode) == isDirectory
+            && access(path, R_OK) == 0;
+}
+
+std::vector<int> toCodePoints(const char *word) {
+    return std::vector<int>(word, word + strlen(word));
+}
+
+void addSuggestion(SuggestionResults *results, const char *word, int score, int type) {
+    const std::vector<int> codePoints = toCodePoints(word);
+    results->addSuggestion(codePoints.data(), (int) codePoints.size(), score, type,
+                           NOT_AN_INDEX, NOT_A_FIRST_WORD_CONFIDENCE);
+}
+
+bool isSuggestion(const SuggestedWord &suggestion, const char *word, int score, int type) {
+    const std::vector<int> codePoints = toCodePoints(word);
+    return suggestion.getCodePointCount() == (int) codePoints.size()
+           && std::equal(codePoints.begin(), codePoints.end(), suggestion.getCodePoint())
+           && suggestion.getScore() == score && suggestion.getType() == type;
+}
+
+void testSuggestionResults() {
+    const int correction = Dictionary::KIND_CORRECTION;
+    const int completion = Dictionary::KIND_COMPLETION;
+
+    SuggestionResults results(3);
+    addSuggestion(&results, "there", 100, correction);
+    addSuggestion(&results, "their", 200, correction);
+    // A better score replaces the word, with the type that came with it; a worse one is dropped.
+    addSuggestion(&results, "there", 300, completion);
+    addSuggestion(&results, "their", 150, completion);
+    check(results.getSuggestionCount() == 2, "one entry per word");
+    const SuggestedWord *suggestions = results.sortAndGetSuggestedWords();
+    check(isSuggestion(suggestions[0], "there", 300, completion),
+          "a duplicate with a better score replaces the word");
+    check(isSuggestion(suggestions[1], "their", 200, correction),
+          "a duplicate with a worse score is dropped");
+
+    // When the results are full, a duplicate replaces its word and evicts nothing.
+    results.clear();
+    addSuggestion(&results, "a", 10, correction);
+    addSuggestion(&results, "b", 20, correction);
+    addSuggestion(&results, "c", 30, correction);
+    addSuggestion(&results, "a", 40, correction);
+    addSuggestion(&results, "c", 5, correction);
+    check(results.getSuggestionCount() == 3, "a duplicate does not evict another word");
+    suggestions = results.sortAndGetSuggestedWords();
+    check(isSuggestion(suggestions[0], "a", 40, correction)
+          && isSuggestion(suggestions[1], "c", 30, correction)
+          && isSuggestion(suggestions[2], "b", 20, correction),
+          "a full heap keeps its order after a duplicate");
+}
+
+// Suggestions for the word typed exactly, with no previous word.
+void getSuggestions(SuggestionProvider *provider, const char *word,
+                    const SuggestionProvider::WordList *wordList,
+                    SuggestionProvider::SuggestionBuffer *outSuggestions) {
+    SuggestOptions suggestOptions(nullptr, 0);
+    PrevWordsInfo prevWordsInfo;
+    std::vector<int> codePoints = toCodePoints(word);
+    provider->getSuggestions(SUGGESTION_COUNT, codePoints.data(), (int) codePoints.size(),
+                             &prevWordsInfo, &suggestOptions, &wordList, wordList ? 1 : 0,
+                             outSuggestions);
+}
+
+// Number of times the word is suggested, and its score the first time.
+int findSuggestion(const SuggestionProvider::SuggestionBuffer &suggestions, const char *word,
+                   int *outScore) {
+    int count = 0;
+    for (int index = suggestions.count - 1; index >= 0; index--) {
+        if (strcmp(suggestions.suggestions[index].utf8, word) == 0) {
+            *outScore = suggestions.suggestions[index].score;
+            count++;
+        }
+    }
+    return count;
+}
+
+// Returns false when the word of a list holding only it is not suggested once.
+bool getListWordScore(SuggestionProvider *provider, int probability, int *outScore) {
+    SuggestionProvider::WordList wordList;
+    const std::vector<int> codePoints = toCodePoints(LIST_WORD);
+    wordList.addWord(codePoints.data(), (int) codePoints.size(), probability);
+    SuggestionProvider::SuggestionBuffer suggestions;
+    getSuggestions(provider, LIST_WORD, &wordList, &suggestions);
+    return findSuggestion(suggestions, LIST_WORD, outScore) == 1;
+}
+
+void testWordLists(const char *dictionaryPath, const char *layoutPath) {
+    SuggestionProvider provider(dictionaryPath, std::string(layoutPath));
+    const std::vector<int> dictionaryWord = toCodePoints(DICTIONARY_WORD);
+    const std::vector<int> listWord = toCodePoints(LIST_WORD);
+    struct stat status;
+    stat(dictionaryPath, &status);
+    const Dictionary dictionary(DictionaryStructureWithBufferPolicyFactory::
+            newPolicyForExistingDictFile(dictionaryPath, 0 /* bufOffset */, (int) status.st_size,
+                                         false /* isUpdatable */));
+    const int probability =
+            dictionary.getProbability(dictionaryWord.data(), (int) dictionaryWord.size());
+    check(probability > 20 && probability + 20 <= MAX_PROBABILITY,
+          "probability of the dictionary word");
+    check(dictionary.getProbability(listWord.data(), (int) listWord.size())
+          == NOT_A_PROBABILITY, "list word missing from the dictionary");
+
+    SuggestionProvider::SuggestionBuffer baseline;
+    getSuggestions(&provider, DICTIONARY_WORD, nullptr, &baseline);
+    int baselineScore = 0;
+    check(findSuggestion(baseline, DICTIONARY_WORD, &baselineScore) == 1
+          && strcmp(baseline.suggestions[0].utf8, DICTIONARY_WORD) == 0,
+          "dictionary word typed exactly comes first");
+
+    // Typed exactly, a word of the same length and probability has the same cost wherever it
+    // comes from.
+    int listScore = 0;
+    check(getListWordScore(&provider, probability, &listScore) && listScore == baselineScore,
+          "list word scored as a dictionary word");
+    int lowerScore = 0;
+    int higherScore = 0;
+    check(getListWordScore(&provider, probability - 20, &lowerScore)
+          && getListWordScore(&provider, probability + 20, &higherScore)
+          && lowerScore < listScore && higherScore > listScore,
+          "list word scores follow its probability");
+
+    // Adding a word again updates its probability.
+    SuggestionProvider::WordList updatedList;
+    updatedList.addWord(listWord.data(), (int) listWord.size(), probability - 20);
+    updatedList.addWord(listWord.data(), (int) listWord.size(), probability);
+    SuggestionProvider::SuggestionBuffer suggestions;
+    getSuggestions(&provider, LIST_WORD, &updatedList, &suggestions);
+    int updatedScore = 0;
+    check(findSuggestion(suggestions, LIST_WORD, &updatedScore) == 1
+          && updatedScore == listScore, "list word added again");
+
+    // A word in both the dictionary and a list comes back once, with its better score.
+    for (const int delta : {-20, 0, 20}) {
+        SuggestionProvider::WordList wordList;
+        wordList.addWord(dictionaryWord.data(), (int) dictionaryWord.size(),
+                         probability + delta);
+        getSuggestions(&provider, DICTIONARY_WORD, &wordList, &suggestions);
+        int score = 0;
+        const int count = findSuggestion(suggestions, DICTIONARY_WORD, &score);
+        char what[64];
+        snprintf(what, sizeof(what), "duplicate word with a list probability %+d", delta);
+        check(count == 1 && (delta > 0 ? score > baselineScore : score == baselineScore),
+              what);
+        // The other suggestions are those of the dictionary alone.
+        bool isSameOtherwise = suggestions.count == baseline.count;
+        for (int index = 1; isSameOtherwise && index < suggestions.count; index++) {
+            isSameOtherwise = strcmp(suggestions.suggestions[index].utf8,
+                                     baseline.suggestions[index].utf8) == 0
+                              && suggestions.suggestions[index].score
+                                 == baseline.suggestions[index].score;
+        }
+        check(isSameOtherwise, what);
+    }
+}
+
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <dictionary> <layout directory>\n", argv[0]);
+        return 1;
+    }
+    testSuggestionResults();
+    if (!isReadable(argv[1], false /* isDirectory */) || !isReadable(argv[2], true)) {
+        printf("skipped: cannot read %s or %s\n", argv[1], argv[2]);
+        return failureCount == 0 ? SKIPPED_EXIT_CODE : 1;
+    }
+    testWordLists(argv[1], argv[2]);
+    printf("%d failures\n", failureCount);
+    return failureCount == 0 ? 0 : 1;
+}